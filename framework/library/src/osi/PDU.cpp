@@ -38,6 +38,26 @@ long int PDU::existingPDUs = 0;
 long int PDU::maxExistingPDUs = 0;
 #endif
 
+#ifndef NDEBUG
+namespace {
+	// PDUs may be created and destroyed by FUs running on several threads
+	// (e.g. the parallel IMTAphy schedulers), so the counters are updated atomically
+	void
+	countCreatedPDU(long int& existing, long int& maxExisting)
+	{
+		long int now = __sync_add_and_fetch(&existing, 1);
+		long int max = maxExisting;
+		while (now > max)
+		{
+			long int seen = __sync_val_compare_and_swap(&maxExisting, max, now);
+			if (seen == max)
+				break;
+			max = seen;
+		}
+	}
+}
+#endif
+
 PDU::PDU(PCI* aPCIPtr, PDU* anSDUPtr) :
     p_pciPtr(PCIPtr()),
     p_userDataPtr(PDUPtr())
@@ -52,8 +72,7 @@ PDU::PDU(PCI* aPCIPtr, PDU* anSDUPtr) :
 		p_pciPtr->setSDU(p_userDataPtr);
 
 #ifndef NDEBUG
-	++existingPDUs;
-	maxExistingPDUs = std::max(maxExistingPDUs, existingPDUs);
+	countCreatedPDU(existingPDUs, maxExistingPDUs);
 #endif // NDEBUG
 }
 
@@ -64,15 +83,14 @@ PDU::PDU(const PDU& aPDURef) :
 	p_userDataPtr(aPDURef.p_userDataPtr)
 {
 #ifndef NDEBUG
-	++existingPDUs;
-	maxExistingPDUs = std::max(maxExistingPDUs, existingPDUs);
+	countCreatedPDU(existingPDUs, maxExistingPDUs);
 #endif // NDEBUG
 }
 
 PDU::~PDU()
 {
 #ifndef NDEBUG
-	--existingPDUs;
+	__sync_sub_and_fetch(&existingPDUs, 1);
 #endif // NDEBUG
 }
 
@@ -86,3 +86,20 @@ ContextCollector::put(double value) const
     probeBus_->forwardMeasurement(t, value, c);
 }
 
+void
+ContextCollector::putAll(const std::vector<double>& values) const
+{
+    if (values.empty() || !probeBus_->hasObservers())
+    {
+        return;
+    }
+    Context c;
+
+    contextProviders_.fillContext(c);
+
+    wns::simulator::Time t = wns::simulator::getEventScheduler()->getTime();
+    for (std::vector<double>::const_iterator it = values.begin(); it != values.end(); ++it)
+    {
+        probeBus_->forwardMeasurement(t, *it, c);
+    }
+}
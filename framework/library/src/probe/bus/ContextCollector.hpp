@@ -135,6 +135,38 @@ namespace wns { namespace probe { namespace bus {
                 probeBus_->forwardMeasurement(t, value, c);
             }
 
+        /**
+         * @brief Forward several values measured at the same time with the
+         * same context. The context is only gathered once.
+         */
+        void
+        putAll(const std::vector<double>& values) const;
+
+        /**
+         * @brief Same as putAll(values) with additional context entries, see
+         * put(value, contextentries).
+         */
+        template<typename Tuple>
+        void
+        putAll(const std::vector<double>& values, const Tuple& contextentries) const
+            {
+                if (values.empty() || !probeBus_->hasObservers())
+                {
+                    return;
+                }
+                Context c;
+
+                contextProviders_.fillContext(c);
+
+                ContextCollector::detail<Tuple, boost::tuples::length<Tuple>::value-2, boost::tuples::length<Tuple>::value-1>::fillContext(c, contextentries);
+
+                wns::simulator::Time t = wns::simulator::getEventScheduler()->getTime();
+                for (std::vector<double>::const_iterator it = values.begin(); it != values.end(); ++it)
+                {
+                    probeBus_->forwardMeasurement(t, *it, c);
+                }
+            }
+
         void
         put(const wns::osi::PDUPtr&, double value) const;
 
@@ -39,11 +39,13 @@ namespace wns { namespace probe { namespace bus { namespace tests {
     {
         CPPUNIT_TEST_SUITE( ContextCollectorTest );
         CPPUNIT_TEST( tupleContext );
+        CPPUNIT_TEST( putAll );
         CPPUNIT_TEST_SUITE_END();
     public:
         void prepare();
         void cleanup();
         void tupleContext();
+        void putAll();
     };
 
     CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( ContextCollectorTest, wns::testsuite::Default() );
@@ -79,3 +81,28 @@ ContextCollectorTest::tupleContext()
     CPPUNIT_ASSERT(pb.lastContext == "{IntContext : 1,StringContext : 'hansi',}");
 }
 
+void
+ContextCollectorTest::putAll()
+{
+    ContextCollector cc_("testSource");
+
+    ProbeBusStub pb;
+
+    pb.startObserving(wns::simulator::getProbeBusRegistry()->getMeasurementSource("testSource"));
+
+    std::vector<double> values;
+    cc_.putAll(values, boost::make_tuple("IntContext", 1));
+    CPPUNIT_ASSERT_EQUAL(0, pb.receivedCounter);
+
+    values.push_back(1.0);
+    values.push_back(2.0);
+    values.push_back(3.0);
+    cc_.putAll(values, boost::make_tuple("IntContext", 1));
+
+    CPPUNIT_ASSERT_EQUAL(3, pb.receivedCounter);
+    CPPUNIT_ASSERT(pb.receivedValues == values);
+    CPPUNIT_ASSERT(pb.lastContext == "{IntContext : 1,}");
+
+    cc_.putAll(values);
+    CPPUNIT_ASSERT_EQUAL(6, pb.receivedCounter);
+}
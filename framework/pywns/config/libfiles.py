@@ -2,6 +2,8 @@ pythonFiles = [
 'playgroundPlugins/Testing/Testing.py',
 'playgroundPlugins/Testing/__init__.py',
 'Probe.py',
+'ChannelTrace.py',
+'PRBTrace.py',
 'MemCheck.py',
 'TableParser.py',
 'WNSUnit.py',
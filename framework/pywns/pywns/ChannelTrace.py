@@ -0,0 +1,139 @@
+###############################################################################
+# This file is part of openWNS (open Wireless Network Simulator)
+# _____________________________________________________________________________
+#
+# Copyright (C) 2004-2007
+# Chair of Communication Networks (ComNets)
+# Kopernikusstr. 16, D-52074 Aachen, Germany
+# phone: ++49-241-80-27910,
+# fax: ++49-241-80-22242
+# email: info@openwns.org
+# www: http://www.openwns.org
+# _____________________________________________________________________________
+#
+# openWNS is free software; you can redistribute it and/or modify it under the
+# terms of the GNU Lesser General Public License version 2 as published by the
+# Free Software Foundation;
+#
+# openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+###############################################################################
+
+"""Reader for the binary channel traces written by IMTAphy's ChannelDumper
+(see modules/phy/imtaphy/src/scanner/ChannelTrace.hpp for the file layout).
+
+    trace = ChannelTrace("CIRCTFdump.trc")
+    cir, ctf = trace.frame(0)       # complex64 arrays of shape (K,U,S,N) and (K,U,S,F)
+    ctf[k, u, s, f]
+
+With memoryMapped = True (the default) uncompressed frames are numpy views into the
+mapped file, so random access into huge traces does not read more than needed.
+"""
+
+import struct
+import zlib
+import numpy
+
+FILE_MAGIC = b'IMTATRC\0'
+FRAME_MAGIC = 0x454d5246
+FORMAT_VERSION = 1
+BYTE_ORDER_MARK = 0x01020304
+
+CODEC_NONE = 0
+CODEC_DEFLATE = 1
+
+# FileHeader: magic, version, byteOrder, K, U, S, N, F, codec, numFrames, reserved, indexOffset
+fileHeaderFormat = '<8s10IQ'
+frameHeaderFormat = '<4I'
+indexEntryType = numpy.dtype([('offset', '<u8'), ('tti', '<u4'), ('storedBytes', '<u4')])
+
+class ChannelTrace:
+    fileName = None
+    K = None
+    U = None
+    S = None
+    N = None
+    F = None
+    codec = None
+    index = None
+
+    def __init__(self, fileName, memoryMapped = True):
+        self.fileName = fileName
+        self.memoryMapped = memoryMapped
+
+        f = open(fileName, 'rb')
+        header = struct.unpack(fileHeaderFormat, f.read(struct.calcsize(fileHeaderFormat)))
+        (magic, version, byteOrder, self.K, self.U, self.S, self.N, self.F,
+         self.codec, numFrames, reserved, indexOffset) = header
+
+        assert magic == FILE_MAGIC, fileName + " is not a channel trace"
+        assert version == FORMAT_VERSION, "Unsupported channel trace version " + str(version)
+        assert byteOrder == BYTE_ORDER_MARK, "Channel trace was written with a different byte order"
+        assert indexOffset != 0, "Channel trace has not been closed properly"
+        assert self.codec in [CODEC_NONE, CODEC_DEFLATE], "Unknown codec " + str(self.codec)
+
+        f.seek(indexOffset)
+        self.index = numpy.fromfile(f, dtype = indexEntryType, count = numFrames)
+        f.close()
+
+        if memoryMapped:
+            self.data = numpy.memmap(fileName, dtype = numpy.uint8, mode = 'r')
+        else:
+            self.data = None
+
+        self.numCIRSamples = self.K * self.U * self.S * self.N
+        self.numSamples = self.numCIRSamples + self.K * self.U * self.S * self.F
+
+    def __len__(self):
+        return len(self.index)
+
+    def ttis(self):
+        return self.index['tti']
+
+    def _stored(self, frame):
+        entry = self.index[frame]
+        headerBytes = struct.calcsize(frameHeaderFormat)
+        offset = int(entry['offset'])
+        storedBytes = int(entry['storedBytes'])
+
+        if self.data is not None:
+            frameHeader = struct.unpack(frameHeaderFormat, self.data[offset:offset + headerBytes].tobytes())
+            stored = self.data[offset + headerBytes:offset + headerBytes + storedBytes]
+        else:
+            f = open(self.fileName, 'rb')
+            f.seek(offset)
+            frameHeader = struct.unpack(frameHeaderFormat, f.read(headerBytes))
+            stored = numpy.frombuffer(f.read(storedBytes), dtype = numpy.uint8)
+            f.close()
+
+        assert frameHeader[0] == FRAME_MAGIC, "Corrupt channel trace frame " + str(frame)
+        return stored
+
+    def samples(self, frame):
+        """All complex64 samples of a frame: the CIR followed by the CTF"""
+        stored = self._stored(frame)
+        if self.codec == CODEC_NONE:
+            return stored.view(numpy.complex64)
+
+        # undo the byte shuffle (all first bytes of the floats, then all second bytes, ...)
+        shuffled = numpy.frombuffer(zlib.decompress(stored.tobytes()), dtype = numpy.uint8)
+        raw = shuffled.reshape(4, 2 * self.numSamples).T.copy()
+        return raw.view(numpy.float32).reshape(-1).view(numpy.complex64)
+
+    def frame(self, frame):
+        """(CIR, CTF) of a frame with shapes (K,U,S,N) and (K,U,S,F)"""
+        samples = self.samples(frame)
+        cir = samples[:self.numCIRSamples].reshape(self.K, self.U, self.S, self.N)
+        ctf = samples[self.numCIRSamples:].reshape(self.K, self.U, self.S, self.F)
+        return (cir, ctf)
+
+    def ctfSeries(self, k, u, s):
+        """CTF of one antenna pair of link k over all frames, shape (numFrames, F)"""
+        offset = self.numCIRSamples + ((k * self.U + u) * self.S + s) * self.F
+        return numpy.array([self.samples(t)[offset:offset + self.F] for t in range(len(self))])
@@ -0,0 +1,107 @@
+###############################################################################
+# This file is part of openWNS (open Wireless Network Simulator)
+# _____________________________________________________________________________
+#
+# Copyright (C) 2004-2007
+# Chair of Communication Networks (ComNets)
+# Kopernikusstr. 16, D-52074 Aachen, Germany
+# phone: ++49-241-80-27910,
+# fax: ++49-241-80-22242
+# email: info@openwns.org
+# www: http://www.openwns.org
+# _____________________________________________________________________________
+#
+# openWNS is free software; you can redistribute it and/or modify it under the
+# terms of the GNU Lesser General Public License version 2 as published by the
+# Free Software Foundation;
+#
+# openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+# A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+# details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+###############################################################################
+
+"""Reader for the columnar per-PRB traces written by IMTAphy's PhyInterfaceRx (prbTraceFile,
+see modules/phy/imtaphy/src/ltea/mac/PRBTrace.hpp for the file layout).
+
+    trace = PRBTrace("prbTrace.dat")
+    block = trace.block(0)          # dict of numpy arrays, one entry per row
+    block['SINR'], block['PMI']     # untraced fields are NaN
+    allRows = trace.concatenated()  # all blocks, with an additional 'tti' column
+"""
+
+import struct
+import numpy
+
+FILE_MAGIC = b'IMTAPRB\0'
+BLOCK_MAGIC = 0x54425250
+FORMAT_VERSION = 1
+BYTE_ORDER_MARK = 0x01020304
+FIELD_NAME_LENGTH = 16
+
+INT_COLUMNS = ['receiver', 'sender', 'tbId', 'attempt', 'decodable', 'layer', 'prb', 'fields']
+
+# FileHeader: magic, version, byteOrder, numFields, numBlocks
+fileHeaderFormat = '<8s4I'
+blockHeaderFormat = '<4I'
+
+class PRBTrace:
+    fieldNames = None
+    blocks = None
+
+    def __init__(self, fileName):
+        data = numpy.memmap(fileName, dtype = numpy.uint8, mode = 'r')
+
+        headerBytes = struct.calcsize(fileHeaderFormat)
+        (magic, version, byteOrder, numFields, numBlocks) = struct.unpack(fileHeaderFormat, data[:headerBytes].tobytes())
+        assert magic == FILE_MAGIC, fileName + " is not a PRB trace"
+        assert version == FORMAT_VERSION, "Unsupported PRB trace version " + str(version)
+        assert byteOrder == BYTE_ORDER_MARK, "PRB trace was written with a different byte order"
+
+        offset = headerBytes
+        self.fieldNames = []
+        for f in range(numFields):
+            self.fieldNames.append(data[offset:offset + FIELD_NAME_LENGTH].tobytes().split(b'\0')[0].decode())
+            offset += FIELD_NAME_LENGTH
+
+        # numBlocks is only written on close, so just walk the blocks
+        self.blocks = []
+        blockHeaderBytes = struct.calcsize(blockHeaderFormat)
+        while offset + blockHeaderBytes <= len(data):
+            (blockMagic, tti, numRows, reserved) = struct.unpack(blockHeaderFormat, data[offset:offset + blockHeaderBytes].tobytes())
+            assert blockMagic == BLOCK_MAGIC, "Corrupt PRB trace block at offset " + str(offset)
+            offset += blockHeaderBytes
+
+            columns = {}
+            for name in INT_COLUMNS:
+                columns[name] = data[offset:offset + 4 * numRows].view('<u4')
+                offset += 4 * numRows
+            for name in ['SINR'] + self.fieldNames:
+                columns[name] = data[offset:offset + 8 * numRows].view('<f8')
+                offset += 8 * numRows
+
+            self.blocks.append((tti, columns))
+
+    def __len__(self):
+        return len(self.blocks)
+
+    def ttis(self):
+        return numpy.array([tti for (tti, columns) in self.blocks])
+
+    def block(self, block):
+        """The columns of a block (one TTI) as a dict of numpy arrays (views into the file)"""
+        return self.blocks[block][1]
+
+    def concatenated(self):
+        """All blocks as one dict of numpy arrays with an additional 'tti' column"""
+        result = {}
+        if len(self.blocks) == 0:
+            return result
+        for name in self.blocks[0][1].keys():
+            result[name] = numpy.concatenate([columns[name] for (tti, columns) in self.blocks])
+        result['tti'] = numpy.concatenate([numpy.repeat(tti, len(columns['prb'])) for (tti, columns) in self.blocks])
+        return result
@@ -37,9 +37,58 @@ class Channel:
     fastFadingModel = None
     linkManager = None
     spectrum = None
+    # Number of OpenMP threads that evolve the channel for the next TTI while the receivers evaluate
+    # the current one, only used if the spatial channel model has pipelinedEvolution enabled.
+    # None means half of the available threads
+    pipelineEvolutionThreads = None
+    # Run the downlink schedulers of all cells in parallel (from TTI 2 on). The transmissions are registered in
+    # the sequential order, so results do not change. Only schedulers whose logger is disabled take part.
+    parallelScheduling = False
+    # How the spatially correlated large scale parameters are generated: "grid" filters a 1m random grid
+    # spanning all mobiles of a site (time and memory grow with the area), "sumOfSinusoids" evaluates a
+    # field with the same correlation at the mobiles' positions only (time grows with the number of links)
+    lsCorrelation = "grid"
+    # Number of sinusoids per field for lsCorrelation = "sumOfSinusoids"
+    lsCorrelationSinusoids = 1024
+    # Directory for caching the LS parameters, wideband losses and RSRPs of a drop between runs. The cache
+    # key covers the seed, the link geometry, the spectrum and the complete pathloss and spatial channel
+    # model configuration (see startupCacheFingerprint); anything else that changes the drop has to be
+    # reflected in startupCacheTag. None disables caching
+    startupCacheDirectory = None
+    startupCacheTag = None
     
     def __init__(self, pathlossModel, spatialChannelModel, linkManager, spectrum = imtaphy.Spectrum.Spectrum()):
         self.pathlossModel = pathlossModel
         self.spatialChannelModel = spatialChannelModel
         self.linkManager = linkManager
         self.spectrum = spectrum
+
+    def startupCacheFingerprint(self):
+        # called from the C++ Channel to build the startup cache key
+        return configFingerprint(self.pathlossModel) + ";" + configFingerprint(self.spatialChannelModel)
+
+def configFingerprint(obj, visited = None):
+    """ Deterministic textual representation of a configuration object and everything it references.
+    Unlike str() it contains no object addresses, loggers are left out because they do not change results."""
+    if visited is None:
+        visited = set()
+    if obj is None or isinstance(obj, (bool, int, long, float, str, unicode)):
+        return repr(obj)
+    if isinstance(obj, (list, tuple)):
+        return "[" + ",".join([configFingerprint(it, visited) for it in obj]) + "]"
+    if isinstance(obj, dict):
+        return "{" + ",".join([configFingerprint(key, visited) + ":" + configFingerprint(obj[key], visited)
+                               for key in sorted(obj.keys())]) + "}"
+    if id(obj) in visited:
+        return "<cycle>"
+    visited.add(id(obj))
+    result = obj.__class__.__name__ + "("
+    for name in dir(obj):
+        if name.startswith('_') or name == "logger":
+            continue
+        value = getattr(obj, name)
+        if callable(value):
+            continue
+        result += name + "=" + configFingerprint(value, visited) + ","
+    visited.remove(id(obj))
+    return result + ")"
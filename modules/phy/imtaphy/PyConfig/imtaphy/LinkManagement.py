@@ -38,18 +38,24 @@ class LinkManager:
     wraparoundShiftVectors = None
     logger = None
     useSCMforRSRP = None
+    scmPruningThreshold = None
     
     # implemented scmLinkCriteria:
     # all: all links are SCM links
     # none: no links are SCM links (default)
     # serving: only links to serving BS are SCM
+    #
+    # scmPruningThreshold (only for "all"): if set (e.g. "40 dB"), links whose wideband loss is more than this
+    # above the mobile's strongest link are not SCM links but get a flat channel to save memory
 
-    def __init__(self, classifier, scmLinkCriterion = "all", handoverMargin = "1 dB", shiftVectors = [], logger = None, useSCMforRSRP = False):
+    def __init__(self, classifier, scmLinkCriterion = "all", handoverMargin = "1 dB", shiftVectors = [], logger = None, useSCMforRSRP = False,
+                 scmPruningThreshold = None):
         self.classifier = classifier
         self.scmLinkCriterion = scmLinkCriterion
         self.handoverMargin = handoverMargin
         self.wraparoundShiftVectors = shiftVectors
         self.useSCMforRSRP = useSCMforRSRP
+        self.scmPruningThreshold = scmPruningThreshold
         if logger is None:
             self.logger = logger = imtaphy.Logger.Logger("LinkManager")
         else:
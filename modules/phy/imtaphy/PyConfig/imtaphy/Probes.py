@@ -217,3 +217,26 @@ def installScannerProbes(scenarioConfig, probeConfig, simulator, settlingTime=0,
         node.getLeafs().appendChildren(table)
     ##########################################################################
 
+
+
+channelPerformanceProbes = {
+    'time.beforeTTIover' : 'wall time of the BeforeTTIOver observers per TTI [s]',
+    'time.receive' : 'wall time of the parallel receiver evaluation per TTI [s]',
+    'time.deliver' : 'wall time of delivering the receptions per TTI [s]',
+    'time.channelUpdate' : 'wall time of evolving (or swapping in) the channel per TTI [s]',
+    'time.evolve' : 'wall time of the SCM evolution per TTI [s]',
+    'time.transform' : 'time of the SCM frequency transformation per TTI, summed over the threads if done on demand [s]',
+    'time.onNewTTI' : 'wall time of notifying the observers about the new TTI (scheduling) [s]',
+    'count.transmissions' : 'transmissions evaluated per TTI',
+    'count.receivers' : 'receivers evaluated per TTI',
+    'count.interferers' : 'interfering transmissions summed over all PRBs of all transmissions per TTI',
+    'count.scmLinks' : 'links evolved by the SCM per TTI',
+    'receive.imbalance' : 'load imbalance (max - mean) / mean of the receiver threads per TTI',
+    }
+
+def installChannelPerformanceProbes(simulator):
+    # the channel publishes these on the "imtaphy.channel.<name>" probe buses
+    for name, description in channelPerformanceProbes.items():
+        probeName = "imtaphy.channel." + name
+        node = openwns.evaluation.createSourceNode(simulator, probeName)
+        node.appendChildren(Moments(name = probeName, description = description))
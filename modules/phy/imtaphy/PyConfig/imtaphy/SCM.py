@@ -33,20 +33,65 @@ class M2135:
     calibrationOutputFileName = None
     dumpCalibrationData = None
     computeEffectiveAntennaGains = None
+    # If True, the rays' phasors exp(j*w*t) are advanced by multiplying with exp(j*w*dt) when
+    # evolve is called with a constant time step instead of recomputing sin/cos of the full argument
+    incrementalEvolution = None
+    # Number of incremental steps after which the phasors are renormalized to unit magnitude
+    renormalizationInterval = None
+    # If True, the channel transfer function of a link is only computed when its channel matrix
+    # is accessed in a TTI instead of transforming all links after each evolution
+    lazyTransformation = None
+    # Storage of the time-invariant ray coefficients: "full" (PRECISION), "half" (IEEE half precision) or
+    # "quantized" (16 bit fixed point scaled per antenna pair); the latter two need 4 bytes per complex value
+    tInvariantFactorStorage = None
+    # If True, the channel of the next TTI is evolved into a second set of buffers while the
+    # receivers still evaluate the current TTI (cannot be combined with lazyTransformation)
+    pipelinedEvolution = None
     
 
-    def __init__(self, logger, calibrationOutputFileName = "calibrationData.it", dumpCalibrationData = False, computeEffectiveAntennaGains = False):
+    def __init__(self, logger, calibrationOutputFileName = "calibrationData.it", dumpCalibrationData = False, computeEffectiveAntennaGains = False,
+                 incrementalEvolution = False, renormalizationInterval = 100, lazyTransformation = False,
+                 tInvariantFactorStorage = "full", pipelinedEvolution = False):
         self.logger = logger
         self.calibrationOutputFileName = calibrationOutputFileName
         self.dumpCalibrationData = dumpCalibrationData
         self.computeEffectiveAntennaGains = computeEffectiveAntennaGains
+        self.incrementalEvolution = incrementalEvolution
+        self.renormalizationInterval = renormalizationInterval
+        self.lazyTransformation = lazyTransformation
+        self.tInvariantFactorStorage = tInvariantFactorStorage
+        self.pipelinedEvolution = pipelinedEvolution
     
 class M2135SinglePrecision(M2135):
     nameInChannelFactory = 'imtaphy.SCM.M2135SinglePrecision'
     
-    def __init__(self, logger, calibrationOutputFileName = "calibrationData.it", dumpCalibrationData = False, computeEffectiveAntennaGains = False):
-        M2135.__init__(self, logger, calibrationOutputFileName, dumpCalibrationData, computeEffectiveAntennaGains)
+    def __init__(self, logger, calibrationOutputFileName = "calibrationData.it", dumpCalibrationData = False, computeEffectiveAntennaGains = False,
+                 incrementalEvolution = False, renormalizationInterval = 100, lazyTransformation = False,
+                 tInvariantFactorStorage = "full", pipelinedEvolution = False):
+        M2135.__init__(self, logger, calibrationOutputFileName, dumpCalibrationData, computeEffectiveAntennaGains,
+                       incrementalEvolution, renormalizationInterval, lazyTransformation, tInvariantFactorStorage,
+                       pipelinedEvolution)
         
+class Replay:
+    """Replays a channel trace recorded with imtaphy.Scanner.ChannelDumper(format = "binary") in the same
+    scenario instead of computing the M2135 channel. The uplink is the transposed downlink channel."""
+    nameInChannelFactory = 'imtaphy.SCM.Replay'
+    logger = None
+    fileName = None
+    # map the trace into memory instead of reading each frame with stdio
+    memoryMapped = None
+    # number of upcoming TTIs the kernel is asked to read ahead
+    readAheadTTIs = None
+    # start over from the first recorded TTI when the simulation outlasts the trace
+    loop = None
+
+    def __init__(self, logger, fileName = "CIRCTFdump.trc", memoryMapped = True, readAheadTTIs = 8, loop = False):
+        self.logger = logger
+        self.fileName = fileName
+        self.memoryMapped = memoryMapped
+        self.readAheadTTIs = readAheadTTIs
+        self.loop = loop
+
 class No:
 	nameInChannelFactory = 'imtaphy.SCM.No'
 	def __init__(self):
@@ -92,8 +92,30 @@ class LteScanner(openwns.node.Component):
 
 class ChannelDumper(LteScanner):
     nameInComponentFactory = "imtaphy.ChannelDumper"
-    def __init__(self, node, name,  phyDataTransmission, phyDataReception):
+    # "binary" writes a channel trace (read it with pywns.ChannelTrace), "matlab" the old text dump
+    format = None
+    fileName = None
+    # "none" or "deflate" (needs IMTAphy to be built with zlib), only for the binary format
+    codec = None
+    compressionLevel = None
+    # compress and write the trace on a separate thread
+    backgroundWriter = None
+
+    def __init__(self, node, name,  phyDataTransmission, phyDataReception,
+                 format = "binary", fileName = None, codec = "none", compressionLevel = 1, backgroundWriter = True):
         super(ChannelDumper, self).__init__(node, name,  phyDataTransmission, phyDataReception)
+        assert format in ["binary", "matlab"], "format has to be binary or matlab"
+        assert codec in ["none", "deflate"], "codec has to be none or deflate"
+        self.format = format
+        if fileName is None:
+            if format == "binary":
+                fileName = "CIRCTFdump.trc"
+            else:
+                fileName = "CIRCTFdump.m"
+        self.fileName = fileName
+        self.codec = codec
+        self.compressionLevel = compressionLevel
+        self.backgroundWriter = backgroundWriter
         
 
 def createSender(x, y, bsId, azimuthDegree, scenarioConfig, probeConfig, numTxAntennas, txPowerdBm):
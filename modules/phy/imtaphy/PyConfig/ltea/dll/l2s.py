@@ -14,6 +14,10 @@ class PhyInterfaceRx(openwns.FUN.FunctionalUnit, openwns.StaticFactoryClass):
                                             parent = parentLogger)
         self.dumpChannel = dumpChannel
         self.processingDelay = processingDelay
+        # File name (in the output directory) of the columnar per-PRB trace of all received transport
+        # blocks, shared by all receivers; None disables it. Read it with pywns.PRBTrace. Needs a build
+        # with prbTrace=True (the default)
+        self.prbTraceFile = None
 
     def enableChannelGainProbing(self):
         self.dumpChannel = True
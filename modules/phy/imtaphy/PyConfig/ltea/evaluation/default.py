@@ -1,4 +1,5 @@
 from openwns.evaluation import *
+import imtaphy.Probes
 
 probeNamePrefix = 'ltea.'
 
@@ -43,6 +44,9 @@ def installProbes(sim,
                   scenarioConfig = None,
                   probeConfig = None):
 
+    # per-TTI timings and work counters of the channel
+    imtaphy.Probes.installChannelPerformanceProbes(sim)
+
     # To distinguish between node types, check for 
     # NodeType  0==EPC, 1==UE, 2 == BS
 
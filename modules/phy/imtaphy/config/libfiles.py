@@ -42,6 +42,8 @@ srcFiles = [
     'src/Link.cpp',
     
     'src/linkManagement/LinkManager.cpp',
+    'src/linkManagement/StartupCache.cpp',
+    'src/linkManagement/tests/StartupCacheTest.cpp',
     'src/linkManagement/classifier/StaticClassifier.cpp',
     'src/linkManagement/classifier/ITUClassifier.cpp',
     
@@ -66,7 +68,9 @@ srcFiles = [
     'src/receivers/tests/LteRel8CodebookTest.cpp',
 #    'src/receivers/tests/MMSEReceiverTest.cpp',
     'src/receivers/tests/LinearReceiverTest.cpp',
+    'src/receivers/tests/InterferenceCacheTest.cpp',
     'src/receivers/tests/MRCReceiverTest.cpp',
+    'src/receivers/tests/InterferenceIndexTest.cpp',
 
     'src/receivers/feedback/LteRel8DLFeedbackManager.cpp',
     'src/receivers/feedback/LteRel10UplinkChannelStatusManager.cpp',
@@ -77,19 +81,26 @@ srcFiles = [
     'src/scanner/LteSender.cpp',
     'src/scanner/LteScanner.cpp',
     'src/scanner/ChannelDumper.cpp',
+    'src/scanner/ChannelTrace.cpp',
+    'src/scanner/tests/ChannelTraceTest.cpp',
+    'src/scanner/tests/ChannelDumperTest.cpp',
     
     'src/antenna/LinearAntennaArray.cpp',
     'src/antenna/AntennaITU.cpp',
     'src/antenna/Omnidirectional.cpp',
     
     'src/spatialChannel/No.cpp',
+    'src/spatialChannel/Replay.cpp',
+    'src/spatialChannel/tests/ReplayTest.cpp',
     'src/spatialChannel/m2135/M2135.cpp',
     'src/spatialChannel/m2135/ClusterPowers.cpp',
     
     'src/lsParams/LSCorrelation.cpp',
+    'src/lsParams/SumOfSinusoids.cpp',
     
     'src/spatialChannel/m2135/RayAngles.cpp',
     'src/spatialChannel/m2135/tests/M2135Test.cpp',
+    'src/spatialChannel/m2135/tests/M2135PerformanceTest.cpp',
     'src/spatialChannel/m2135/tests/ClusterPowersTest.cpp',
     'src/spatialChannel/m2135/tests/LSCorrelationTest.cpp',
     'src/spatialChannel/m2135/tests/RayAnglesTest.cpp',
@@ -100,6 +111,8 @@ srcFiles = [
     'src/tests/ChannelStub.cpp',
     'src/tests/StationPhyStub.cpp',
     'src/tests/AnglesTest.cpp',
+    'src/tests/ParallelNewTTITest.cpp',
+    'src/tests/PipelinedEvolutionTest.cpp',
     
     'src/pathloss/tests/PathlossTest.cpp',
     
@@ -109,6 +122,10 @@ srcFiles = [
     'src/detail/tests/LookupTableTest.cpp',
     'src/detail/tests/InterpolationTest.cpp',
     'src/detail/tests/LinearAlgebraTest.cpp',
+    'src/detail/tests/SinCosTest.cpp',
+    'src/detail/tests/WorkStealingSchedulerTest.cpp',
+    'src/detail/tests/SmallMatrixTest.cpp',
+    'src/detail/tests/SmallMatrixPerformanceTest.cpp',
 
     
     'src/link2System/Modulations.cpp',
@@ -150,6 +167,10 @@ srcFiles = [
     'src/ltea/mac/scheduler/uplink/UEScheduler.cpp',
 
     'src/ltea/mac/tests/PerformanceModelTest.cpp',
+    'src/ltea/mac/scheduler/tests/UsersPRBManagerTest.cpp',
+    'src/ltea/mac/scheduler/downlink/tests/ProportionalFairTest.cpp',
+    'src/ltea/mac/tests/PRBTraceTest.cpp',
+    'src/ltea/l2s/harq/tests/ChaseCombiningDecoderTest.cpp',
 
     'src/ltea/mac/harq/HARQentity.cpp',
     'src/ltea/mac/harq/HARQ.cpp',
@@ -157,6 +178,7 @@ srcFiles = [
     'src/ltea/mac/harq/HARQSenderProcess.cpp',
 
     'src/ltea/mac/ModulationAndCodingSchemes.cpp',
+    'src/ltea/mac/PRBTrace.cpp',
 
     'src/ltea/mac/linkAdaptation/downlink/SINRThresholdLA.cpp',
     'src/ltea/mac/linkAdaptation/downlink/BlerAdaptiveLA.cpp',
@@ -170,6 +192,7 @@ hppFiles = [
     'src/linkManagement/classifier/LinkClassifierInterface.hpp',
     'src/linkManagement/classifier/ITUClassifier.hpp',
     'src/linkManagement/LinkManager.hpp',
+    'src/linkManagement/StartupCache.hpp',
     'src/pathloss/No.hpp',
     'src/pathloss/PathlossModelInterface.hpp',
     'src/pathloss/SingleSlope.hpp',
@@ -179,6 +202,7 @@ hppFiles = [
     'src/StationPhy.hpp',
     'src/Transmission.hpp',
     'src/scanner/ChannelDumper.hpp',
+    'src/scanner/ChannelTrace.hpp',
     'src/scanner/LteSender.hpp',
     'src/scanner/LteScanner.hpp',
     'src/spatialChannel/m2135/Delays.hpp',
@@ -189,6 +213,7 @@ hppFiles = [
     'src/spatialChannel/m2135/RayAngles.hpp',
     'src/spatialChannel/m2135/FixPar.hpp',
     'src/spatialChannel/No.hpp',
+    'src/spatialChannel/Replay.hpp',
     'src/spatialChannel/SpatialChannelModelInterface.hpp',
     'src/antenna/AntennaITU.hpp',
     'src/antenna/AntennaInterface.hpp',
@@ -222,6 +247,7 @@ hppFiles = [
     'src/ltea/mac/scheduler/uplink/UEScheduler.hpp',
     'src/ltea/mac/scheduler/ResourceManagerInterface.hpp',
     'src/ltea/mac/DCI.hpp',
+    'src/ltea/mac/PRBTrace.hpp',
     'src/ltea/mac/tests/PerformanceModelTest.hpp',
     'src/ltea/mac/harq/HARQReceiverProcess.hpp',
     'src/ltea/mac/harq/HARQ.hpp',
@@ -238,6 +264,7 @@ hppFiles = [
     'src/ltea/EPCgw.hpp',
     'src/lsParams/LargeScaleParameters.hpp',
     'src/lsParams/LSCorrelation.hpp',
+    'src/lsParams/SumOfSinusoids.hpp',
     'src/lsParams/RngMock.hpp',
     'src/link2System/EffectiveSINRModelInterface.hpp',
     'src/link2System/MMIBeffectiveSINR.hpp',
@@ -246,6 +273,13 @@ hppFiles = [
     'src/link2System/MMSE-FDE.hpp',
     'src/link2System/LteCQIs.hpp',
     'src/detail/LinearAlgebra.hpp',
+    'src/detail/MathBackend.hpp',
+    'src/detail/SinCos.hpp',
+    'src/detail/CompactComplex.hpp',
+    'src/detail/StaticPartition.hpp',
+    'src/detail/StaleFlags.hpp',
+    'src/detail/WorkStealingScheduler.hpp',
+    'src/detail/SmallMatrix.hpp',
     'src/detail/NodePtrCompare.hpp',
     'src/detail/LookupTable.hpp',
     'src/detail/HashRNG.hpp',
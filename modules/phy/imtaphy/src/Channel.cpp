@@ -35,14 +35,24 @@
 #include <IMTAPHY/StationPhy.hpp>
 #include <IMTAPHY/ChannelModuleCreator.hpp>
 #include <WNS/pyconfig/Parser.hpp>
+#include <WNS/Exception.hpp>
 #include <WNS/distribution/Uniform.hpp>
 
 #include <itpp/itbase.h>
 #include <itpp/base/math/misc.h>
 #include <IMTAPHY/Link.hpp>
 #include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <IMTAPHY/linkManagement/StartupCache.hpp>
 #include <IMTAPHY/receivers/ReceiverInterface.hpp>
+#include <IMTAPHY/detail/StaticPartition.hpp>
+#include <WNS/probe/bus/ContextCollector.hpp>
+#if defined(_OPENMP) && !defined(__APPLE__)
+#include <omp.h>
+#endif
 #include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <functional>
 
 using namespace imtaphy;
 
@@ -52,17 +62,27 @@ Channel::Channel() :
     lsCorrelation(NULL),
     largeScaleParams(NULL),
     linkManager(NULL),
+    startupCache(NULL),
     transmissionsPerPRB(2), // for uplink and downlink
+    interferenceIndex(2),
     config(wns::simulator::getInstance()->getConfiguration().getView("modules").getView("imtaphy").getView("channelConfig")),
     logger(config.get("logger")),
     tti(0),
     initialized(false),
-    transmissionIdCounter(0)
+    transmissionIdCounter(0),
+    pipelined(false),
+    pipelineEvolutionThreads(0),
+    parallelScheduling(false),
+    bufferingRegistrations(false),
+    inParallelNewTTI(false),
+    numSCMLinks(0),
+    interferersThisTTI(0),
+    shutdown(false)
 {
     // Init the it++ Random Number Generator with a Random Number from the 
     // openWNS generator. If its seed is fixed, it will also be fixed for it++
     wns::distribution::StandardUniform rnd = wns::distribution::StandardUniform();
-    unsigned int itppSeed = rnd() * UINT_MAX;
+    itppSeed = rnd() * UINT_MAX;
     itpp::RNG_reset(itppSeed);
     
         
@@ -73,6 +93,8 @@ Channel::Channel() :
       
     transmissionsPerPRB[Uplink].resize(spectrum->getNumberOfPRBs(imtaphy::Uplink));
     transmissionsPerPRB[Downlink].resize(spectrum->getNumberOfPRBs(imtaphy::Downlink));
+    interferenceIndex[Uplink].resize(spectrum->getNumberOfPRBs(imtaphy::Uplink));
+    interferenceIndex[Downlink].resize(spectrum->getNumberOfPRBs(imtaphy::Downlink));
         
     baseStations.clear();
     mobileStations.clear();
@@ -81,7 +103,16 @@ Channel::Channel() :
 }
 
 Channel::Channel(int dummy) : // this is just for unit testing to avoid regular constructor
-    config(wns::pyconfig::Parser()) // create empty config
+    startupCache(NULL),
+    config(wns::pyconfig::Parser()), // create empty config
+    pipelined(false),
+    pipelineEvolutionThreads(0),
+    parallelScheduling(false),
+    bufferingRegistrations(false),
+    inParallelNewTTI(false),
+    numSCMLinks(0),
+    interferersThisTTI(0),
+    shutdown(false)
 {
 
 }
@@ -130,8 +161,55 @@ Channel::onWorldCreated() // TODO: it would be nice if the simulator could call
     timer.tic();
     LinkVector allLinks = linkManager->getAllLinks();
     imtaphy::lsparams::RandomMatrix* rnGen = new imtaphy::lsparams::RandomMatrix();
-    lsCorrelation = new lsparams::LSCorrelation(allLinks, linkManager, rnGen);
-    largeScaleParams = lsCorrelation->generateLSCorrelation();
+    lsparams::LSCorrelation::Method lsMethod = lsparams::LSCorrelation::GridFilter;
+    unsigned int numSinusoids = 1024;
+    if (config.knows("lsCorrelation") && !config.isNone("lsCorrelation"))
+        lsMethod = lsparams::LSCorrelation::methodFromString(config.get<std::string>("lsCorrelation"));
+    if (config.knows("lsCorrelationSinusoids"))
+        numSinusoids = config.get<unsigned int>("lsCorrelationSinusoids");
+
+    wns::pyconfig::View spatialChannelModelConfig = config.get("spatialChannelModel");
+
+    if (config.knows("startupCacheDirectory") && !config.isNone("startupCacheDirectory"))
+    {
+        // everything not covered by the link geometry that changes the cached results
+        std::stringstream fingerprint;
+        fingerprint << config.get<std::string>("startupCacheFingerprint()") << ";"
+                    << lsMethod << ";" << numSinusoids << ";"
+                    << config.get("linkManager").get<std::string>("scmLinkCriterion") << ";"
+                    << config.get("linkManager").get<bool>("useSCMforRSRP") << ";";
+        if (config.knows("startupCacheTag") && !config.isNone("startupCacheTag"))
+            fingerprint << config.get<std::string>("startupCacheTag");
+
+        startupCache = new StartupCache(config.get<std::string>("startupCacheDirectory"),
+                                        StartupCache::hashScenario(itppSeed, allLinks, spectrum, fingerprint.str()));
+        startupCache->load(allLinks.size());
+    }
+
+    if (startupCache && startupCache->isHit())
+    {
+        // the large scale parameters come from the cache, continue with the it++ state
+        // the generation left behind so that the SCM draws the same realization
+        largeScaleParams = startupCache->getLargeScaleParameters(allLinks);
+        itpp::RNG_set_state(startupCache->getRNGState());
+
+        // rnGen was still created because it draws its seed from the openWNS generator
+        delete rnGen;
+
+        MESSAGE_SINGLE(NORMAL, logger, "Restored LS parameters and RSRPs for " << allLinks.size() << " links from " << startupCache->getFileName());
+    }
+    else
+    {
+        lsCorrelation = new lsparams::LSCorrelation(allLinks, linkManager, rnGen, lsMethod, numSinusoids);
+        largeScaleParams = lsCorrelation->generateLSCorrelation();
+
+        if (startupCache)
+        {
+            itpp::ivec rngState;
+            itpp::RNG_get_state(rngState);
+            startupCache->setRNGState(rngState);
+        }
+    }
 
     MESSAGE_SINGLE(VERBOSE, logger,"Took "<<timer.get_time()/60.0 << " minutes for generating LS parameters for " << allLinks.size() <<" links");
 
@@ -140,15 +218,42 @@ Channel::onWorldCreated() // TODO: it would be nice if the simulator could call
     linkManager->onPathlossAndShadowingReady();
     linkManager->doBeforeSCMinit();
 
-    wns::pyconfig::View spatialChannelModelConfig = config.get("spatialChannelModel");
     plugin = spatialChannelModelConfig.get<std::string>("nameInChannelFactory"); // name under which the C++ implementation of the model is registered
     SpatialChannelModelCreator* scmc = SpatialChannelModelFactory::creator(plugin);
     spatialChannelModel = scmc->create(this, spatialChannelModelConfig);
 
     MESSAGE_SINGLE(NORMAL, logger, "Initializing the spatial Channel Model for " << linkManager->getSCMLinks().size() << " links"); 
     spatialChannelModel->onWorldCreated(linkManager, largeScaleParams, false);
+    numSCMLinks = linkManager->getSCMLinks().size();
 
     linkManager->doAfterSCMinit(spatialChannelModel, getSpectrum());
+
+    if (startupCache && startupCache->isHit())
+    {
+        // the wideband losses are not taken from the cache, so they show whether the
+        // pathloss configuration changed in a way the cache key does not cover. The LS parameters
+        // and the SCM are already based on the cache at this point, so the run cannot continue
+        unsigned int mismatch = startupCache->checkWidebandLoss(allLinks, 1e-6);
+        if (mismatch != allLinks.size())
+        {
+            std::stringstream ss;
+            ss << "Wideband loss of link " << mismatch << " differs from the startup cache "
+               << startupCache->getFileName() << ", delete it or set a different startupCacheTag";
+            throw wns::Exception(ss.str());
+        }
+    }
+    else if (startupCache)
+    {
+        if (startupCache->store(allLinks, largeScaleParams))
+        {
+            MESSAGE_SINGLE(NORMAL, logger, "Stored LS parameters and RSRPs in " << startupCache->getFileName());
+        }
+        else
+        {
+            MESSAGE_SINGLE(QUIET, logger, "Could not write the startup cache " << startupCache->getFileName()
+                           << ", continuing without it");
+        }
+    }
     
     
     // Tell all stations that the channel is now setup and ready
@@ -160,11 +265,42 @@ Channel::onWorldCreated() // TODO: it would be nice if the simulator could call
     
     // start the channel model at t=0
     spatialChannelModel->evolve(0.0);
+
+    if (spatialChannelModel->supportsPipelinedEvolution())
+    {
+        unsigned int threads = imtaphy::detail::StaticPartition::maxThreads();
+        if (config.knows("pipelineEvolutionThreads") && !config.isNone("pipelineEvolutionThreads"))
+            initPipelinedEvolution(config.get<unsigned int>("pipelineEvolutionThreads"));
+        else
+            initPipelinedEvolution(std::max(threads / 2, 1U));
+
+        MESSAGE_SINGLE(NORMAL, logger, "Pipelined channel evolution with " << pipelineEvolutionThreads << " of " << threads << " threads");
+    }
+
+    if (config.knows("parallelScheduling"))
+        parallelScheduling = config.get<bool>("parallelScheduling");
+    if (parallelScheduling)
+        MESSAGE_SINGLE(NORMAL, logger, "Parallel scheduling on up to " << imtaphy::detail::StaticPartition::maxThreads() << " threads");
+}
+
+void
+Channel::initPipelinedEvolution(unsigned int evolutionThreads)
+{
+    pipelined = true;
+    pipelineEvolutionThreads = evolutionThreads;
+
+#if defined(_OPENMP) && !defined(__APPLE__)
+    // receiveAndEvolveNext gives the receivers and the evolution a nested team each
+    if (omp_get_max_active_levels() < 2)
+        omp_set_max_active_levels(2);
+#endif
 }
 
 void
 Channel::registerStationPhy(StationPhy* station)
 {
+    station->setChannelIndex(getNumStations());
+    
     if (station->getStationType() == BASESTATION)
         baseStations.push_back(station);
     else
@@ -175,6 +311,13 @@ Channel::registerStationPhy(StationPhy* station)
 void
 Channel::registerTransmission(TransmissionPtr transmission) 
 {
+    if (bufferingRegistrations)
+    {
+        // registered in observer order at the end of notifyNewTTI
+        pendingRegistrations[observerOfThread[imtaphy::detail::StaticPartition::currentThread()]].push_back(transmission);
+        return;
+    }
+
     imtaphy::Direction direction = transmission->getDirection();
     const imtaphy::interface::PrbPowerPrecodingMap& prbPowerPrecodingMap = transmission->getPrbPowerPrecodingMap();
     
@@ -182,6 +325,11 @@ Channel::registerTransmission(TransmissionPtr transmission)
     
     transmission->setId(transmissionIdCounter++);
     
+    PRBTransmission entry;
+    entry.transmission = transmission;
+    entry.sourceIndex = transmission->getSource()->getChannelIndex();
+    entry.bs = transmission->getLink()->getBS();
+    
     for (imtaphy::interface::PrbPowerPrecodingMap::const_iterator iter = prbPowerPrecodingMap.begin();
          iter != prbPowerPrecodingMap.end(); iter++)
     {
@@ -190,7 +338,11 @@ Channel::registerTransmission(TransmissionPtr transmission)
         assure((prb < transmissionsPerPRB[direction].size()) && (prb >= 0), "Invalid PRB.");
       
         transmissionsPerPRB[direction][prb].push_back(transmission);
-      
+        
+        // ids are increasing, so every PRB's index stays sorted by transmission id
+        entry.precoding = iter->second.precoding.get();
+        entry.txPower_mW = static_cast<float>(iter->second.power.get_mW());
+        interferenceIndex[direction][prb].push_back(entry);
     }
     allCurrentTransmissions.push_back(transmission);
 }
@@ -208,18 +360,40 @@ Channel::getTransmissionsOnPRB(Direction direction, imtaphy::interface::PRB prb)
 void
 Channel::periodically() // TTI over
 {
+    itpp::Real_Timer timer;
+    timer.tic();
+
     // notify all subscribed receivers that the TTI is almost over
     // tti old, channel old
     wns::Subject<imtaphy::interface::IMTAphyObserver>::forEachObserver(BeforeTTIOver(tti));
-
-    itpp::Real_Timer timer;
+    
+    timer.toc();
+    recordTTIstatistic("time.beforeTTIover", timer.get_time());
+    timer.reset();
     timer.tic();
     
     // and notify the receivers about the transmissions
     // tti old, channel old
-    evaluateAllTransmissions(); 
+    if (pipelined)
+        receiveAndEvolveNext();
+    else
+        receiveAllTransmissions();
+    
     timer.toc();
-    MESSAGE_SINGLE(VERBOSE, logger, "Evaluating all transmission took " << timer.get_time() << " seconds");
+    recordTTIstatistic("time.receive", timer.get_time());
+    timer.reset();
+    timer.tic();
+    
+    deliverAllReceptions();
+    
+    timer.toc();
+    recordTTIstatistic("time.deliver", timer.get_time());
+
+    recordTTIstatistic("count.transmissions", allCurrentTransmissions.size());
+    recordTTIstatistic("count.receivers", receiveScheduler.getNumTasks());
+    recordTTIstatistic("count.interferers", interferersThisTTI);
+    recordTTIstatistic("count.scmLinks", numSCMLinks);
+    recordTTIstatistic("receive.imbalance", receiveScheduler.getImbalance());
 
     // now, clear current transmissions:
     allCurrentTransmissions.clear();
@@ -227,77 +401,269 @@ Channel::periodically() // TTI over
     for (unsigned int prb = 0; prb < transmissionsPerPRB[imtaphy::Downlink].size(); prb++)
     {
         transmissionsPerPRB[imtaphy::Downlink][prb].clear();
+        interferenceIndex[imtaphy::Downlink][prb].clear();
     }
     for (unsigned int prb = 0; prb < transmissionsPerPRB[imtaphy::Uplink].size(); prb++)
     {
         transmissionsPerPRB[imtaphy::Uplink][prb].clear();
+        interferenceIndex[imtaphy::Uplink][prb].clear();
     }
 
     // now move on to next TTI
     tti++;
     
-    // and evolve the channel
+    // and evolve the channel (or switch to the channel that has already been evolved during the reception)
     timer.reset();
     MESSAGE_SINGLE(NORMAL, logger, "Now evolving the channel for TTI from t= " << (tti-1) * 0.001 << " until " << (tti) * 0.001); 
     timer.tic();
-    spatialChannelModel->evolve((tti) * 0.001); // for the next TTI
-    MESSAGE_SINGLE(VERBOSE, logger,"SCM took "<<timer.get_time()<<" seconds for evolving " << linkManager->getSCMLinks().size() << " links");
+    if (pipelined)
+        spatialChannelModel->swapBuffers();
+    else
+        spatialChannelModel->evolve((tti) * 0.001); // for the next TTI
     timer.toc();
-
+    MESSAGE_SINGLE(VERBOSE, logger,"SCM took "<<timer.get_time()<<" seconds for evolving " << numSCMLinks << " links");
     
-    // trigger the new TTI beginning in all stations, use the OnNewTTI functor:
-    wns::Subject<imtaphy::interface::IMTAphyObserver>::forEachObserver(OnNewTTI(tti));
+    // in the pipelined mode, the model's evolve and transform ran during the reception; lazy models
+    // report the on-demand transformations of the TTI that just ended
+    recordTTIstatistic("time.channelUpdate", timer.get_time());
+    recordTTIstatistic("time.evolve", spatialChannelModel->getLastEvolveSeconds());
+    recordTTIstatistic("time.transform", spatialChannelModel->getLastTransformSeconds());
     
+    // trigger the new TTI beginning in all stations
+    timer.reset();
+    timer.tic();
+    notifyNewTTI();
+    timer.toc();
+    recordTTIstatistic("time.onNewTTI", timer.get_time());
+}
+
+void
+Channel::notifyNewTTI()
+{
+    // in the first TTI, the schedulers initialize themselves and the UEs send their scheduling requests
+    if (!parallelScheduling || (tti < 2))
+    {
+        wns::Subject<imtaphy::interface::IMTAphyObserver>::forEachObserver(OnNewTTI(tti));
+        return;
+    }
+
+    newTTIobservers.clear();
+    wns::Subject<imtaphy::interface::IMTAphyObserver>::forEachObserver(CollectObservers(newTTIobservers));
+
+    parallelObservers.clear();
+    pendingRegistrations.resize(newTTIobservers.size());
+    observerOfThread.resize(imtaphy::detail::StaticPartition::maxThreads());
+    bufferingRegistrations = true;
+
+    // the others might depend on each other, so they keep their order and run first
+    for (unsigned int i = 0; i < newTTIobservers.size(); i++)
+    {
+        if (newTTIobservers[i]->supportsParallelNewTTI())
+        {
+            parallelObservers.push_back(i);
+        }
+        else
+        {
+            observerOfThread[imtaphy::detail::StaticPartition::currentThread()] = i;
+            newTTIobservers[i]->onNewTTI(tti);
+        }
+    }
+
+    inParallelNewTTI = true;
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int k = 0; k < static_cast<int>(parallelObservers.size()); k++)
+    {
+        observerOfThread[imtaphy::detail::StaticPartition::currentThread()] = parallelObservers[k];
+        newTTIobservers[parallelObservers[k]]->onNewTTI(tti);
+    }
+    inParallelNewTTI = false;
+    bufferingRegistrations = false;
+
+    // same registration (and thus transmission id) order as if all observers had run sequentially
+    for (unsigned int i = 0; i < pendingRegistrations.size(); i++)
+    {
+        for (unsigned int t = 0; t < pendingRegistrations[i].size(); t++)
+            registerTransmission(pendingRegistrations[i][t]);
+        pendingRegistrations[i].clear();
+    }
+
+    for (unsigned int k = 0; k < parallelObservers.size(); k++)
+        newTTIobservers[parallelObservers[k]]->afterParallelNewTTI(tti);
 }
 
+void
+Channel::recordTTIstatistic(const std::string& name, double value)
+{
+    TTIstatistic& statistic = ttiStatistics[name];
+
+    if (statistic.probe == NULL)
+        statistic.probe = wns::probe::bus::ContextCollectorPtr(new wns::probe::bus::ContextCollector("imtaphy.channel." + name));
+
+    statistic.probe->put(value);
+    statistic.sum += value;
+    statistic.max = std::max(statistic.max, value);
+    statistic.count++;
+}
 
 void
-Channel::evaluateAllTransmissions() const
+Channel::onShutdown()
 {
+    // all stations call this, only the first call prints the summary
+    if (shutdown)
+        return;
+    shutdown = true;
 
-    MESSAGE_SINGLE(NORMAL, logger, "Evaluating " << allCurrentTransmissions.size() << " current transmissions ...\n");
-    
-    // We have to do a little re-organization first. We want to parallelize the reception for the individual receivers but avoid
-    // reentrant calls to the same receiver. This can happen in uplink when a single eNB receives from different UEs.
-    
-    typedef std::set<TransmissionPtr> TransmissionSet;
-    typedef std::map<imtaphy::receivers::ReceiverInterface*, TransmissionSet> ReceiverTransmissionMap;
-    ReceiverTransmissionMap receiversAndTransmissionsMap;
-    
-    for (unsigned int n = 0; n < allCurrentTransmissions.size(); n++)
+    MESSAGE_BEGIN(NORMAL, logger, m, "Per-TTI statistics over " << tti << " TTIs (mean / max / total):\n");
+    for (std::map<std::string, TTIstatistic>::const_iterator iter = ttiStatistics.begin(); iter != ttiStatistics.end(); iter++)
     {
-        receiversAndTransmissionsMap[allCurrentTransmissions[n]->getDestination()->getReceiver()].insert(allCurrentTransmissions[n]);
+        const TTIstatistic& statistic = iter->second;
+        m << "  " << iter->first << ": " << statistic.sum / std::max(statistic.count, 1UL)
+          << " / " << statistic.max << " / " << statistic.sum << "\n";
     }
-    
-    unsigned int n = 0;
-    std::vector<TransmissionSet> transmissionSetVector(receiversAndTransmissionsMap.size());
-    
-    for (ReceiverTransmissionMap::const_iterator iter = receiversAndTransmissionsMap.begin(); iter != receiversAndTransmissionsMap.end(); n++, iter++)
+    MESSAGE_END();
+}
+
+
+namespace {
+    // orders transmission indices by receiver (and within one receiver by transmission, like the former std::set)
+    struct ByReceiver
+    {
+        ByReceiver(const TransmissionVector& transmissions_) : transmissions(transmissions_) {}
+        
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            imtaphy::receivers::ReceiverInterface* receiverA = transmissions[a]->getDestination()->getReceiver();
+            imtaphy::receivers::ReceiverInterface* receiverB = transmissions[b]->getDestination()->getReceiver();
+            if (receiverA != receiverB)
+                return std::less<imtaphy::receivers::ReceiverInterface*>()(receiverA, receiverB);
+
+            return transmissions[a] < transmissions[b];
+        }
+        
+        const TransmissionVector& transmissions;
+    };
+
+    // one task = all transmissions towards one receiver
+    struct ReceiveTask
     {
-        transmissionSetVector[n] = iter->second;
+        ReceiveTask(const TransmissionVector& transmissions_, const std::vector<unsigned int>& order_, const std::vector<unsigned int>& taskBegin_) :
+            transmissions(transmissions_), order(order_), taskBegin(taskBegin_) {}
+        
+        void operator()(unsigned int task)
+        {
+            for (unsigned int i = taskBegin[task]; i < taskBegin[task + 1]; i++)
+            {
+                const TransmissionPtr& transmission = transmissions[order[i]];
+                transmission->getDestination()->getReceiver()->receive(transmission);
+            }
+        }
+        
+        const TransmissionVector& transmissions;
+        const std::vector<unsigned int>& order;
+        const std::vector<unsigned int>& taskBegin;
+    };
+}
+
+void
+Channel::receiveAndEvolveNext()
+{
+    // The receivers only read the channel of the current TTI and the evolution only depends on time, so the
+    // channel model can evolve the next TTI into its back buffers while the receivers are busy. Both sides get
+    // their own share of the threads (nested parallelism, enabled by initPipelinedEvolution). The thread counts
+    // set in the sections only apply to the section's own nested team. Neither team consists of the threads the
+    // SCM arrays were first touched with, so the pipelined mode gives up the NUMA placement of StaticPartition.
+    int threads = imtaphy::detail::StaticPartition::maxThreads();
+    int evolveThreads = std::min(static_cast<int>(pipelineEvolutionThreads), std::max(threads - 1, 1));
+    int receiveThreads = std::max(threads - evolveThreads, 1);
+
+#pragma omp parallel sections num_threads(2)
+    {
+#pragma omp section
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            omp_set_num_threads(receiveThreads);
+#endif
+            receiveAllTransmissions();
+        }
+#pragma omp section
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            omp_set_num_threads(evolveThreads);
+#endif
+            spatialChannelModel->evolveBackBuffer((tti + 1) * 0.001);
+        }
     }
+}
+
+void
+Channel::receiveAllTransmissions()
+{
+
+    MESSAGE_SINGLE(NORMAL, logger, "Evaluating " << allCurrentTransmissions.size() << " current transmissions ...\n");
     
-    int num = transmissionSetVector.size();
-    int i; // signed int for OpenMP parallel for loop
-    TransmissionPtr transmission;
-    TransmissionSet::const_iterator iter;
-    TransmissionSet transmissionsThisReceiver;
+    // We have to do a little re-organization first. We want to parallelize the reception for the individual receivers but avoid
+    // reentrant calls to the same receiver. This can happen in uplink when a single eNB receives from different UEs.
+    // So we sort the transmissions by receiver and make one task per receiver. All containers are members that keep
+    // their memory from TTI to TTI.
     
-    // do the computation intensive part of the receiver operation in parallel
-    #pragma omp parallel for private(iter, transmission, transmissionsThisReceiver), shared(num, transmissionSetVector), default(none)
-    for (i = 0; i < num; i++)
+    receiveOrder.resize(allCurrentTransmissions.size());
+    for (unsigned int n = 0; n < allCurrentTransmissions.size(); n++)
+        receiveOrder[n] = n;
+    std::sort(receiveOrder.begin(), receiveOrder.end(), ByReceiver(allCurrentTransmissions));
+    
+    // Each receiver's home thread is the one that evolves the SCM link of its (first) transmission, using the same
+    // static link-to-thread mapping as the SCM, so that the channel state is mostly read from memory local to that
+    // thread's NUMA node. Receivers without a SCM link are dealt out round robin. The cost estimate (PRBs x layers x
+    // transmissions on these PRBs) lets the threads start with their most expensive receivers; whoever runs out of
+    // work steals from the others.
+    //
+    // The threads of the nested team in the pipelined mode are not the ones the SCM's link mapping refers to
+    // (and the team is smaller), so there all receivers are dealt out round robin.
+    imtaphy::detail::StaticPartition partition(numSCMLinks, imtaphy::detail::StaticPartition::maxThreads());
+    bool linkHomes = !imtaphy::detail::StaticPartition::inParallelRegion();
+    receiveScheduler.clear();
+    receiveTaskBegin.clear();
+    interferersThisTTI = 0;
+    
+    for (unsigned int i = 0; i < receiveOrder.size(); i++)
     {
-        transmissionsThisReceiver = transmissionSetVector[i];
+        TransmissionPtr transmission = allCurrentTransmissions[receiveOrder[i]];
         
-        for (iter = transmissionsThisReceiver.begin(); iter != transmissionsThisReceiver.end(); iter++)
+        if ((i == 0) || (transmission->getDestination()->getReceiver() != allCurrentTransmissions[receiveOrder[i - 1]]->getDestination()->getReceiver()))
         {
-            transmission = *iter;
-            transmission->getDestination()->getReceiver()->receive(transmission);
+            unsigned int task = receiveTaskBegin.size();
+            imtaphy::Link* link = transmission->getLink();
+            unsigned int home = (linkHomes && link->isSCM()) ? partition.threadOf(link->getSCMlinkId()) : task % partition.getNumThreads();
+            
+            receiveTaskBegin.push_back(i);
+            receiveScheduler.addTask(0.0, home);
         }
+        
+        double cost = 0.0;
+        const imtaphy::interface::PrbPowerPrecodingMap& prbs = transmission->getPrbPowerPrecodingMap();
+        for (imtaphy::interface::PrbPowerPrecodingMap::const_iterator iter = prbs.begin(); iter != prbs.end(); iter++)
+            cost += transmissionsPerPRB[transmission->getDirection()][iter->first].size();
+        interferersThisTTI += static_cast<unsigned long int>(cost) - prbs.size();
+        
+        receiveScheduler.addCost(receiveTaskBegin.size() - 1, cost * transmission->getNumLayers());
     }
+    receiveTaskBegin.push_back(receiveOrder.size());
+    
+    // do the computation intensive part of the receiver operation in parallel
+    ReceiveTask worker(allCurrentTransmissions, receiveOrder, receiveTaskBegin);
+    receiveScheduler.run(worker);
+    
+    MESSAGE_SINGLE(VERBOSE, logger, "Received on " << receiveScheduler.getNumTasks() << " receivers with " << receiveScheduler.getNumThreads()
+                   << " threads, " << receiveScheduler.getSteals() << " stolen, load imbalance " << receiveScheduler.getImbalance() * 100.0 << "%");
 
+}
+
+void
+Channel::deliverAllReceptions()
+{
     // deliver the results of the previous step sequentially (single-threaded)
     // to avoid any race conditions (e.g. in the event scheduler)
+    TransmissionPtr transmission;
     for (unsigned int i = 0; i < allCurrentTransmissions.size(); i++)
     {
         transmission = allCurrentTransmissions[i];
@@ -325,7 +691,7 @@ Channel::computeShadowing(Link* link)
 {
     wns::Ratio shadowing = wns::Ratio::from_factor(1.0);
     
-    assure(lsCorrelation, "No valid LS correlation pointer");
+    assure(largeScaleParams, "No valid LS parameters pointer");
 
     if (largeScaleParams->find(link) != largeScaleParams->end())
             shadowing = wns::Ratio::from_factor((*largeScaleParams)[link].getShadowFading());
@@ -47,10 +47,13 @@
 #include <IMTAPHY/spatialChannel/SpatialChannelModelInterface.hpp>
 #include <IMTAPHY/Spectrum.hpp>
 #include <IMTAPHY/lsParams/LSCorrelation.hpp>
+#include <IMTAPHY/detail/WorkStealingScheduler.hpp>
+#include <WNS/probe/bus/ContextCollector.hpp>
 
 #include <WNS/pyconfig/View.hpp>
 
 #include <vector>
+#include <map>
 
 // this could be templated...
 #define SCMPRECISION float
@@ -59,6 +62,8 @@ namespace imtaphy {
   
     
     class LinkManager;
+    class StartupCache;
+    namespace tests { class ChannelStub; }
     //class StationPhy;
   
     class Channel :
@@ -66,6 +71,7 @@ namespace imtaphy {
             // IMTAphyObserver
             public wns::Subject<imtaphy::interface::IMTAphyObserver>
     {
+        friend class imtaphy::tests::ChannelStub;
     public:
         Channel();
         Channel(int dummy);// For unit testing
@@ -79,6 +85,19 @@ namespace imtaphy {
 
     
         const TransmissionVector& getTransmissionsOnPRB(Direction direction, imtaphy::interface::PRB prb) const;
+        
+        /**
+         * @brief Returns all transmissions on the PRB in registration (i.e., transmission id) order
+         * with their link end points, precoding and power for that PRB already resolved
+         */
+        const PRBTransmissionVector& getInterferenceIndexOnPRB(Direction direction, imtaphy::interface::PRB prb) const
+        {
+            assure(prb < interferenceIndex[direction].size(), "Invalid PRB.");
+            return interferenceIndex[direction][prb];
+        }
+        
+        // number of registered stations, StationPhy::getChannelIndex() is below this
+        unsigned int getNumStations() const {return baseStations.size() + mobileStations.size();}
     
         /**
          * @brief Returns the azimuth angle (in radians -Pi..Pi) as seen from
@@ -96,12 +115,27 @@ namespace imtaphy {
         wns::Ratio computeShadowing(imtaphy::Link* link);
     
         virtual void periodically();
+
+        /**
+         * @brief Logs the summary of the per-TTI timings and counters, only the first call has an effect
+         */
+        void onShutdown();
     
         LinkManager* getLinkManager() const;
         scm::SpatialChannelModelInterface<SCMPRECISION>* getSpatialChannelModel() const;
         Spectrum* getSpectrum() const;
+
+        /**
+         * @brief The cache configured via startupCacheDirectory, NULL if disabled
+         */
+        StartupCache* getStartupCache() const {return startupCache;}
         
         unsigned int getTTI() const {return tti;}
+
+        /**
+         * @brief True while the onNewTTI of the observers supporting it run concurrently, see parallelScheduling
+         */
+        bool isInParallelNewTTI() const {return inParallelNewTTI;}
         
         // functor to call the onNewTTI in the observing stationPhys
         struct OnNewTTI
@@ -134,6 +168,21 @@ namespace imtaphy {
         private:
             unsigned int tti;
         }; 
+
+        // functor to collect the observers, e.g., for notifying them in parallel
+        struct CollectObservers
+        {
+            CollectObservers(std::vector<imtaphy::interface::IMTAphyObserver*>& _observers):
+                observers(&_observers)
+            {}
+
+            void operator()(imtaphy::interface::IMTAphyObserver* observer)
+            {
+                observers->push_back(observer);
+            }
+        private:
+            std::vector<imtaphy::interface::IMTAphyObserver*>* observers;
+        };
   
     protected:
   
@@ -148,13 +197,24 @@ namespace imtaphy {
     
         Spectrum* spectrum;
         LinkManager* linkManager;
+        StartupCache* startupCache;
        
     
     private:
-        void evaluateAllTransmissions() const;
+        void receiveAllTransmissions();
+        void deliverAllReceptions();
+        void receiveAndEvolveNext();
+        void notifyNewTTI();
+        void initPipelinedEvolution(unsigned int evolutionThreads);
     
         std::vector<TransmissionsPerPRB> transmissionsPerPRB; 
+        std::vector<PRBTransmissionsPerPRB> interferenceIndex; // same layout, cleared with transmissionsPerPRB
         TransmissionVector allCurrentTransmissions;
+
+        // per-TTI receive scheduling, kept as members to reuse their memory
+        std::vector<unsigned int> receiveOrder;     // indices into allCurrentTransmissions sorted by receiver
+        std::vector<unsigned int> receiveTaskBegin; // receiver i gets receiveOrder[receiveTaskBegin[i]..receiveTaskBegin[i+1])
+        imtaphy::detail::WorkStealingScheduler receiveScheduler;
     
         // we assume PRBs are counted from 0..numberOfPRBs-1
         wns::pyconfig::View config;
@@ -163,6 +223,38 @@ namespace imtaphy {
         unsigned int tti;
         bool initialized;
         unsigned int transmissionIdCounter;
+        unsigned int itppSeed;
+
+        // evolve the SCM for the next TTI while receiving the current one
+        bool pipelined;
+        unsigned int pipelineEvolutionThreads;
+
+        // Schedule the cells in parallel: the onNewTTI of observers that support it runs concurrently.
+        // Transmissions registered during the notification are buffered per observer and registered
+        // in observer order afterwards, so the transmission ids are the same as in a sequential run.
+        bool parallelScheduling;
+        bool bufferingRegistrations;
+        bool inParallelNewTTI;
+        std::vector<imtaphy::interface::IMTAphyObserver*> newTTIobservers;
+        std::vector<unsigned int> parallelObservers;          // indices into newTTIobservers
+        std::vector<TransmissionVector> pendingRegistrations; // per entry of newTTIobservers
+        std::vector<unsigned int> observerOfThread;           // newTTIobservers index each thread is notifying
+
+        // Per-TTI instrumentation: wall time of the phases of periodically() and work counters, each
+        // published on the probe bus "imtaphy.channel.<name>" and summarized in onShutdown
+        struct TTIstatistic
+        {
+            TTIstatistic() : sum(0.0), max(0.0), count(0) {}
+            wns::probe::bus::ContextCollectorPtr probe;
+            double sum;
+            double max;
+            unsigned long int count;
+        };
+        void recordTTIstatistic(const std::string& name, double value);
+        std::map<std::string, TTIstatistic> ttiStatistics;
+        unsigned int numSCMLinks;
+        unsigned long int interferersThisTTI;
+        bool shutdown;
     
     };
       
@@ -42,7 +42,8 @@ Link::Link(StationPhy* bs_, StationPhy* ms_,
     propagation(propagation_),
     userLocation(userLocation_),
     outdoorPropagation(outdoorPropagation_),
-    channelMatrices(2) // uplink and downlink
+    channelMatrices(2), // uplink and downlink
+    lazyChannelModel(NULL)
 {
 }
 
@@ -65,6 +66,9 @@ namespace imtaphy {
                 channelMatrices[direction][prb] = scm->getChannelMatrix(this, static_cast<imtaphy::Direction>(direction), prb);
             }
         }
+
+        if (isSCM() && scm->transformsLazily())
+            lazyChannelModel = scm;
     }
 
     template <> void Link::initComplexFloatChannelMatrices<double>(imtaphy::Spectrum* spectrum,
@@ -61,7 +61,7 @@ namespace imtaphy {
                 
         static const int NonSCMLink = -1;
 
-        Link() {};
+        Link() : lazyChannelModel(NULL) {};
         
         Link(StationPhy* bs, StationPhy* ms, 
              Scenario scenario, Propagation propagation, Propagation outdoorPropagation,
@@ -122,6 +122,9 @@ namespace imtaphy {
         {
             assure(prb < channelMatrices[direction].size(), "Invalid PRB requested");
 
+            if (lazyChannelModel)
+                lazyChannelModel->materializeChannel(scmLinkId, direction);
+
             return channelMatrices[direction][prb]->data();
         }
 
@@ -129,6 +132,9 @@ namespace imtaphy {
         {
             assure(prb < channelMatrices[direction].size(), "Invalid PRB requested");
 
+            if (lazyChannelModel)
+                lazyChannelModel->materializeChannel(scmLinkId, direction);
+
             return channelMatrices[direction][prb];
         }
 
@@ -161,6 +167,9 @@ namespace imtaphy {
         wns::Ratio shadowing;
 
         std::vector<std::vector<imtaphy::detail::ComplexFloatMatrixPtr> > channelMatrices;
+
+        // only set if the channel model computes the channel matrices on demand
+        imtaphy::scm::SpatialChannelModelInterface<float>* lazyChannelModel;
     };
     
     
@@ -60,7 +60,8 @@ StationPhy::StationPhy(wns::node::Interface* node, const wns::pyconfig::View& co
     position(wns::Position(config.get("position"))),
     directionOfTravel(config.get<double>("directionOfTravel")),
     speed(config.get<double>("speed")),
-    stationID(node->getNodeID()) // nodes have unique ids that are uniquely assigned by openwns.node.Node class in Python
+    stationID(node->getNodeID()), // nodes have unique ids that are uniquely assigned by openwns.node.Node class in Python
+    channelIndex(0)
 {
     assure((directionOfTravel <= itpp::pi + 0.0001) && (directionOfTravel >= -itpp::pi - 0.0001), "Direction of travel should be between -Pi..Pi"); 
     
@@ -114,6 +115,9 @@ void
 StationPhy::onShutdown()
 {
     receiver->onShutdown();
+
+    // only the first station's call has an effect
+    channel->onShutdown();
 }
 
 void
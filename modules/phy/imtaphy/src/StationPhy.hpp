@@ -54,6 +54,10 @@ namespace imtaphy {
     namespace receivers {
         class ReceiverInterface;
     }
+
+    namespace tests {
+        class StationPhyStub;
+    }
     
     typedef std::list<StationPhy*> StationList;
     
@@ -65,6 +69,7 @@ namespace imtaphy {
         
             // The PositionableInterface
     {
+        friend class imtaphy::tests::StationPhyStub;
     public:
         
         StationPhy(wns::node::Interface* node, const wns::pyconfig::View& pyco);
@@ -101,6 +106,13 @@ namespace imtaphy {
         
         unsigned int getStationID() const {return stationID;}
         
+        /**
+         * @brief Dense index 0..numStations-1 assigned by the channel on registration, used to
+         * address per-station tables without tree lookups
+         */
+        unsigned int getChannelIndex() const {return channelIndex;}
+        void setChannelIndex(unsigned int index) {channelIndex = index;}
+        
         /**
          * @brief Returns the absolute value of the mobile's speed in m/s
          */
@@ -144,6 +156,7 @@ namespace imtaphy {
         imtaphy::Direction transmitDirection;
         
         unsigned int stationID;
+        unsigned int channelIndex;
         
     };
     
@@ -106,6 +106,19 @@ namespace imtaphy {
     typedef std::vector<TransmissionPtr> TransmissionVector; 
     typedef std::vector<TransmissionVector> TransmissionsPerPRB;
 
+    // Dense per-PRB view of a transmission with everything a receiver needs to treat it as an
+    // interferer, resolved once in Channel::registerTransmission instead of per receiver and PRB
+    struct PRBTransmission
+    {
+        TransmissionPtr transmission;
+        unsigned int sourceIndex; // StationPhy::getChannelIndex() of the transmitting station
+        imtaphy::StationPhy* bs; // base station end of the transmission's link
+        imtaphy::detail::ComplexFloatMatrix* precoding; // owned by the transmission
+        float txPower_mW;
+    };
+    typedef std::vector<PRBTransmission> PRBTransmissionVector;
+    typedef std::vector<PRBTransmissionVector> PRBTransmissionsPerPRB;
+
 }
 #endif
 
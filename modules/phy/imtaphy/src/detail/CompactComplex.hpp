@@ -0,0 +1,174 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef IMTAPHY_DETAIL_COMPACTCOMPLEX_HPP
+#define IMTAPHY_DETAIL_COMPACTCOMPLEX_HPP
+
+#include <boost/cstdint.hpp>
+#include <complex>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace imtaphy { namespace detail {
+
+    // Reduced-precision storage formats for large arrays of complex coefficients that are written once
+    // and read often (e.g. the M2135 time-invariant factors). Both formats need 4 bytes per complex value
+    // instead of 8 (float) or 16 (double) and decode with cheap, branch-free arithmetic only.
+
+    // IEEE 754 binary16 ("half precision") conversion with round-to-nearest-even, incl. subnormals
+    inline boost::uint16_t
+    floatToHalf(float value)
+    {
+        boost::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        boost::uint16_t sign = static_cast<boost::uint16_t>((bits >> 16) & 0x8000);
+        int floatExponent = static_cast<int>((bits >> 23) & 0xff);
+        int exponent = floatExponent - 127 + 15;
+        boost::uint32_t mantissa = bits & 0x007fffff;
+
+        if (floatExponent == 0xff) // Inf / NaN
+            return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+
+        if (exponent >= 31) // overflow -> Inf
+            return sign | 0x7c00;
+
+        if (exponent <= 0)
+        {
+            if (exponent < -10) // underflow -> signed zero
+                return sign;
+
+            // subnormal half: add the implicit leading one and shift into place
+            mantissa |= 0x00800000;
+            int shift = 14 - exponent;
+            boost::uint32_t halfMantissa = mantissa >> shift;
+            boost::uint32_t remainder = mantissa & ((1u << shift) - 1);
+            boost::uint32_t halfway = 1u << (shift - 1);
+            if ((remainder > halfway) || ((remainder == halfway) && (halfMantissa & 1)))
+                halfMantissa++;
+            return sign | static_cast<boost::uint16_t>(halfMantissa);
+        }
+
+        boost::uint16_t half = sign | static_cast<boost::uint16_t>(exponent << 10) | static_cast<boost::uint16_t>(mantissa >> 13);
+        boost::uint32_t remainder = mantissa & 0x1fff;
+        // a carry into the exponent is the correct rounding result
+        if ((remainder > 0x1000) || ((remainder == 0x1000) && (half & 1)))
+            half++;
+        return half;
+    }
+
+    inline float
+    halfToFloat(boost::uint16_t half)
+    {
+        boost::uint32_t sign = static_cast<boost::uint32_t>(half & 0x8000) << 16;
+        int exponent = (half >> 10) & 0x1f;
+        boost::uint32_t mantissa = half & 0x3ff;
+        boost::uint32_t bits;
+
+        if (exponent == 0)
+        {
+            if (mantissa == 0)
+                bits = sign;
+            else
+            {
+                // subnormal half: normalize for the float representation
+                exponent = 1;
+                while (!(mantissa & 0x400))
+                {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                mantissa &= 0x3ff;
+                bits = sign | (static_cast<boost::uint32_t>(exponent + 127 - 15) << 23) | (mantissa << 13);
+            }
+        }
+        else if (exponent == 31)
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        else
+            bits = sign | (static_cast<boost::uint32_t>(exponent + 127 - 15) << 23) | (mantissa << 13);
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // in: n complex values, out: 2n halfs (real, imag interleaved)
+    template <typename PRECISION>
+    inline void
+    encodeHalf(const std::complex<PRECISION>* in, unsigned int n, boost::uint16_t* out)
+    {
+        for (unsigned int i = 0; i < n; i++)
+        {
+            out[2 * i] = floatToHalf(static_cast<float>(in[i].real()));
+            out[2 * i + 1] = floatToHalf(static_cast<float>(in[i].imag()));
+        }
+    }
+
+    // in: 2n halfs, out: 2n PRECISION values (real, imag interleaved like std::complex)
+    template <typename PRECISION>
+    inline void
+    decodeHalf(const boost::uint16_t* in, unsigned int n, PRECISION* out)
+    {
+        for (unsigned int i = 0; i < 2 * n; i++)
+            out[i] = static_cast<PRECISION>(halfToFloat(in[i]));
+    }
+
+    // Block floating point: real and imaginary parts of a block of n values are stored as 16 bit fixed-point
+    // numbers relative to the largest magnitude in the block. Returns the scale needed for decoding.
+    template <typename PRECISION>
+    inline float
+    encodeQuantized(const std::complex<PRECISION>* in, unsigned int n, boost::int16_t* out)
+    {
+        PRECISION maxValue = 0.0;
+        for (unsigned int i = 0; i < n; i++)
+            maxValue = std::max(maxValue, std::max(std::fabs(in[i].real()), std::fabs(in[i].imag())));
+
+        float scale = static_cast<float>(maxValue) / 32767.0f;
+        PRECISION inverse = (maxValue > 0.0) ? static_cast<PRECISION>(32767.0) / maxValue : static_cast<PRECISION>(0.0);
+
+        for (unsigned int i = 0; i < n; i++)
+        {
+            out[2 * i] = static_cast<boost::int16_t>(floor(in[i].real() * inverse + 0.5));
+            out[2 * i + 1] = static_cast<boost::int16_t>(floor(in[i].imag() * inverse + 0.5));
+        }
+        return scale;
+    }
+
+    template <typename PRECISION>
+    inline void
+    decodeQuantized(const boost::int16_t* in, float scale, unsigned int n, PRECISION* out)
+    {
+        for (unsigned int i = 0; i < 2 * n; i++)
+            out[i] = static_cast<PRECISION>(in[i]) * static_cast<PRECISION>(scale);
+    }
+
+}}
+
+#endif
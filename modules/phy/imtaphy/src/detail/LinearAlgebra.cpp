@@ -65,12 +65,12 @@ namespace imtaphy { namespace detail {
          // for detailed example please have a look at the following link
          // http://software.intel.com/sites/products/documentation/hpc/mkl/lapack/mkl_lapack_examples/cgesvd_ex.c.htm/
          
-         MKL_INT m = A.getRows();
-         MKL_INT n = A.getColumns();
+         lapack_int m = A.getRows();
+         lapack_int n = A.getColumns();
          
-         MKL_INT lda = m; // should be m according to the manual
-         MKL_INT ldu = m;
-         MKL_INT ldvt = n;
+         lapack_int lda = m; // should be m according to the manual
+         lapack_int ldu = m;
+         lapack_int ldvt = n;
          int minDim = m;
          int sizeNull = n - m; // size of null space
          
@@ -94,19 +94,19 @@ namespace imtaphy { namespace detail {
          // allocate the U, S, V matrices
          MKLMatrix<std::complex<float> > U(m, m);
          
-         float* S = static_cast<float*>(mkl_malloc(sizeof(float) * minDim, 32));
+         float* S = static_cast<float*>(alignedMalloc(sizeof(float) * minDim, 32));
          
          MKLMatrix<std::complex<float> > V(n, n);
          
          // According to MKL docs:
          // lwork >= 2*min(m, n) + max(m, n) (for complex flavors).
          // For good performance, lwork must generally be larger.
-         MKL_INT lwork = (2*m + n) * 10; // big enough!?
-         std::complex<float>* work = static_cast<std::complex<float>*>(mkl_malloc(sizeof(std::complex<float>) * lwork, 32 ));
+         lapack_int lwork = (2*m + n) * 10; // big enough!?
+         std::complex<float>* work = static_cast<std::complex<float>*>(alignedMalloc(sizeof(std::complex<float>) * lwork, 32 ));
          
          // Workspace array, DIMENSION at least max(1, 5*min(m, n)). Used in complex flavors only.
-         float* rwork = static_cast<float*>(mkl_malloc(sizeof(float) * 10 * 5 * minDim, 32)); // how dows cgesvd know about this size?
-         MKL_INT info = 0;
+         float* rwork = static_cast<float*>(alignedMalloc(sizeof(float) * 10 * 5 * minDim, 32)); // how dows cgesvd know about this size?
+         lapack_int info = 0;
          
          // CGESVD computes the singular value decomposition (SVD) of a complex M-by-N matrix A, optionally
          // computing the left and/or right singular vectors. The SVD is written
@@ -158,10 +158,10 @@ namespace imtaphy { namespace detail {
          //       bidiagonal form B did not converge to zero. See the description of  RWORK above for details.
          );
          
-         MKL_free(work);
-         MKL_free(rwork);
+         alignedFree(work);
+         alignedFree(rwork);
          
-         MKL_free(S);
+         alignedFree(S);
          if (info > 0)
          {
              std::cout << "The algorithm for computing SVD failed to converge\n";
@@ -42,16 +42,7 @@
 #include <boost/multi_array.hpp>
 
 
-//#ifdef MKL
-// from the MKL user guide:
-#define MKL_Complex8 std::complex<float>
-#define MKL_Complex16 std::complex<double>
-#include <mkl_vml_functions.h>
-#include <mkl_service.h>
-#include <mkl_cblas.h>
-#include <mkl_vml_defines.h>
-#include <mkl_lapacke.h>
-#include <mkl.h>
+#include <IMTAPHY/detail/MathBackend.hpp>
 
 #include <boost/random.hpp>
 #include <boost/smart_ptr.hpp>
@@ -66,13 +57,13 @@ namespace imtaphy { namespace detail {
     {                
     public:
         MKLMatrix() :
-         boost::multi_array_ref<T, 2>(static_cast<T*>(mkl_malloc(sizeof(T) * 1, 32)), boost::extents[1][1])
+         boost::multi_array_ref<T, 2>(static_cast<T*>(alignedMalloc(sizeof(T) * 1, 32)), boost::extents[1][1])
         {
             assure(0, "Do not use the default constructor");
         }
         inline
         MKLMatrix(unsigned int rows_, unsigned int columns_) :
-            boost::multi_array_ref<T, 2>(static_cast<T*>(mkl_malloc(sizeof(T) * rows_ * columns_, 32)), boost::extents[rows_][columns_]),
+            boost::multi_array_ref<T, 2>(static_cast<T*>(alignedMalloc(sizeof(T) * rows_ * columns_, 32)), boost::extents[rows_][columns_]),
             external(false)
         {
             assure(rows_, "Number of rows must be positive");
@@ -97,13 +88,13 @@ namespace imtaphy { namespace detail {
             if (!external)
             {
                 assure(this->data(), "Trying to free null pointer");
-                mkl_free(this->data());
+                alignedFree(this->data());
             }
         }
         
         inline
         MKLMatrix(const MKLMatrix& copy) :
-            boost::multi_array_ref<T, 2>(static_cast<T*>(mkl_malloc(sizeof(T) * copy.getRows() * copy.getColumns(), 32)), boost::extents[copy.getRows()][copy.getColumns()]),
+            boost::multi_array_ref<T, 2>(static_cast<T*>(alignedMalloc(sizeof(T) * copy.getRows() * copy.getColumns(), 32)), boost::extents[copy.getRows()][copy.getColumns()]),
             external(false)
         {
             memcpy(this->data(), copy.data(), sizeof(T)* copy.getRows() * copy.getColumns());
@@ -113,6 +104,14 @@ namespace imtaphy { namespace detail {
         inline unsigned int getColumns() const {return this->shape()[1];}
         inline T* getLocation() const {return const_cast<T*>(this->data());}
 
+        // lets a matrix constructed on external memory point to another location of the same shape
+        inline void relocate(T* location)
+        {
+            assure(external, "Only matrices on external memory can be relocated");
+            assure(location, "Cannot point to null");
+            this->set_base_ptr(location);
+        }
+
     private:
         bool external;
     };
@@ -305,7 +304,7 @@ namespace imtaphy { namespace detail {
 
     
     template <typename PRECISION>
-    MKL_INT pseudoInverse(MKLMatrix<std::complex<PRECISION> >&  A,
+    lapack_int pseudoInverse(MKLMatrix<std::complex<PRECISION> >&  A,
                        MKLMatrix<std::complex<PRECISION> >& inverse)
     {
         assure(A.getColumns() == inverse.getRows(), "Number of columns of A must be equal to number of rows of inverse");
@@ -323,7 +322,7 @@ namespace imtaphy { namespace detail {
                wns::SingletonHolder<Identity<std::complex<PRECISION> > >::Instance().get(maxDim)->getLocation(), 
                sizeof(std::complex<PRECISION>) * maxDim * maxDim);
         
-        PRECISION* singularValues = static_cast<PRECISION*>(mkl_malloc(sizeof(PRECISION) * maxDim, 32));
+        PRECISION* singularValues = static_cast<PRECISION*>(alignedMalloc(sizeof(PRECISION) * maxDim, 32));
         
         lapack_int rank;
         
@@ -359,7 +358,7 @@ namespace imtaphy { namespace detail {
             }
         }
 
-        mkl_free(singularValues);
+        alignedFree(singularValues);
         
         if (status != 0)
             std::cout << "Problem with pinv, status=" << status << "\n";
@@ -733,12 +732,12 @@ namespace imtaphy { namespace detail {
             // for detailed example please have a look at the following link
             // http://software.intel.com/sites/products/documentation/hpc/mkl/lapack/mkl_lapack_examples/cgesvd_ex.c.htm/
             
-        MKL_INT m = A.getRows();
-        MKL_INT n = A.getColumns();
+        lapack_int m = A.getRows();
+        lapack_int n = A.getColumns();
         
-        MKL_INT lda = m; // should be m according to the manual
-        MKL_INT ldu = m;
-        MKL_INT ldvt = n;
+        lapack_int lda = m; // should be m according to the manual
+        lapack_int ldu = m;
+        lapack_int ldvt = n;
         int minDim = m;
         
         // First we need to take the hermitian of matrix A, because the cgesvd() function reads the matrix in column-major mode.
@@ -755,12 +754,12 @@ namespace imtaphy { namespace detail {
         // According to MKL docs:
         // lwork >= 2*min(m, n) + max(m, n) (for complex flavors).
         // For good performance, lwork must generally be larger.
-        MKL_INT lwork = (2*m + n) * 10; // big enough!?
-        std::complex<PRECISION>* work = static_cast<std::complex<float>*>(mkl_malloc(sizeof(std::complex<float>) * lwork, 32 ));
+        lapack_int lwork = (2*m + n) * 10; // big enough!?
+        std::complex<PRECISION>* work = static_cast<std::complex<float>*>(alignedMalloc(sizeof(std::complex<float>) * lwork, 32 ));
         
         // Workspace array, DIMENSION at least max(1, 5*min(m, n)). Used in complex flavors only.
-        PRECISION* rwork = static_cast<float*>(mkl_malloc(sizeof(float) * 10 * 5 * minDim, 32)); // how dows cgesvd know about this size?
-        MKL_INT info = 0;
+        PRECISION* rwork = static_cast<float*>(alignedMalloc(sizeof(float) * 10 * 5 * minDim, 32)); // how dows cgesvd know about this size?
+        lapack_int info = 0;
         
         // CGESVD computes the singular value decomposition (SVD) of a complex M-by-N matrix A, optionally
         // computing the left and/or right singular vectors. The SVD is written
@@ -812,8 +811,8 @@ namespace imtaphy { namespace detail {
                 //       bidiagonal form B did not converge to zero. See the description of  RWORK above for details.
         );
         
-        MKL_free(work);
-        MKL_free(rwork);
+        alignedFree(work);
+        alignedFree(rwork);
         
         if (info > 0)
         {
@@ -840,12 +839,12 @@ namespace imtaphy { namespace detail {
             // for detailed example please have a look at the following link
             // http://software.intel.com/sites/products/documentation/hpc/mkl/lapack/mkl_lapack_examples/cgesvd_ex.c.htm/
             
-        MKL_INT m = A.getRows();
-        MKL_INT n = A.getColumns();
+        lapack_int m = A.getRows();
+        lapack_int n = A.getColumns();
         
-        MKL_INT lda = m; // should be m according to the manual
-        MKL_INT ldu = m;
-        MKL_INT ldvt = n;
+        lapack_int lda = m; // should be m according to the manual
+        lapack_int ldu = m;
+        lapack_int ldvt = n;
         int minDim = m;
         
         // First we need to take the hermitian of matrix A, because the cgesvd() function reads the matrix in column-major mode.
@@ -861,12 +860,12 @@ namespace imtaphy { namespace detail {
         // According to MKL docs:
         // lwork >= 2*min(m, n) + max(m, n) (for complex flavors).
         // For good performance, lwork must generally be larger.
-        MKL_INT lwork = (2*m + n) * 10; // big enough!?
-        std::complex<PRECISION>* work = static_cast<std::complex<float>*>(mkl_malloc(sizeof(std::complex<float>) * lwork, 32 ));
+        lapack_int lwork = (2*m + n) * 10; // big enough!?
+        std::complex<PRECISION>* work = static_cast<std::complex<float>*>(alignedMalloc(sizeof(std::complex<float>) * lwork, 32 ));
         
         // Workspace array, DIMENSION at least max(1, 5*min(m, n)). Used in complex flavors only.
-        PRECISION* rwork = static_cast<float*>(mkl_malloc(sizeof(float) * 10 * 5 * minDim, 32)); // how dows cgesvd know about this size?
-        MKL_INT info = 0;
+        PRECISION* rwork = static_cast<float*>(alignedMalloc(sizeof(float) * 10 * 5 * minDim, 32)); // how dows cgesvd know about this size?
+        lapack_int info = 0;
         
         // CGESVD computes the singular value decomposition (SVD) of a complex M-by-N matrix A, optionally
         // computing the left and/or right singular vectors. The SVD is written
@@ -918,8 +917,8 @@ namespace imtaphy { namespace detail {
                 //       bidiagonal form B did not converge to zero. See the description of  RWORK above for details.
         );
         
-        MKL_free(work);
-        MKL_free(rwork);
+        alignedFree(work);
+        alignedFree(rwork);
         
         if (info > 0)
         {
@@ -947,12 +946,12 @@ namespace imtaphy { namespace detail {
             // for detailed example please have a look at the following link
             // http://software.intel.com/sites/products/documentation/hpc/mkl/lapack/mkl_lapack_examples/cgesvd_ex.c.htm/
             
-        MKL_INT m = A.getRows();
-        MKL_INT n = A.getColumns();
+        lapack_int m = A.getRows();
+        lapack_int n = A.getColumns();
         
-        MKL_INT lda = m; // should be m according to the manual
-        MKL_INT ldu = m;
-        MKL_INT ldvt = n;
+        lapack_int lda = m; // should be m according to the manual
+        lapack_int ldu = m;
+        lapack_int ldvt = n;
         int minDim = m;
         
         // First we need to take the hermitian of matrix A, because the cgesvd() function reads the matrix in column-major mode.
@@ -968,12 +967,12 @@ namespace imtaphy { namespace detail {
         // According to MKL docs:
         // lwork >= 2*min(m, n) + max(m, n) (for complex flavors).
         // For good performance, lwork must generally be larger.
-        MKL_INT lwork = (2*m + n) * 10; // big enough!?
-        std::complex<PRECISION>* work = static_cast<std::complex<float>*>(mkl_malloc(sizeof(std::complex<float>) * lwork, 32 ));
+        lapack_int lwork = (2*m + n) * 10; // big enough!?
+        std::complex<PRECISION>* work = static_cast<std::complex<float>*>(alignedMalloc(sizeof(std::complex<float>) * lwork, 32 ));
         
         // Workspace array, DIMENSION at least max(1, 5*min(m, n)). Used in complex flavors only.
-        PRECISION* rwork = static_cast<float*>(mkl_malloc(sizeof(float) * 10 * 5 * minDim, 32)); // how dows cgesvd know about this size?
-        MKL_INT info = 0;
+        PRECISION* rwork = static_cast<float*>(alignedMalloc(sizeof(float) * 10 * 5 * minDim, 32)); // how dows cgesvd know about this size?
+        lapack_int info = 0;
         
         // CGESVD computes the singular value decomposition (SVD) of a complex M-by-N matrix A, optionally
         // computing the left and/or right singular vectors. The SVD is written
@@ -1025,8 +1024,8 @@ namespace imtaphy { namespace detail {
                 //       bidiagonal form B did not converge to zero. See the description of  RWORK above for details.
         );
         
-        MKL_free(work);
-        MKL_free(rwork);
+        alignedFree(work);
+        alignedFree(rwork);
         
         matrixHermitian<PRECISION>(tempU, U);
         if (info > 0)
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef IMTAPHY_DETAIL_MATHBACKEND_HPP
+#define IMTAPHY_DETAIL_MATHBACKEND_HPP
+
+// This header hides which BLAS/LAPACK/VML implementation IMTAphy is built against.
+// The backend is chosen at build time (scons mathBackend=mkl|openblas) which results
+// in either the MKL or the OPENBLAS preprocessor symbol being defined.
+// Everything else (LinearAlgebra, M2135, ...) should only include this header and
+// use the standard CBLAS/LAPACKE interfaces or the helpers below.
+
+#include <complex>
+#include <cstdlib>
+
+#if defined(MKL)
+
+// from the MKL user guide:
+#define MKL_Complex8 std::complex<float>
+#define MKL_Complex16 std::complex<double>
+#include <mkl_vml_functions.h>
+#include <mkl_service.h>
+#include <mkl_cblas.h>
+#include <mkl_vml_defines.h>
+#include <mkl_lapacke.h>
+#include <mkl.h>
+
+#elif defined(OPENBLAS)
+
+// LAPACKE allows to override its complex types, we want the C++ ones so that
+// we can pass std::complex<> pointers without casting
+#define lapack_complex_float std::complex<float>
+#define lapack_complex_double std::complex<double>
+#include <cblas.h>
+#include <lapacke.h>
+
+#else
+#error "No math backend selected: define either MKL or OPENBLAS (see SConscript)"
+#endif
+
+namespace imtaphy { namespace detail {
+
+    inline const char*
+    mathBackendName()
+    {
+#ifdef MKL
+        return "MKL";
+#else
+        return "OpenBLAS";
+#endif
+    }
+
+    // Aligned allocation for all big arrays and matrices. MKL recommends at least
+    // 16 (better 32) byte alignment to get identical results in parallel runs and
+    // the SIMD kernels profit from it as well.
+    inline void*
+    alignedMalloc(size_t bytes, int alignment)
+    {
+#ifdef MKL
+        return mkl_malloc(bytes, alignment);
+#else
+        void* ptr = NULL;
+        if (posix_memalign(&ptr, alignment, bytes) != 0)
+            return NULL;
+        return ptr;
+#endif
+    }
+
+    inline void
+    alignedFree(void* ptr)
+    {
+#ifdef MKL
+        mkl_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+
+#ifdef OPENBLAS
+    // MKL offers the Fortran LAPACK routines with C linkage and without the trailing
+    // underscore. To keep the (column-major) call sites identical, provide the same
+    // signature on top of the LAPACKE "work" interface, which does not allocate.
+    inline void
+    cgesvd(const char* jobu, const char* jobvt, const lapack_int* m, const lapack_int* n,
+           std::complex<float>* a, const lapack_int* lda, float* s,
+           std::complex<float>* u, const lapack_int* ldu,
+           std::complex<float>* vt, const lapack_int* ldvt,
+           std::complex<float>* work, const lapack_int* lwork, float* rwork, lapack_int* info)
+    {
+        *info = LAPACKE_cgesvd_work(LAPACK_COL_MAJOR, jobu[0], jobvt[0], *m, *n, a, *lda, s,
+                                    u, *ldu, vt, *ldvt, work, *lwork, rwork);
+    }
+#endif
+
+}}
+
+#endif
@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef IMTAPHY_DETAIL_SINCOS_HPP
+#define IMTAPHY_DETAIL_SINCOS_HPP
+
+#include <complex>
+#include <cmath>
+#include <algorithm>
+
+namespace imtaphy { namespace detail {
+
+    // Portable replacement for MKL's VML v?CIS functions that compute exp(j*a) = cos(a) + j*sin(a)
+    // for whole vectors. This is based on the well-known Cephes sin/cos implementation: the argument
+    // is reduced to [-pi/4, pi/4] by an extended precision (Cody-Waite) subtraction of the nearest
+    // multiple of pi/2 and then both sine and cosine are evaluated via minimax polynomials.
+    // The loop body has no branches and no table lookups so that the compiler can vectorize it
+    // for whatever SIMD instruction set the target has (SSE/AVX, NEON, VSX...) at -O3.
+    //
+    // Accuracy: float is within a few ulp for |a| < 8192, double within 1-2 ulp for |a| < 2^30.
+    // Beyond that the range reduction loses precision (as does the float argument itself).
+
+    template <typename T>
+    struct SinCosCoefficients;
+
+    template <>
+    struct SinCosCoefficients<float>
+    {
+        static float fourOverPi() {return 1.27323954473516f;}
+
+        // pi/4 split into three parts for the extended precision range reduction
+        static float DP1() {return 0.78515625f;}
+        static float DP2() {return 2.4187564849853515625e-4f;}
+        static float DP3() {return 3.77489497744594108e-8f;}
+
+        static float sinPoly(float zz)
+        {
+            return (-1.9515295891e-4f * zz + 8.3321608736e-3f) * zz - 1.6666654611e-1f;
+        }
+        static float cosPoly(float zz)
+        {
+            return (2.443315711809948e-5f * zz - 1.388731625493765e-3f) * zz + 4.166664568298827e-2f;
+        }
+    };
+
+    template <>
+    struct SinCosCoefficients<double>
+    {
+        static double fourOverPi() {return 1.27323954473516268615;}
+
+        static double DP1() {return 7.85398125648498535156e-1;}
+        static double DP2() {return 3.77489470793079817668e-8;}
+        static double DP3() {return 2.69515142907905952645e-15;}
+
+        static double sinPoly(double zz)
+        {
+            return (((((1.58962301576546568060e-10 * zz - 2.50507477628578072866e-8) * zz
+                       + 2.75573136213857245213e-6) * zz - 1.98412698295895385996e-4) * zz
+                     + 8.33333333332211858878e-3) * zz - 1.66666666666666307295e-1);
+        }
+        static double cosPoly(double zz)
+        {
+            return (((((-1.13585365213876817300e-11 * zz + 2.08757008419747316778e-9) * zz
+                       - 2.75573141792967388112e-7) * zz + 2.48015872888517045348e-5) * zz
+                     - 1.38888888888730564116e-3) * zz + 4.16666666666665929218e-2);
+        }
+    };
+
+    template <typename T>
+    inline void
+    sinCos(T x, T& sine, T& cosine)
+    {
+        typedef SinCosCoefficients<T> C;
+
+        T ax = std::fabs(x);
+
+        // index of the octant, rounded up to the next even number so that the reduced
+        // argument lies within [-pi/4, pi/4]
+        int j = static_cast<int>(ax * C::fourOverPi());
+        j = (j + 1) & ~1;
+        T y = static_cast<T>(j);
+
+        T z = ((ax - y * C::DP1()) - y * C::DP2()) - y * C::DP3();
+        T zz = z * z;
+
+        T s = z + z * zz * C::sinPoly(zz);
+        T c = static_cast<T>(1.0) - static_cast<T>(0.5) * zz + zz * zz * C::cosPoly(zz);
+
+        // quadrant 0..3 decides whether sine and cosine swap and which signs they get
+        int quadrant = (j >> 1) & 3;
+        bool swap = quadrant & 1;
+        T sinSign = (quadrant & 2) ? static_cast<T>(-1.0) : static_cast<T>(1.0);
+        T cosSign = ((quadrant + 1) & 2) ? static_cast<T>(-1.0) : static_cast<T>(1.0);
+        // sin(-x) = -sin(x), cos(-x) = cos(x)
+        T argSign = (x < static_cast<T>(0.0)) ? static_cast<T>(-1.0) : static_cast<T>(1.0);
+
+        sine = argSign * sinSign * (swap ? c : s);
+        cosine = cosSign * (swap ? s : c);
+    }
+
+    // y[i] = cos(a[i]) + j*sin(a[i]) for i = 0..n-1, same semantics as vcCIS / vzCIS
+    template <typename T>
+    inline void
+    vectorCis(const int n, const T* a, std::complex<T>* y)
+    {
+        // std::complex<T> is guaranteed to be layout-compatible with T[2] (real, imag)
+        T* out = reinterpret_cast<T*>(y);
+
+        // work on small blocks with separate sine/cosine buffers: the interleaved
+        // (real, imag) output would otherwise keep the compiler from vectorizing
+        const int BlockSize = 64;
+        T sines[BlockSize];
+        T cosines[BlockSize];
+
+        for (int start = 0; start < n; start += BlockSize)
+        {
+            int len = std::min(BlockSize, n - start);
+            const T* in = a + start;
+
+            for (int i = 0; i < len; i++)
+                sinCos<T>(in[i], sines[i], cosines[i]);
+
+            T* block = out + 2 * start;
+            for (int i = 0; i < len; i++)
+            {
+                block[2 * i] = cosines[i];
+                block[2 * i + 1] = sines[i];
+            }
+        }
+    }
+
+}}
+
+#endif
@@ -0,0 +1,254 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef IMTAPHY_DETAIL_SMALLMATRIX_HPP
+#define IMTAPHY_DETAIL_SMALLMATRIX_HPP
+
+#include <IMTAPHY/detail/LinearAlgebra.hpp>
+#include <complex>
+
+namespace imtaphy { namespace detail {
+
+    // Fixed-capacity matrix for the per-PRB temporaries of the receiver chain. Up to MAXDIM x MAXDIM
+    // the entries live inside the object, so declaring one on the stack does not touch the heap;
+    // bigger matrices (more than 8 antennas) fall back to an aligned heap block. The MKLMatrix view
+    // onto that storage makes it a drop-in argument for every routine in LinearAlgebra.hpp.
+    template <typename T, unsigned int MAXDIM = 8>
+    class SmallMatrix
+    {
+    public:
+        static const unsigned int maxDim = MAXDIM;
+
+        inline
+        SmallMatrix(unsigned int rows_, unsigned int columns_) :
+            view(rows_, columns_, fits(rows_, columns_) ? storage : static_cast<T*>(alignedMalloc(sizeof(T) * rows_ * columns_, 32)))
+        {
+        }
+
+        inline
+        ~SmallMatrix()
+        {
+            if (view.getLocation() != storage)
+                alignedFree(view.getLocation());
+        }
+
+        static bool fits(unsigned int rows_, unsigned int columns_) {return (rows_ <= MAXDIM) && (columns_ <= MAXDIM);}
+
+        inline MKLMatrix<T>& matrix() {return view;}
+        inline operator MKLMatrix<T>&() {return view;}
+
+        inline unsigned int getRows() const {return view.getRows();}
+        inline unsigned int getColumns() const {return view.getColumns();}
+        inline T* getLocation() const {return view.getLocation();}
+
+        // row access without going through the multi_array machinery
+        inline T* operator[](unsigned int row) {return view.getLocation() + row * view.getColumns();}
+
+    private:
+        // the view points into our own storage, so copies would alias
+        SmallMatrix(const SmallMatrix&);
+        SmallMatrix& operator=(const SmallMatrix&);
+
+        T storage[MAXDIM * MAXDIM];
+        MKLMatrix<T> view;
+    };
+
+    typedef SmallMatrix<std::complex<float> > SmallComplexFloatMatrix;
+    typedef SmallMatrix<float> SmallFloatMatrix;
+
+    // Kernels for the tiny products of the receiver chain. The joint dimension P is a template
+    // parameter so that the inner loop is fully unrolled for 1, 2, 4 and 8 antennas/layers; P = 0
+    // takes the joint dimension from the run-time argument instead. The complex products are
+    // spelled out on real and imaginary parts, which avoids the NaN/Inf recovery path (__mulsc3)
+    // that std::complex::operator* has to take without -ffast-math.
+    template <typename PRECISION, unsigned int P>
+    struct SmallMatrixKernel
+    {
+        typedef std::complex<PRECISION> Complex;
+
+        // C (m-by-n) = A (m-by-p) * B (p-by-n)
+        static void
+        multiply(Complex* C, const Complex* A, const Complex* B, unsigned int m, unsigned int n, unsigned int p)
+        {
+            const unsigned int joint = P ? P : p;
+
+            for (unsigned int i = 0; i < m; i++, A += joint, C += n)
+                for (unsigned int j = 0; j < n; j++)
+                {
+                    PRECISION re = 0, im = 0;
+                    for (unsigned int k = 0; k < joint; k++)
+                    {
+                        const Complex& a = A[k];
+                        const Complex& b = B[k * n + j];
+                        re += a.real() * b.real() - a.imag() * b.imag();
+                        im += a.real() * b.imag() + a.imag() * b.real();
+                    }
+                    C[j] = Complex(re, im);
+                }
+        }
+
+        // C (m-by-n) = abs(A * B).^2
+        static void
+        multiplyNorm(PRECISION* C, const Complex* A, const Complex* B, unsigned int m, unsigned int n, unsigned int p)
+        {
+            const unsigned int joint = P ? P : p;
+
+            for (unsigned int i = 0; i < m; i++, A += joint, C += n)
+                for (unsigned int j = 0; j < n; j++)
+                {
+                    PRECISION re = 0, im = 0;
+                    for (unsigned int k = 0; k < joint; k++)
+                    {
+                        const Complex& a = A[k];
+                        const Complex& b = B[k * n + j];
+                        re += a.real() * b.real() - a.imag() * b.imag();
+                        im += a.real() * b.imag() + a.imag() * b.real();
+                    }
+                    C[j] = re * re + im * im;
+                }
+        }
+
+        // C (m-by-m) += alphaSquare * A * A^H with A being m-by-p; only the upper triangle is
+        // computed, the lower one is mirrored
+        static void
+        addScaledAAhermitian(Complex* C, const Complex* A, unsigned int m, unsigned int p, PRECISION alphaSquare)
+        {
+            const unsigned int joint = P ? P : p;
+
+            for (unsigned int i = 0; i < m; i++)
+            {
+                const Complex* rowI = A + i * joint;
+                for (unsigned int j = i; j < m; j++)
+                {
+                    const Complex* rowJ = A + j * joint;
+                    PRECISION re = 0, im = 0;
+                    for (unsigned int k = 0; k < joint; k++)
+                    {
+                        // rowI[k] * conj(rowJ[k])
+                        re += rowI[k].real() * rowJ[k].real() + rowI[k].imag() * rowJ[k].imag();
+                        im += rowI[k].imag() * rowJ[k].real() - rowI[k].real() * rowJ[k].imag();
+                    }
+                    re *= alphaSquare;
+                    im *= alphaSquare;
+
+                    C[i * m + j] += Complex(re, im);
+                    if (i != j)
+                        C[j * m + i] += Complex(re, -im);
+                }
+            }
+        }
+    };
+
+    // beyond this size (8x8 times 8x8) the MKL call overhead does not matter anymore
+    static const unsigned int smallMatrixMaxOperations = 512;
+
+    template <typename PRECISION>
+    void smallMatrixMultiplyCequalsAB(MKLMatrix<std::complex<PRECISION> >& C,
+                                      const std::complex<PRECISION>* A,
+                                      MKLMatrix<std::complex<PRECISION> >& B)
+    {
+        assure(C.getColumns() == B.getColumns(), "Result matrix C must have as many columns as second multiplicand B");
+
+        unsigned int m = C.getRows();      // rows of result C
+        unsigned int n = B.getColumns();   // columns of result C
+        unsigned int p = B.getRows();      // joint dimension
+
+        if (m * n * p > smallMatrixMaxOperations)
+        {
+            matrixMultiplyCequalsAB(C, const_cast<std::complex<PRECISION>*>(A), B);
+            return;
+        }
+
+        switch (p)
+        {
+        case 1: SmallMatrixKernel<PRECISION, 1>::multiply(C.getLocation(), A, B.getLocation(), m, n, p); break;
+        case 2: SmallMatrixKernel<PRECISION, 2>::multiply(C.getLocation(), A, B.getLocation(), m, n, p); break;
+        case 4: SmallMatrixKernel<PRECISION, 4>::multiply(C.getLocation(), A, B.getLocation(), m, n, p); break;
+        case 8: SmallMatrixKernel<PRECISION, 8>::multiply(C.getLocation(), A, B.getLocation(), m, n, p); break;
+        default: SmallMatrixKernel<PRECISION, 0>::multiply(C.getLocation(), A, B.getLocation(), m, n, p);
+        }
+    }
+
+    template <typename PRECISION>
+    void smallMatrixMultiplyCequalsAB(MKLMatrix<std::complex<PRECISION> >& C,
+                                      MKLMatrix<std::complex<PRECISION> >& A,
+                                      MKLMatrix<std::complex<PRECISION> >& B)
+    {
+        assure(C.getRows() == A.getRows(), "Result matrix C must have as many rows as first multiplicand A");
+        assure(A.getColumns() == B.getRows(), "First multiplicand must have as many columns as second multiplicand has rows");
+
+        smallMatrixMultiplyCequalsAB(C, A.getLocation(), B);
+    }
+
+    template <typename PRECISION>
+    void smallMatrixMultiplyCequalsNormOfAB(MKLMatrix<PRECISION>& C,
+                                            MKLMatrix<std::complex<PRECISION> >& A,
+                                            MKLMatrix<std::complex<PRECISION> >& B)
+    {
+        assure(C.getColumns() == B.getColumns(), "Result matrix C must have as many columns as second multiplicand B");
+        assure(C.getRows() == A.getRows(), "Result matrix C must have as many rows as first multiplicand A");
+        assure(A.getColumns() == B.getRows(), "First multiplicand must have as many columns as second multiplicand has rows");
+
+        unsigned int m = A.getRows();
+        unsigned int n = B.getColumns();
+        unsigned int p = A.getColumns();
+
+        switch (p)
+        {
+        case 1: SmallMatrixKernel<PRECISION, 1>::multiplyNorm(C.getLocation(), A.getLocation(), B.getLocation(), m, n, p); break;
+        case 2: SmallMatrixKernel<PRECISION, 2>::multiplyNorm(C.getLocation(), A.getLocation(), B.getLocation(), m, n, p); break;
+        case 4: SmallMatrixKernel<PRECISION, 4>::multiplyNorm(C.getLocation(), A.getLocation(), B.getLocation(), m, n, p); break;
+        case 8: SmallMatrixKernel<PRECISION, 8>::multiplyNorm(C.getLocation(), A.getLocation(), B.getLocation(), m, n, p); break;
+        default: SmallMatrixKernel<PRECISION, 0>::multiplyNorm(C.getLocation(), A.getLocation(), B.getLocation(), m, n, p);
+        }
+    }
+
+    template <typename PRECISION>
+    void smallMatrixMultiplyCequalsAlphaSquareTimesAAhermitianPlusC(MKLMatrix<std::complex<PRECISION> >& C,
+                                                                    MKLMatrix<std::complex<PRECISION> >& A,
+                                                                    PRECISION alphaSquare)
+    {
+        assure(C.getRows() == C.getColumns(), "Resulting matrix C will be square");
+        assure(C.getRows() == A.getRows(), "Resulting matrix C will have as many rows as input A");
+
+        unsigned int m = A.getRows();
+        unsigned int p = A.getColumns();
+
+        switch (p)
+        {
+        case 1: SmallMatrixKernel<PRECISION, 1>::addScaledAAhermitian(C.getLocation(), A.getLocation(), m, p, alphaSquare); break;
+        case 2: SmallMatrixKernel<PRECISION, 2>::addScaledAAhermitian(C.getLocation(), A.getLocation(), m, p, alphaSquare); break;
+        case 4: SmallMatrixKernel<PRECISION, 4>::addScaledAAhermitian(C.getLocation(), A.getLocation(), m, p, alphaSquare); break;
+        case 8: SmallMatrixKernel<PRECISION, 8>::addScaledAAhermitian(C.getLocation(), A.getLocation(), m, p, alphaSquare); break;
+        default: SmallMatrixKernel<PRECISION, 0>::addScaledAAhermitian(C.getLocation(), A.getLocation(), m, p, alphaSquare);
+        }
+    }
+}}
+
+#endif
@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef IMTAPHY_DETAIL_STALEFLAGS_HPP
+#define IMTAPHY_DETAIL_STALEFLAGS_HPP
+
+#include <vector>
+#include <algorithm>
+
+namespace imtaphy { namespace detail {
+
+    // Per-link flags for channel models that compute a link's data on first use (e.g. the lazy
+    // transformation in M2135). Readers may check isStale() without a lock: it is an acquire load
+    // that pairs with the release store in markFresh(), so a thread that sees a link as fresh also
+    // sees the data written before markFresh(). Updating a stale link has to be serialized by the
+    // caller (e.g. with a lock per link, checking isStale() again after acquiring it).
+    // markAllStale() and markAllFresh() must not run concurrently with readers.
+    class StaleFlags
+    {
+    public:
+        void assign(unsigned int numLinks, bool isStale)
+        {
+            flags.assign(numLinks, isStale ? 1 : 0);
+        }
+
+        unsigned int size() const {return flags.size();}
+
+        bool isStale(unsigned int k) const
+        {
+            return __atomic_load_n(&flags[k], __ATOMIC_ACQUIRE) != 0;
+        }
+
+        void markFresh(unsigned int k)
+        {
+            __atomic_store_n(&flags[k], static_cast<unsigned char>(0), __ATOMIC_RELEASE);
+        }
+
+        void markAllStale() {std::fill(flags.begin(), flags.end(), 1);}
+        void markAllFresh() {std::fill(flags.begin(), flags.end(), 0);}
+
+    private:
+        std::vector<unsigned char> flags;
+    };
+}}
+
+#endif
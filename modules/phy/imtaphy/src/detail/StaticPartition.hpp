@@ -0,0 +1,133 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef IMTAPHY_DETAIL_STATICPARTITION_HPP
+#define IMTAPHY_DETAIL_STATICPARTITION_HPP
+
+#if defined(_OPENMP) && !defined(__APPLE__)
+#include <omp.h>
+#endif
+
+#include <algorithm>
+
+namespace imtaphy { namespace detail {
+
+    // Contiguous split of numItems (e.g. SCM links) onto numThreads threads in the same way as
+    // "#pragma omp parallel for schedule(static)" does it in GCC and LLVM: every thread gets
+    // numItems / numThreads items and the first numItems % numThreads threads get one more.
+    //
+    // All per-link loops in M2135 use schedule(static) and the arrays are first touched with the
+    // same schedule, so on NUMA machines the pages of a link end up on the socket of the thread that
+    // works on them. Code that does per-link work outside of M2135 (e.g. the receivers in
+    // Channel::receiveAllTransmissions) can use threadOf() to run on the same thread.
+    // Threads should be pinned (OMP_PROC_BIND=close or spread, OMP_PLACES=cores) for this to pay off.
+    // The thread numbers only refer to the same threads in the outermost team, for regions nested
+    // in another parallel region (see inParallelRegion) the mapping does not mean anything.
+    class StaticPartition
+    {
+    public:
+        StaticPartition(unsigned int numItems_, unsigned int numThreads_) :
+            numItems(numItems_),
+            numThreads(std::max(numThreads_, 1U)),
+            quotient(numItems / numThreads),
+            remainder(numItems % numThreads)
+        {
+        }
+
+        unsigned int begin(unsigned int thread) const
+        {
+            return thread * quotient + std::min(thread, remainder);
+        }
+
+        unsigned int end(unsigned int thread) const
+        {
+            return begin(thread) + quotient + ((thread < remainder) ? 1 : 0);
+        }
+
+        unsigned int threadOf(unsigned int item) const
+        {
+            // the first remainder threads own (quotient + 1) items each
+            unsigned int boundary = remainder * (quotient + 1);
+            if (item < boundary)
+                return item / (quotient + 1);
+            
+            return remainder + (item - boundary) / std::max(quotient, 1U);
+        }
+
+        unsigned int getNumThreads() const {return numThreads;}
+        unsigned int getNumItems() const {return numItems;}
+
+        // number of threads the next parallel region will use
+        static unsigned int maxThreads()
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+
+        // only meaningful inside a parallel region
+        static unsigned int currentThread()
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif
+        }
+
+        static unsigned int currentNumThreads()
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            return omp_get_num_threads();
+#else
+            return 1;
+#endif
+        }
+
+        // true inside an active parallel region, i.e., a parallel region started from here is nested
+        static bool inParallelRegion()
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            return omp_get_active_level() > 0;
+#else
+            return false;
+#endif
+        }
+
+    private:
+        unsigned int numItems;
+        unsigned int numThreads;
+        unsigned int quotient;
+        unsigned int remainder;
+    };
+}}
+
+#endif
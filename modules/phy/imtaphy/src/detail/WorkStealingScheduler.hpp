@@ -0,0 +1,245 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef IMTAPHY_DETAIL_WORKSTEALINGSCHEDULER_HPP
+#define IMTAPHY_DETAIL_WORKSTEALINGSCHEDULER_HPP
+
+#include <IMTAPHY/detail/StaticPartition.hpp>
+#include <WNS/StopWatch.hpp>
+#include <WNS/Assure.hpp>
+
+#include <vector>
+#include <algorithm>
+
+namespace imtaphy { namespace detail {
+
+    // Runs a set of independent, coarse-grained tasks (e.g. one receiver per task) on the OpenMP
+    // threads. Every task has an estimated cost and a home thread (e.g. from a StaticPartition for
+    // NUMA locality). Each thread first works through its own queue from the most to the least
+    // expensive task and then steals the cheapest remaining tasks from the other queues, so that
+    // a few expensive tasks (e.g. eNB receivers in the uplink) do not leave the other cores idle.
+    //
+    // The object is meant to be kept alive and refilled every TTI: clear() keeps all the memory.
+    // The OpenMP runtime keeps its threads alive between parallel regions, so there is no need
+    // for a separate thread pool.
+    class WorkStealingScheduler
+    {
+    public:
+        WorkStealingScheduler() :
+            steals(0),
+            imbalance(0.0)
+        {
+        }
+
+        ~WorkStealingScheduler()
+        {
+            destroyLocks();
+        }
+
+        void clear()
+        {
+            costs.clear();
+            homes.clear();
+        }
+
+        void addTask(double cost, unsigned int homeThread)
+        {
+            costs.push_back(cost);
+            homes.push_back(homeThread);
+        }
+
+        void addCost(unsigned int task, double cost)
+        {
+            assure(task < costs.size(), "Invalid task");
+            costs[task] += cost;
+        }
+
+        unsigned int getNumTasks() const {return costs.size();}
+
+        // calls worker(task) exactly once for every task
+        template <typename WORKER>
+        void run(WORKER& worker)
+        {
+            unsigned int numQueues = StaticPartition::maxThreads();
+            if (queues.size() != numQueues)
+            {
+                destroyLocks();
+                queues.resize(numQueues);
+                initLocks();
+            }
+
+            for (unsigned int q = 0; q < numQueues; q++)
+            {
+                queues[q].tasks.clear();
+                queues[q].busySeconds = 0.0;
+                queues[q].steals = 0;
+            }
+            for (unsigned int task = 0; task < costs.size(); task++)
+                queues[homes[task] % numQueues].tasks.push_back(task);
+            
+            CostDescending byCost(costs);
+            for (unsigned int q = 0; q < numQueues; q++)
+            {
+                std::stable_sort(queues[q].tasks.begin(), queues[q].tasks.end(), byCost);
+                queues[q].head = 0;
+                queues[q].tail = queues[q].tasks.size();
+            }
+
+#pragma omp parallel
+            {
+                unsigned int me = StaticPartition::currentThread() % numQueues;
+                unsigned int task;
+                bool stolen;
+                wns::StopWatch watch;
+                double busySeconds = 0.0;
+                unsigned int stolenTasks = 0;
+
+                while (next(me, task, stolen))
+                {
+                    watch.start();
+                    worker(task);
+                    busySeconds += watch.stop();
+                    if (stolen)
+                        stolenTasks++;
+                }
+                queues[me].busySeconds = busySeconds;
+                queues[me].steals = stolenTasks;
+            }
+
+            // imbalance = (max - mean) / mean of the per-thread busy times
+            double maxBusy = 0.0;
+            double sumBusy = 0.0;
+            steals = 0;
+            for (unsigned int q = 0; q < numQueues; q++)
+            {
+                maxBusy = std::max(maxBusy, queues[q].busySeconds);
+                sumBusy += queues[q].busySeconds;
+                steals += queues[q].steals;
+            }
+            imbalance = (sumBusy > 0.0) ? maxBusy * double(numQueues) / sumBusy - 1.0 : 0.0;
+        }
+
+        // statistics of the last run()
+        double getImbalance() const {return imbalance;}
+        unsigned int getSteals() const {return steals;}
+        unsigned int getNumThreads() const {return queues.size();}
+        double getBusySeconds(unsigned int thread) const
+        {
+            assure(thread < queues.size(), "Invalid thread");
+            return queues[thread].busySeconds;
+        }
+
+    private:
+        struct Queue
+        {
+            std::vector<unsigned int> tasks;
+            unsigned int head;
+            unsigned int tail;
+            double busySeconds;
+            unsigned int steals;
+#if defined(_OPENMP) && !defined(__APPLE__)
+            omp_lock_t lock;
+#endif
+        };
+
+        struct CostDescending
+        {
+            CostDescending(const std::vector<double>& costs_) : costs(costs_) {}
+            bool operator()(unsigned int a, unsigned int b) const {return costs[a] > costs[b];}
+            const std::vector<double>& costs;
+        };
+
+        // own queue first (expensive tasks first), then steal from the back of the other queues
+        bool next(unsigned int me, unsigned int& task, bool& stolen)
+        {
+            unsigned int numQueues = queues.size();
+            for (unsigned int i = 0; i < numQueues; i++)
+            {
+                unsigned int victim = (me + i) % numQueues;
+                Queue& queue = queues[victim];
+                bool found = false;
+
+                lock(queue);
+                if (queue.head < queue.tail)
+                {
+                    task = (victim == me) ? queue.tasks[queue.head++] : queue.tasks[--queue.tail];
+                    found = true;
+                }
+                unlock(queue);
+
+                if (found)
+                {
+                    stolen = (victim != me);
+                    return true;
+                }
+            }
+            // tasks do not create new tasks, so all queues stay empty from now on
+            return false;
+        }
+
+        void lock(Queue& queue)
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            omp_set_lock(&queue.lock);
+#endif
+        }
+
+        void unlock(Queue& queue)
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            omp_unset_lock(&queue.lock);
+#endif
+        }
+
+        void initLocks()
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            for (unsigned int q = 0; q < queues.size(); q++)
+                omp_init_lock(&queues[q].lock);
+#endif
+        }
+
+        void destroyLocks()
+        {
+#if defined(_OPENMP) && !defined(__APPLE__)
+            for (unsigned int q = 0; q < queues.size(); q++)
+                omp_destroy_lock(&queues[q].lock);
+#endif
+        }
+
+        std::vector<double> costs;
+        std::vector<unsigned int> homes;
+        std::vector<Queue> queues;
+
+        unsigned int steals;
+        double imbalance;
+    };
+}}
+
+#endif
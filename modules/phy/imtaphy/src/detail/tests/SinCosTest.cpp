@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/detail/SinCos.hpp>
+
+#include <vector>
+#include <cmath>
+
+namespace imtaphy { namespace detail { namespace tests {
+        class SinCosTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( SinCosTest );
+            CPPUNIT_TEST ( testScalarFloat );
+            CPPUNIT_TEST ( testScalarDouble );
+            CPPUNIT_TEST ( testVectorCisFloat );
+            CPPUNIT_TEST ( testVectorCisDouble );
+            CPPUNIT_TEST_SUITE_END();
+        
+        public:
+            void setUp();
+            void tearDown();
+
+            void testScalarFloat();
+            void testScalarDouble();
+            void testVectorCisFloat();
+            void testVectorCisDouble();
+
+        private:
+            template <typename T> void checkScalar(T tolerance);
+            template <typename T> void checkVectorCis(T tolerance);
+
+            // sample points covering the phase ranges occurring in M2135::evolve
+            std::vector<double> arguments;
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( SinCosTest );
+    
+        void
+        SinCosTest::setUp()
+        {
+            arguments.clear();
+
+            // dense around zero and the quadrant boundaries
+            for (int i = -2000; i <= 2000; i++)
+                arguments.push_back(double(i) * 0.005);
+
+            // large phases as produced by Doppler terms after a long simulation time
+            for (int i = 0; i < 1000; i++)
+            {
+                arguments.push_back(double(i) * 8.123456789);
+                arguments.push_back(-double(i) * 7.987654321);
+            }
+        }
+
+        void
+        SinCosTest::tearDown()
+        {
+        }
+
+        template <typename T>
+        void
+        SinCosTest::checkScalar(T tolerance)
+        {
+            for (unsigned int i = 0; i < arguments.size(); i++)
+            {
+                T x = static_cast<T>(arguments[i]);
+                T sine, cosine;
+                sinCos<T>(x, sine, cosine);
+
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(std::sin(x), sine, tolerance);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(std::cos(x), cosine, tolerance);
+            }
+        }
+
+        template <typename T>
+        void
+        SinCosTest::checkVectorCis(T tolerance)
+        {
+            // use an odd length so that the remainder handling of the blocked kernel is exercised
+            std::vector<T> x(arguments.size() - 1);
+            for (unsigned int i = 0; i < x.size(); i++)
+                x[i] = static_cast<T>(arguments[i]);
+
+            std::vector<std::complex<T> > y(x.size());
+            vectorCis<T>(x.size(), &x[0], &y[0]);
+
+            for (unsigned int i = 0; i < x.size(); i++)
+            {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(std::cos(x[i]), y[i].real(), tolerance);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(std::sin(x[i]), y[i].imag(), tolerance);
+            }
+        }
+
+        void
+        SinCosTest::testScalarFloat()
+        {
+            checkScalar<float>(1.0e-06);
+        }
+
+        void
+        SinCosTest::testScalarDouble()
+        {
+            checkScalar<double>(1.0e-13);
+        }
+
+        void
+        SinCosTest::testVectorCisFloat()
+        {
+            checkVectorCis<float>(1.0e-06);
+        }
+
+        void
+        SinCosTest::testVectorCisDouble()
+        {
+            checkVectorCis<double>(1.0e-13);
+        }
+}}}
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <WNS/StopWatch.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/detail/SmallMatrix.hpp>
+
+#include <itpp/itbase.h>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+namespace imtaphy { namespace detail { namespace tests {
+
+        // Compares the per-PRB matrix work of LinearReceiver::computeSINRs and the perfect I+N
+        // covariance (effective interferer channel, W^H * R * W) done with heap-allocated
+        // ComplexFloatMatrix temporaries and matrixMultiplyCequalsAB against the stack-based
+        // SmallMatrix kernels. Registered in the Performance registry so it only runs on demand.
+        class SmallMatrixPerformanceTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( SmallMatrixPerformanceTest );
+            CPPUNIT_TEST( receiverChain );
+            CPPUNIT_TEST_SUITE_END();
+
+        public:
+            void setUp() {}
+            void tearDown() {}
+
+            void receiverChain();
+
+        private:
+            void benchmark(unsigned int numAntennas, unsigned int numLayers);
+
+            static const unsigned int numIterations = 200000;
+        };
+
+        CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( SmallMatrixPerformanceTest, wns::testsuite::Performance() );
+
+        void
+        SmallMatrixPerformanceTest::receiverChain()
+        {
+            benchmark(1, 1);
+            benchmark(2, 2);
+            benchmark(4, 2);
+            benchmark(8, 4);
+            benchmark(8, 8);
+        }
+
+        void
+        SmallMatrixPerformanceTest::benchmark(unsigned int u, unsigned int m)
+        {
+            ComplexFloatMatrix H(u, u);
+            ComplexFloatMatrix precoding(u, m);
+            ComplexFloatMatrix W(u, m);
+            ComplexFloatMatrix Whermitian(m, u);
+            ComplexFloatMatrix R(u, u);
+
+            for (unsigned int i = 0; i < u; i++)
+                for (unsigned int j = 0; j < u; j++)
+                {
+                    H[i][j] = std::complex<float>(itpp::randn(), itpp::randn());
+                    R[i][j] = std::complex<float>(itpp::randn(), itpp::randn());
+                }
+            for (unsigned int i = 0; i < u; i++)
+                for (unsigned int j = 0; j < m; j++)
+                {
+                    precoding[i][j] = std::complex<float>(itpp::randn(), itpp::randn());
+                    W[i][j] = std::complex<float>(itpp::randn(), itpp::randn());
+                }
+            matrixHermitian<float>(W, Whermitian);
+
+            // keep the results alive so that nothing gets optimized away
+            float checksumHeap = 0.0;
+            float checksumSmall = 0.0;
+
+            wns::StopWatch heap;
+            heap.start();
+            for (unsigned int n = 0; n < numIterations; n++)
+            {
+                ComplexFloatMatrix effectiveChannel(u, m);
+                ComplexFloatMatrix covariance(R);
+                ComplexFloatMatrix temp(m, u);
+                ComplexFloatMatrix Y(m, m);
+
+                matrixMultiplyCequalsAB(effectiveChannel, H.getLocation(), precoding);
+                matrixMultiplyCequalsAlphaSquareTimesAAhermitianPlusC<float>(covariance, effectiveChannel, 0.5f);
+                matrixMultiplyCequalsAB<float>(temp, Whermitian, covariance);
+                matrixMultiplyCequalsAB<float>(Y, temp, W);
+                checksumHeap += Y[0][0].real();
+            }
+            heap.stop();
+
+            wns::StopWatch small;
+            small.start();
+            for (unsigned int n = 0; n < numIterations; n++)
+            {
+                SmallComplexFloatMatrix effectiveChannel(u, m);
+                SmallComplexFloatMatrix covariance(u, u);
+                SmallComplexFloatMatrix temp(m, u);
+                SmallComplexFloatMatrix Y(m, m);
+
+                std::copy(R.getLocation(), R.getLocation() + u * u, covariance.getLocation());
+                smallMatrixMultiplyCequalsAB(effectiveChannel.matrix(), H.getLocation(), precoding);
+                smallMatrixMultiplyCequalsAlphaSquareTimesAAhermitianPlusC<float>(covariance, effectiveChannel, 0.5f);
+                smallMatrixMultiplyCequalsAB<float>(temp, Whermitian, covariance);
+                smallMatrixMultiplyCequalsAB<float>(Y, temp, W);
+                checksumSmall += Y[0][0].real();
+            }
+            small.stop();
+
+            std::cout << "\n" << u << " antennas, " << m << " layers, " << numIterations << " PRBs: "
+                      << "ComplexFloatMatrix " << heap.toString() << ", SmallMatrix " << small.toString()
+                      << " (speedup " << heap.getInSeconds() / small.getInSeconds() << ")" << std::endl;
+
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(checksumHeap, checksumSmall, 1e-03 * std::max(1.0f, std::fabs(checksumHeap)));
+        }
+}}}
@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/detail/SmallMatrix.hpp>
+
+#include <itpp/itbase.h>
+
+namespace imtaphy { namespace detail { namespace tests {
+        class SmallMatrixTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( SmallMatrixTest );
+            CPPUNIT_TEST( testMultiplication );
+            CPPUNIT_TEST( testNormOfAB );
+            CPPUNIT_TEST( testAlphaSquareTimesAAhermitianPlusC );
+            CPPUNIT_TEST( testHeapFallback );
+            CPPUNIT_TEST_SUITE_END();
+
+        public:
+            void setUp() {}
+            void tearDown() {}
+
+            void testMultiplication();
+            void testNormOfAB();
+            void testAlphaSquareTimesAAhermitianPlusC();
+            void testHeapFallback();
+
+        private:
+            static void fillRandom(MKLMatrix<std::complex<float> >& A)
+            {
+                for (unsigned int i = 0; i < A.getRows(); i++)
+                    for (unsigned int j = 0; j < A.getColumns(); j++)
+                        A[i][j] = std::complex<float>(itpp::randn(), itpp::randn());
+            }
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( SmallMatrixTest );
+
+        void
+        SmallMatrixTest::testMultiplication()
+        {
+            // the specialized kernels (1, 2, 4, 8) and the generic one (3, 5) must agree with the
+            // reference implementation for both the matrix and the raw pointer variant
+            for (unsigned int m = 1; m <= 8; m++)
+                for (unsigned int n = 1; n <= 8; n++)
+                    for (unsigned int p = 1; p <= 8; p++)
+                    {
+                        ComplexFloatMatrix A(m, p);
+                        ComplexFloatMatrix B(p, n);
+                        ComplexFloatMatrix reference(m, n);
+                        fillRandom(A);
+                        fillRandom(B);
+
+                        SmallComplexFloatMatrix C1(m, n);
+                        SmallComplexFloatMatrix C2(m, n);
+
+                        matrixMultiplyCequalsAB<float>(reference, A, B);
+                        smallMatrixMultiplyCequalsAB<float>(C1, A, B);
+                        smallMatrixMultiplyCequalsAB(C2.matrix(), A.getLocation(), B);
+
+                        for (unsigned int i = 0; i < m; i++)
+                            for (unsigned int j = 0; j < n; j++)
+                            {
+                                CPPUNIT_ASSERT_DOUBLES_EQUAL(reference[i][j].real(), C1[i][j].real(), 1e-04);
+                                CPPUNIT_ASSERT_DOUBLES_EQUAL(reference[i][j].imag(), C1[i][j].imag(), 1e-04);
+                                CPPUNIT_ASSERT_DOUBLES_EQUAL(reference[i][j].real(), C2[i][j].real(), 1e-04);
+                                CPPUNIT_ASSERT_DOUBLES_EQUAL(reference[i][j].imag(), C2[i][j].imag(), 1e-04);
+                            }
+                    }
+        }
+
+        void
+        SmallMatrixTest::testNormOfAB()
+        {
+            for (unsigned int m = 1; m <= 8; m++)
+                for (unsigned int p = 1; p <= 8; p++)
+                {
+                    ComplexFloatMatrix A(m, p);
+                    ComplexFloatMatrix B(p, m);
+                    FloatMatrix reference(m, m);
+                    fillRandom(A);
+                    fillRandom(B);
+
+                    SmallFloatMatrix C(m, m);
+
+                    matrixMultiplyCequalsNormOfAB<float>(reference, A, B);
+                    smallMatrixMultiplyCequalsNormOfAB<float>(C, A, B);
+
+                    for (unsigned int i = 0; i < m; i++)
+                        for (unsigned int j = 0; j < m; j++)
+                            CPPUNIT_ASSERT_DOUBLES_EQUAL(reference[i][j], C[i][j], 1e-03);
+                }
+        }
+
+        void
+        SmallMatrixTest::testAlphaSquareTimesAAhermitianPlusC()
+        {
+            for (unsigned int m = 1; m <= 8; m++)
+                for (unsigned int p = 1; p <= 8; p++)
+                {
+                    ComplexFloatMatrix A(m, p);
+                    ComplexFloatMatrix reference(m, m);
+                    SmallComplexFloatMatrix C(m, m);
+                    fillRandom(A);
+
+                    // start from the same hermitian matrix, like the noise covariance in the receiver
+                    ComplexFloatMatrix start(m, m);
+                    fillRandom(start);
+                    matrixMultiplyCequalsAAhermitian<float>(reference, start);
+                    matrixMultiplyCequalsAAhermitian<float>(C, start);
+
+                    matrixMultiplyCequalsAlphaSquareTimesAAhermitianPlusC<float>(reference, A, 0.3f);
+                    smallMatrixMultiplyCequalsAlphaSquareTimesAAhermitianPlusC<float>(C, A, 0.3f);
+
+                    for (unsigned int i = 0; i < m; i++)
+                        for (unsigned int j = 0; j < m; j++)
+                        {
+                            CPPUNIT_ASSERT_DOUBLES_EQUAL(reference[i][j].real(), C[i][j].real(), 1e-04);
+                            CPPUNIT_ASSERT_DOUBLES_EQUAL(reference[i][j].imag(), C[i][j].imag(), 1e-04);
+                        }
+                }
+        }
+
+        void
+        SmallMatrixTest::testHeapFallback()
+        {
+            // more than 8 antennas still works, the storage just moves to the heap
+            CPPUNIT_ASSERT(SmallComplexFloatMatrix::fits(8, 8));
+            CPPUNIT_ASSERT(!SmallComplexFloatMatrix::fits(16, 2));
+
+            ComplexFloatMatrix A(16, 16);
+            ComplexFloatMatrix B(16, 2);
+            ComplexFloatMatrix reference(16, 2);
+            fillRandom(A);
+            fillRandom(B);
+
+            SmallComplexFloatMatrix C(16, 2);
+            CPPUNIT_ASSERT_EQUAL(16U, C.getRows());
+            CPPUNIT_ASSERT_EQUAL(2U, C.getColumns());
+
+            matrixMultiplyCequalsAB<float>(reference, A, B);
+            smallMatrixMultiplyCequalsAB<float>(C, A, B);
+
+            for (unsigned int i = 0; i < 16; i++)
+                for (unsigned int j = 0; j < 2; j++)
+                {
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(reference[i][j].real(), C[i][j].real(), 1e-03);
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(reference[i][j].imag(), C[i][j].imag(), 1e-03);
+                }
+        }
+}}}
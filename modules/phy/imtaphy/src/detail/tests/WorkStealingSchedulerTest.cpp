@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/detail/WorkStealingScheduler.hpp>
+
+#include <vector>
+
+namespace imtaphy { namespace detail { namespace tests {
+        class WorkStealingSchedulerTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( WorkStealingSchedulerTest );
+            CPPUNIT_TEST ( testEveryTaskOnce );
+            CPPUNIT_TEST ( testReuse );
+            CPPUNIT_TEST ( testStaticPartition );
+            CPPUNIT_TEST_SUITE_END();
+        
+        public:
+            void setUp() {}
+            void tearDown() {}
+
+            void testEveryTaskOnce();
+            void testReuse();
+            void testStaticPartition();
+
+        private:
+            // each task only touches its own counter
+            struct CountingWorker
+            {
+                CountingWorker(std::vector<int>& counters_) : counters(counters_) {}
+                void operator()(unsigned int task) {counters[task]++;}
+                std::vector<int>& counters;
+            };
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( WorkStealingSchedulerTest );
+    
+        void
+        WorkStealingSchedulerTest::testEveryTaskOnce()
+        {
+            // all tasks live on one home thread and have very different costs,
+            // the others have to steal but no task may be lost or executed twice
+            WorkStealingScheduler scheduler;
+            for (unsigned int task = 0; task < 500; task++)
+                scheduler.addTask((task % 50 == 0) ? 100.0 : 1.0, 0);
+            scheduler.addCost(7, 10.0);
+
+            std::vector<int> counters(500, 0);
+            CountingWorker worker(counters);
+            scheduler.run(worker);
+
+            for (unsigned int task = 0; task < 500; task++)
+                CPPUNIT_ASSERT_EQUAL(1, counters[task]);
+
+            CPPUNIT_ASSERT(scheduler.getImbalance() >= 0.0);
+            CPPUNIT_ASSERT(scheduler.getNumThreads() >= 1);
+            CPPUNIT_ASSERT(scheduler.getSteals() < 500);
+        }
+
+        void
+        WorkStealingSchedulerTest::testReuse()
+        {
+            WorkStealingScheduler scheduler;
+            
+            for (unsigned int round = 1; round <= 3; round++)
+            {
+                scheduler.clear();
+                for (unsigned int task = 0; task < 100 * round; task++)
+                    scheduler.addTask(1.0, task);
+                CPPUNIT_ASSERT_EQUAL(100 * round, scheduler.getNumTasks());
+
+                std::vector<int> counters(100 * round, 0);
+                CountingWorker worker(counters);
+                scheduler.run(worker);
+
+                for (unsigned int task = 0; task < 100 * round; task++)
+                    CPPUNIT_ASSERT_EQUAL(1, counters[task]);
+            }
+
+            // nothing to do at all
+            scheduler.clear();
+            std::vector<int> counters;
+            CountingWorker worker(counters);
+            scheduler.run(worker);
+            CPPUNIT_ASSERT_EQUAL(0U, scheduler.getSteals());
+        }
+
+        void
+        WorkStealingSchedulerTest::testStaticPartition()
+        {
+            // contiguous, complete and consistent with threadOf
+            for (unsigned int items = 0; items < 40; items++)
+                for (unsigned int threads = 1; threads < 9; threads++)
+                {
+                    StaticPartition partition(items, threads);
+                    unsigned int expectedBegin = 0;
+                    for (unsigned int thread = 0; thread < threads; thread++)
+                    {
+                        CPPUNIT_ASSERT_EQUAL(expectedBegin, partition.begin(thread));
+                        CPPUNIT_ASSERT(partition.end(thread) - partition.begin(thread) <= items / threads + 1);
+                        for (unsigned int item = partition.begin(thread); item < partition.end(thread); item++)
+                            CPPUNIT_ASSERT_EQUAL(thread, partition.threadOf(item));
+                        expectedBegin = partition.end(thread);
+                    }
+                    CPPUNIT_ASSERT_EQUAL(items, expectedBegin);
+                }
+        }
+}}}
@@ -38,6 +38,13 @@ class IMTAphyObserver
     public:
     virtual void onNewTTI(unsigned int ttiNumber) = 0;
     virtual void beforeTTIover(unsigned int ttiNumber) = 0;
+
+    // With the channel's parallelScheduling enabled, the onNewTTI of all observers returning true
+    // here may run concurrently (from TTI 2 on). They must only modify their own state then and
+    // leave everything that has to happen in observer order (probing, waking up other FUs) to
+    // afterParallelNewTTI, which the channel calls sequentially and in observer order afterwards.
+    virtual bool supportsParallelNewTTI() const {return false;}
+    virtual void afterParallelNewTTI(unsigned int /* ttiNumber */) {}
 };
 
 }}
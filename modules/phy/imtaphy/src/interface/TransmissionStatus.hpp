@@ -138,7 +138,7 @@ namespace imtaphy { namespace interface {
 #endif
                 return sinrs[layer-1][prbMap[prb]];
             }
-            
+
             SINRVector getSINRsForLayer(unsigned int layer)
             {
                 assure((layer > 0) && (layer <= numberOfLayers), "Invalid layer index, must be from 1..numberOfLayers");
@@ -156,6 +156,21 @@ namespace imtaphy { namespace interface {
                 return result;
             }
             
+            // writes the linear SINRs of one layer in the order of getPRBs() to a contiguous array of
+            // getNumberOfPRBs() entries, which saves the SINRVector copy in per-TB loops
+            void getSINRFactorsForLayer(unsigned int layer, double* factors)
+            {
+                assure((layer > 0) && (layer <= numberOfLayers), "Invalid layer index, must be from 1..numberOfLayers");
+
+                for (unsigned int i = 0; i < numberOfPRBs; i++)
+                {
+#ifndef WNS_NDEBUG
+                    assure(checkSINR[layer-1][i], "Trying to read a SINR entry that had not been set");
+#endif
+                    factors[i] = sinrs[layer-1][i].get_factor();
+                }
+            }
+
             IoTVector getIoTsForLayer(unsigned int layer)
             {
                 assure((layer > 0) && (layer <= numberOfLayers), "Invalid layer index, must be from 1..numberOfLayers");
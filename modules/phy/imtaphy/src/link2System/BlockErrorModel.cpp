@@ -221,6 +221,13 @@ BlockErrorModel::BlockErrorModel() :
         }        
     }
     
+    // resample the (monotonized) curves onto dense surfaces for the fast lookup
+    surfaces.resize(3);
+    for (unsigned int m = 0; m < 3; m++)
+    {
+        buildSurface(m, *curves[m]);
+    }
+    
     // determine suitable thresholds to switch between CQIs
     unsigned int sinrResolution = 350;
     double minSINR = -10.0;
@@ -237,10 +244,10 @@ BlockErrorModel::BlockErrorModel() :
             unsigned int assumeBlocksize = static_cast<float>(((14-3)*12 - 6) * assumeNumPRBs * modulation.getBitsPerSymbol()) * codeRate;
             assumeBlocksize = std::max(40u, assumeBlocksize);
            
-            blers[sinr][cqi] = getBlockErrorRate(wns::Ratio::from_dB(getSinr(sinr, sinrResolution, minSINR, maxSINR)),
-                                                 modulation,
-                                                 codeRate,
-                                                 assumeBlocksize);
+            blers[sinr][cqi] = getReferenceBlockErrorRate(wns::Ratio::from_dB(getSinr(sinr, sinrResolution, minSINR, maxSINR)),
+                                                          modulation,
+                                                          codeRate,
+                                                          assumeBlocksize);
 
         }
     }
@@ -278,10 +285,56 @@ BlockErrorModel::BlockErrorModel() :
 }
 
 
+void
+BlockErrorModel::mapCodeRate(unsigned int m, float codeRate, unsigned int& curve, double& shift_dB) const
+{
+    if (codeRate <= minCR[m])
+    {
+        // We can treat a lower code rate as if some bits of the with "minCodeRate" encoded bits
+        // are repeated and thus their received power or SINRs are added up (in fact, this is basically what happens in LTE)
+        shift_dB = 10.0 * log10(minCR[m] / codeRate);
+        curve = 0;
+    }
+    else if (codeRate >= maxCR[m])
+    {
+        // TODO: (February 2012) this actually does not work as intended. We should provide more link level 
+        // results (maybe also investigate why the are a bit shifted). However, during operation, 
+        // this extrapolation is usually not needed so that it should not cause problems at the moment
+        // this we could model as if some bits were punctured away, i.e., their power is lost
+        shift_dB = -10.0 * log10(codeRate / maxCR[m]);
+        curve = keys[m][1].size() - 1;
+    }
+    else // codeRate is in the middle between two known ones
+    {
+        unsigned int crIndex;
+        for (crIndex = 0; codeRate > keys[m][1][crIndex]; crIndex++)
+            ;
+        
+        assure(crIndex > 0, "Must be greater because we previously check for that case");
+        
+        // Take the curve for the lower code rate but shift the sinr by the corresponding SINR
+        // distance to the next bigger code rate
+        double fraction = (codeRate - keys[m][1][crIndex-1]) / (keys[m][1][crIndex] - keys[m][1][crIndex-1]);
+        
+        assure((fraction >= 0) && (fraction <= 1), "something is messed up");
+
+        if (fraction < 0.5)
+        {
+            curve = crIndex - 1;
+            shift_dB = -offsets[m][crIndex-1] * fraction;
+        }
+        else
+        {
+            curve = crIndex;
+            shift_dB = offsets[m][crIndex-1] * (1.0 - fraction);
+        }
+    }
+}
+
 double
-BlockErrorModel::getBlockErrorRate(wns::Ratio sinr, 
-                                imtaphy::l2s::ModulationScheme modulation, 
-                                float codeRate, unsigned int blockSize) const
+BlockErrorModel::getReferenceBlockErrorRate(wns::Ratio sinr, 
+                                            imtaphy::l2s::ModulationScheme modulation, 
+                                            float codeRate, unsigned int blockSize) const
 {
     // blockSize is the pure transport block size, have to add 24 CRC bits
     // see also  ModulationScheme::getEffectiveCodeRate
@@ -311,7 +364,7 @@ BlockErrorModel::getBlockErrorRate(wns::Ratio sinr,
         unsigned int segmentedBlockSize = (blockSize + 24*(1+numBlocks)) / numBlocks;
         assure(segmentedBlockSize <= 6144, "Code Block Segment is too big"); 
         
-        double perCBsuccessProb = 1.0 - getBlockErrorRate(sinr, modulation, codeRate, segmentedBlockSize);
+        double perCBsuccessProb = 1.0 - getReferenceBlockErrorRate(sinr, modulation, codeRate, segmentedBlockSize);
        
         bler = 1.0 - pow(perCBsuccessProb, static_cast<double>(numBlocks));
 //         std::cout << "TBsize=" << blockSize << " gives " << numBlocks << " code blocks of size << " << segmentedBlockSize 
@@ -332,55 +385,11 @@ BlockErrorModel::getBlockErrorRate(wns::Ratio sinr,
 
    
     
-    double lookForCodeRate;
-    wns::Ratio adjustedSINR;
-    if (codeRate <= minCR[m])
-    {
-        // We can treat a lower code rate as if some bits of the with "minCodeRate" encoded bits
-        // are repeated and thus their received power or SINRs are added up (in fact, this is basically what happens in LTE)
-        wns::Ratio gain = wns::Ratio::from_factor(minCR[m] / codeRate);
-        adjustedSINR = sinr + gain;
-
-        lookForCodeRate = minCR[m];
-    }
-    else if (codeRate >= maxCR[m])
-    {
-        // TODO: (February 2012) this actually does not work as intended. We should provide more link level 
-        // results (maybe also investigate why the are a bit shifted). However, during operation, 
-        // this extrapolation is usually not needed so that it should not cause problems at the moment
-        // this we could model as if some bits were punctured away, i.e., their power is lost
-        wns::Ratio loss = wns::Ratio::from_factor(codeRate / maxCR[m]);
-        adjustedSINR = sinr - loss;
-        lookForCodeRate = maxCR[m];
-    }
-    else // codeRate is in the middle between two known ones
-    {
-        
-        unsigned int crIndex;
-        for (crIndex = 0; codeRate > keys[m][1][crIndex]; crIndex++)
-            ;
-        
-        assure(crIndex > 0, "Must be greater because we previously check for that case");
-        
-        
-        // Take the curve for the lower code rate but shift the sinr by the corresponding SINR
-        // distance to the next bigger code rate
-        double fraction = (codeRate - keys[m][1][crIndex-1]) / (keys[m][1][crIndex] - keys[m][1][crIndex-1]);
-        
-        assure((fraction >= 0) && (fraction <= 1), "something is messed up");
-
-        if (fraction < 0.5)
-        {
-            lookForCodeRate = keys[m][1][crIndex-1];
-            adjustedSINR = sinr - wns::Ratio::from_dB(offsets[m][crIndex-1] * fraction);
-        }
-        else
-        {
-            lookForCodeRate = keys[m][1][crIndex];
-            adjustedSINR = sinr + wns::Ratio::from_dB(offsets[m][crIndex-1] * (1.0 - fraction));
-        }
-
-    }
+    unsigned int curve;
+    double codeRateShift_dB;
+    mapCodeRate(m, codeRate, curve, codeRateShift_dB);
+    float lookForCodeRate = keys[m][1][curve];
+    wns::Ratio adjustedSINR = sinr + wns::Ratio::from_dB(codeRateShift_dB);
     
     if (blockLength < minBL)
         blockLength = minBL;
@@ -420,3 +429,165 @@ BlockErrorModel::getBlockErrorRate(wns::Ratio sinr,
     
     return tri.linear(lookupResult, lookForKeys);
 }
+
+void
+BlockErrorModel::buildSurface(unsigned int m, const boost::multi_array_ref<double, 2>& curves)
+{
+    BLERSurface& surface = surfaces[m];
+    
+    const std::vector<float>& sinrKeys = keys[m][0];
+    const std::vector<float>& blockLengthKeys = keys[m][2];
+    
+    // the link level SINRs are (nearly) uniform already, so keeping their number keeps the curves as they are
+    surface.minSINR_dB = minSINR;
+    surface.numSINRs = sinrKeys.size();
+    surface.stepsPerdB = static_cast<float>(surface.numSINRs - 1) / (maxSINR - minSINR);
+    
+    surface.numCurves = keys[m][1].size();
+    
+    surface.minLogBlockLength = log(minBL);
+    surface.numBlockLengths = surfaceNumBlockLengths;
+    surface.stepsPerLogBlockLength = static_cast<float>(surface.numBlockLengths - 1) / (log(maxBL) - log(minBL));
+    
+    surface.bler.resize(surface.numSINRs * surface.numCurves * surface.numBlockLengths);
+    
+    for (unsigned int bl = 0; bl < surface.numBlockLengths; bl++)
+    {
+        // interpolate linearly between the two link level block lengths around this bin like the LookupTable does
+        float blockLength = exp(surface.minLogBlockLength + static_cast<float>(bl) / surface.stepsPerLogBlockLength);
+        blockLength = std::min(std::max(blockLength, minBL), maxBL);
+        
+        unsigned int blIndex = std::upper_bound(blockLengthKeys.begin(), blockLengthKeys.end(), blockLength) - blockLengthKeys.begin();
+        blIndex = std::min(std::max(blIndex, 1u), static_cast<unsigned int>(blockLengthKeys.size()) - 1) - 1;
+        double blFraction = (blockLength - blockLengthKeys[blIndex]) / (blockLengthKeys[blIndex + 1] - blockLengthKeys[blIndex]);
+        
+        for (unsigned int curve = 0; curve < surface.numCurves; curve++)
+        {
+            unsigned int lowerColumn = surface.numCurves * blIndex + curve;
+            unsigned int upperColumn = surface.numCurves * (blIndex + 1) + curve;
+            
+            float* row = &surface.bler[(bl * surface.numCurves + curve) * surface.numSINRs];
+            
+            for (unsigned int sinr = 0; sinr < surface.numSINRs; sinr++)
+            {
+                double sinr_dB = std::min(surface.minSINR_dB + static_cast<double>(sinr) / surface.stepsPerdB, static_cast<double>(maxSINR));
+                
+                unsigned int sinrIndex = std::upper_bound(sinrKeys.begin(), sinrKeys.end(), sinr_dB) - sinrKeys.begin();
+                sinrIndex = std::min(std::max(sinrIndex, 1u), static_cast<unsigned int>(sinrKeys.size()) - 1) - 1;
+                double sinrFraction = (sinr_dB - sinrKeys[sinrIndex]) / (sinrKeys[sinrIndex + 1] - sinrKeys[sinrIndex]);
+                
+                double lower = (1.0 - sinrFraction) * curves[sinrIndex][lowerColumn] + sinrFraction * curves[sinrIndex + 1][lowerColumn];
+                double upper = (1.0 - sinrFraction) * curves[sinrIndex][upperColumn] + sinrFraction * curves[sinrIndex + 1][upperColumn];
+                
+                row[sinr] = (1.0 - blFraction) * lower + blFraction * upper;
+            }
+        }
+    }
+}
+
+unsigned int
+BlockErrorModel::getNumCodeBlocks(unsigned int blockSize, unsigned int& codeBlockSize) const
+{
+    // see getReferenceBlockErrorRate for the code block segmentation
+    if (blockSize + 24 > 6144)
+    {
+        unsigned int numBlocks = ((blockSize + 24) + 6120 - 1) / 6120;
+        codeBlockSize = (blockSize + 24*(1+numBlocks)) / numBlocks;
+        assure(codeBlockSize <= 6144, "Code Block Segment is too big"); 
+        return numBlocks;
+    }
+    
+    codeBlockSize = blockSize;
+    return 1;
+}
+
+BlockErrorModel::SurfaceCell
+BlockErrorModel::getSurfaceCell(unsigned int m, float codeRate, unsigned int codeBlockSize) const
+{
+    const BLERSurface& surface = surfaces[m];
+    SurfaceCell cell;
+    
+    // the code rate selects a curve and shifts the SINR exactly like in the reference
+    unsigned int curve;
+    mapCodeRate(m, codeRate, curve, cell.sinrShift_dB);
+    
+    switch (m)
+    {
+        case 0:
+            cell.sinrShift_dB += sinrOffsetQPSK.get_dB();
+            break;
+        case 1:
+            cell.sinrShift_dB += sinrOffsetQAM16.get_dB();
+            break;
+        case 2:
+            cell.sinrShift_dB += sinrOffsetQAM64.get_dB();
+            break;
+    }
+    
+    float blPosition = (log(static_cast<float>(codeBlockSize)) - surface.minLogBlockLength) * surface.stepsPerLogBlockLength;
+    blPosition = std::min(std::max(blPosition, 0.0f), static_cast<float>(surface.numBlockLengths - 1));
+    unsigned int bl = std::min(static_cast<unsigned int>(blPosition), surface.numBlockLengths - 2);
+    float blFraction = blPosition - static_cast<float>(bl);
+    
+    cell.rows[0] = &surface.bler[(bl * surface.numCurves + curve) * surface.numSINRs];
+    cell.rows[1] = &surface.bler[((bl + 1) * surface.numCurves + curve) * surface.numSINRs];
+    cell.weights[0] = 1.0f - blFraction;
+    cell.weights[1] = blFraction;
+    
+    return cell;
+}
+
+inline double
+BlockErrorModel::interpolate(const BLERSurface& surface, const SurfaceCell& cell, double sinr_dB) const
+{
+    double position = (sinr_dB + cell.sinrShift_dB - surface.minSINR_dB) * surface.stepsPerdB;
+    position = std::min(std::max(position, 0.0), static_cast<double>(surface.numSINRs - 1));
+    unsigned int sinr = std::min(static_cast<unsigned int>(position), surface.numSINRs - 2);
+    float fraction = position - static_cast<double>(sinr);
+    
+    const float* lower = cell.rows[0];
+    const float* upper = cell.rows[1];
+    
+    return cell.weights[0] * (lower[sinr] + fraction * (lower[sinr + 1] - lower[sinr])) +
+           cell.weights[1] * (upper[sinr] + fraction * (upper[sinr + 1] - upper[sinr]));
+}
+
+double
+BlockErrorModel::getBlockErrorRate(wns::Ratio sinr, ModulationScheme modulation, float codeRate, unsigned int blockSize) const
+{
+    double bler;
+    getBlockErrorRates(&sinr, 1, modulation, codeRate, blockSize, &bler);
+    return bler;
+}
+
+void
+BlockErrorModel::getBlockErrorRates(const wns::Ratio* sinrs, unsigned int numSINRs, ModulationScheme modulation,
+                                    float codeRate, unsigned int blockSize, double* blers) const
+{
+    assure((codeRate > 0) && (codeRate <= 1), "Code rate bigger than 0 and <= 1 required");
+    assure(blockSize > 0, "block size must be positive");
+
+    unsigned int m = modulation.getBitsPerSymbol() / 2 - 1;
+    assure((m >= 0) && (m <= 2), "unsupported modulation");
+    
+    // everything but the SINR is resolved once for the whole batch
+    unsigned int codeBlockSize;
+    unsigned int numBlocks = getNumCodeBlocks(blockSize, codeBlockSize);
+    
+    const BLERSurface& surface = surfaces[m];
+    SurfaceCell cell = getSurfaceCell(m, codeRate, codeBlockSize);
+    
+    for (unsigned int i = 0; i < numSINRs; i++)
+    {
+        double bler = interpolate(surface, cell, sinrs[i].get_dB());
+        
+        // the transport block is lost if any of its (equally sized) code blocks is lost
+        double success = 1.0 - bler;
+        double allSuccess = success;
+        for (unsigned int block = 1; block < numBlocks; block++)
+            allSuccess *= success;
+        
+        blers[i] = 1.0 - allSuccess;
+    }
+}
+
@@ -47,8 +47,25 @@ namespace imtaphy { namespace l2s {
         public:
             BlockErrorModel();
 
+            /**
+             * @brief BLER from the dense surfaces: direct index arithmetic and interpolation over SINR and
+             * (logarithmic) block length, the code rate selects the curve and SINR shift. Stays within the
+             * error bound checked by BlockErrorModelTest of getReferenceBlockErrorRate.
+             */
             double getBlockErrorRate(wns::Ratio sinr, ModulationScheme modulation, float codeRate, unsigned int blockSize) const;
             
+            /**
+             * @brief Batch version for many SINRs with the same modulation, code rate and block size, e.g.,
+             * for HARQ or link adaptation sweeps. Writes numSINRs values to blers.
+             */
+            void getBlockErrorRates(const wns::Ratio* sinrs, unsigned int numSINRs, ModulationScheme modulation,
+                                    float codeRate, unsigned int blockSize, double* blers) const;
+            
+            /**
+             * @brief The original lookup on the link level curves that the surfaces are sampled from
+             */
+            double getReferenceBlockErrorRate(wns::Ratio sinr, ModulationScheme modulation, float codeRate, unsigned int blockSize) const;
+            
             wns::Ratio getSINRthreshold(unsigned int cqi)
             {
                 assure((cqi >= 0) && (cqi < 16), "Invalid CQI");
@@ -67,6 +84,40 @@ namespace imtaphy { namespace l2s {
         private:
             typedef imtaphy::detail::LookupTable<float, float, 3> BLERLookUpTable;
             
+            // The monotonized link level curves of one modulation resampled on a uniform SINR grid (dB) and
+            // uniform bins of log(block length), stored as bler[(blockLength * numCurves + curve) * numSINRs + sinr].
+            // A code rate maps to one curve and a SINR shift (see mapCodeRate) as in the reference, so the lookup
+            // interpolates over SINR and block length only and reproduces the reference's jump between curves.
+            struct BLERSurface
+            {
+                double minSINR_dB;
+                double stepsPerdB;
+                unsigned int numSINRs;
+                unsigned int numCurves;
+                float minLogBlockLength;
+                float stepsPerLogBlockLength;
+                unsigned int numBlockLengths;
+                std::vector<float> bler;
+            };
+            
+            // the SINR rows of the two block length bins around a code block size for one curve
+            struct SurfaceCell
+            {
+                const float* rows[2];
+                float weights[2];
+                double sinrShift_dB;
+            };
+            
+            static const unsigned int surfaceNumBlockLengths = 32;
+            
+            void mapCodeRate(unsigned int m, float codeRate, unsigned int& curve, double& shift_dB) const;
+            void buildSurface(unsigned int m, const boost::multi_array_ref<double, 2>& curves);
+            unsigned int getNumCodeBlocks(unsigned int blockSize, unsigned int& codeBlockSize) const;
+            SurfaceCell getSurfaceCell(unsigned int m, float codeRate, unsigned int codeBlockSize) const;
+            double interpolate(const BLERSurface& surface, const SurfaceCell& cell, double sinr_dB) const;
+            
+            std::vector<BLERSurface> surfaces;
+            
             std::vector<BLERLookUpTable*> blerLUTs;
        
             imtaphy::detail::Interpolation<float, float, 3> tri;
@@ -41,8 +41,8 @@ namespace imtaphy { namespace l2s {
         public:
             EffectiveSINRModelInterface() {};
             
-            virtual wns::Ratio getEffectiveSINR(std::vector<wns::Ratio> sinrs,
-                                                ModulationScheme modulation)  = 0;
+            virtual wns::Ratio getEffectiveSINR(const std::vector<wns::Ratio>& sinrs,
+                                                ModulationScheme modulation) const = 0;
             
         };
         
@@ -53,8 +53,8 @@ namespace imtaphy { namespace l2s {
             EffectiveSINRModelBase() :
                 EffectiveSINRModelInterface() {};
             
-            wns::Ratio getEffectiveSINR(std::vector<wns::Ratio> sinrs,
-                                        ModulationScheme modulation) 
+            wns::Ratio getEffectiveSINR(const std::vector<wns::Ratio>& sinrs,
+                                        ModulationScheme modulation) const
             {
                 // transform sinrs into a domain that allows taking the arithmetic mean
                 // by using the forwardMapping (e.g. compute Mean Mutual Information per Bit)
@@ -78,9 +78,9 @@ namespace imtaphy { namespace l2s {
                 
         protected:
             virtual double forwardMapping(wns::Ratio sinr,
-                                          ModulationScheme modulation)  = 0;
+                                          ModulationScheme modulation) const = 0;
             virtual wns::Ratio reverseMapping(double average,
-                                              ModulationScheme modulation) = 0;
+                                              ModulationScheme modulation) const = 0;
         };
         
     }}
@@ -29,134 +29,196 @@
 
 #include <IMTAPHY/link2System/MMIBeffectiveSINR.hpp>
 #include <math.h>
+#include <algorithm>
 
 using namespace imtaphy::l2s;
 
 MMIBeffectiveSINR::MMIBeffectiveSINR() :
     EffectiveSINRModelBase(),
-    lookForKey(1),
-    result(imtaphy::detail::getResultShape<MiSinrLutType::HyperCubeType, 1>()),
-    interpolation(),
     minSINR(pow10(-15.0 / 10.0)),
-    maxSINR(pow10(25.0 / 10.0))
+    maxSINR(pow10(25.0 / 10.0)),
+    minSINR_dB(-15.0),
+    maxSINR_dB(25.0)
 {
-    int resolution = 1000;
+    // according to Table 29 in IEEE 802.16m-08/004r5
+    terms[0].numTerms = 1;
+    terms[0].weight[0] = 1.0;        terms[0].scale[0] = 2.0;
     
-    std::vector<unsigned int> shape(1, resolution);
+    terms[1].numTerms = 3;
+    terms[1].weight[0] = 0.5;        terms[1].scale[0] = 0.8;
+    terms[1].weight[1] = 0.25;       terms[1].scale[1] = 2.17;
+    terms[1].weight[2] = 0.25;       terms[1].scale[2] = 0.965;
     
-    std::vector<double> qam16Keys(resolution);
-    std::vector<double> qam64Keys(resolution);
-    std::vector<double> sinrs(resolution);
-    std::vector<unsigned int> position(1);
+    terms[2].numTerms = 3;
+    terms[2].weight[0] = 1.0 / 3.0;  terms[2].scale[0] = 1.47;
+    terms[2].weight[1] = 1.0 / 3.0;  terms[2].scale[1] = 0.529;
+    terms[2].weight[2] = 1.0 / 3.0;  terms[2].scale[2] = 0.366;
     
-    for (int index = 0; index < resolution; index++)
+    buildInverseTable(QPSK(), inverseTables[0]);
+    buildInverseTable(QAM16(), inverseTables[1]);
+    buildInverseTable(QAM64(), inverseTables[2]);
+}
+
+void
+MMIBeffectiveSINR::buildInverseTable(ModulationScheme modulation, InverseTable& table) const
+{
+    // QPSK saturates to MMIB = 1 in double precision well below maxSINR, so the table ends where 1 - MMIB
+    // is still resolved and everything above maps to maxSINR like for averages beyond the table range
+    const double saturation = 1e-12;
+    double upper_dB = maxSINR_dB;
+    
+    if (1.0 - forwardMapping(wns::Ratio::from_dB(upper_dB), modulation) < saturation)
     {
-        sinrs[index] = (maxSINR - minSINR) * double(index)/double(resolution) + minSINR;
-        qam16Keys[index] = forwardMapping(wns::Ratio::from_factor(sinrs[index]), QAM16());
-        qam64Keys[index] = forwardMapping(wns::Ratio::from_factor(sinrs[index]), QAM64());
+        double low = minSINR_dB;
+        for (unsigned int iteration = 0; iteration < 50; iteration++)
+        {
+            double mid = 0.5 * (low + upper_dB);
+            if (1.0 - forwardMapping(wns::Ratio::from_dB(mid), modulation) < saturation)
+                upper_dB = mid;
+            else
+                low = mid;
+        }
+        upper_dB = low;
     }
-
-    minMIqam16 = *std::min_element(qam16Keys.begin(), qam16Keys.end());
-    maxMIqam16 = *std::max_element(qam16Keys.begin(), qam16Keys.end());
-    minMIqam64 = *std::min_element(qam64Keys.begin(), qam64Keys.end());
-    maxMIqam64 = *std::max_element(qam64Keys.begin(), qam64Keys.end());
     
-    qam16Lut = new MiSinrLutType(shape, std::vector<std::vector<double> >(1,qam16Keys), false);
-    qam64Lut = new MiSinrLutType(shape, std::vector<std::vector<double> >(1,qam64Keys), false);
-
-    for (int index = 0; index < resolution; index++)
+    table.minMI = forwardMapping(wns::Ratio::from_factor(minSINR), modulation);
+    table.maxMI = forwardMapping(wns::Ratio::from_dB(upper_dB), modulation);
+    
+    double minLogit = log(table.minMI) - log1p(-table.minMI);
+    double maxLogit = log(table.maxMI) - log1p(-table.maxMI);
+    
+    table.minLogit = minLogit;
+    table.stepsPerLogit = static_cast<double>(inverseTableSize - 1) / (maxLogit - minLogit);
+    table.sinr_dB.resize(inverseTableSize);
+    
+    // the forward mapping is monotonic, so each grid point can be inverted by bisection over the SINR range
+    for (unsigned int index = 0; index < inverseTableSize; index++)
     {
-        position[0] = index;
-        qam16Lut->fill(position, sinrs[index]);
-        qam64Lut->fill(position, sinrs[index]);
+        double logit = minLogit + static_cast<double>(index) / table.stepsPerLogit;
+        double low = minSINR_dB;
+        double high = upper_dB;
+        
+        for (unsigned int iteration = 0; iteration < 50; iteration++)
+        {
+            double mid = 0.5 * (low + high);
+            double mi = forwardMapping(wns::Ratio::from_dB(mid), modulation);
+            
+            if (log(mi) - log1p(-mi) < logit)
+                low = mid;
+            else
+                high = mid;
+        }
+        table.sinr_dB[index] = 0.5 * (low + high);
     }
 }
 
+const MMIBeffectiveSINR::MMIBTerms&
+MMIBeffectiveSINR::getTerms(ModulationScheme modulation) const
+{
+    unsigned int bits = modulation.getBitsPerSymbol();
+    assure((bits == 2) || (bits == 4) || (bits == 6), "unsupported modulation");
+    
+    return terms[bits / 2 - 1];
+}
+
+const MMIBeffectiveSINR::InverseTable&
+MMIBeffectiveSINR::getInverseTable(ModulationScheme modulation) const
+{
+    unsigned int bits = modulation.getBitsPerSymbol();
+    assure((bits == 2) || (bits == 4) || (bits == 6), "unsupported modulation");
+    
+    return inverseTables[bits / 2 - 1];
+}
+
 double 
-MMIBeffectiveSINR::forwardMapping(wns::Ratio _sinr, ModulationScheme modulation)
+MMIBeffectiveSINR::forwardMapping(wns::Ratio _sinr, ModulationScheme modulation) const
 {
-    double mi = 0.0;
     double sinr = _sinr.get_factor();
+    return sumOfMI(&sinr, 1, modulation);
+}
 
-    // also the J functions have limited ranges in which  they operate
-    if (sinr > maxSINR)
-        sinr = maxSINR;
-    if (sinr < minSINR)
-        sinr = minSINR;
-    
-    // according to Table 29 in IEEE 802.16m-08/004r5    
-    switch(modulation.getBitsPerSymbol())
-    {  
-        case 2:
-            mi  = J(2.0 * sqrt(sinr));
-            break;
-        case 4:
-            mi = 0.5 * J(0.8 * sqrt(sinr)) + 
-                 0.25 * J(2.17 * sqrt(sinr)) + 
-                 0.25 * J(0.965 * sqrt(sinr));
-            break;
-        case 6:
-            mi = 1.0/3.0 * J(1.47 * sqrt(sinr)) + 
-                 1.0/3.0 * J(0.529 * sqrt(sinr)) + 
-                 1.0/3.0 * J(0.366 * sqrt(sinr));
-            break;
-        default:
-            assure(0, "unsupported modulation");
+double
+MMIBeffectiveSINR::sumOfMI(const double* sinrs, unsigned int numSINRs, ModulationScheme modulation) const
+{
+    const MMIBTerms& mmib = getTerms(modulation);
+    
+    // clamp and take the square root once per SINR of a block, then one loop per term over the block
+    const unsigned int blockSize = 64;
+    double root[blockSize];
+    double sum = 0.0;
+    
+    for (unsigned int begin = 0; begin < numSINRs; begin += blockSize)
+    {
+        unsigned int size = std::min(blockSize, numSINRs - begin);
+        
+        // also the J functions have limited ranges in which they operate
+        for (unsigned int i = 0; i < size; i++)
+            root[i] = sqrt(std::min(std::max(sinrs[begin + i], minSINR), maxSINR));
+        
+        for (unsigned int term = 0; term < mmib.numTerms; term++)
+        {
+            double weight = mmib.weight[term];
+            double scale = mmib.scale[term];
+            
+            for (unsigned int i = 0; i < size; i++)
+                sum += weight * J(scale * root[i]);
+        }
     }
-    return mi;
+    
+    return sum;
 }
 
-wns::Ratio 
-MMIBeffectiveSINR::reverseMapping(double average, ModulationScheme modulation) 
+wns::Ratio
+MMIBeffectiveSINR::getEffectiveSINR(const double* sinrs, unsigned int numSINRs, ModulationScheme modulation) const
 {
-    double sinr = -1.0;
-    
-    switch(modulation.getBitsPerSymbol())
-    {  
-        case 2:
-            // revert mi  = J(2.0 * sqrt(sinr))
-            sinr = Jinv(average) / 2.0;
-            sinr *= sinr;
+    assure(numSINRs, "effective SINRs called with empty vector");
+    
+    return reverseMapping(sumOfMI(sinrs, numSINRs, modulation) / static_cast<double>(numSINRs), modulation);
+}
 
-            if (sinr < minSINR)
-                sinr = minSINR;
-            if (sinr > maxSINR)
-                sinr = maxSINR;
-            
-            break;
-        case 4:
-            if (average <= minMIqam16)
-                sinr = minSINR;
-            else if (average >= maxMIqam16)
-                sinr = maxSINR;
-            else
-            {
-                lookForKey[0] = average;
-                result = qam16Lut->getHyperCube(lookForKey);
-                sinr = interpolation.linear(result, lookForKey);
-            }
-            break;
-        case 6:
-            if (average <= minMIqam64)
-                sinr = minSINR;
-            else if (average >= maxMIqam64)
-                sinr = maxSINR;
-            else
-            {
-                lookForKey[0] = average;
-                result = qam64Lut->getHyperCube(lookForKey);
-                sinr = interpolation.linear(result, lookForKey);
-            }
-            break;
-        default:
-            assure(0, "unsupported modulation");
+wns::Ratio
+MMIBeffectiveSINR::getEffectiveSINR(const std::vector<wns::Ratio>& sinrs, ModulationScheme modulation) const
+{
+    assure(sinrs.size(), "effective SINRs called with empty vector");
+    
+    // convert to factors in blocks on the stack: no allocation per call and, unlike a member
+    // buffer, no shared state in this singleton that the receivers use from several threads
+    const unsigned int blockSize = 64;
+    double factors[blockSize];
+    double sum = 0.0;
+    
+    for (unsigned int begin = 0; begin < sinrs.size(); begin += blockSize)
+    {
+        unsigned int size = std::min(blockSize, static_cast<unsigned int>(sinrs.size()) - begin);
+        
+        for (unsigned int i = 0; i < size; i++)
+            factors[i] = sinrs[begin + i].get_factor();
+        
+        sum += sumOfMI(factors, size, modulation);
     }
     
-    return wns::Ratio::from_factor(sinr);
+    return reverseMapping(sum / static_cast<double>(sinrs.size()), modulation);
+}
+
+wns::Ratio 
+MMIBeffectiveSINR::reverseMapping(double average, ModulationScheme modulation) const
+{
+    const InverseTable& table = getInverseTable(modulation);
+    
+    if (average <= table.minMI)
+        return wns::Ratio::from_factor(minSINR);
+    if (average >= table.maxMI)
+        return wns::Ratio::from_factor(maxSINR);
+    
+    double position = (log(average) - log1p(-average) - table.minLogit) * table.stepsPerLogit;
+    unsigned int index = std::min(static_cast<unsigned int>(position), inverseTableSize - 2);
+    double fraction = position - static_cast<double>(index);
+    
+    return wns::Ratio::from_dB(table.sinr_dB[index] + fraction * (table.sinr_dB[index + 1] - table.sinr_dB[index]));
 }
 
 inline
-double MMIBeffectiveSINR::J(double x) const
+double MMIBeffectiveSINR::J(double x)
 {
     double x2 = x * x;
     double x3 = x2 * x;
@@ -166,14 +228,3 @@ double MMIBeffectiveSINR::J(double x) const
     else
         return 1.0 - exp(0.00181492 * x3 - 0.142675 * x2 - 0.0822054 * x + 0.0549608);
 }
-
-inline
-double MMIBeffectiveSINR::Jinv(double y) const
-{
-    assure((y >= 0) && (y <= 1), "y is supposed to be a mean mutual information per bit, must be between 0 and 1");
-
-    if (y < 0.3646)
-        return 1.09542 * y*y + 0.214217 * y + 2.33727 * sqrt(y);
-    else
-        return -0.706692 * log(-0.386013 * (y - 1.0)) + 1.75017 * y;
-}
\ No newline at end of file
@@ -34,9 +34,8 @@
 #include <WNS/PowerRatio.hpp>
 #include <WNS/pyconfig/View.hpp>
 #include <IMTAPHY/link2System/EffectiveSINRModelInterface.hpp>
-#include <IMTAPHY/detail/LookupTable.hpp>
-#include <IMTAPHY/detail/Interpolation.hpp>
 #include <WNS/Singleton.hpp>
+#include <vector>
 
 namespace imtaphy { namespace l2s {
 
@@ -44,6 +43,8 @@ namespace imtaphy { namespace l2s {
          * according to WiMAX 802.16m Evaluation Methodology Document
          * IEEE 802.16m-08/004r5, Section 4.3.2.1 
          * 
+         * All methods are const and only read tables built in the constructor,
+         * so a single instance can be used from parallel threads.
          * */
     
         class MMIBeffectiveSINR :
@@ -52,26 +53,52 @@ namespace imtaphy { namespace l2s {
         public:
             MMIBeffectiveSINR();
             
+            wns::Ratio getEffectiveSINR(const std::vector<wns::Ratio>& sinrs,
+                                        ModulationScheme modulation) const;
+            
+            /**
+             * @brief Batch version for linear (factor) SINRs, e.g., all PRBs of one layer of a transport block
+             */
+            wns::Ratio getEffectiveSINR(const double* sinrs,
+                                        unsigned int numSINRs,
+                                        ModulationScheme modulation) const;
+            
             double forwardMapping(wns::Ratio sinr,
-                                  ModulationScheme modulation) ;
+                                  ModulationScheme modulation) const;
             wns::Ratio reverseMapping(double average,
-                                      ModulationScheme modulation);
+                                      ModulationScheme modulation) const;
         private:
-            typedef imtaphy::detail::LookupTable<double, double, 1> MiSinrLutType;
-
-            double J(double x) const;
-            double Jinv(double y) const;
-
-            std::vector<double> lookForKey;
-            MiSinrLutType::HyperCubeType result;
-            imtaphy::detail::Interpolation<double, double, 1> interpolation;
+            // MMIB(sinr) = sum over terms of weight * J(scale * sqrt(sinr)), Table 29 in IEEE 802.16m-08/004r5
+            struct MMIBTerms
+            {
+                unsigned int numTerms;
+                double weight[3];
+                double scale[3];
+            };
             
-            MiSinrLutType* qam16Lut;
-            MiSinrLutType* qam64Lut;
+            // SINR in dB sampled on a uniform grid of logit(MMIB) = log(MMIB / (1 - MMIB)), which
+            // resolves both the flat low and the saturating high end of the curve
+            struct InverseTable
+            {
+                double minMI, maxMI;
+                double minLogit, stepsPerLogit;
+                std::vector<double> sinr_dB;
+            };
+            
+            static const unsigned int inverseTableSize = 1024;
+            
+            static double J(double x);
+            double sumOfMI(const double* sinrs, unsigned int numSINRs, ModulationScheme modulation) const;
+            const MMIBTerms& getTerms(ModulationScheme modulation) const;
+            const InverseTable& getInverseTable(ModulationScheme modulation) const;
+            void buildInverseTable(ModulationScheme modulation, InverseTable& table) const;
+
+            // indexed by bits per symbol / 2 - 1, i.e., QPSK, 16QAM, 64QAM
+            MMIBTerms terms[3];
+            InverseTable inverseTables[3];
 
             double minSINR, maxSINR;
-            double minMIqam16, maxMIqam16;
-            double minMIqam64, maxMIqam64;
+            double minSINR_dB, maxSINR_dB;
         };
         
         typedef wns::SingletonHolder<MMIBeffectiveSINR> TheMMIBEffectiveSINRModel;
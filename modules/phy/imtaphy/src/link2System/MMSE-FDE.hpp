@@ -41,21 +41,35 @@ namespace imtaphy { namespace l2s {
             MMSEFrequencyDomainEqualization() :
                 EffectiveSINRModelInterface() {};
             
-            wns::Ratio getEffectiveSINR(std::vector<wns::Ratio> sinrs,
-                                        ModulationScheme modulation) 
+            wns::Ratio getEffectiveSINR(const std::vector<wns::Ratio>& sinrs,
+                                        ModulationScheme modulation) const
+            {
+                std::vector<double> factors(sinrs.size());
+                for (unsigned int k = 0; k < sinrs.size(); k++)
+                    factors[k] = sinrs[k].get_factor();
+
+                return getEffectiveSINR(&factors[0], factors.size(), modulation);
+            }
+
+            /**
+             * @brief Batch version for linear (factor) SINRs, e.g., all PRBs of one layer of a transport block
+             */
+            wns::Ratio getEffectiveSINR(const double* sinrs,
+                                        unsigned int numSINRs,
+                                        ModulationScheme /* modulation */) const
             {
                 // Effect of Frequency Domain MMSE Equalization for the SC-FDMA uplink
                 // according to R1-050718 and R1-051352
                 
                 double lambda = 0.0;
-                double K = sinrs.size();
+                double K = numSINRs;
                 
-                for (unsigned int k = 0; k < sinrs.size(); k++)
+                for (unsigned int k = 0; k < numSINRs; k++)
                 {
-                    lambda += sinrs[k].get_factor() / (sinrs[k].get_factor() + 1.0);
+                    lambda += sinrs[k] / (sinrs[k] + 1.0);
                 }
                 
-                double gamma = pow(lambda, 2.0) / (K*lambda - pow(lambda, 2.0));
+                double gamma = (lambda * lambda) / (K*lambda - lambda * lambda);
                 
                 return wns::Ratio::from_factor(gamma);
             }
@@ -37,6 +37,9 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 
 namespace imtaphy { namespace l2s { namespace tests {
 
@@ -47,6 +50,8 @@ namespace imtaphy { namespace l2s { namespace tests {
 
                 CPPUNIT_TEST_SUITE( BlockErrorModelTest );
                 CPPUNIT_TEST( outputCurves );
+                CPPUNIT_TEST( surfaceErrorBound );
+                CPPUNIT_TEST( batch );
                 CPPUNIT_TEST_SUITE_END();
 
             public:
@@ -54,6 +59,8 @@ namespace imtaphy { namespace l2s { namespace tests {
                 void setUp();
                 void tearDown();
                 void outputCurves();
+                void surfaceErrorBound();
+                void batch();
 
             private:
             };
@@ -178,5 +185,58 @@ namespace imtaphy { namespace l2s { namespace tests {
             }
 
 
+
+            void
+            BlockErrorModelTest::surfaceErrorBound()
+            {
+                // The dense surfaces only differ from the reference lookup by sampling the block length
+                // dimension in logarithmic bins. Check all modulations over code rates and block sizes
+                // inside and outside of the link level ranges, including segmented transport blocks.
+                imtaphy::l2s::BlockErrorModel blerModel;
+
+                std::vector<ModulationScheme> modulations;
+                modulations.push_back(QPSK());
+                modulations.push_back(QAM16());
+                modulations.push_back(QAM64());
+
+                double maxError = 0.0;
+
+                for (unsigned int m = 0; m < modulations.size(); m++)
+                    for (unsigned int blockSize = 40; blockSize < 20000; blockSize = blockSize * 3 / 2 + 7)
+                        for (int codeRate = 5; codeRate < 100; codeRate += 3)
+                            for (int sinrIdx = -120; sinrIdx < 260; sinrIdx++)
+                            {
+                                // avoid hitting the link level SINR grid only
+                                wns::Ratio sinr = wns::Ratio::from_dB(sinrIdx / 10. + 0.037);
+                                float cr = static_cast<float>(codeRate) / 100.0;
+
+                                double error = fabs(blerModel.getBlockErrorRate(sinr, modulations[m], cr, blockSize) -
+                                                    blerModel.getReferenceBlockErrorRate(sinr, modulations[m], cr, blockSize));
+                                maxError = std::max(maxError, error);
+                            }
+
+                CPPUNIT_ASSERT(maxError < 0.01);
+            }
+
+            void
+            BlockErrorModelTest::batch()
+            {
+                imtaphy::l2s::BlockErrorModel blerModel;
+
+                std::vector<wns::Ratio> sinrs;
+                for (int sinrIdx = -150; sinrIdx < 300; sinrIdx++)
+                    sinrs.push_back(wns::Ratio::from_dB(sinrIdx / 10.));
+
+                std::vector<double> blers(sinrs.size());
+
+                // single and segmented code block
+                blerModel.getBlockErrorRates(&sinrs[0], sinrs.size(), QAM16(), 0.45, 3000, &blers[0]);
+                for (unsigned int i = 0; i < sinrs.size(); i++)
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(blerModel.getBlockErrorRate(sinrs[i], QAM16(), 0.45, 3000), blers[i], 1e-12);
+
+                blerModel.getBlockErrorRates(&sinrs[0], sinrs.size(), QAM64(), 0.8, 30000, &blers[0]);
+                for (unsigned int i = 0; i < sinrs.size(); i++)
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(blerModel.getBlockErrorRate(sinrs[i], QAM64(), 0.8, 30000), blers[i], 1e-12);
+            }
 }}}
 
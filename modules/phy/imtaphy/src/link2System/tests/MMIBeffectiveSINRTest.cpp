@@ -44,6 +44,7 @@ namespace imtaphy { namespace l2s { namespace tests {
                     CPPUNIT_TEST_SUITE( MMIBeffectiveSINRTest );
                     CPPUNIT_TEST( testForwardReverse );
                     CPPUNIT_TEST( testEffectiveSINR );
+                    CPPUNIT_TEST( testBatch );
                     CPPUNIT_TEST_SUITE_END();
 
                 public:
@@ -52,6 +53,7 @@ namespace imtaphy { namespace l2s { namespace tests {
                     void tearDown();
                     void testForwardReverse();
                     void testEffectiveSINR();
+                    void testBatch();
                     
         
                 private:
@@ -146,5 +148,42 @@ namespace imtaphy { namespace l2s { namespace tests {
                     CPPUNIT_ASSERT_DOUBLES_EQUAL(mapper.getEffectiveSINR(sinrsHigh, imtaphy::l2s::QPSK()).get_dB(), 25, 0.1);
 
                 }
-}}}
 
+                void
+                MMIBeffectiveSINRTest::testBatch()
+                {
+                    // the batch API must give the same result as averaging the forward mappings of the individual SINRs
+                    const MMIBeffectiveSINR mapper;
+                    
+                    std::vector<ModulationScheme> modulations;
+                    modulations.push_back(QPSK());
+                    modulations.push_back(QAM16());
+                    modulations.push_back(QAM64());
+                    
+                    // more than one block of the vectorized loop and SINRs outside of the mapping range
+                    std::vector<double> sinrs;
+                    std::vector<wns::Ratio> ratios;
+                    for (int i = 0; i < 150; i++)
+                    {
+                        sinrs.push_back(pow(10.0, (i % 50 - 20) / 10.0));
+                        ratios.push_back(wns::Ratio::from_factor(sinrs.back()));
+                    }
+                    
+                    for (unsigned int m = 0; m < modulations.size(); m++)
+                    {
+                        double average = 0.0;
+                        for (unsigned int i = 0; i < ratios.size(); i++)
+                            average += mapper.forwardMapping(ratios[i], modulations[m]);
+                        average /= static_cast<double>(ratios.size());
+                        
+                        double expected = mapper.reverseMapping(average, modulations[m]).get_dB();
+                        
+                        CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, mapper.getEffectiveSINR(&sinrs[0], sinrs.size(), modulations[m]).get_dB(), 1e-06);
+                        CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, mapper.getEffectiveSINR(ratios, modulations[m]).get_dB(), 1e-06);
+                        
+                        // a single SINR inside the range must come back almost unchanged
+                        double single = pow(10.0, 0.75);
+                        CPPUNIT_ASSERT_DOUBLES_EQUAL(7.5, mapper.getEffectiveSINR(&single, 1, modulations[m]).get_dB(), 0.02);
+                    }
+                }
+}}}
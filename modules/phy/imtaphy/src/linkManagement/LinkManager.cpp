@@ -28,6 +28,7 @@
  ******************************************************************************/
 
 #include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <IMTAPHY/linkManagement/StartupCache.hpp>
 #include <IMTAPHY/linkManagement/classifier/LinkClassifierInterface.hpp>
 #include <IMTAPHY/spatialChannel/No.hpp>
 #include <IMTAPHY/ChannelModuleCreator.hpp>
@@ -35,6 +36,10 @@
 #include <IMTAPHY/Channel.hpp>
 #include <WNS/distribution/DiscreteUniform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
 using namespace imtaphy;
 
 LinkManager::LinkManager(Channel* channel_, StationList bsList, StationList msList, wns::pyconfig::View config_) :
@@ -224,28 +229,46 @@ void LinkManager::computeRSRPbasedOnSCM(imtaphy::scm::SpatialChannelModelInterfa
 
     // evolve to multiple time instances to allow for averaging over time-selective channel
     unsigned int count = 0;
+    unsigned int numPRBs = spectrum->getNumberOfPRBs(direction);
+    int numLinks = links.size();
     for (unsigned int tti = 1; tti < 500; tti += 100)
     {
         scm->evolve(static_cast<double>(tti) / 1000.0);
 
-        for (LinkVector::const_iterator iter = links.begin(); iter != links.end(); iter++)
+        // links are independent: each thread only reads the channel and writes its own links' RSRP.
+        // The raw channel matrices avoid allocating a matrix view per link and PRB
+        int k;
+#if defined(_OPENMP) && !defined(__APPLE__)
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+        for (k = 0; k < numLinks; k++)
         {
-            unsigned int numMSantenna = (*iter)->getMS()->getAntenna()->getNumberOfElements();
-            unsigned int numBSantenna = (*iter)->getBS()->getAntenna()->getNumberOfElements();
+            Link* link = links[k];
+            unsigned int numMSantenna = link->getMS()->getAntenna()->getNumberOfElements();
+            unsigned int numBSantenna = link->getBS()->getAntenna()->getNumberOfElements();
             double gain = 0.0;
 
-            for (unsigned int prb = 0; prb < spectrum->getNumberOfPRBs(direction); prb = prb + 1)
+            // all PRBs of a link share the dimensions of the first one
+            imtaphy::detail::ComplexFloatMatrixPtr firstMatrix = link->getChannelMatrix(direction, 0);
+            unsigned int numEntries = firstMatrix->getRows() * firstMatrix->getColumns();
+
+            for (unsigned int prb = 0; prb < numPRBs; prb++)
             {
-                imtaphy::detail::ComplexFloatMatrixPtr channelMatrix = (*iter)->getChannelMatrix(direction, prb);
+                const std::complex<float>* h = link->getRawChannelMatrix(direction, prb);
 
-                gain += pow(imtaphy::detail::matrixNorm(*channelMatrix), 2.0);
+                // squared Frobenius norm, accumulated in float like matrixNorm
+                float prbGain = 0.0;
+                for (unsigned int i = 0; i < numEntries; i++)
+                    prbGain += std::norm(h[i]);
+
+                gain += prbGain;
             }
 
-            gain /= static_cast<double>(spectrum->getNumberOfPRBs(direction));
+            gain /= static_cast<double>(numPRBs);
 
             // compute the linear average over frequency bins of the current channel gain
             // normalize transmit power by transmit antennas s
-            (*iter)->RSRP += wns::Power::from_mW((referenceTxPower.get_mW() / static_cast<double>(numMSantenna*numBSantenna)) * gain);
+            link->RSRP += wns::Power::from_mW((referenceTxPower.get_mW() / static_cast<double>(numMSantenna*numBSantenna)) * gain);
         } // end loop over all links
 
         count++;
@@ -281,13 +304,23 @@ void LinkManager::doAfterSCMinit(imtaphy::scm::SpatialChannelModelInterface< flo
     {
         if (useSCMforRSRP)
         {
-            computeRSRPbasedOnSCM(scm, spectrum);
+            StartupCache* cache = channel ? channel->getStartupCache() : NULL;
+            if (cache && cache->isHit())
+            {
+                for (unsigned int i = 0; i < links.size(); i++)
+                    links[i]->RSRP = cache->getRSRP(i);
+            }
+            else
+                computeRSRPbasedOnSCM(scm, spectrum);
         }
         else
         {
             computeRSRPbasedOnWBL();
         }
         determineServingLinks();
+
+        if (!prunedLinks.empty())
+            reportPruning(scm);
     }
     else
     {
@@ -321,6 +354,71 @@ void LinkManager::doAfterSCMinit(imtaphy::scm::SpatialChannelModelInterface< flo
     MESSAGE_END();
 }
 
+bool
+LinkManager::isRelevantForSCM(Link* link, wns::Ratio threshold)
+{
+    // compare against the strongest (least wideband loss) link of the same mobile, which will 
+    // typically become its serving link
+    const LinkMap& linksForThisMS = linksPerStation[link->getMS()];
+    wns::Ratio bestLoss = link->getWidebandLoss();
+    
+    for (LinkMap::const_iterator iter = linksForThisMS.begin(); iter != linksForThisMS.end(); iter++)
+    {
+        if (iter->second->getWidebandLoss() < bestLoss)
+            bestLoss = iter->second->getWidebandLoss();
+    }
+    
+    return (link->getWidebandLoss() - bestLoss) <= threshold;
+}
+
+void
+LinkManager::reportPruning(imtaphy::scm::SpatialChannelModelInterface< float >* scm)
+{
+    // Pruned links get a flat channel with the same average power, so the mean interference is preserved
+    // and only its fast fading is lost. As a conservative bound for the SINR error we report by how much
+    // the SINR would change if the pruned links' interference was missing altogether.
+    double sumErrorDB = 0.0;
+    double maxErrorDB = 0.0;
+    unsigned int numMobiles = 0;
+    
+    for (StationList::const_iterator msIter = mobileStations.begin(); msIter != mobileStations.end(); msIter++)
+    {
+        if (servingLinks.find(*msIter) == servingLinks.end())
+            continue;
+        
+        Link* servingLink = servingLinks[*msIter];
+        const LinkMap& linksForThisMS = linksPerStation[*msIter];
+        double keptInterference = 0.0;
+        double prunedInterference = 0.0;
+        
+        for (LinkMap::const_iterator iter = linksForThisMS.begin(); iter != linksForThisMS.end(); iter++)
+        {
+            Link* link = iter->second;
+            if (link == servingLink)
+                continue;
+            
+            if (link->isSCM())
+                keptInterference += 1.0 / link->getWidebandLoss().get_factor();
+            else
+                prunedInterference += 1.0 / link->getWidebandLoss().get_factor();
+        }
+
+        double errorDB = (keptInterference > 0.0) ? 10.0 * log10(1.0 + prunedInterference / keptInterference) : 0.0;
+        sumErrorDB += errorDB;
+        maxErrorDB = std::max(maxErrorDB, errorDB);
+        numMobiles++;
+    }
+
+    double savedMB = static_cast<double>(prunedLinks.size()) * static_cast<double>(scm->getStateBytesPerLink()) / (1024.0 * 1024.0);
+    
+    MESSAGE_BEGIN(NORMAL, logger, m, "");
+        m << "Pruned " << prunedLinks.size() << " of " << links.size() << " links from the SCM (threshold " 
+          << config.get<wns::Ratio>("scmPruningThreshold") << "), saving " << savedMB << " MB of channel state. "
+          << "SINR error bound: mean " << (numMobiles > 0 ? sumErrorDB / static_cast<double>(numMobiles) : 0.0) 
+          << " dB, max " << maxErrorDB << " dB";
+    MESSAGE_END();
+}
+
 void LinkManager::doBeforeSCMinit()
 {
     // determine SCM links (based on serving links which were computed based on widebandloss)
@@ -330,11 +428,22 @@ void LinkManager::doBeforeSCMinit()
     
     if ((scmCriterion == "all") || (scmCriterion == "All"))
     {   // add all links
-    for (LinkVector::const_iterator iter = links.begin();
-         iter < links.end(); iter++)
-         {
-             scmLinks.push_back(*iter);
-         }
+        // optionally, links far below the mobile's strongest link are not modeled by the SCM because their
+        // fast-fading state would cost a lot of memory but they hardly contribute to the interference
+        bool pruning = config.knows("scmPruningThreshold") && !config.isNone("scmPruningThreshold");
+        wns::Ratio threshold;
+        if (pruning)
+            threshold = config.get<wns::Ratio>("scmPruningThreshold");
+        
+        prunedLinks.clear();
+        for (LinkVector::const_iterator iter = links.begin();
+             iter < links.end(); iter++)
+        {
+            if (!pruning || isRelevantForSCM(*iter, threshold))
+                scmLinks.push_back(*iter);
+            else
+                prunedLinks.push_back(*iter);
+        }
          
     }
     else
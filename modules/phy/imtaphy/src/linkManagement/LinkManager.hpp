@@ -74,14 +74,23 @@ namespace imtaphy {
         wns::Power getRSRPReferenceTxPower() const {return referenceTxPower;}
 
         imtaphy::linkclassify::LinkClassifierInterface* getClassifier() {return linkClassifier;}
+
+        /**
+         * @brief Links that would have been SCM links but whose wideband loss is more than the 
+         * configured scmPruningThreshold above the mobile's best link. They use a flat channel instead.
+         */
+        LinkVector getPrunedLinks() const {return prunedLinks;}
               
     protected:
         void computeRSRPbasedOnWBL();
         void computeRSRPbasedOnSCM(scm::SpatialChannelModelInterface<float>* scmm, imtaphy::Spectrum* spectrum);
+        bool isRelevantForSCM(Link* link, wns::Ratio threshold);
+        void reportPruning(scm::SpatialChannelModelInterface<float>* scm);
 
         
         LinkVector links;
         LinkVector scmLinks;
+        LinkVector prunedLinks;
 
         StationList baseStations;
         StationList mobileStations;
@@ -0,0 +1,274 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <IMTAPHY/linkManagement/StartupCache.hpp>
+#include <IMTAPHY/StationPhy.hpp>
+#include <WNS/Assure.hpp>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+using namespace imtaphy;
+
+namespace {
+    const char cacheMagic[8] = {'I', 'M', 'T', 'A', 'S', 'U', 'C', '\0'};
+    const boost::uint32_t cacheVersion = 1;
+
+    struct CacheHeader
+    {
+        char magic[8];
+        boost::uint32_t version;
+        boost::uint32_t numLinks;
+        boost::uint64_t key;
+        boost::uint32_t rngStateSize;
+        boost::uint32_t reserved;
+    };
+
+    class FNV1a
+    {
+    public:
+        FNV1a() : state(14695981039346656037ULL) {}
+
+        void add(const void* data, unsigned int bytes)
+        {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            for (unsigned int i = 0; i < bytes; i++)
+            {
+                state ^= p[i];
+                state *= 1099511628211ULL;
+            }
+        }
+
+        template <typename T>
+        void add(T value) {add(&value, sizeof(T));}
+
+        void add(const wns::Position& position)
+        {
+            add<double>(position.getX());
+            add<double>(position.getY());
+            add<double>(position.getZ());
+        }
+
+        boost::uint64_t get() const {return state;}
+    private:
+        boost::uint64_t state;
+    };
+}
+
+StartupCache::StartupCache(const std::string& directory, boost::uint64_t _key) :
+    key(_key),
+    hit(false)
+{
+    // an existing directory is fine, any other problem shows up when storing
+    mkdir(directory.c_str(), 0755);
+
+    std::stringstream name;
+    name << directory << "/imtaphy-startup-" << std::hex << std::setw(16) << std::setfill('0') << key << ".cache";
+    fileName = name.str();
+}
+
+boost::uint64_t
+StartupCache::hashScenario(unsigned int seed, const LinkVector& links, const Spectrum* spectrum,
+                           const std::string& configFingerprint)
+{
+    FNV1a hash;
+
+    hash.add<boost::uint32_t>(cacheVersion);
+    hash.add<boost::uint32_t>(seed);
+    hash.add(configFingerprint.data(), configFingerprint.size());
+
+    for (unsigned int d = 0; d < 2; d++)
+    {
+        Direction direction = d == 0 ? Downlink : Uplink;
+        hash.add<boost::uint32_t>(spectrum->getNumberOfPRBs(direction));
+        hash.add<double>(spectrum->getSystemCenterFrequencyHz(direction));
+    }
+    hash.add<double>(spectrum->getPRBbandWidthHz());
+
+    hash.add<boost::uint32_t>(links.size());
+    for (LinkVector::const_iterator iter = links.begin(); iter != links.end(); iter++)
+    {
+        hash.add((*iter)->getBS()->getPosition());
+        hash.add((*iter)->getMS()->getPosition());
+        hash.add((*iter)->getWrappedMSposition());
+        hash.add<boost::int32_t>((*iter)->getScenario());
+        hash.add<boost::int32_t>((*iter)->getPropagation());
+        hash.add<boost::int32_t>((*iter)->getOutdoorPropagation());
+        hash.add<boost::int32_t>((*iter)->getUserLocation());
+        hash.add<boost::uint32_t>((*iter)->getBS()->getAntenna()->getNumberOfElements());
+        hash.add<boost::uint32_t>((*iter)->getMS()->getAntenna()->getNumberOfElements());
+    }
+
+    return hash.get();
+}
+
+bool
+StartupCache::load(unsigned int numLinks)
+{
+    hit = false;
+
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (file == NULL)
+        return false;
+
+    CacheHeader header;
+    bool valid = (fread(&header, sizeof(CacheHeader), 1, file) == 1) &&
+        (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0) &&
+        (header.version == cacheVersion) &&
+        (header.key == key) &&
+        (header.numLinks == numLinks);
+
+    if (valid)
+    {
+        std::vector<boost::int32_t> state(header.rngStateSize);
+        records.resize(numLinks);
+
+        valid = (header.rngStateSize == 0 || fread(&state[0], sizeof(boost::int32_t), state.size(), file) == state.size()) &&
+            (numLinks == 0 || fread(&records[0], sizeof(LinkRecord), numLinks, file) == numLinks);
+
+        rngState.set_size(state.size());
+        for (unsigned int i = 0; i < state.size(); i++)
+            rngState[i] = state[i];
+    }
+    fclose(file);
+
+    if (!valid)
+        records.clear();
+
+    hit = valid;
+    return hit;
+}
+
+lsparams::LSmap*
+StartupCache::getLargeScaleParameters(const LinkVector& links) const
+{
+    assure(hit, "No startup cache loaded");
+    assure(links.size() == records.size(), "Number of links does not match the startup cache");
+
+    lsparams::LSmap* lsParams = new lsparams::LSmap();
+    for (unsigned int i = 0; i < links.size(); i++)
+    {
+        if (!records[i].hasLargeScaleParameters)
+            continue;
+
+        lsparams::LargeScaleParameters& params = (*lsParams)[links[i]];
+        params.setDelaySpread(records[i].delaySpread);
+        params.setAngularSpreadDeparture(records[i].angularSpreadDeparture);
+        params.setAngularSpreadArrival(records[i].angularSpreadArrival);
+        params.setShadowFading(records[i].shadowFading);
+        params.setRiceanK(records[i].riceanK);
+    }
+    return lsParams;
+}
+
+wns::Power
+StartupCache::getRSRP(unsigned int linkIndex) const
+{
+    assure(hit, "No startup cache loaded");
+    assure(linkIndex < records.size(), "Invalid link index");
+
+    return wns::Power::from_mW(records[linkIndex].rsrpMW);
+}
+
+unsigned int
+StartupCache::checkWidebandLoss(const LinkVector& links, double toleranceDB) const
+{
+    assure(hit, "No startup cache loaded");
+    assure(links.size() == records.size(), "Number of links does not match the startup cache");
+
+    for (unsigned int i = 0; i < links.size(); i++)
+    {
+        if (fabs(links[i]->getWidebandLoss().get_dB() - records[i].widebandLossDB) > toleranceDB)
+            return i;
+    }
+    return links.size();
+}
+
+bool
+StartupCache::store(const LinkVector& links, const lsparams::LSmap* lsParams) const
+{
+    std::vector<LinkRecord> output(links.size());
+    for (unsigned int i = 0; i < links.size(); i++)
+    {
+        LinkRecord& record = output[i];
+        memset(&record, 0, sizeof(LinkRecord));
+
+        lsparams::LSmap::const_iterator params = lsParams->find(links[i]);
+        if (params != lsParams->end())
+        {
+            record.delaySpread = params->second.getDelaySpread();
+            record.angularSpreadDeparture = params->second.getAngularSpreadDeparture();
+            record.angularSpreadArrival = params->second.getAngularSpreadArrival();
+            record.shadowFading = params->second.getShadowFading();
+            record.riceanK = params->second.getRicanK();
+            record.hasLargeScaleParameters = 1;
+        }
+        record.widebandLossDB = links[i]->getWidebandLoss().get_dB();
+        record.rsrpMW = links[i]->getRSRP().get_mW();
+    }
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(CacheHeader));
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.numLinks = links.size();
+    header.key = key;
+    header.rngStateSize = rngState.size();
+
+    std::vector<boost::int32_t> state(rngState.size());
+    for (unsigned int i = 0; i < state.size(); i++)
+        state[i] = rngState[i];
+
+    std::stringstream tempName;
+    tempName << fileName << ".tmp." << getpid();
+
+    FILE* file = fopen(tempName.str().c_str(), "wb");
+    if (file == NULL)
+        return false;
+
+    bool written = (fwrite(&header, sizeof(CacheHeader), 1, file) == 1) &&
+        (state.empty() || fwrite(&state[0], sizeof(boost::int32_t), state.size(), file) == state.size()) &&
+        (output.empty() || fwrite(&output[0], sizeof(LinkRecord), output.size(), file) == output.size());
+    if (fclose(file) != 0)
+        written = false;
+
+    if (!written || (rename(tempName.str().c_str(), fileName.c_str()) != 0))
+    {
+        // a partial file must not stay behind, load() would reject it anyway
+        std::remove(tempName.str().c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef IMTAPHY_LINKMANAGEMENT_STARTUPCACHE_HPP
+#define IMTAPHY_LINKMANAGEMENT_STARTUPCACHE_HPP
+
+#include <IMTAPHY/Link.hpp>
+#include <IMTAPHY/Spectrum.hpp>
+#include <IMTAPHY/lsParams/LargeScaleParameters.hpp>
+#include <WNS/PowerRatio.hpp>
+
+#include <itpp/base/vec.h>
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <string>
+
+namespace imtaphy {
+
+    /**
+     * @brief On-disk cache of everything the channel computes per drop before the
+     * first TTI: the correlated large scale parameters, the wideband losses and the
+     * SCM based RSRPs that determine the cell association.
+     *
+     * A cache file is identified by a hash over the it++ seed, the positions and
+     * classification of all links, the spectrum and a configuration fingerprint.
+     * Together with the large scale parameters the it++ generator state after their
+     * generation is stored, so a run that hits the cache draws the same fast fading
+     * realization as the run that wrote it.
+     */
+    class StartupCache
+    {
+    public:
+        StartupCache(const std::string& directory, boost::uint64_t key);
+
+        /**
+         * @brief FNV-1a hash over everything the startup results depend on. Links
+         * have to be passed in LinkManager::getAllLinks() order.
+         */
+        static boost::uint64_t
+        hashScenario(unsigned int seed, const LinkVector& links, const Spectrum* spectrum,
+                     const std::string& configFingerprint);
+
+        /**
+         * @brief Tries to read the cache file, returns false if it does not exist
+         * or belongs to a different scenario
+         */
+        bool load(unsigned int numLinks);
+
+        bool isHit() const {return hit;}
+        std::string getFileName() const {return fileName;}
+
+        // only valid after a successful load()
+        lsparams::LSmap* getLargeScaleParameters(const LinkVector& links) const;
+        const itpp::ivec& getRNGState() const {return rngState;}
+        wns::Power getRSRP(unsigned int linkIndex) const;
+
+        /**
+         * @brief Compares the cached wideband losses with the ones computed in this
+         * run and returns the index of the first link that deviates by more than
+         * toleranceDB or links.size() if all of them match
+         */
+        unsigned int checkWidebandLoss(const LinkVector& links, double toleranceDB) const;
+
+        // to be set right after generating the large scale parameters on a miss
+        void setRNGState(const itpp::ivec& state) {rngState = state;}
+
+        /**
+         * @brief Writes the cache file. The file is written under a temporary name
+         * and renamed so that concurrently started runs never see partial files.
+         * Returns false if the file could not be written, the cache is only an
+         * optimization so the run continues without it.
+         */
+        bool store(const LinkVector& links, const lsparams::LSmap* lsParams) const;
+
+    private:
+        struct LinkRecord
+        {
+            double delaySpread;
+            double angularSpreadDeparture;
+            double angularSpreadArrival;
+            double shadowFading;
+            double riceanK;
+            double widebandLossDB;
+            double rsrpMW;
+            boost::uint32_t hasLargeScaleParameters;
+            boost::uint32_t reserved;
+        };
+
+        std::string fileName;
+        boost::uint64_t key;
+        bool hit;
+        itpp::ivec rngState;
+        std::vector<LinkRecord> records;
+    };
+}
+
+#endif
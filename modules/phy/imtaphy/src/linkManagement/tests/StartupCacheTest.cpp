@@ -0,0 +1,267 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <WNS/node/Registry.hpp>
+
+#include <IMTAPHY/linkManagement/StartupCache.hpp>
+#include <IMTAPHY/tests/ChannelStub.hpp>
+#include <IMTAPHY/tests/StationPhyStub.hpp>
+#include <IMTAPHY/Spectrum.hpp>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <sstream>
+
+namespace imtaphy { namespace tests {
+
+    // the RSRP is only set by the LinkManager, the cache needs it for storing
+    class LinkWithRSRPStub :
+        public imtaphy::LinkStub
+    {
+    public:
+        LinkWithRSRPStub(StationPhy* bs, StationPhy* ms, wns::Ratio widebandLoss, wns::Power rsrp) :
+            imtaphy::LinkStub(bs, ms, imtaphy::Link::UMa, imtaphy::Link::NLoS, imtaphy::Link::NLoS, imtaphy::Link::NotApplicable,
+                              ms->getPosition(), widebandLoss, imtaphy::Link::NonSCMLink)
+        {
+            RSRP = rsrp;
+        }
+
+        void setWidebandLoss(wns::Ratio loss) {widebandLoss = loss;}
+    };
+
+    class StartupCacheTest :
+        public CppUnit::TestFixture
+    {
+        CPPUNIT_TEST_SUITE( StartupCacheTest );
+        CPPUNIT_TEST( roundTrip );
+        CPPUNIT_TEST( keyMismatch );
+        CPPUNIT_TEST( truncatedFile );
+        CPPUNIT_TEST( notWritable );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        void roundTrip();
+        void keyMismatch();
+        void truncatedFile();
+        void notWritable();
+
+    private:
+        boost::uint64_t key(const std::string& fingerprint) const
+        {
+            return StartupCache::hashScenario(42, links, channel->getSpectrum(), fingerprint);
+        }
+
+        // stores the cache file for key("test") and returns its name
+        std::string store();
+
+        static const unsigned int numMS = 3;
+        static const std::string directory;
+
+        ChannelStub* channel;
+        wns::node::Registry* registry;
+        LinkVector links;
+        lsparams::LSmap lsParams;
+        itpp::ivec rngState;
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( StartupCacheTest );
+
+    const std::string StartupCacheTest::directory = "StartupCacheTest.dir";
+
+    void
+    StartupCacheTest::setUp()
+    {
+        channel = new ChannelStub();
+        channel->setSpectrum(new imtaphy::Spectrum(2E09, 180000.0, 10, 10));
+        registry = new wns::node::Registry();
+
+        double lambda = channel->getSpectrum()->getSystemCenterFrequencyWavelenghtMeters(imtaphy::Downlink);
+        StationPhyStub* bs = createStationStub("BS", wns::Position(0, 0, 25), "BS", 4, 0.5 * lambda, 0, registry, channel);
+        for (unsigned int k = 0; k < numMS; k++)
+        {
+            std::stringstream name;
+            name << "MS" << k;
+            StationPhyStub* ms = createStationStub(name.str(), wns::Position(100.0 + 20.0 * k, 50, 1.5), "MS", 2, 0.5 * lambda, 3.0, registry, channel);
+            links.push_back(new LinkWithRSRPStub(bs, ms, wns::Ratio::from_dB(90.0 + k), wns::Power::from_dBm(-80.0 - k)));
+
+            // the last link has no large scale parameters like links that are not simulated with the SCM
+            if (k + 1 < numMS)
+            {
+                lsparams::LargeScaleParameters& params = lsParams[links[k]];
+                params.setDelaySpread(3.6e-7 * (k + 1));
+                params.setAngularSpreadDeparture(12.5 + k);
+                params.setAngularSpreadArrival(60.0 - k);
+                params.setShadowFading(1.0 / (k + 3));
+                params.setRiceanK(0.5 * k);
+            }
+        }
+
+        rngState.set_size(5);
+        for (int i = 0; i < rngState.size(); i++)
+            rngState[i] = 1000 * i - 7;
+    }
+
+    void
+    StartupCacheTest::tearDown()
+    {
+        std::remove(StartupCache(directory, key("test")).getFileName().c_str());
+        std::remove(StartupCache(directory, key("other")).getFileName().c_str());
+        rmdir(directory.c_str());
+
+        for (unsigned int i = 0; i < links.size(); i++)
+            delete static_cast<LinkWithRSRPStub*>(links[i]);
+        links.clear();
+        lsParams.clear();
+    }
+
+    std::string
+    StartupCacheTest::store()
+    {
+        StartupCache cache(directory, key("test"));
+        CPPUNIT_ASSERT(!cache.load(links.size()));
+        CPPUNIT_ASSERT(!cache.isHit());
+
+        cache.setRNGState(rngState);
+        CPPUNIT_ASSERT(cache.store(links, &lsParams));
+        return cache.getFileName();
+    }
+
+    void
+    StartupCacheTest::roundTrip()
+    {
+        store();
+
+        StartupCache cache(directory, key("test"));
+        CPPUNIT_ASSERT(cache.load(links.size()));
+        CPPUNIT_ASSERT(cache.isHit());
+
+        CPPUNIT_ASSERT_EQUAL(rngState.size(), cache.getRNGState().size());
+        for (int i = 0; i < rngState.size(); i++)
+            CPPUNIT_ASSERT_EQUAL(rngState[i], cache.getRNGState()[i]);
+
+        lsparams::LSmap* restored = cache.getLargeScaleParameters(links);
+        CPPUNIT_ASSERT_EQUAL(lsParams.size(), restored->size());
+        for (lsparams::LSmap::const_iterator iter = lsParams.begin(); iter != lsParams.end(); iter++)
+        {
+            CPPUNIT_ASSERT(restored->find(iter->first) != restored->end());
+            const lsparams::LargeScaleParameters& params = (*restored)[iter->first];
+            CPPUNIT_ASSERT_EQUAL(iter->second.getDelaySpread(), params.getDelaySpread());
+            CPPUNIT_ASSERT_EQUAL(iter->second.getAngularSpreadDeparture(), params.getAngularSpreadDeparture());
+            CPPUNIT_ASSERT_EQUAL(iter->second.getAngularSpreadArrival(), params.getAngularSpreadArrival());
+            CPPUNIT_ASSERT_EQUAL(iter->second.getShadowFading(), params.getShadowFading());
+            CPPUNIT_ASSERT_EQUAL(iter->second.getRicanK(), params.getRicanK());
+        }
+        delete restored;
+
+        for (unsigned int i = 0; i < links.size(); i++)
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(links[i]->getRSRP().get_mW(), cache.getRSRP(i).get_mW(), 1e-15);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(links.size()), cache.checkWidebandLoss(links, 1e-6));
+
+        // a wideband loss that changed although the key did not is reported
+        static_cast<LinkWithRSRPStub*>(links[1])->setWidebandLoss(wns::Ratio::from_dB(95.0));
+        CPPUNIT_ASSERT_EQUAL(1U, cache.checkWidebandLoss(links, 1e-6));
+    }
+
+    void
+    StartupCacheTest::keyMismatch()
+    {
+        // the key covers the configuration fingerprint, the seed and the link geometry
+        CPPUNIT_ASSERT(key("test") != key("other"));
+        CPPUNIT_ASSERT(key("test") != StartupCache::hashScenario(43, links, channel->getSpectrum(), "test"));
+        LinkVector fewerLinks(links.begin(), links.end() - 1);
+        CPPUNIT_ASSERT(key("test") != StartupCache::hashScenario(42, fewerLinks, channel->getSpectrum(), "test"));
+
+        std::string fileName = store();
+
+        StartupCache other(directory, key("other"));
+        CPPUNIT_ASSERT(other.getFileName() != fileName);
+        CPPUNIT_ASSERT(!other.load(links.size()));
+
+        // a file with a foreign key in its header is rejected even under the expected name
+        CPPUNIT_ASSERT_EQUAL(0, std::rename(fileName.c_str(), other.getFileName().c_str()));
+        StartupCache renamed(directory, key("other"));
+        CPPUNIT_ASSERT(!renamed.load(links.size()));
+        CPPUNIT_ASSERT(!renamed.isHit());
+
+        // as is a file for a different number of links
+        CPPUNIT_ASSERT_EQUAL(0, std::rename(other.getFileName().c_str(), fileName.c_str()));
+        StartupCache cache(directory, key("test"));
+        CPPUNIT_ASSERT(!cache.load(links.size() - 1));
+        CPPUNIT_ASSERT(cache.load(links.size()));
+    }
+
+    void
+    StartupCacheTest::truncatedFile()
+    {
+        std::string fileName = store();
+
+        struct stat status;
+        CPPUNIT_ASSERT_EQUAL(0, stat(fileName.c_str(), &status));
+
+        // cut into the link records, then into the header
+        CPPUNIT_ASSERT_EQUAL(0, truncate(fileName.c_str(), status.st_size - 1));
+        StartupCache cache(directory, key("test"));
+        CPPUNIT_ASSERT(!cache.load(links.size()));
+        CPPUNIT_ASSERT(!cache.isHit());
+
+        CPPUNIT_ASSERT_EQUAL(0, truncate(fileName.c_str(), 10));
+        CPPUNIT_ASSERT(!cache.load(links.size()));
+        CPPUNIT_ASSERT(!cache.isHit());
+    }
+
+    void
+    StartupCacheTest::notWritable()
+    {
+        // only the last directory level is created
+        StartupCache missing(directory + "/missing/cache", key("test"));
+        missing.setRNGState(rngState);
+        CPPUNIT_ASSERT(!missing.store(links, &lsParams));
+
+        // the rename fails if a directory has taken the cache file's name
+        StartupCache cache(directory, key("test"));
+        cache.setRNGState(rngState);
+        CPPUNIT_ASSERT_EQUAL(0, mkdir(cache.getFileName().c_str(), 0755));
+        CPPUNIT_ASSERT(!cache.store(links, &lsParams));
+
+        std::stringstream tempName;
+        tempName << cache.getFileName() << ".tmp." << getpid();
+        struct stat status;
+        CPPUNIT_ASSERT(stat(tempName.str().c_str(), &status) != 0);
+
+        CPPUNIT_ASSERT(!cache.load(links.size()));
+        CPPUNIT_ASSERT_EQUAL(0, rmdir(cache.getFileName().c_str()));
+    }
+}}
@@ -28,6 +28,7 @@
  ******************************************************************************/
 
 #include <IMTAPHY/lsParams//LSCorrelation.hpp>
+#include <IMTAPHY/lsParams/SumOfSinusoids.hpp>
 #include <WNS/evaluation/statistics/moments.hpp>
 
 
@@ -67,9 +68,24 @@ using namespace imtaphy::lsparams;
 
 // this could be indpendent from M2135 but currently it is M2135-specific
 
-LSCorrelation::LSCorrelation(imtaphy::LinkVector _links, LinkManager* _linkManager, RandomMatrix* _rnGen):
+LSCorrelation::Method
+LSCorrelation::methodFromString(const std::string& name)
+{
+    if (name == "grid")
+        return GridFilter;
+    if (name == "sumOfSinusoids")
+        return SinusoidSum;
+
+    assure(0, "Unknown LS correlation method " << name << ", use grid or sumOfSinusoids");
+    return GridFilter;
+}
+
+LSCorrelation::LSCorrelation(imtaphy::LinkVector _links, LinkManager* _linkManager, RandomMatrix* _rnGen,
+                             Method _method, unsigned int _numSinusoids):
     links(_links), 
-    linkManager(_linkManager)
+    linkManager(_linkManager),
+    method(_method),
+    numSinusoids(_numSinusoids)
 {
     rnGen = _rnGen;
     // find out which base stations are at the same site
@@ -205,219 +221,10 @@ LSCorrelation::performCorrelation(LinkVector linksToCorrelate, const imtaphy::sc
         delta[3] = scenarioPropagationParams->CD_SF; 
         delta[4] = scenarioPropagationParams->CD_K;
         
-        // first let's find the corners of the grid
-        std::vector<double> xCoords, yCoords;
-        
-        xCoords.resize(linksToCorrelate.size());
-        yCoords.resize(linksToCorrelate.size());
-        
-        for (unsigned int j = 0; j < linksToCorrelate.size(); j++)
-        {
-            xCoords[j] = linksToCorrelate[j]->getWrappedMSposition().getX();
-            yCoords[j] = linksToCorrelate[j]->getWrappedMSposition().getY();
-        }
-        
-        double Xmax = *std::max_element(xCoords.begin(), xCoords.end());
-        double Xmin = *std::min_element(xCoords.begin(), xCoords.end());
-        double Ymax = *std::max_element(yCoords.begin(), yCoords.end());
-        double Ymin = *std::min_element(yCoords.begin(), yCoords.end());
-        
-        double D = 100; // for adding some extra samples in grid
-      
-#ifdef MKL
-        unsigned int cols = Xmax-Xmin+2*D+1;
-        unsigned int rows = Ymax-Ymin+2*D+1;
-
-        float* gridMem = NULL;
-        float* tempMem = NULL;
-        gridMem = static_cast<float*>(mkl_malloc(sizeof(float) * cols * rows , 16));
-        tempMem = static_cast<float*>(mkl_malloc(sizeof(float) * cols * rows , 16));
-        
-        assure(gridMem, "Could not get memory for grid");
-        assure(tempMem, "Could not get memory for temporary grid");
-
-        typedef boost::multi_array_ref<float, 2> Grid2DArray;
-        Grid2DArray grid(gridMem, boost::extents[rows][cols]);  
-        Grid2DArray temp(tempMem, boost::extents[rows][cols]);
-        
-        unsigned int FilterLength = 101;
-        float* filter = static_cast<float*>(mkl_malloc(sizeof(float) * FilterLength , 16));
-
-#endif        
-        // iterate over all 5 large scale parameters
-        for (int i = 0; i < 5; i++) 
-        {
-            // each LS paramter gets its own grid
-
-#ifdef MKL
-            rnGen->fillNormalDistributionWithMKL(gridMem, rows, cols);
-            
-            // prepare the filter vector:
-            double sum = 0.0;
-            for (unsigned int n = 0; n < FilterLength; n++)
-            {
-                filter[n] = exp(-1.0 * double(n) / delta[i]);
-                sum += filter[n];
-            }
-            for (unsigned int n = 0; n < FilterLength; n++)
-                filter[n] = filter[n] / sum;
-
-            // First, we setup a convolution task in MKL, then we filter each row and column.
-            // As the filter is always the same, we can use the same task for each column and row
-            // of a grid. This saves internal computation time. Different sites might have different
-            // grid sizes so we have to create a new task for each grid. The filters per LS parameter 
-            // i are also different.
-            
-            int status;
-            VSLConvTaskPtr task;
-            // create the row task. Here, we want to feed one row after the other and the convolution operation
-            // is performed on all the entries (columns) of that row. So the size of input2 and output is cols.
-            status = vslsConvNewTaskX1D(&task, // to store the task ptr - single (float) precision
-                                        VSL_CONV_MODE_AUTO, 
-                                        //                                          VSL_CONV_MODE_AUTO, // mode
-                                        FilterLength, // xshape: the length of the filter used for all subsequent calls
-                                        cols,  // yshape: the length of the second input
-                                        cols, // zshape: the lenght of the output (=input)
-                                        filter, // the pointer to the input x
-                                        1); // the stride for the input x
-            
-            assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
-            
-            int y; // signed int for OpenMP parallel for loop
-#pragma omp parallel for            
-            for (y = 0; y < static_cast<int>(rows); y++)
-            {
-                status = vslsConvExecX1D(task,
-                                         &(grid[y][0]), // pointer where row starts in input y
-                                         1, // ystride, skip over the columns to the next x
-                                         &(temp[y][0]), // pointer to output z
-                                         1); // zstride
-                
-                                
-                assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
-            }
-            
-            // Free this task, the number of columns might be different
-            
-            status = vslConvDeleteTask(&task);
-            assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
-            
-            // create the column task
-            status = vslsConvNewTaskX1D(&task, // to store the task ptr - single (float) precision
-                                        VSL_CONV_MODE_AUTO, 
-                                        //                                          VSL_CONV_MODE_AUTO, // mode
-                                        FilterLength, // xshape: the length of the filter used for all subsequent calls
-                                        rows,  // yshape: the length of the second input
-                                        rows, // zshape: the lenght of the output (=input)
-                                        filter, // the pointer to the input x
-                                        1); // the stride for the input x
-            assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
-            
-            // now filter column-wise, use the row-filtered matrix temp as input and store back to the grid
-            int x; // signed int for OpenMP parallel for loop
-#pragma omp parallel for            
-            for (x = 0; x < static_cast<int>(cols); x++)
-            {
-                status = vslsConvExecX1D(task,
-                                         &(temp[0][x]), // pointer to the start of row (colum_major!)
-                                         cols, // stride (no stride due to column_major)
-                                         &(grid[0][x]), // same for the result matrix grid
-                                         cols); // zstride: for the grid
-                                        
-                assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
-            }
-            
-            // Free this task, the next one  might be different
-            status = vslConvDeleteTask(&task);
-            assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
-            
-            // compute the std. dev. could also be done using MKL VSL functions available in MKL v.10.3
-            sum = 0.0;
-            double sq_sum = 0.0;
-
-            float* p = gridMem;
-            for (unsigned int ii = 0; ii < cols*rows; ii++, p++) 
-            {
-                sum += *p;
-                sq_sum += *p * *p;
-            }
-
-            double stdDev =sqrt((sq_sum - sum*sum / (cols*rows)) / double((cols*rows) - 1));
-            
-            // we don't want to divide by zeros
-            if( stdDev == 0 )
-                stdDev =1.0;
-                
-            // finally set the correlated random entry for each considered link
-            // according to the position of the mobile on the grid
-            // for the current LS parameter i
-            for(unsigned int j =0 ; j < linksToCorrelate.size(); j++)
-            {                
-                ksi(i, j) = 
-                    grid[linksToCorrelate[j]->getWrappedMSposition().getY() - Ymin + D]
-                        [linksToCorrelate[j]->getWrappedMSposition().getX() - Xmin + D] / stdDev;
-
-            }
-#else  // ifdef MKL
-            // No MKL, just use itpp functionality
-            itpp::mat grid = rnGen->getNormalDistribution((Ymax-Ymin+2*D+1), (Xmax-Xmin+2*D+1));
-            
-            // prepare the filter vector:
-            itpp::vec d = "0:1:100";
-            itpp::vec filter = itpp::exp((-d)/delta[i]);
-            filter = filter / itpp::sum(filter);
-
-            itpp::mat tmpGrid;
-            tmpGrid.set_size(grid.rows(), grid.cols());
-
-            // column-wise filtering :
-            for(int j = 0; j < grid.cols(); j++)
-            {
-                
-                itpp::Freq_Filt<double> FF(filter,grid.get_col(0).length());
-                // Filter the data
-                tmpGrid.set_col( j, FF.filter(grid.get_col(j), 0) );
-            }
-            
-            // row-wise filtering
-            for(int j = 0; j < tmpGrid.rows(); j++)
-            {
-                itpp::Freq_Filt<double> FF2(filter,tmpGrid.get_row(0).length());
-                // Filter the data
-                grid.set_row( j, FF2.filter(tmpGrid.get_row(j), 0) );
-            }
-
-            // find the std. dev. and divide each entry of the gride by the std. dev.
-            wns::evaluation::statistics::Moments mnts;
-            mnts.reset();
-            
-            for (int k=0; k<grid.rows(); k++)
-                for(int m=0; m<grid.cols(); m++)
-                    mnts.put(grid.get(k,m));
-                
-            double stdDev = sqrt(mnts.variance());
-
-            // we don't want to divide by zeros
-            if( stdDev == 0 )
-                stdDev =1.0;
-                
-            // finally set the correlated random entry for each considered link
-            // according to the position of the mobile on the grid
-            // for the current LS parameter i
-            for(int j =0 ; j < linksToCorrelate.size(); j++)
-            {                
-                ksi(i, j) = 
-                    grid(linksToCorrelate[j]->getWrappedMSposition().getY() - Ymin + D, 
-                             linksToCorrelate[j]->getWrappedMSposition().getX() - Xmin + D) / stdDev;
-            }
-#endif // non-MKL version            
-        } // enf o loop over all LS parameters i
-        
-#ifdef MKL
-    mkl_free(filter);
-    mkl_free(gridMem);
-    mkl_free(tempMem);
-#endif
+        if (method == SinusoidSum)
+            correlateWithSinusoids(linksToCorrelate, delta, ksi);
+        else
+            correlateOnGrid(linksToCorrelate, delta, ksi);
     } // end of handling the case of multiple links
 
     // now introduce cross-correlation by multiplying with the corresponding R_sqrt matrix:
@@ -458,3 +265,258 @@ LSCorrelation::performCorrelation(LinkVector linksToCorrelate, const imtaphy::sc
     }    
 }
 
+void
+LSCorrelation::correlateOnGrid(LinkVector& linksToCorrelate, std::vector<double>& delta, itpp::mat& ksi)
+{
+    // first let's find the corners of the grid
+    std::vector<double> xCoords, yCoords;
+    
+    xCoords.resize(linksToCorrelate.size());
+    yCoords.resize(linksToCorrelate.size());
+    
+    for (unsigned int j = 0; j < linksToCorrelate.size(); j++)
+    {
+        xCoords[j] = linksToCorrelate[j]->getWrappedMSposition().getX();
+        yCoords[j] = linksToCorrelate[j]->getWrappedMSposition().getY();
+    }
+    
+    double Xmax = *std::max_element(xCoords.begin(), xCoords.end());
+    double Xmin = *std::min_element(xCoords.begin(), xCoords.end());
+    double Ymax = *std::max_element(yCoords.begin(), yCoords.end());
+    double Ymin = *std::min_element(yCoords.begin(), yCoords.end());
+    
+    double D = 100; // for adding some extra samples in grid
+  
+#ifdef MKL
+    unsigned int cols = Xmax-Xmin+2*D+1;
+    unsigned int rows = Ymax-Ymin+2*D+1;
+
+    float* gridMem = NULL;
+    float* tempMem = NULL;
+    gridMem = static_cast<float*>(mkl_malloc(sizeof(float) * cols * rows , 16));
+    tempMem = static_cast<float*>(mkl_malloc(sizeof(float) * cols * rows , 16));
+    
+    assure(gridMem, "Could not get memory for grid");
+    assure(tempMem, "Could not get memory for temporary grid");
+
+    typedef boost::multi_array_ref<float, 2> Grid2DArray;
+    Grid2DArray grid(gridMem, boost::extents[rows][cols]);  
+    Grid2DArray temp(tempMem, boost::extents[rows][cols]);
+    
+    unsigned int FilterLength = 101;
+    float* filter = static_cast<float*>(mkl_malloc(sizeof(float) * FilterLength , 16));
+
+#endif        
+    // iterate over all 5 large scale parameters
+    for (int i = 0; i < 5; i++) 
+    {
+        // each LS paramter gets its own grid
+
+#ifdef MKL
+        rnGen->fillNormalDistributionWithMKL(gridMem, rows, cols);
+        
+        // prepare the filter vector:
+        double sum = 0.0;
+        for (unsigned int n = 0; n < FilterLength; n++)
+        {
+            filter[n] = exp(-1.0 * double(n) / delta[i]);
+            sum += filter[n];
+        }
+        for (unsigned int n = 0; n < FilterLength; n++)
+            filter[n] = filter[n] / sum;
+
+        // First, we setup a convolution task in MKL, then we filter each row and column.
+        // As the filter is always the same, we can use the same task for each column and row
+        // of a grid. This saves internal computation time. Different sites might have different
+        // grid sizes so we have to create a new task for each grid. The filters per LS parameter 
+        // i are also different.
+        
+        int status;
+        VSLConvTaskPtr task;
+        // create the row task. Here, we want to feed one row after the other and the convolution operation
+        // is performed on all the entries (columns) of that row. So the size of input2 and output is cols.
+        status = vslsConvNewTaskX1D(&task, // to store the task ptr - single (float) precision
+                                    VSL_CONV_MODE_AUTO, 
+                                    //                                          VSL_CONV_MODE_AUTO, // mode
+                                    FilterLength, // xshape: the length of the filter used for all subsequent calls
+                                    cols,  // yshape: the length of the second input
+                                    cols, // zshape: the lenght of the output (=input)
+                                    filter, // the pointer to the input x
+                                    1); // the stride for the input x
+        
+        assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
+        
+        int y; // signed int for OpenMP parallel for loop
+#pragma omp parallel for            
+        for (y = 0; y < static_cast<int>(rows); y++)
+        {
+            status = vslsConvExecX1D(task,
+                                     &(grid[y][0]), // pointer where row starts in input y
+                                     1, // ystride, skip over the columns to the next x
+                                     &(temp[y][0]), // pointer to output z
+                                     1); // zstride
+            
+                            
+            assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
+        }
+        
+        // Free this task, the number of columns might be different
+        
+        status = vslConvDeleteTask(&task);
+        assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
+        
+        // create the column task
+        status = vslsConvNewTaskX1D(&task, // to store the task ptr - single (float) precision
+                                    VSL_CONV_MODE_AUTO, 
+                                    //                                          VSL_CONV_MODE_AUTO, // mode
+                                    FilterLength, // xshape: the length of the filter used for all subsequent calls
+                                    rows,  // yshape: the length of the second input
+                                    rows, // zshape: the lenght of the output (=input)
+                                    filter, // the pointer to the input x
+                                    1); // the stride for the input x
+        assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
+        
+        // now filter column-wise, use the row-filtered matrix temp as input and store back to the grid
+        int x; // signed int for OpenMP parallel for loop
+#pragma omp parallel for            
+        for (x = 0; x < static_cast<int>(cols); x++)
+        {
+            status = vslsConvExecX1D(task,
+                                     &(temp[0][x]), // pointer to the start of row (colum_major!)
+                                     cols, // stride (no stride due to column_major)
+                                     &(grid[0][x]), // same for the result matrix grid
+                                     cols); // zstride: for the grid
+                                    
+            assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
+        }
+        
+        // Free this task, the next one  might be different
+        status = vslConvDeleteTask(&task);
+        assure(status == VSL_STATUS_OK, "MKL Convolution gave an error message");
+        
+        // compute the std. dev. could also be done using MKL VSL functions available in MKL v.10.3
+        sum = 0.0;
+        double sq_sum = 0.0;
+
+        float* p = gridMem;
+        for (unsigned int ii = 0; ii < cols*rows; ii++, p++) 
+        {
+            sum += *p;
+            sq_sum += *p * *p;
+        }
+
+        double stdDev =sqrt((sq_sum - sum*sum / (cols*rows)) / double((cols*rows) - 1));
+        
+        // we don't want to divide by zeros
+        if( stdDev == 0 )
+            stdDev =1.0;
+            
+        // finally set the correlated random entry for each considered link
+        // according to the position of the mobile on the grid
+        // for the current LS parameter i
+        for(unsigned int j =0 ; j < linksToCorrelate.size(); j++)
+        {                
+            ksi(i, j) = 
+                grid[linksToCorrelate[j]->getWrappedMSposition().getY() - Ymin + D]
+                    [linksToCorrelate[j]->getWrappedMSposition().getX() - Xmin + D] / stdDev;
+
+        }
+#else  // ifdef MKL
+        // No MKL, just use itpp functionality
+        itpp::mat grid = rnGen->getNormalDistribution((Ymax-Ymin+2*D+1), (Xmax-Xmin+2*D+1));
+        
+        // prepare the filter vector:
+        itpp::vec d = "0:1:100";
+        itpp::vec filter = itpp::exp((-d)/delta[i]);
+        filter = filter / itpp::sum(filter);
+
+        itpp::mat tmpGrid;
+        tmpGrid.set_size(grid.rows(), grid.cols());
+
+        // column-wise filtering :
+        for(int j = 0; j < grid.cols(); j++)
+        {
+            
+            itpp::Freq_Filt<double> FF(filter,grid.get_col(0).length());
+            // Filter the data
+            tmpGrid.set_col( j, FF.filter(grid.get_col(j), 0) );
+        }
+        
+        // row-wise filtering
+        for(int j = 0; j < tmpGrid.rows(); j++)
+        {
+            itpp::Freq_Filt<double> FF2(filter,tmpGrid.get_row(0).length());
+            // Filter the data
+            grid.set_row( j, FF2.filter(tmpGrid.get_row(j), 0) );
+        }
+
+        // find the std. dev. and divide each entry of the gride by the std. dev.
+        wns::evaluation::statistics::Moments mnts;
+        mnts.reset();
+        
+        for (int k=0; k<grid.rows(); k++)
+            for(int m=0; m<grid.cols(); m++)
+                mnts.put(grid.get(k,m));
+            
+        double stdDev = sqrt(mnts.variance());
+
+        // we don't want to divide by zeros
+        if( stdDev == 0 )
+            stdDev =1.0;
+            
+        // finally set the correlated random entry for each considered link
+        // according to the position of the mobile on the grid
+        // for the current LS parameter i
+        for(int j =0 ; j < linksToCorrelate.size(); j++)
+        {                
+            ksi(i, j) = 
+                grid(linksToCorrelate[j]->getWrappedMSposition().getY() - Ymin + D, 
+                         linksToCorrelate[j]->getWrappedMSposition().getX() - Xmin + D) / stdDev;
+        }
+#endif // non-MKL version            
+    } // enf o loop over all LS parameters i
+    
+#ifdef MKL
+    mkl_free(filter);
+    mkl_free(gridMem);
+    mkl_free(tempMem);
+#endif
+}
+
+void
+LSCorrelation::correlateWithSinusoids(LinkVector& linksToCorrelate, std::vector<double>& delta, itpp::mat& ksi)
+{
+    // Same correlation as the grid filtering above (see SumOfSinusoids.hpp) but evaluated at the
+    // mobiles' positions only. Like on the grid, positions are truncated to the 1m lattice
+    // relative to the lower left corner of the mobiles' bounding box.
+    double Xmin = linksToCorrelate[0]->getWrappedMSposition().getX();
+    double Ymin = linksToCorrelate[0]->getWrappedMSposition().getY();
+    for (unsigned int j = 1; j < linksToCorrelate.size(); j++)
+    {
+        Xmin = std::min(Xmin, linksToCorrelate[j]->getWrappedMSposition().getX());
+        Ymin = std::min(Ymin, linksToCorrelate[j]->getWrappedMSposition().getY());
+    }
+
+    std::vector<int> x(linksToCorrelate.size());
+    std::vector<int> y(linksToCorrelate.size());
+    for (unsigned int j = 0; j < linksToCorrelate.size(); j++)
+    {
+        x[j] = static_cast<int>(linksToCorrelate[j]->getWrappedMSposition().getX() - Xmin);
+        y[j] = static_cast<int>(linksToCorrelate[j]->getWrappedMSposition().getY() - Ymin);
+    }
+
+    unsigned int FilterLength = 101;
+
+    for (int i = 0; i < 5; i++)
+    {
+        itpp::vec random = rnGen->getUniformDistribution(3 * numSinusoids);
+        std::vector<double> uniforms(random._data(), random._data() + random.size());
+
+        imtaphy::lsparams::SumOfSinusoids field(delta[i], FilterLength, numSinusoids, uniforms);
+
+        int j; // signed int for OpenMP parallel for loop
+#pragma omp parallel for
+        for (j = 0; j < static_cast<int>(linksToCorrelate.size()); j++)
+            ksi(i, j) = field(x[j], y[j]);
+    }
+}
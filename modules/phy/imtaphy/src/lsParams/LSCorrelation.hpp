@@ -47,7 +47,19 @@ namespace imtaphy { namespace lsparams {
         class LSCorrelation
         {
         public:
-            LSCorrelation(imtaphy::LinkVector _links, LinkManager* _linkManager, RandomMatrix* _rnGen);
+            enum Method
+            {
+                // filter a white Gaussian 1m grid covering all mobiles of a site (memory and time grow with the area)
+                GridFilter,
+                // evaluate a sum of sinusoids with the same correlation at the mobiles' positions only
+                SinusoidSum
+            };
+
+            static Method
+            methodFromString(const std::string& name);
+
+            LSCorrelation(imtaphy::LinkVector _links, LinkManager* _linkManager, RandomMatrix* _rnGen,
+                          Method _method = GridFilter, unsigned int _numSinusoids = 1024);
                         
             virtual ~LSCorrelation();
             /**
@@ -60,6 +72,8 @@ namespace imtaphy { namespace lsparams {
         private:
             imtaphy::LinkVector getLinksWithSameScenarioPropagationThisSite(StationSet colocatedBSs, Link::Scenario scenario, Link::Propagation propagation);
             void performCorrelation(LinkVector linksToCorrelate, const imtaphy::scm::m2135::Parameters* scenarioPropagationParams);
+            void correlateOnGrid(LinkVector& linksToCorrelate, std::vector<double>& delta, itpp::mat& ksi);
+            void correlateWithSinusoids(LinkVector& linksToCorrelate, std::vector<double>& delta, itpp::mat& ksi);
             unsigned int findNextPower(unsigned int size);
             
             imtaphy::LinkVector links;
@@ -69,6 +83,8 @@ namespace imtaphy { namespace lsparams {
             LSmap* lsParams;
             
             RandomMatrix* rnGen;
+            Method method;
+            unsigned int numSinusoids;
             
             
         };
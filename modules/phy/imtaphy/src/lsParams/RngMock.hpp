@@ -70,6 +70,11 @@ namespace imtaphy { namespace lsparams {
                 return itpp::randn(rows, cols);
             };
 
+            virtual itpp::Vec<double> getUniformDistribution(int size)
+            {
+                return itpp::randu(size);
+            };
+
 #ifdef MKL
             virtual void fillNormalDistributionWithMKL(float* ptr, int rows, int cols)
             {
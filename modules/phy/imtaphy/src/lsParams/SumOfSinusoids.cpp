@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <IMTAPHY/lsParams/SumOfSinusoids.hpp>
+#include <WNS/Assure.hpp>
+
+#include <algorithm>
+#include <math.h>
+
+using namespace imtaphy::lsparams;
+
+SumOfSinusoids::SumOfSinusoids(double correlationDistance, unsigned int filterLength,
+                               unsigned int numSinusoids, const std::vector<double>& uniforms) :
+    kx(numSinusoids),
+    ky(numSinusoids),
+    phase(numSinusoids),
+    amplitude(sqrt(2.0 / double(numSinusoids)))
+{
+    assure(numSinusoids > 0, "Need at least one sinusoid");
+    assure(uniforms.size() >= 3 * numSinusoids, "Need 3 uniform random numbers per sinusoid");
+
+    buildInverseCDF(correlationDistance, filterLength);
+
+    for (unsigned int m = 0; m < numSinusoids; m++)
+    {
+        // |H(k)|^2 is even, so drawing kx from [0, pi] and ky from [-pi, pi] covers all
+        // (kx, ky) combinations (the sign of the pair is absorbed by the uniform phase)
+        kx[m] = sampleFrequency(uniforms[3 * m]);
+        double u = 2.0 * uniforms[3 * m + 1];
+        ky[m] = (u < 1.0) ? sampleFrequency(u) : -sampleFrequency(u - 1.0);
+        phase[m] = 2.0 * M_PI * uniforms[3 * m + 2];
+    }
+}
+
+void
+SumOfSinusoids::buildInverseCDF(double correlationDistance, unsigned int filterLength)
+{
+    double rho = exp(-1.0 / correlationDistance);
+    double rhoL = pow(rho, double(filterLength));
+
+    // |H(k)|^2 for H(k) = sum_n rho^n exp(-jkn) = (1 - rho^L exp(-jkL)) / (1 - rho exp(-jk))
+    std::vector<double> density(TableSize);
+    for (unsigned int i = 0; i < TableSize; i++)
+    {
+        double k = M_PI * double(i) / double(TableSize - 1);
+        double numerator = 1.0 - 2.0 * rhoL * cos(k * filterLength) + rhoL * rhoL;
+        double denominator = 1.0 - 2.0 * rho * cos(k) + rho * rho;
+        density[i] = numerator / denominator;
+    }
+
+    cdf.resize(TableSize);
+    cdf[0] = 0.0;
+    for (unsigned int i = 1; i < TableSize; i++)
+        cdf[i] = cdf[i - 1] + 0.5 * (density[i - 1] + density[i]);
+    for (unsigned int i = 1; i < TableSize; i++)
+        cdf[i] /= cdf[TableSize - 1];
+}
+
+double
+SumOfSinusoids::sampleFrequency(double u) const
+{
+    // invert the piecewise linear CDF
+    unsigned int i = std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    if (i >= TableSize)
+        return M_PI;
+    if (i == 0)
+        return 0.0;
+
+    double fraction = (u - cdf[i - 1]) / (cdf[i] - cdf[i - 1]);
+    return M_PI * (double(i - 1) + fraction) / double(TableSize - 1);
+}
+
+double
+SumOfSinusoids::operator()(int x, int y) const
+{
+    double sum = 0.0;
+    for (unsigned int m = 0; m < kx.size(); m++)
+        sum += cos(kx[m] * x + ky[m] * y + phase[m]);
+
+    return amplitude * sum;
+}
+
+double
+SumOfSinusoids::autocorrelation(double correlationDistance, unsigned int filterLength, int lag)
+{
+    unsigned int d = std::abs(lag);
+    if (d >= filterLength)
+        return 0.0;
+
+    double energy = 0.0;
+    double overlap = 0.0;
+    for (unsigned int n = 0; n < filterLength; n++)
+    {
+        double h = exp(-double(n) / correlationDistance);
+        energy += h * h;
+        if (n + d < filterLength)
+            overlap += h * exp(-double(n + d) / correlationDistance);
+    }
+    return overlap / energy;
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef LSPARAMS_SUMOFSINUSOIDS_HPP
+#define LSPARAMS_SUMOFSINUSOIDS_HPP
+
+#include <vector>
+
+namespace imtaphy { namespace lsparams {
+
+        /**
+         * @brief Spatially correlated, unit variance random field with the same correlation as the
+         * filtered grids of LSCorrelation, evaluated directly at the positions of interest.
+         *
+         * LSCorrelation filters a white Gaussian 1m grid along its rows and columns with the
+         * truncated exponential h[n] = exp(-n/delta), n = 0..filterLength-1. The resulting field has
+         * the separable autocorrelation r(dx) * r(dy) with r(d) = sum_n h[n]h[n+|d|] / sum_n h[n]^2,
+         * i.e. the power spectrum |H(kx)|^2 |H(ky)|^2. Here, the field is a sum of numSinusoids
+         * plane waves cos(kx*x + ky*y + phi) with kx and ky drawn from |H(k)|^2 (inverse CDF on a
+         * fine table) and uniform phases phi, which has exactly that autocorrelation on the integer
+         * grid and becomes Gaussian as the number of sinusoids grows. Evaluating it costs
+         * numSinusoids operations per position instead of memory and time proportional to the area.
+         */
+        class SumOfSinusoids
+        {
+        public:
+            /**
+             * @param uniforms 3*numSinusoids independent samples from U[0,1) that determine the
+             * realization (kx, ky and phase of each sinusoid)
+             */
+            SumOfSinusoids(double correlationDistance, unsigned int filterLength,
+                           unsigned int numSinusoids, const std::vector<double>& uniforms);
+
+            double operator()(int x, int y) const;
+
+            /**
+             * @brief Normalized autocorrelation r(lag) of the truncated exponential filter
+             */
+            static double
+            autocorrelation(double correlationDistance, unsigned int filterLength, int lag);
+
+        private:
+            void buildInverseCDF(double correlationDistance, unsigned int filterLength);
+            double sampleFrequency(double u) const;
+
+            static const unsigned int TableSize = 4096;
+
+            // cdf[i] = P(k < pi * i / (TableSize-1)) for k in [0, pi]
+            std::vector<double> cdf;
+
+            std::vector<double> kx;
+            std::vector<double> ky;
+            std::vector<double> phase;
+            double amplitude;
+        };
+
+    }}
+
+#endif
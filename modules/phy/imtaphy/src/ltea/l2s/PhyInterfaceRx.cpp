@@ -82,6 +82,11 @@ PhyInterfaceRx::PhyInterfaceRx(wns::ldk::fun::FUN* fuNet, const wns::pyconfig::V
     
     harq->setDCIReader(dciReader);
 
+    // all receivers share one dump, the first one opens it
+    if (config.knows("prbTraceFile") && !config.isNone("prbTraceFile"))
+        ltea::mac::PRBTraceDump::getInstance().open(wns::simulator::getConfiguration().get<std::string>("outputDir") + "/" 
+                                                    + config.get<std::string>("prbTraceFile"));
+
     /* Command name must be provided in PyConfig if different RLC modes are used*/
     if(fuNet->knowsFunctionalUnit("rlcUnacknowledgedMode"))
         rlcReader = fuNet->getCommandReader("rlcUnacknowledgedMode");
@@ -93,6 +98,8 @@ PhyInterfaceRx::PhyInterfaceRx(wns::ldk::fun::FUN* fuNet, const wns::pyconfig::V
 void
 PhyInterfaceRx::onShutdown()
 {
+    ltea::mac::PRBTraceDump::getInstance().close();
+
     if (station->getStationType() == imtaphy::MOBILESTATION)
     {
         imtaphy::Link* servingLink = imtaphy::TheIMTAChannel::Instance().getLinkManager()->getServingLinkForMobileStation(station);
@@ -184,11 +191,6 @@ PhyInterfaceRx::channelInitialized()
         servingBSContextCollector = wns::probe::bus::ContextCollectorPtr(
                                     new wns::probe::bus::ContextCollector(localcpc, "servingBS"));
         servingBSContextCollector->put(servingLink->getBS()->getNode()->getNodeID());
-        
-        if (dumpChannel)
-            {
-                this->startObserving(&(imtaphy::TheIMTAChannel::Instance()));
-            }
     }
     else // we are in a Base Station
     {
@@ -218,10 +220,22 @@ PhyInterfaceRx::channelInitialized()
 
     postFDEAvgSINRContextCollector = wns::probe::bus::ContextCollectorPtr(
         new wns::probe::bus::ContextCollector(localcpc, "avgUplinkPostFDESINR"));
+
+    // the channel's onNewTTI forwards the instantaneous SINR / IoT values collected during a TTI
+    if (((receivingInDirection == imtaphy::Downlink) && dumpChannel) ||
+        instantaneousSINRContextCollector->hasObservers() ||
+        instantaneousIoTContextCollector->hasObservers())
+    {
+        this->startObserving(&(imtaphy::TheIMTAChannel::Instance()));
+    }
     
     jsonTracing = wns::probe::bus::ContextCollectorPtr(
         new wns::probe::bus::ContextCollector(localcpc, "phyRxTracing"));
 
+    // the schedulers only collect the per-PRB tracing if somebody consumes it
+    if (jsonTracing->hasObservers())
+        ltea::mac::PRBTrace::enable();
+
     laProbingActualSINR = wns::probe::bus::ContextCollectorPtr(
         new wns::probe::bus::ContextCollector(localcpc, "laProbingActualSINR"));
 
@@ -246,7 +260,9 @@ PhyInterfaceRx::channelInitialized()
 void
 PhyInterfaceRx::beforeTTIover(unsigned int ttiNumber)
 {
-    // This will only be called in a mobile station
+    // we might only observe the channel for the per-TTI probes, dumping it is for mobile stations only
+    if (!dumpChannel || (receivingInDirection != imtaphy::Downlink))
+        return;
     
     imtaphy::LinkMap allLinks = imtaphy::TheIMTAChannel::Instance().getLinkManager()->getAllLinksForStation(station);
     
@@ -272,6 +288,32 @@ PhyInterfaceRx::beforeTTIover(unsigned int ttiNumber)
     }
 }
 
+void
+PhyInterfaceRx::onNewTTI(unsigned int ttiNumber)
+{
+    // all receptions of the previous TTI have been delivered in the same event
+    flushTTIProbes();
+}
+
+void
+PhyInterfaceRx::flushTTIProbes()
+{
+    for (unsigned int l = 0; l < ttiSINRsPerLayer.size(); l++)
+    {
+        instantaneousSINRContextCollector->putAll(ttiSINRsPerLayer[l], boost::make_tuple("Layer", l + 1));
+        ttiSINRsPerLayer[l].clear();
+    }
+
+    instantaneousSINRContextCollector->putAll(ttiPostFDESINRs);
+    ttiPostFDESINRs.clear();
+
+    for (unsigned int l = 0; l < ttiIoTsPerLayer.size(); l++)
+    {
+        instantaneousIoTContextCollector->putAll(ttiIoTsPerLayer[l], boost::make_tuple("Layer", l + 1));
+        ttiIoTsPerLayer[l].clear();
+    }
+}
+
 void
 PhyInterfaceRx::processingDelayOver(std::vector<wns::ldk::CompoundPtr> transportBlocks,
                                     wns::node::Interface* source,
@@ -334,26 +376,37 @@ PhyInterfaceRx::processingDelayOver(std::vector<wns::ldk::CompoundPtr> transport
             // so, nothing to deliver to higher sublayers
         }
         
-        ///////////////
-        double linearSINRavg = 0.0;
-        int linearSINRcounter = 0;
-        for (unsigned int l = 0; l < dci->peer.assignedToLayers.size(); l++)
-        {
-            imtaphy::interface::SINRVector sinrs = status->getSINRsForLayer(dci->peer.assignedToLayers[l]);
-            for (unsigned int p = 0; p < sinrs.size(); p++)
-            {
-                linearSINRavg += sinrs[p].get_factor();
-                linearSINRcounter++;
-            }
-        }
-        if (dci->magic.estimatedLinearAvgSINR.get_factor() > 0)
+        bool probeSINRMismatch = linearAvgEstimatedSINRContextCollector->hasObservers() &&
+                                 (dci->magic.estimatedLinearAvgSINR.get_factor() > 0);
+        bool tracing = jsonTracing->hasObservers() || ltea::mac::PRBTraceDump::getInstance().isOpen();
+
+        if (!probeSINRMismatch && !tracing)
+            continue;
+
+        // gather the linear SINRs of all PRBs on all layers of this TB into one contiguous array
+        unsigned int numLayers = dci->peer.assignedToLayers.size();
+        unsigned int numTBPRBs = status->getNumberOfPRBs();
+        tbSINRs.resize(numLayers * numTBPRBs);
+        for (unsigned int l = 0; l < numLayers; l++)
+            status->getSINRFactorsForLayer(dci->peer.assignedToLayers[l], &tbSINRs[l * numTBPRBs]);
+
+        if (probeSINRMismatch)
         {
-            linearAvgEstimatedSINRContextCollector->put(wns::Ratio::from_factor((linearSINRavg / static_cast<double>(linearSINRcounter)) / dci->magic.estimatedLinearAvgSINR.get_factor()).get_dB());
+            double linearSINRsum = 0.0;
+            for (unsigned int k = 0; k < tbSINRs.size(); k++)
+                linearSINRsum += tbSINRs[k];
+
+            linearAvgEstimatedSINRContextCollector->put(wns::Ratio::from_factor((linearSINRsum / static_cast<double>(tbSINRs.size())) / dci->magic.estimatedLinearAvgSINR.get_factor()).get_dB());
         }
-        //std::cout << "Linear average of SINR estimate: " << dci->magic.estimatedLinearAvgSINR 
-        //            << " actual average = " << wns::Ratio::from_factor(linearSINRavg / static_cast<double>(linearSINRcounter)) << "\n"; 
-        ///////////////
-                    
+
+        if (!tracing)
+            continue;
+
+        // the traces want dB
+        for (unsigned int k = 0; k < tbSINRs.size(); k++)
+            tbSINRs[k] = 10.0 * log10(tbSINRs[k]);
+
+        imtaphy::interface::PRBVector prbs = status->getPRBs();
                     
         // probe to json tracing but only if it will be recorded
         if (jsonTracing->hasObservers())
@@ -396,21 +449,21 @@ PhyInterfaceRx::processingDelayOver(std::vector<wns::ldk::CompoundPtr> transport
             {
                 objdoc["Transmission"]["Layer"] = wns::probe::bus::json::Number(layers[l]);
                 
-                imtaphy::interface::PRBVector prbs = status->getPRBs();
-                imtaphy::interface::SINRVector sinrs = status->getSINRsForLayer(layers[l]);
-                assure(prbs.size() == sinrs.size(), "status must have exactly one SINR per PRB");
+                const double* sinrs_dB = &tbSINRs[l * numTBPRBs];
                 
                 for (unsigned int p = 0; p < prbs.size(); p++)
                 {
-                    // add all dict elements to json tracing
-                    for (ltea::mac::SchedulingTracingDict::const_iterator iter = dci->magic.prbTracingDict[prbs[p]].begin(); 
-                         iter != dci->magic.prbTracingDict[prbs[p]].end(); iter++)
+                    // add all traced fields to json tracing
+                    const ltea::mac::PRBTraceRecord* record = dci->magic.prbTrace.find(prbs[p]);
+                    for (unsigned int f = 0; (record != NULL) && (f < ltea::mac::NumPRBTraceFields); f++)
                     {
-                        objdoc["Transmission"][iter->first] = wns::probe::bus::json::Number(iter->second);
+                        ltea::mac::PRBTraceField field = static_cast<ltea::mac::PRBTraceField>(f);
+                        if (record->has(field))
+                            objdoc["Transmission"][ltea::mac::prbTraceFieldName(field)] = wns::probe::bus::json::Number(record->get(field));
                     }
                     
                     objdoc["Transmission"]["PRB"] = wns::probe::bus::json::Number(prbs[p]);
-                    objdoc["Transmission"]["SINR"] = wns::probe::bus::json::Number(sinrs[p].get_dB());
+                    objdoc["Transmission"]["SINR"] = wns::probe::bus::json::Number(sinrs_dB[p]);
                     wns::probe::bus::json::probeJSON(jsonTracing, objdoc);
                     
                     // linkadaptation probing
@@ -421,7 +474,7 @@ PhyInterfaceRx::processingDelayOver(std::vector<wns::ldk::CompoundPtr> transport
                             msId = source->getNodeID();
                         else
                             msId = station->getNode()->getNodeID();
-                        laProbingActualSINR->put(sinrs[p].get_dB(), boost::make_tuple("PRB", prbs[p],
+                        laProbingActualSINR->put(sinrs_dB[p], boost::make_tuple("PRB", prbs[p],
                                                                                       "MSID", msId));
                         laProbingEstimatedSINR->put(dci->magic.estimatedLinkAdaptationSINR.get_dB(), boost::make_tuple("PRB", prbs[p],
                                                                                                                        "MSID", msId));
@@ -430,6 +483,33 @@ PhyInterfaceRx::processingDelayOver(std::vector<wns::ldk::CompoundPtr> transport
                 }
             } // over layers 
         } // end of json probing
+
+        if (ltea::mac::PRBTraceDump::getInstance().isOpen())
+        {
+            ltea::mac::PRBTraceDump& dump = ltea::mac::PRBTraceDump::getInstance();
+            unsigned int tti = imtaphy::TheIMTAChannel::Instance().getTTI();
+
+            boost::uint32_t row[ltea::mac::PRBTraceDump::NumIntColumns];
+            row[ltea::mac::PRBTraceDump::ColReceiver] = station->getNode()->getNodeID();
+            row[ltea::mac::PRBTraceDump::ColSender] = source->getNodeID();
+            row[ltea::mac::PRBTraceDump::ColTBid] = dci->magic.id;
+            row[ltea::mac::PRBTraceDump::ColAttempt] = dci->magic.transmissionAttempts;
+            row[ltea::mac::PRBTraceDump::ColDecodable] = success ? 1 : 0;
+
+            for (unsigned int l = 0; l < numLayers; l++)
+            {
+                const double* sinrs_dB = &tbSINRs[l * numTBPRBs];
+                row[ltea::mac::PRBTraceDump::ColLayer] = dci->peer.assignedToLayers[l];
+
+                for (unsigned int p = 0; p < prbs.size(); p++)
+                {
+                    const ltea::mac::PRBTraceRecord* record = dci->magic.prbTrace.find(prbs[p]);
+                    row[ltea::mac::PRBTraceDump::ColPRB] = prbs[p];
+                    row[ltea::mac::PRBTraceDump::ColFields] = (record != NULL) ? record->fields : 0;
+                    dump.append(tti, row, sinrs_dB[p], record);
+                }
+            }
+        }
     }
 }
         
@@ -462,41 +542,47 @@ PhyInterfaceRx::onData( std::vector<wns::ldk::CompoundPtr> transportBlocks,
        
     MESSAGE_END();
     
+    // the per-PRB values are only collected here and forwarded to the probes once per TTI
+    unsigned int numLayers = status->getNumberOfLayers();
+    unsigned int numTBPRBs = status->getNumberOfPRBs();
+
     if (instantaneousSINRContextCollector->hasObservers() ||
         ((receivingInDirection == imtaphy::Uplink) && postFDEAvgSINRContextCollector->hasObservers()))
     {
-        for (unsigned int j = 1; j <= status->getNumberOfLayers(); j++)
+        if (ttiSINRsPerLayer.size() < numLayers)
+            ttiSINRsPerLayer.resize(numLayers);
+
+        tbSINRs.resize(numTBPRBs);
+        for (unsigned int j = 1; j <= numLayers; j++)
         {
+            status->getSINRFactorsForLayer(j, &tbSINRs[0]);
+
             if (receivingInDirection == imtaphy::Uplink)
             {
-                wns::Ratio postEqualization = mmsefde.getEffectiveSINR(status->getSINRsForLayer(j), imtaphy::l2s::Generic()); // modulation not used
+                wns::Ratio postEqualization = mmsefde.getEffectiveSINR(&tbSINRs[0], numTBPRBs, imtaphy::l2s::Generic()); // modulation not used
                 
-                instantaneousSINRContextCollector->put(postEqualization.get_dB());
+                if (instantaneousSINRContextCollector->hasObservers())
+                    ttiPostFDESINRs.push_back(postEqualization.get_dB());
                 perUserLinSINR[source].put(postEqualization.get_factor());
             }
             else
             {
-                imtaphy::interface::SINRVector sinrs = status->getSINRsForLayer(j);
-                for (unsigned int i = 0; i < sinrs.size(); i++)
-                {
-                    instantaneousSINRContextCollector->put(sinrs[i].get_dB(),
-                                                           boost::make_tuple("Layer", j)
-                    );
-                }
+                std::vector<double>& values = ttiSINRsPerLayer[j-1];
+                for (unsigned int i = 0; i < numTBPRBs; i++)
+                    values.push_back(10.0 * log10(tbSINRs[i]));
             }
         }
     }
     if (instantaneousIoTContextCollector->hasObservers())
     {
-        for (unsigned int j = 1; j <= status->getNumberOfLayers(); j++)
+        if (ttiIoTsPerLayer.size() < numLayers)
+            ttiIoTsPerLayer.resize(numLayers);
+
+        for (unsigned int j = 1; j <= numLayers; j++)
         {
             imtaphy::interface::IoTVector iots = status->getIoTsForLayer(j);
             for (unsigned int i = 0; i < iots.size(); i++)
-            {
-                instantaneousIoTContextCollector->put(iots[i].get_dB(),
-                                                      boost::make_tuple("Layer", j)
-                );
-            }
+                ttiIoTsPerLayer[j-1].push_back(iots[i].get_dB());
         }
     }
 
@@ -87,7 +87,7 @@ namespace ltea { namespace l2s {
         void onFUNCreated();
 
         // IMTAphy observer interface:
-        void onNewTTI(unsigned int ttiNumber) {};
+        void onNewTTI(unsigned int ttiNumber);
         void beforeTTIover(unsigned int ttiNumber);
 
 
@@ -96,6 +96,8 @@ namespace ltea { namespace l2s {
                                  wns::node::Interface* source,
                                  imtaphy::interface::TransmissionStatusPtr status);
 
+        void flushTTIProbes();
+
         //
         // compound handler interface
         //
@@ -142,6 +144,14 @@ namespace ltea { namespace l2s {
         typedef std::map<wns::node::Interface*, wns::evaluation::statistics::Moments> NodeMomentsMap;
         NodeMomentsMap perUserLinSINR;
 
+        // per-PRB probe values of the current TTI, forwarded together in onNewTTI
+        std::vector<std::vector<double> > ttiSINRsPerLayer; // in dB, indexed by layer - 1
+        std::vector<double> ttiPostFDESINRs; // in dB
+        std::vector<std::vector<double> > ttiIoTsPerLayer; // in dB, indexed by layer - 1
+
+        // linear SINRs of the transport block being evaluated, layer after layer
+        std::vector<double> tbSINRs;
+
     };
 
 }}
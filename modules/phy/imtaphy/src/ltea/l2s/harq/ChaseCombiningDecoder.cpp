@@ -33,6 +33,7 @@
 #include <IMTAPHY/interface/TransmissionStatus.hpp>
 #include <WNS/simulator/ISimulator.hpp>
 #include <IMTAPHY/Spectrum.hpp>
+#include <iterator>
 
 
 using namespace ltea::l2s::harq;
@@ -61,12 +62,10 @@ ChaseCombiningDecoder::ChaseCombiningDecoder(const wns::pyconfig::View& config)
 }
 
 bool
-ChaseCombiningDecoder::canDecode(SoftCombiningBuffer& receivedRedundancyVersions)
+ChaseCombiningDecoder::canDecode(SoftCombiningBuffer& receivedRedundancyVersions, SoftCombiningState& state)
 {
-    // we could store the current state after the first transmission attempt so we don't have to rebuild everything
-    // on each new redundancy version
-    
     assure(entity, "Need access to the HARQ entity for DCI reader access");
+    assure(!receivedRedundancyVersions.empty(), "Nothing to decode");
 
     // Here we assume non-adaptive HARQ retransmissions meaning that we will have retransmission with the same number of
     // prbs used (i.e. same code rate) and the same modulation.
@@ -90,22 +89,22 @@ ChaseCombiningDecoder::canDecode(SoftCombiningBuffer& receivedRedundancyVersions
     // In Uplink we compute a post MMSE Frequency Domain Equalization SINR (over the involved PRBs) for each layer,
     // put the layers into the vector, add that post MMSE SINR SINRs vector and take the effective SINR over the per 
     // layer sum SINR
-    
-    std::vector<wns::Ratio> sumSINRs;
-    if (direction == imtaphy::Downlink)
-    {
-        sumSINRs.resize(totalNumPRBs, wns::Ratio::from_factor(0));
-    }
-    else // Uplink
+    // The sums are kept in the HARQ process' state, so only redundancy versions not combined so far are added.
+
+    assure(state.numCombined < receivedRedundancyVersions.size(), "No new redundancy version - was the soft buffer cleared without its state?");
+
+    if (state.numCombined == 0)
     {
-        sumSINRs.resize(numLayers, wns::Ratio::from_factor(0));
+        state.sumSINRs.assign(direction == imtaphy::Downlink ? totalNumPRBs : numLayers, 0.0);
     }
-    
+    assure(state.sumSINRs.size() == (direction == imtaphy::Downlink ? totalNumPRBs : numLayers), "Combined SINR state does not match the initial transmission");
+
     // See, e.g., IEEE 802.16m EMD section 4.6
-    // we put together a vector of 
     
-    for (SoftCombiningBuffer::const_iterator iter = receivedRedundancyVersions.begin();
-         iter != receivedRedundancyVersions.end(); iter++)
+    SoftCombiningBuffer::const_iterator iter = receivedRedundancyVersions.begin();
+    std::advance(iter, state.numCombined);
+
+    for (; iter != receivedRedundancyVersions.end(); iter++)
     {
         RedundancyVersionStatus transmission = *iter;
 
@@ -118,33 +117,35 @@ ChaseCombiningDecoder::canDecode(SoftCombiningBuffer& receivedRedundancyVersions
         assure(blockSize == dci->peer.blockSize, "Transport block size cannot change between HARQ retransmissions");
         assure(modulation.getBitsPerSymbol() == dci->peer.modulation.getBitsPerSymbol(), "This implementation does not support different modulation schemes between HARQ retransmissions");
 
-        imtaphy::interface::PRBVector prbs = transmission.second->getPRBs();
-        
+        double* sum = &state.sumSINRs[0];
+        rvSINRs.resize(numPRBsPerLayer);
+
         for (unsigned int m = 0; m < numLayers; m++)
         {       
+            // layers counted from 1..max
+            transmission.second->getSINRFactorsForLayer(dci->peer.assignedToLayers[m], &rvSINRs[0]);
+
             if (direction == imtaphy::Downlink)
             {            
+                double* layerSum = sum + m*numPRBsPerLayer;
                 for (unsigned int f = 0; f < numPRBsPerLayer; f++)
                 {
-                    unsigned int prb = prbs[f];
-                    // layers counted from 1..max
-                    sumSINRs[f + m*numPRBsPerLayer] = wns::Ratio::from_factor(sumSINRs[f + m*numPRBsPerLayer].get_factor() + transmission.second->getSINR(prb, dci->peer.assignedToLayers[m]).get_factor());
+                    layerSum[f] += rvSINRs[f];
                 }
             }
             else // Uplink -> perform frequency domain MMSE equalization
             {
-                imtaphy::interface::SINRVector sinrPerLayer = transmission.second->getSINRsForLayer(dci->peer.assignedToLayers[m]);
-                
-                wns::Ratio postMMSE_FDE_SINR = uplinkMMSEFDE.getEffectiveSINR(sinrPerLayer, modulation);
-                sumSINRs[m] = wns::Ratio::from_factor(sumSINRs[m].get_factor() + postMMSE_FDE_SINR.get_factor());
+                sum[m] += uplinkMMSEFDE.getEffectiveSINR(&rvSINRs[0], numPRBsPerLayer, modulation).get_factor();
             }
         }
-        MESSAGE_SINGLE(NORMAL, logger, "After adding sinrs, we have the following sinrs:");
-        for (unsigned int i = 0; i < sumSINRs.size(); i++)
-            MESSAGE_SINGLE(NORMAL, logger, "Entry " << i << " has current accumulated SINR of " << sumSINRs[i]);
+        state.numCombined++;
+
+        MESSAGE_SINGLE(NORMAL, logger, "After adding sinrs of redundancy version " << state.numCombined << ", we have the following sinrs:");
+        for (unsigned int i = 0; i < state.sumSINRs.size(); i++)
+            MESSAGE_SINGLE(NORMAL, logger, "Entry " << i << " has current accumulated SINR of " << wns::Ratio::from_factor(state.sumSINRs[i]));
     }        
 
-    wns::Ratio effectiveSINR = effSinrModel->getEffectiveSINR(sumSINRs, modulation);
+    wns::Ratio effectiveSINR = effSinrModel->getEffectiveSINR(&state.sumSINRs[0], state.sumSINRs.size(), modulation);
     dci->magic.effSINR = effectiveSINR;
     
     effSINRContextCollector->put(effectiveSINR.get_dB());
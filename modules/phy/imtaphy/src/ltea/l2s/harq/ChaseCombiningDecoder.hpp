@@ -46,12 +46,14 @@ namespace ltea { namespace l2s { namespace harq {
     public:
         ChaseCombiningDecoder(const wns::pyconfig::View& config);
         
-        virtual bool canDecode(SoftCombiningBuffer &receivedRedundancyVersions);
+        virtual bool canDecode(SoftCombiningBuffer &receivedRedundancyVersions, SoftCombiningState &state);
 
     private:
         imtaphy::l2s::BlockErrorModel* blerModel;
         imtaphy::l2s::MMIBeffectiveSINR* effSinrModel;
         imtaphy::l2s::MMSEFrequencyDomainEqualization uplinkMMSEFDE;
+        // linear SINRs of one layer of the redundancy version being combined
+        std::vector<double> rvSINRs;
         
 
         wns::distribution::Uniform uniformRandom;
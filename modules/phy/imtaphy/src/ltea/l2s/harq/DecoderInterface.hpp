@@ -32,6 +32,7 @@
 
 
 #include <list>
+#include <vector>
 #include <IMTAPHY/interface/TransmissionStatus.hpp>
 #include <WNS/ldk/Compound.hpp>
 #include <WNS/pyconfig/View.hpp>
@@ -45,6 +46,27 @@ namespace ltea { namespace l2s { namespace harq {
 
     typedef std::pair<wns::ldk::CompoundPtr, imtaphy::interface::TransmissionStatusPtr> RedundancyVersionStatus;
     typedef std::list<RedundancyVersionStatus> SoftCombiningBuffer;
+
+    // Combined SINR state of one HARQ process's soft buffer. The decoder folds in each redundancy
+    // version once, so decoding a retransmission only costs the new RV's PRBs. The owner has to
+    // clear() it together with the SoftCombiningBuffer.
+    struct SoftCombiningState
+    {
+        SoftCombiningState() :
+            numCombined(0)
+        {}
+
+        void clear()
+        {
+            sumSINRs.clear();
+            numCombined = 0;
+        }
+
+        // accumulated linear SINRs, per layer and PRB (DL) or per layer (UL)
+        std::vector<double> sumSINRs;
+        // number of redundancy versions from the front of the buffer contained in sumSINRs
+        unsigned int numCombined;
+    };
     
     class DecoderInterface :
         public virtual wns::CloneableInterface
@@ -54,7 +76,7 @@ namespace ltea { namespace l2s { namespace harq {
             entity(NULL)
         {};
         
-        virtual bool canDecode(SoftCombiningBuffer &receivedRedundancyVersions) = 0;
+        virtual bool canDecode(SoftCombiningBuffer &receivedRedundancyVersions, SoftCombiningState &state) = 0;
 
         virtual void setEntity(ltea::mac::harq::HARQEntity* entity_) {entity = entity_;}
     protected:
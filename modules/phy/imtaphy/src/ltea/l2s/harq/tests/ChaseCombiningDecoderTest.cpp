@@ -0,0 +1,309 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/ltea/l2s/harq/ChaseCombiningDecoder.hpp>
+#include <IMTAPHY/ltea/mac/harq/HARQentity.hpp>
+#include <IMTAPHY/ltea/mac/DCI.hpp>
+#include <IMTAPHY/interface/TransmissionStatus.hpp>
+
+#include <WNS/ldk/fun/Main.hpp>
+#include <WNS/ldk/tests/LayerStub.hpp>
+#include <WNS/ldk/CommandTypeSpecifier.hpp>
+#include <WNS/ldk/HasReceptor.hpp>
+#include <WNS/ldk/HasConnector.hpp>
+#include <WNS/ldk/HasDeliverer.hpp>
+#include <WNS/ldk/Compound.hpp>
+#include <WNS/pyconfig/Parser.hpp>
+#include <WNS/Cloneable.hpp>
+
+#include <vector>
+#include <algorithm>
+
+namespace ltea { namespace l2s { namespace harq { namespace tests {
+
+        // provides the DCI command, like the scheduler does in the simulator
+        struct DCIProvider :
+            public virtual wns::ldk::FunctionalUnit,
+            public wns::ldk::HasReceptor<>,
+            public wns::ldk::HasConnector<>,
+            public wns::ldk::HasDeliverer<>,
+            public wns::Cloneable<DCIProvider>,
+            public wns::ldk::CommandTypeSpecifier<ltea::mac::DownlinkControlInformation>
+        {
+            DCIProvider(wns::ldk::fun::FUN* fun) : wns::ldk::CommandTypeSpecifier<ltea::mac::DownlinkControlInformation>(fun) {}
+            void doOnData(const wns::ldk::CompoundPtr&) {}
+            void doSendData(const wns::ldk::CompoundPtr&) {}
+            bool doIsAccepting(const wns::ldk::CompoundPtr&) const {return true;}
+            void doWakeup() {}
+        };
+
+        // counts the magic HARQ feedback
+        struct FeedbackCounter
+        {
+            FeedbackCounter(unsigned int* _counter) : counter(_counter) {}
+            void operator()() {(*counter)++;}
+            unsigned int* counter;
+        };
+
+        class ChaseCombiningDecoderTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( ChaseCombiningDecoderTest );
+            CPPUNIT_TEST( incrementalEqualsFullRecomputeDownlink );
+            CPPUNIT_TEST( incrementalEqualsFullRecomputeUplink );
+            CPPUNIT_TEST( newDataIndicatorResetsState );
+            CPPUNIT_TEST_SUITE_END();
+
+        public:
+            void setUp();
+            void tearDown();
+
+            void incrementalEqualsFullRecomputeDownlink();
+            void incrementalEqualsFullRecomputeUplink();
+            void newDataIndicatorResetsState();
+
+        private:
+            void incrementalEqualsFullRecompute(imtaphy::Direction direction);
+
+            // a transport block on numPRBs PRBs and the given layers; the SINR of layer l on PRB f is
+            // sinrDB + l + 0.5*f*variation dB
+            RedundancyVersionStatus redundancyVersion(imtaphy::Direction direction, const std::vector<unsigned int>& layers,
+                                                      double sinrDB, double variation, bool ndi, unsigned int attempt);
+
+            ltea::mac::DownlinkControlInformation* getDCI(const RedundancyVersionStatus& rv)
+            {
+                return dciReader->readCommand<ltea::mac::DownlinkControlInformation>(rv.first->getCommandPool());
+            }
+
+            wns::ldk::CommandProxy* proxy;
+            wns::ldk::CommandReaderInterface* dciReader;
+            DCIProvider* fu;
+            wns::pyconfig::Parser pyConfig;
+            ltea::mac::harq::HARQEntity* entity;
+            unsigned int acks;
+            unsigned int nacks;
+
+            static const unsigned int numPRBs = 6;
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( ChaseCombiningDecoderTest );
+
+        void
+        ChaseCombiningDecoderTest::setUp()
+        {
+            // the same FUN setup as in ltea::mac::tests::PerformanceModelTest
+            wns::ldk::ILayer* layer = new wns::ldk::tests::LayerStub();
+            wns::pyconfig::Parser pycoParser;
+            pycoParser.loadString("import openwns.logger\n"
+                                  "class LinkHandler:\n"
+                                  "  type = \"wns.ldk.SimpleLinkHandler\"\n"
+                                  "  isAcceptingLogger = openwns.logger.Logger(\"W-NS\", \"LinkHandler\", True)\n"
+                                  "  sendDataLogger = openwns.logger.Logger(\"W-NS\", \"LinkHandler\", True)\n"
+                                  "  wakeupLogger = openwns.logger.Logger(\"W-NS\", \"LinkHandler\", True)\n"
+                                  "  onDataLogger = openwns.logger.Logger(\"W-NS\", \"LinkHandler\", True)\n"
+                                  "  traceCompoundJourney = True\n"
+                                  "linkHandler = LinkHandler()\n"
+                                  "class FUNConfig:\n"
+                                  "  logger = openwns.logger.Logger(\"W-NS\",\"TestFUN\",True)\n"
+                                  "  commandProxy = openwns.FUN.CommandProxy(logger)\n"
+                                  "fun = FUNConfig()");
+            wns::ldk::fun::FUN* fun = new wns::ldk::fun::Main(layer, pycoParser);
+            proxy = fun->getProxy();
+            fu = new DCIProvider(fun);
+            proxy->addFunctionalUnit("Scheduler", fu);
+            dciReader = proxy->getCommandReader("Scheduler");
+
+            pyConfig.loadString("import ltea.dll.harq\n"
+                                "harqEntity = ltea.dll.harq.HARQEntity()\n");
+
+            entity = new ltea::mac::harq::HARQEntity(pyConfig.get("harqEntity"), 8, 8, 1, 3, 0.0, wns::logger::Logger());
+            entity->setDCIReader(dciReader);
+
+            acks = 0;
+            nacks = 0;
+        }
+
+        void
+        ChaseCombiningDecoderTest::tearDown()
+        {
+            delete entity;
+        }
+
+        RedundancyVersionStatus
+        ChaseCombiningDecoderTest::redundancyVersion(imtaphy::Direction direction, const std::vector<unsigned int>& layers,
+                                                     double sinrDB, double variation, bool ndi, unsigned int attempt)
+        {
+            wns::ldk::CompoundPtr compound(new wns::ldk::Compound(proxy->createCommandPool()));
+            proxy->activateCommand(compound->getCommandPool(), fu);
+
+            ltea::mac::DownlinkControlInformation* dci = dciReader->readCommand<ltea::mac::DownlinkControlInformation>(compound->getCommandPool());
+            dci->peer.assignedToLayers = layers;
+            dci->peer.modulation = imtaphy::l2s::QAM64();
+            // far beyond what the SINRs support, so the TB is never decoded and the soft buffer is kept
+            dci->peer.codeRate = 0.92;
+            dci->peer.blockSize = 6000;
+            dci->peer.NDI = ndi;
+            dci->peer.processID = 3;
+            dci->peer.rv = attempt - 1;
+            dci->magic.ackCallback = FeedbackCounter(&acks);
+            dci->magic.nackCallback = FeedbackCounter(&nacks);
+            dci->magic.spatialID = 0;
+            dci->magic.transmissionAttempts = attempt;
+            dci->magic.mcsIndex = 28;
+            dci->magic.estimatedLinkAdaptationSINR = wns::Ratio::from_dB(sinrDB);
+            dci->magic.direction = direction;
+
+            imtaphy::interface::PRBVector prbs(numPRBs);
+            for (unsigned int f = 0; f < numPRBs; f++)
+                prbs[f] = 10 + f;
+
+            unsigned int maxLayer = *std::max_element(layers.begin(), layers.end());
+            imtaphy::interface::TransmissionStatusPtr status(new imtaphy::interface::TransmissionStatus(maxLayer, prbs));
+            for (unsigned int f = 0; f < numPRBs; f++)
+            {
+                imtaphy::interface::SINRVector sinrs(maxLayer);
+                for (unsigned int l = 0; l < maxLayer; l++)
+                    sinrs[l] = wns::Ratio::from_dB(sinrDB + l + 0.5 * f * variation);
+                status->setSINRsForPRB(prbs[f], sinrs);
+            }
+
+            return RedundancyVersionStatus(compound, status);
+        }
+
+        void
+        ChaseCombiningDecoderTest::incrementalEqualsFullRecompute(imtaphy::Direction direction)
+        {
+            // decoding each retransmission only folds in the new RV, which has to give the same
+            // combined SINRs as combining the whole soft buffer from scratch
+            DecoderInterface* decoder = entity->getDecoder();
+
+            std::vector<unsigned int> layers;
+            layers.push_back(1);
+            layers.push_back(2);
+
+            double rvSINRs[] = {-6.0, -9.5, -4.25, -7.0};
+            double rvVariation[] = {1.0, -0.7, 0.3, 2.0};
+            unsigned int numRVs = sizeof(rvSINRs) / sizeof(double);
+
+            SoftCombiningBuffer buffer;
+            SoftCombiningState incremental;
+            for (unsigned int rv = 0; rv < numRVs; rv++)
+            {
+                buffer.push_back(redundancyVersion(direction, layers, rvSINRs[rv], rvVariation[rv], rv == 0, rv + 1));
+
+                CPPUNIT_ASSERT( !decoder->canDecode(buffer, incremental) );
+                CPPUNIT_ASSERT_EQUAL( rv + 1, incremental.numCombined );
+                double incrementalEffSINR = getDCI(buffer.back())->magic.effSINR.get_dB();
+
+                SoftCombiningState full;
+                CPPUNIT_ASSERT( !decoder->canDecode(buffer, full) );
+                CPPUNIT_ASSERT_EQUAL( rv + 1, full.numCombined );
+
+                CPPUNIT_ASSERT_EQUAL( full.sumSINRs.size(), incremental.sumSINRs.size() );
+                for (unsigned int i = 0; i < full.sumSINRs.size(); i++)
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL( full.sumSINRs[i], incremental.sumSINRs[i], 1E-12 * full.sumSINRs[i] );
+                CPPUNIT_ASSERT_DOUBLES_EQUAL( getDCI(buffer.back())->magic.effSINR.get_dB(), incrementalEffSINR, 1E-9 );
+            }
+
+            // in the downlink the state holds the plain per layer and PRB sums
+            if (direction == imtaphy::Downlink)
+            {
+                CPPUNIT_ASSERT_EQUAL( static_cast<std::size_t>(layers.size() * numPRBs), incremental.sumSINRs.size() );
+                for (unsigned int l = 0; l < layers.size(); l++)
+                    for (unsigned int f = 0; f < numPRBs; f++)
+                    {
+                        double expected = 0.0;
+                        for (unsigned int rv = 0; rv < numRVs; rv++)
+                            expected += wns::Ratio::from_dB(rvSINRs[rv] + l + 0.5 * f * rvVariation[rv]).get_factor();
+                        CPPUNIT_ASSERT_DOUBLES_EQUAL( expected, incremental.sumSINRs[l * numPRBs + f], 1E-9 * expected );
+                    }
+            }
+            else
+            {
+                CPPUNIT_ASSERT_EQUAL( layers.size(), incremental.sumSINRs.size() );
+            }
+        }
+
+        void
+        ChaseCombiningDecoderTest::incrementalEqualsFullRecomputeDownlink()
+        {
+            incrementalEqualsFullRecompute(imtaphy::Downlink);
+        }
+
+        void
+        ChaseCombiningDecoderTest::incrementalEqualsFullRecomputeUplink()
+        {
+            incrementalEqualsFullRecompute(imtaphy::Uplink);
+        }
+
+        void
+        ChaseCombiningDecoderTest::newDataIndicatorResetsState()
+        {
+            // through the HARQ receiver process, which owns the soft buffer and its combining state
+            DecoderInterface* decoder = entity->getDecoder();
+            std::vector<unsigned int> layers(1, 1);
+
+            RedundancyVersionStatus first = redundancyVersion(imtaphy::Downlink, layers, -5.0, 1.0, true, 1);
+            RedundancyVersionStatus retransmission = redundancyVersion(imtaphy::Downlink, layers, -6.0, -1.0, false, 2);
+            RedundancyVersionStatus newData = redundancyVersion(imtaphy::Downlink, layers, -8.0, 0.5, true, 1);
+
+            CPPUNIT_ASSERT( !entity->decodeReceivedTransportBlock(first.first, first.second, 0) );
+            CPPUNIT_ASSERT( !entity->decodeReceivedTransportBlock(retransmission.first, retransmission.second, 0) );
+            double combinedEffSINR = getDCI(retransmission)->magic.effSINR.get_dB();
+            CPPUNIT_ASSERT( !entity->decodeReceivedTransportBlock(newData.first, newData.second, 0) );
+            double newDataEffSINR = getDCI(newData)->magic.effSINR.get_dB();
+            CPPUNIT_ASSERT_EQUAL( 0U, acks );
+            CPPUNIT_ASSERT_EQUAL( 3U, nacks );
+
+            // the retransmission was combined with the first transmission
+            SoftCombiningBuffer buffer;
+            buffer.push_back(first);
+            buffer.push_back(retransmission);
+            SoftCombiningState state;
+            decoder->canDecode(buffer, state);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL( getDCI(retransmission)->magic.effSINR.get_dB(), combinedEffSINR, 1E-9 );
+
+            // the toggled NDI started over: only the new TB is in the soft buffer
+            buffer.clear();
+            state.clear();
+            buffer.push_back(newData);
+            decoder->canDecode(buffer, state);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL( getDCI(newData)->magic.effSINR.get_dB(), newDataEffSINR, 1E-9 );
+
+            buffer.clear();
+            state.clear();
+            buffer.push_back(first);
+            buffer.push_back(retransmission);
+            buffer.push_back(newData);
+            decoder->canDecode(buffer, state);
+            CPPUNIT_ASSERT( getDCI(newData)->magic.effSINR.get_dB() > newDataEffSINR + 1.0 );
+        }
+}}}}
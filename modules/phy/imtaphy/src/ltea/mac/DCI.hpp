@@ -36,15 +36,13 @@
 #include <IMTAPHY/interface/DataTransmission.hpp>
 #include <IMTAPHY/detail/LinearAlgebra.hpp>
 #include <IMTAPHY/Spectrum.hpp>
+#include <IMTAPHY/ltea/mac/PRBTrace.hpp>
 
 namespace ltea { namespace mac { 
 
     // Note that even though DCI stands for DownlinkControlInformation, it seems to be used for
     // uplink scheduling grants as well (OK, they are also signalied in the downlink). So we will
     // also use it for uplink transmisison infos.
-    
-    typedef std::map<std::string, double> SchedulingTracingDict;
-    typedef std::map<imtaphy::interface::PRB, SchedulingTracingDict> PRBSchedulingTracingDictMap;
 
     class DownlinkControlInformation :
         public wns::ldk::Command
@@ -87,8 +85,8 @@ namespace ltea { namespace mac {
                 double bler;
                 wns::Ratio effSINR;
                 
-                // dictionary that can hold arbitrary tracing information
-                PRBSchedulingTracingDictMap prbTracingDict;
+                // per-PRB tracing information, only filled if PRBTrace::isEnabled()
+                PRBTrace prbTrace;
 
             } magic;
     };
@@ -0,0 +1,251 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <IMTAPHY/ltea/mac/PRBTrace.hpp>
+#include <WNS/Assure.hpp>
+#include <WNS/Exception.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cstddef>
+
+using namespace ltea::mac;
+
+#ifndef LTEA_NO_PRBTRACE
+bool PRBTrace::enabled = false;
+#endif
+
+namespace {
+    const char* fieldNames[NumPRBTraceFields] = {
+        "PMI",
+        "RI",
+        "PFmetric",
+        "EstInTTI",
+        "TxPwrPRBmW",
+        "NumPRBs",
+        "TotalPwrmW",
+        "TBsize",
+        "CI",
+        "SINRoff",
+        "Metric",
+        "PerfSINRest",
+        "best+offset"
+    };
+
+    struct PRBLess
+    {
+        bool operator()(const PRBTraceRecord& record, imtaphy::interface::PRB prb) const {return record.prb < prb;}
+    };
+
+    const boost::uint32_t formatVersion = 1;
+    const boost::uint32_t byteOrderMark = 0x01020304;
+    const boost::uint32_t blockMagic = 0x54425250; // "PRBT"
+    const unsigned int fieldNameLength = 16;
+}
+
+const char*
+ltea::mac::prbTraceFieldName(PRBTraceField field)
+{
+    assure(field < NumPRBTraceFields, "Invalid PRB trace field");
+    return fieldNames[field];
+}
+
+#ifndef LTEA_NO_PRBTRACE
+PRBTraceRecord&
+PRBTrace::operator[](imtaphy::interface::PRB prb)
+{
+    // the producers mostly trace in increasing PRB order
+    if (records.empty() || (records.back().prb < prb))
+    {
+        records.push_back(PRBTraceRecord(prb));
+        return records.back();
+    }
+
+    std::vector<PRBTraceRecord>::iterator iter = std::lower_bound(records.begin(), records.end(), prb, PRBLess());
+    if ((iter == records.end()) || (iter->prb != prb))
+        iter = records.insert(iter, PRBTraceRecord(prb));
+    return *iter;
+}
+
+const PRBTraceRecord*
+PRBTrace::find(imtaphy::interface::PRB prb) const
+{
+    const_iterator iter = std::lower_bound(records.begin(), records.end(), prb, PRBLess());
+    if ((iter == records.end()) || (iter->prb != prb))
+        return NULL;
+    return &(*iter);
+}
+
+void
+PRBTrace::complement(const PRBTrace& other)
+{
+    for (std::vector<PRBTraceRecord>::iterator iter = records.begin(); iter != records.end(); iter++)
+    {
+        const PRBTraceRecord* otherRecord = other.find(iter->prb);
+        if (otherRecord == NULL)
+            continue;
+
+        boost::uint32_t missing = otherRecord->fields & ~(iter->fields);
+        for (unsigned int f = 0; f < NumPRBTraceFields; f++)
+        {
+            if ((missing >> f) & 1)
+                iter->set(static_cast<PRBTraceField>(f), otherRecord->values[f]);
+        }
+    }
+}
+
+#else
+PRBTraceRecord&
+PRBTrace::operator[](imtaphy::interface::PRB)
+{
+    throw wns::Exception("PRB tracing has been compiled out (built with prbTrace=False)");
+}
+#endif
+
+PRBTraceDump&
+PRBTraceDump::getInstance()
+{
+    static PRBTraceDump instance;
+    return instance;
+}
+
+PRBTraceDump::PRBTraceDump() :
+    file(NULL),
+    currentTTI(0),
+    numRows(0),
+    numBlocks(0)
+{
+}
+
+PRBTraceDump::~PRBTraceDump()
+{
+    close();
+}
+
+void
+PRBTraceDump::open(const std::string& fileName)
+{
+#ifdef LTEA_NO_PRBTRACE
+    throw wns::Exception("Cannot write the PRB trace dump " + fileName + ", PRB tracing has been compiled out (built with prbTrace=False)");
+#endif
+
+    if (file != NULL)
+        return;
+
+    file = std::fopen(fileName.c_str(), "wb");
+    assure(file, "Could not open PRB trace dump " << fileName);
+
+    // the dump is a singleton that may be reopened after close (e.g., in the unit tests)
+    numRows = 0;
+    numBlocks = 0;
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::strncpy(header.magic, "IMTAPRB", sizeof(header.magic));
+    header.version = formatVersion;
+    header.byteOrder = byteOrderMark;
+    header.numFields = NumPRBTraceFields;
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    char names[NumPRBTraceFields][fieldNameLength];
+    std::memset(names, 0, sizeof(names));
+    for (unsigned int f = 0; f < NumPRBTraceFields; f++)
+        std::strncpy(names[f], fieldNames[f], fieldNameLength - 1);
+    std::fwrite(names, sizeof(names), 1, file);
+
+    PRBTrace::enable();
+}
+
+void
+PRBTraceDump::append(unsigned int tti, const boost::uint32_t intValues[NumIntColumns], double sinrDB, const PRBTraceRecord* record)
+{
+    assure(file, "PRB trace dump has not been opened");
+
+    if ((numRows > 0) && (tti != currentTTI))
+        writeBlock();
+    currentTTI = tti;
+
+    for (unsigned int c = 0; c < NumIntColumns; c++)
+        intColumns[c].push_back(intValues[c]);
+
+    doubleColumns[0].push_back(sinrDB);
+    for (unsigned int f = 0; f < NumPRBTraceFields; f++)
+    {
+        if ((record != NULL) && record->has(static_cast<PRBTraceField>(f)))
+            doubleColumns[f + 1].push_back(record->values[f]);
+        else
+            doubleColumns[f + 1].push_back(std::numeric_limits<double>::quiet_NaN());
+    }
+    numRows++;
+}
+
+void
+PRBTraceDump::writeBlock()
+{
+    BlockHeader header;
+    header.magic = blockMagic;
+    header.tti = currentTTI;
+    header.numRows = numRows;
+    header.reserved = 0;
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    // clear() keeps the capacity, so the columns are only allocated during the first TTIs
+    for (unsigned int c = 0; c < NumIntColumns; c++)
+    {
+        std::fwrite(&intColumns[c][0], sizeof(boost::uint32_t), numRows, file);
+        intColumns[c].clear();
+    }
+    for (unsigned int c = 0; c < NumPRBTraceFields + 1; c++)
+    {
+        std::fwrite(&doubleColumns[c][0], sizeof(double), numRows, file);
+        doubleColumns[c].clear();
+    }
+
+    numRows = 0;
+    numBlocks++;
+}
+
+void
+PRBTraceDump::close()
+{
+    if (file == NULL)
+        return;
+
+    if (numRows > 0)
+        writeBlock();
+
+    // patch the number of blocks into the header
+    std::fseek(file, offsetof(FileHeader, numBlocks), SEEK_SET);
+    boost::uint32_t blocks = numBlocks;
+    std::fwrite(&blocks, sizeof(blocks), 1, file);
+
+    std::fclose(file);
+    file = NULL;
+}
@@ -0,0 +1,216 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef LTEA_MAC_PRBTRACE_HPP
+#define LTEA_MAC_PRBTRACE_HPP
+
+#include <IMTAPHY/interface/TransmissionStatus.hpp>
+
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+namespace ltea { namespace mac {
+
+    // Per-PRB tracing information that schedulers and link adaptations attach to a DCI for the
+    // receiver's transmission traces (see PhyInterfaceRx). Every field has a fixed slot, so
+    // recording a value does not allocate anything beyond the PRB's record.
+    //
+    // Tracing is off unless a consumer enables it (the phyRxTracing JSON probe or the columnar
+    // PRBTraceDump), producers check PRBTrace::isEnabled() before recording. Building with the
+    // SCons option prbTrace=False defines LTEA_NO_PRBTRACE: PRBTrace then is an empty class whose
+    // isEnabled() is constant false, so the recording branches, the records the DCIs carry and
+    // the dump's column writing are compiled out.
+    enum PRBTraceField
+    {
+        TracePMI = 0,
+        TraceRI,
+        TracePFmetric,
+        TraceEstInTTI,
+        TraceTxPwrPRBmW,
+        TraceNumPRBs,
+        TraceTotalPwrmW,
+        TraceTBsize,
+        TraceCI,
+        TraceSINRoff,
+        TraceMetric,
+        TracePerfSINRest,
+        TraceBestPlusOffset,
+        NumPRBTraceFields
+    };
+
+    // the names as used in the JSON trace (the keys of the former tracing dictionaries)
+    const char*
+    prbTraceFieldName(PRBTraceField field);
+
+    struct PRBTraceRecord
+    {
+        explicit PRBTraceRecord(imtaphy::interface::PRB _prb) :
+            prb(_prb),
+            fields(0)
+        {}
+
+        bool has(PRBTraceField field) const {return (fields >> field) & 1;}
+        double get(PRBTraceField field) const {return values[field];}
+
+        void set(PRBTraceField field, double value)
+        {
+            values[field] = value;
+            fields |= (1U << field);
+        }
+
+        imtaphy::interface::PRB prb;
+        boost::uint32_t fields; // bit i set if values[i] is valid
+        double values[NumPRBTraceFields];
+    };
+
+    class PRBTrace
+    {
+    public:
+#ifndef LTEA_NO_PRBTRACE
+        typedef std::vector<PRBTraceRecord>::const_iterator const_iterator;
+
+        static bool isEnabled() {return enabled;}
+
+        static void enable() {enabled = true;}
+
+        // the record of that PRB, created if the PRB has not been traced yet
+        PRBTraceRecord& operator[](imtaphy::interface::PRB prb);
+
+        // NULL if the PRB has not been traced
+        const PRBTraceRecord* find(imtaphy::interface::PRB prb) const;
+
+        // For all PRBs traced here, add the fields that are only set in other. This is what the
+        // schedulers did with std::map::insert to join their and the link adaptation's dictionaries.
+        void complement(const PRBTrace& other);
+
+        void clear() {records.clear();}
+        bool empty() const {return records.empty();}
+        unsigned int size() const {return records.size();}
+        const_iterator begin() const {return records.begin();}
+        const_iterator end() const {return records.end();}
+
+    private:
+        std::vector<PRBTraceRecord> records; // sorted by PRB
+        static bool enabled;
+#else
+        typedef const PRBTraceRecord* const_iterator;
+
+        static bool isEnabled() {return false;}
+        static void enable() {}
+
+        // only reachable behind isEnabled(), throws if called anyway
+        PRBTraceRecord& operator[](imtaphy::interface::PRB prb);
+
+        const PRBTraceRecord* find(imtaphy::interface::PRB) const {return NULL;}
+        void complement(const PRBTrace&) {}
+        void clear() {}
+        bool empty() const {return true;}
+        unsigned int size() const {return 0;}
+        const_iterator begin() const {return NULL;}
+        const_iterator end() const {return NULL;}
+#endif
+    };
+
+    // Columnar binary dump of the traced PRBs of all received transport blocks. The rows of a TTI
+    // are collected in column buffers that are reused every TTI and written as one block when
+    // the first row of the next TTI arrives (or on close). Layout (native little endian):
+    //
+    //   FileHeader, char fieldNames[NumPRBTraceFields][16]
+    //   block: BlockHeader, uint32 columns (receiver, sender, tbId, attempt, decodable, layer,
+    //          prb, fields) and double columns (SINR in dB, then one per PRBTraceField, NaN if
+    //          not set) with numRows entries each
+    //
+    // framework/pywns/pywns/PRBTrace.py reads it with numpy.
+    class PRBTraceDump
+    {
+    public:
+        struct FileHeader
+        {
+            char magic[8];              // "IMTAPRB"
+            boost::uint32_t version;
+            boost::uint32_t byteOrder;
+            boost::uint32_t numFields;
+            boost::uint32_t numBlocks;  // 0 until the dump has been closed
+        };
+
+        struct BlockHeader
+        {
+            boost::uint32_t magic;      // "PRBT"
+            boost::uint32_t tti;
+            boost::uint32_t numRows;
+            boost::uint32_t reserved;
+        };
+
+        enum IntColumn
+        {
+            ColReceiver = 0,
+            ColSender,
+            ColTBid,
+            ColAttempt,
+            ColDecodable,
+            ColLayer,
+            ColPRB,
+            ColFields,
+            NumIntColumns
+        };
+
+        static PRBTraceDump& getInstance();
+
+        // only the first call opens the file, later calls (e.g., from other receivers) are ignored;
+        // throws if PRB tracing has been compiled out
+        void open(const std::string& fileName);
+#ifndef LTEA_NO_PRBTRACE
+        bool isOpen() const {return file != NULL;}
+#else
+        bool isOpen() const {return false;}
+#endif
+
+        // one row per traced PRB and layer of a received transport block
+        void append(unsigned int tti, const boost::uint32_t intValues[NumIntColumns], double sinrDB, const PRBTraceRecord* record);
+
+        void close();
+
+    private:
+        PRBTraceDump();
+        ~PRBTraceDump();
+
+        void writeBlock();
+
+        std::FILE* file;
+        unsigned int currentTTI;
+        unsigned int numRows;
+        unsigned int numBlocks;
+        std::vector<boost::uint32_t> intColumns[NumIntColumns];
+        std::vector<double> doubleColumns[NumPRBTraceFields + 1];
+    };
+}}
+
+#endif
@@ -126,6 +126,12 @@ namespace ltea { namespace mac { namespace harq {
         hasRetransmission(wns::node::Interface* peer, int processID, unsigned int spatialID);
 
         void setDCIReader(wns::ldk::CommandReaderInterface* dciReader);
+
+        /**
+         * @brief The logger shared by all HARQ entities and processes
+         */
+        const wns::logger::Logger&
+        getLogger() const {return logger_;}
         
         
         /**
@@ -98,6 +98,7 @@ HARQReceiverProcess::decodeReceivedTransportBlock(wns::ldk::CompoundPtr transpor
     if (dci->peer.NDI)
     {
         receptionBuffer_.clear();
+        combiningState_.clear();
     }
 
     if (dci->magic.ackCallback.empty())
@@ -115,11 +116,12 @@ HARQReceiverProcess::decodeReceivedTransportBlock(wns::ldk::CompoundPtr transpor
     receptionBuffer_.push_back(std::make_pair<wns::ldk::CompoundPtr, imtaphy::interface::TransmissionStatusPtr>(transportBlockRedundancyVersion, status));
     
     
-    if(entity_->getDecoder()->canDecode(receptionBuffer_))
+    if(entity_->getDecoder()->canDecode(receptionBuffer_, combiningState_))
     {
         MESSAGE_SINGLE(NORMAL, logger_, "HARQReceiver processID=" << processID_ << " sucessful decoded");
         
         receptionBuffer_.clear();
+        combiningState_.clear();
 
         // send magic ACK feedback to sending process        
         dci->magic.ackCallback();
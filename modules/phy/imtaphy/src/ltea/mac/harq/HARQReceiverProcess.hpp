@@ -116,6 +116,8 @@ namespace ltea { namespace mac { namespace harq {
         wns::logger::Logger logger_;
         
         ltea::l2s::harq::SoftCombiningBuffer receptionBuffer_;
+
+        ltea::l2s::harq::SoftCombiningState combiningState_;
     };
     
     
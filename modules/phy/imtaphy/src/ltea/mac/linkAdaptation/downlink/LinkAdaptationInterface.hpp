@@ -54,7 +54,7 @@ namespace ltea { namespace mac { namespace la { namespace downlink {
             double codeRate;
             imtaphy::l2s::ModulationScheme modulation;
             wns::Ratio estimatedSINR;
-            PRBSchedulingTracingDictMap prbTracingDict;
+            PRBTrace prbTrace;
         };
     
         class LinkAdaptationInterface 
@@ -80,6 +80,8 @@ namespace ltea { namespace mac { namespace la { namespace downlink {
                                                                bool provideRel10DMRS,
                                                                unsigned int numRel10CSIrsSets
                                                                ) = 0;                     
+
+            virtual const wns::logger::Logger& getLogger() const = 0;
         };
         
         class LinkAdaptationBase :
@@ -106,6 +108,11 @@ namespace ltea { namespace mac { namespace la { namespace downlink {
                 {
                     harq = harq_;
                 }
+
+                virtual const wns::logger::Logger& getLogger() const
+                {
+                    return logger;
+                }
             
             protected:
                 imtaphy::receivers::feedback::DownlinkFeedbackManagerInterface* feedbackManager;
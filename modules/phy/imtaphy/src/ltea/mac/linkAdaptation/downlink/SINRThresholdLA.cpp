@@ -102,7 +102,8 @@ SINRThresholdLinkAdaptation::performLinkAdaptation(wns::node::Interface* userID,
         // would yield a BLER of 10%. This is a conservative assumption
         sinrs.push_back(sinrThreshold + iter->second);
         
-        result.prbTracingDict[prb]["EstInTTI"] = feedback->estimatedInTTI[prb];
+        if (PRBTrace::isEnabled())
+            result.prbTrace[prb].set(TraceEstInTTI, feedback->estimatedInTTI[prb]);
     }
     
     // here we want to compute an effective SINR based on the individual SINRs
@@ -80,7 +80,8 @@ LinkAdaptationBase::performLinkAdaptation(wns::node::Interface* userID,
         sinrs[f] = sinrEstimates[userID][prbs[f]] + sinrPowerGain;
         
         // TODO: rename or somthing?
-        result.prbTracingDict[prbs[f]]["EstInTTI"] = channelStatus->estimatedInTTI[prbs[f]];
+        if (PRBTrace::isEnabled())
+            result.prbTrace[prbs[f]].set(TraceEstInTTI, channelStatus->estimatedInTTI[prbs[f]]);
     }
         
                    
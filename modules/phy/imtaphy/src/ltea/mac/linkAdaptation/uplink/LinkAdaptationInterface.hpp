@@ -66,7 +66,7 @@ namespace ltea { namespace mac {
             imtaphy::l2s::ModulationScheme modulation;
             wns::Ratio estimatedSINR;
             wns::Power txPowerPerPRB;
-            PRBSchedulingTracingDictMap prbTracingDict;
+            PRBTrace prbTrace;
         };
     
         class LinkAdaptationInterface 
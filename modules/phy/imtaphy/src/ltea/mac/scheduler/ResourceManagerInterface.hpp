@@ -50,6 +50,7 @@ namespace ltea { namespace mac { namespace scheduler {
             virtual void setUplinkStatusManager(imtaphy::receivers::feedback::UplinkChannelStatusManagerInterface* uplinkChannelStatus) = 0;
 
             virtual void determineResourceRestrictions(ltea::mac::scheduler::UsersPRBManager& usersPRBManager, imtaphy::Direction direction) = 0;
+            virtual const wns::logger::Logger& getLogger() const = 0;
 
         };
         
@@ -63,6 +64,7 @@ namespace ltea { namespace mac { namespace scheduler {
                 virtual void setDownlinkFeedbackManager(imtaphy::receivers::feedback::DownlinkFeedbackManagerInterface* feedbackManager);
                 virtual void setUplinkStatusManager(imtaphy::receivers::feedback::UplinkChannelStatusManagerInterface* uplinkChannelStatus);
                 virtual void determineResourceRestrictions(ltea::mac::scheduler::UsersPRBManager& usersPRBManager, imtaphy::Direction direction);
+                virtual const wns::logger::Logger& getLogger() const {return logger;}
 
             protected:
                 wns::logger::Logger logger;
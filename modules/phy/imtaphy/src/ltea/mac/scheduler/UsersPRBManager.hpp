@@ -31,125 +31,246 @@
 #define LTEA_MAC_SCHEDULER_USERSPRBMANAGER_HPP
 
 #include <WNS/node/Interface.hpp>
+#include <WNS/PowerRatio.hpp>
+#include <WNS/Assure.hpp>
 #include <IMTAPHY/detail/NodePtrCompare.hpp>
 #include <IMTAPHY/interface/TransmissionStatus.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <vector>
 #include <set>
 
 namespace ltea { namespace mac { namespace scheduler {
 
     typedef std::set<imtaphy::interface::PRB> PRBSet; 
     typedef std::set<wns::node::Interface*, imtaphy::detail::WnsNodeInterfacePtrCompare> UserSet;
-    typedef std::map<imtaphy::interface::PRB, UserSet> PRBUserSetMap;
     typedef std::vector<wns::Power> PowerVector;
-    
+
+    // one bit per user index (or PRB), 64 per word
+    typedef boost::uint64_t BitWord;
+    const unsigned int bitsPerWord = 64;
+
+    inline unsigned int
+    lowestSetBit(BitWord word)
+    {
+        assure(word != 0, "No bit set");
+#ifdef __GNUC__
+        return __builtin_ctzll(word);
+#else
+        unsigned int bit = 0;
+        while ((word & 1) == 0)
+        {
+            word >>= 1;
+            bit++;
+        }
+        return bit;
+#endif
+    }
+
+    /**
+     * @brief Bookkeeping of which users may still be scheduled on which PRBs and with
+     * which power.
+     *
+     * Users are identified by a dense index assigned by registerUsers (sorted by node ID
+     * so that iterating over indices visits the users in UserSet order) or on first use.
+     * For each free PRB a bitmask over user indices tells the users that may be scheduled
+     * there; getUserMask allows the schedulers to iterate over these bits directly.
+     */
     class UsersPRBManager
     {
         public:
             UsersPRBManager(unsigned int numPRBs_, wns::Power defaultMaxPowerPerPRB_) :
                 numPRBs(numPRBs_),
+                numUserWords(0),
+                numPRBWords((numPRBs_ + bitsPerWord - 1) / bitsPerWord),
+                freePRBs(numPRBWords, 0),
+                numFreePRBs(0),
                 defaultMaxPowerPerPRB(defaultMaxPowerPerPRB_),
                 maxPowerPerPRB(numPRBs, defaultMaxPowerPerPRB)
             {
-                for (unsigned int prb = 0; prb < numPRBs; prb++)
+                reset();
+            }
+
+            /**
+             * @brief Assigns indices to all users, ordered by their node IDs. Users that are
+             * already known keep their index.
+             */
+            void registerUsers(const std::vector<wns::node::Interface*>& users_)
+            {
+                std::vector<wns::node::Interface*> sorted(users_);
+                std::sort(sorted.begin(), sorted.end(), imtaphy::detail::WnsNodeInterfacePtrCompare());
+
+                for (unsigned int i = 0; i < sorted.size(); i++)
+                    getUserIndex(sorted[i]);
+            }
+
+            unsigned int getNumUsers() const
+            {
+                return users.size();
+            }
+
+            wns::node::Interface* getUser(unsigned int userIndex) const
+            {
+                assure(userIndex < users.size(), "Invalid user index");
+                return users[userIndex];
+            }
+
+            /**
+             * @brief The dense index of user, unknown users are registered on the fly
+             */
+            unsigned int getUserIndex(wns::node::Interface* user)
+            {
+                unsigned int nodeID = user->getNodeID();
+                if ((nodeID < nodeIndex.size()) && (nodeIndex[nodeID] >= 0))
+                    return nodeIndex[nodeID];
+
+                if (nodeID >= nodeIndex.size())
+                    nodeIndex.resize(nodeID + 1, -1);
+
+                unsigned int userIndex = users.size();
+                nodeIndex[nodeID] = userIndex;
+                users.push_back(user);
+                userPowerRestricted.push_back(false);
+                userPower.resize(users.size() * numPRBs);
+
+                // grow the bitmasks if the new user does not fit into the last word
+                unsigned int words = (users.size() + bitsPerWord - 1) / bitsPerWord;
+                if (words != numUserWords)
                 {
-                    prbsAndUsers[prb] = UserSet();
+                    std::vector<BitWord> masks(numPRBs * words, 0);
+                    for (unsigned int prb = 0; prb < numPRBs; prb++)
+                        std::copy(prbUsers.begin() + prb * numUserWords, prbUsers.begin() + (prb + 1) * numUserWords,
+                                  masks.begin() + prb * words);
+                    prbUsers.swap(masks);
+                    activeUsers.resize(words, 0);
+                    numUserWords = words;
                 }
+                return userIndex;
+            }
+
+            bool isActive(unsigned int userIndex) const
+            {
+                assure(userIndex < users.size(), "Invalid user index");
+                return (activeUsers[userIndex / bitsPerWord] >> (userIndex % bitsPerWord)) & 1;
             }
 
             bool isActive(wns::node::Interface* user) const
             {
-                return (activeUsers.find(user) != activeUsers.end());
+                unsigned int nodeID = user->getNodeID();
+                return (nodeID < nodeIndex.size()) && (nodeIndex[nodeID] >= 0) && isActive(nodeIndex[nodeID]);
             }
 
             UserSet getActiveUsers() const
             {
-               return activeUsers;
+                return usersInMask(numUserWords ? &activeUsers[0] : NULL);
             }
             
             UserSet getActiveUsers(unsigned int prb) const
             {
-                // return the set of active users for that prb or an empty set if not found
-                PRBUserSetMap::const_iterator iter;
-                if ((iter = prbsAndUsers.find(prb)) != prbsAndUsers.end())
-                {
-                    return iter->second;
-                }
-                else
-                {
+                // return the set of active users for that prb or an empty set if the PRB is used
+                if (!prbAvailable(prb))
                     return UserSet();
-                }
+
+                return usersInMask(getUserMask(prb));
+            }
+
+            /**
+             * @brief getNumUserWords() words with bit u set if user index u may be scheduled
+             * on the PRB, all zero if the PRB is not available anymore
+             */
+            const BitWord* getUserMask(imtaphy::interface::PRB prb) const
+            {
+                assure(prb < numPRBs, "Invalid PRB");
+                return numUserWords ? &prbUsers[prb * numUserWords] : NULL;
+            }
+
+            unsigned int getNumUserWords() const
+            {
+                return numUserWords;
             }
 
             void restrictUserToPRBs(wns::node::Interface* user, PRBSet prbs)
             {
-                for (PRBUserSetMap::iterator iter = prbsAndUsers.begin(); 
-                        iter != prbsAndUsers.end(); iter++)
+                unsigned int userIndex = getUserIndex(user);
+
+                // Erase user from PRBs not included in the "prbs" set
+                for (unsigned int prb = 0; prb < numPRBs; prb++)
                 {
-                    // Erase user from PRBs not included in the "prbs" set
-                    if (prbs.find(iter->first) == prbs.end())
-                    {
-                        iter->second.erase(user);
-                    }
+                    if (prbs.find(prb) == prbs.end())
+                        clearBit(&prbUsers[prb * numUserWords], userIndex);
                 }
             }
             
             void addActiveUser(wns::node::Interface* user)
             {
-                // add user to set of active users and allow him on all PRBs
-                for (PRBUserSetMap::iterator iter = prbsAndUsers.begin(); 
-                        iter != prbsAndUsers.end(); iter++)
+                unsigned int userIndex = getUserIndex(user);
+
+                // add user to set of active users and allow him on all free PRBs
+                for (unsigned int prb = 0; prb < numPRBs; prb++)
                 {
-                    iter->second.insert(user);
+                    if (prbAvailable(prb))
+                        setBit(&prbUsers[prb * numUserWords], userIndex);
                 }
                 
-                activeUsers.insert(user);
+                setBit(&activeUsers[0], userIndex);
             }
 
-            void removeActiveUser(wns::node::Interface* user)
+            void removeActiveUser(unsigned int userIndex)
             {
+                assure(userIndex < users.size(), "Invalid user index");
+
                 // remove from all user sets and from the set of active users
-                for (PRBUserSetMap::iterator iter = prbsAndUsers.begin(); 
-                     iter != prbsAndUsers.end(); iter++)
-                {
-                    iter->second.erase(user);
-                }
+                for (unsigned int prb = 0; prb < numPRBs; prb++)
+                    clearBit(&prbUsers[prb * numUserWords], userIndex);
                 
-                activeUsers.erase(user);
+                clearBit(&activeUsers[0], userIndex);
+            }
+
+            void removeActiveUser(wns::node::Interface* user)
+            {
+                removeActiveUser(getUserIndex(user));
             }
             
             void markPRBused(unsigned int prb)
             {
-                prbsAndUsers.erase(prb);
+                if (!prbAvailable(prb))
+                    return;
+
+                clearBit(&freePRBs[0], prb);
+                numFreePRBs--;
+                std::fill(prbUsers.begin() + prb * numUserWords, prbUsers.begin() + (prb + 1) * numUserWords, 0);
             }
             
-            imtaphy::interface::PRBVector getPRBsAvailable(wns::node::Interface* user)
+            imtaphy::interface::PRBVector getPRBsAvailable(unsigned int userIndex) const
             {
+                assure(userIndex < users.size(), "Invalid user index");
+
                 imtaphy::interface::PRBVector result;
                 
-                // Return all PRBs for which user is in the user set
-                for (PRBUserSetMap::const_iterator iter = prbsAndUsers.begin(); 
-                     iter != prbsAndUsers.end(); iter++)
+                // Return all PRBs for which the user's bit is set
+                for (unsigned int prb = 0; prb < numPRBs; prb++)
                 {
-                    if (iter->second.find(user) != iter->second.end())
-                    {
-                        result.push_back(iter->first);
-                    }
+                    if (testBit(&prbUsers[prb * numUserWords], userIndex))
+                        result.push_back(prb);
                 }
                 
                 return result;
             }
+
+            imtaphy::interface::PRBVector getPRBsAvailable(wns::node::Interface* user)
+            {
+                return getPRBsAvailable(getUserIndex(user));
+            }
             
             unsigned int getNumPRBsAvailable(wns::node::Interface* user)
             {
+                unsigned int userIndex = getUserIndex(user);
                 unsigned int result = 0;
                 
-                for (PRBUserSetMap::const_iterator iter = prbsAndUsers.begin(); 
-                     iter != prbsAndUsers.end(); iter++)
+                for (unsigned int prb = 0; prb < numPRBs; prb++)
                 {
-                    if (iter->second.find(user) != iter->second.end())
-                    {
+                    if (testBit(&prbUsers[prb * numUserWords], userIndex))
                         result++;
-                    }
                 }
                 
                 return result;
@@ -157,57 +278,56 @@ namespace ltea { namespace mac { namespace scheduler {
             
             imtaphy::interface::PRBVector getPRBsAvailable() const
             {
-                imtaphy::interface::PRBVector result(prbsAndUsers.size());
-                
-                unsigned int i;
-                PRBUserSetMap::const_iterator iter;
-                for (iter = prbsAndUsers.begin(), i = 0; 
-                     iter != prbsAndUsers.end(); iter++, i++)
+                imtaphy::interface::PRBVector result;
+                result.reserve(numFreePRBs);
+
+                for (unsigned int w = 0; w < numPRBWords; w++)
                 {
-                    result[i] = iter->first;
+                    for (BitWord word = freePRBs[w]; word != 0; word &= word - 1)
+                        result.push_back(w * bitsPerWord + lowestSetBit(word));
                 }
                 
                 return result;
             }
 
 
-            unsigned int getNumPRBsAvailable()
+            unsigned int getNumPRBsAvailable() const
             {
-                return prbsAndUsers.size();
+                return numFreePRBs;
             }
            
             bool prbAvailable(unsigned int prb) const
             {
-                return (prbsAndUsers.find(prb) != prbsAndUsers.end());
+                return (prb < numPRBs) && testBit(&freePRBs[0], prb);
             }
            
             void reset()
             {
-                prbsAndUsers.clear();
-                
+                // all PRBs are free again but no user may use them until (re-)added
+                std::fill(prbUsers.begin(), prbUsers.end(), 0);
+                std::fill(freePRBs.begin(), freePRBs.end(), 0);
                 for (unsigned int prb = 0; prb < numPRBs; prb++)
-                {
-                    prbsAndUsers[prb] = UserSet();
-                }
+                    setBit(&freePRBs[0], prb);
+                numFreePRBs = numPRBs;
                 
-                maxPowerPerPRB = PowerVector(numPRBs, defaultMaxPowerPerPRB);
-                perUserPowerRestrictions.clear();
+                std::fill(maxPowerPerPRB.begin(), maxPowerPerPRB.end(), defaultMaxPowerPerPRB);
+                std::fill(userPowerRestricted.begin(), userPowerRestricted.end(), false);
             }
             
-            
-            
-            wns::Power getAvailablePower(wns::node::Interface* user, imtaphy::interface::PRB prb)
+            wns::Power getAvailablePower(unsigned int userIndex, imtaphy::interface::PRB prb) const
             {
                 assure(prb < numPRBs, "Invalid PRB");
-                
-                if (perUserPowerRestrictions.find(user) == perUserPowerRestrictions.end())
-                {
-                    return maxPowerPerPRB[prb];
-                }
+                assure(userIndex < users.size(), "Invalid user index");
+
+                if (userPowerRestricted[userIndex])
+                    return userPower[userIndex * numPRBs + prb];
                 else
-                {
-                    return perUserPowerRestrictions[user][prb];
-                }
+                    return maxPowerPerPRB[prb];
+            }
+            
+            wns::Power getAvailablePower(wns::node::Interface* user, imtaphy::interface::PRB prb)
+            {
+                return getAvailablePower(getUserIndex(user), prb);
             }
 
             wns::Power getAvailablePower(imtaphy::interface::PRB prb)
@@ -227,23 +347,60 @@ namespace ltea { namespace mac { namespace scheduler {
             void restrictPower(wns::node::Interface* user, imtaphy::interface::PRB prb, wns::Power power)
             {
                 assure(prb < numPRBs, "Invalid PRB");
+                unsigned int userIndex = getUserIndex(user);
                     
-                if (perUserPowerRestrictions.find(user) == perUserPowerRestrictions.end())
+                if (!userPowerRestricted[userIndex])
                 {
-                    perUserPowerRestrictions[user] = maxPowerPerPRB;
+                    std::copy(maxPowerPerPRB.begin(), maxPowerPerPRB.end(), userPower.begin() + userIndex * numPRBs);
+                    userPowerRestricted[userIndex] = true;
                 }
                 
-                perUserPowerRestrictions[user][prb] = power;
+                userPower[userIndex * numPRBs + prb] = power;
             }
             
         private:
+            static bool testBit(const BitWord* words, unsigned int bit)
+            {
+                return (words[bit / bitsPerWord] >> (bit % bitsPerWord)) & 1;
+            }
+
+            static void setBit(BitWord* words, unsigned int bit)
+            {
+                words[bit / bitsPerWord] |= BitWord(1) << (bit % bitsPerWord);
+            }
+
+            static void clearBit(BitWord* words, unsigned int bit)
+            {
+                words[bit / bitsPerWord] &= ~(BitWord(1) << (bit % bitsPerWord));
+            }
+
+            UserSet usersInMask(const BitWord* mask) const
+            {
+                UserSet result;
+                for (unsigned int w = 0; w < numUserWords; w++)
+                {
+                    for (BitWord word = mask[w]; word != 0; word &= word - 1)
+                        result.insert(users[w * bitsPerWord + lowestSetBit(word)]);
+                }
+                return result;
+            }
+
             unsigned int numPRBs;
-            PRBUserSetMap prbsAndUsers;
-            UserSet activeUsers;
+            unsigned int numUserWords;
+            unsigned int numPRBWords;
+
+            std::vector<wns::node::Interface*> users;  // by user index
+            std::vector<int> nodeIndex;                // user index by node ID, -1 if unknown
+
+            std::vector<BitWord> prbUsers;             // numPRBs x numUserWords
+            std::vector<BitWord> activeUsers;          // numUserWords
+            std::vector<BitWord> freePRBs;             // numPRBWords
+            unsigned int numFreePRBs;
+
             wns::Power defaultMaxPowerPerPRB;
             PowerVector maxPowerPerPRB;
-            std::map<wns::node::Interface*, PowerVector> perUserPowerRestrictions;
-            
+            std::vector<bool> userPowerRestricted;     // by user index
+            PowerVector userPower;                     // user index x numPRBs, valid if restricted
     };
     
 }}}
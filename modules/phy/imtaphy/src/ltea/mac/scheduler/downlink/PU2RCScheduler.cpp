@@ -30,7 +30,6 @@
 
 #include <IMTAPHY/ltea/mac/scheduler/downlink/PU2RCScheduler.hpp>
 #include <boost/graph/graph_concepts.hpp>
-#include <IMTAPHY/receivers/feedback/PU2RCFeedbackManager.hpp>
 #include <algorithm>
 #include <fstream>
 #include <IMTAPHY/antenna/LinearAntennaArray.hpp>
@@ -96,11 +95,7 @@ PU2RCScheduler::initScheduler()
 
     assure(syncHARQ == false, "PU2RCScheduler only supports asynchronous/adaptive HARQ operation, i.e., with HARQ retransmissions controlled by the PU2RC scheduler");
 
-    // Init the throughput history for exponential averaging
-    for (unsigned int i = 0; i < allUsers.size(); i++)
-    {
-        throughputHistory[allUsers[i]] = 1.0;
-    }
+    // the throughput history for exponential averaging starts at 1.0 in userState
 
     assure(numTxAntennas == 4, "Only works with 4 antennas and not with " << numTxAntennas);
 
@@ -397,7 +392,7 @@ PU2RCScheduler::doScheduling()
     unsigned int numImperfectRetransmissions = 0;
     unsigned int numImperfectTransmissions = 0;
     
-    throughputThisTTI.clear();
+    std::fill(userState.throughputThisTTI.begin(), userState.throughputThisTTI.end(), 0.0);
     
     grid->reset();
     
@@ -489,7 +484,7 @@ PU2RCScheduler::doScheduling()
     }
     
     // log how much of the grid could be filled by the initial scheduling routine (i.e., how uch has to be fixed
-    fillLevelContextCollector->put(static_cast<double>(numInitialResources)/static_cast<double>(4*numPRBs));
+    putProbe(fillLevelContextCollector, static_cast<double>(numInitialResources)/static_cast<double>(4*numPRBs));
 
     
     ltea::mac::scheduler::UserSet scheduledNewTransmissions;
@@ -539,7 +534,7 @@ PU2RCScheduler::doScheduling()
         {
             for (ltea::mac::scheduler::UserSet::iterator iterTooFew = retransmissionsTooFewPRBs.begin(); iterTooFew != retransmissionsTooFewPRBs.end(); iterTooFew++)
             {
-                //if (userToIndexLookup[*iterTooFew][coordIter->prb] == codebook->getIndex(grid->getPMI(coordIter->prb), coordIter->column))
+                //if (getPreferredIndex(*iterTooFew, coordIter->prb) == codebook->getIndex(grid->getPMI(coordIter->prb), coordIter->column))
                 if (userFits(*iterTooFew, coordIter->prb, grid->getPMI(coordIter->prb), coordIter->column) &&
                     !grid->userAlreadyScheduledOnPRB(*iterTooFew, coordIter->prb))
                 {
@@ -577,7 +572,7 @@ PU2RCScheduler::doScheduling()
 //            for (ltea::mac::scheduler::UserSet::iterator newUserIter = newTransmissionUsers.begin(); newUserIter != newTransmissionUsers.end(); newUserIter++)
            for (ltea::mac::scheduler::UserSet::iterator newUserIter = scheduledNewTransmissions.begin(); newUserIter != scheduledNewTransmissions.end(); newUserIter++)
             {   
-                // if (userToIndexLookup[*newUserIter][coordIter->prb] == codebook->getIndex(grid->getPMI(coordIter->prb), coordIter->column))
+                // if (getPreferredIndex(*newUserIter, coordIter->prb) == codebook->getIndex(grid->getPMI(coordIter->prb), coordIter->column))
                 if (userFits(*newUserIter, coordIter->prb, grid->getPMI(coordIter->prb), coordIter->column) &&
                     !grid->userAlreadyScheduledOnPRB(*newUserIter, coordIter->prb))
                 {
@@ -648,7 +643,7 @@ PU2RCScheduler::doScheduling()
             }
             else // this row was free, so assign desired pmi/ci
             {
-                // imtaphy::receivers::CodebookColumn preferred =  *(codebook->getCodebookColumns(userToIndexLookup[user][prb]).begin());
+                // imtaphy::receivers::CodebookColumn preferred =  *(codebook->getCodebookColumns(getPreferredIndex(user, prb)).begin());
                 imtaphy::receivers::CodebookColumn preferred = getPreferredCodebookColumn(user, prb);
                 grid->addEntry(prb, preferred.pmi, preferred.column, user, 0, wns::Ratio::from_factor(1.0));
             }
@@ -834,21 +829,23 @@ PU2RCScheduler::doScheduling()
         
         imtaphy::interface::PrbPowerPrecodingMap newPRBPowerPrecoding;
         
-        // clear the old tracing dict because it contains potentially wrong PRBs
-        dci->magic.prbTracingDict.clear();
+        // clear the old tracing because it contains potentially wrong PRBs
+        dci->magic.prbTrace.clear();
         
         imtaphy::interface::PrbPowerPrecodingMap::iterator resourceIter = dci->local.prbPowerPrecoders.begin();
         GridCoordinateSet::iterator coordinateIter = grid->getUserGridCoordinates(user).begin();
         for (; resourceIter != dci->local.prbPowerPrecoders.end(); resourceIter++, coordinateIter++)
         {
-            ltea::mac::SchedulingTracingDict tracing;
-            tracing["TBsize"] = grid->getNumPRBsPerUser(user); // number of PRBs
-            tracing["CI"] = coordinateIter->column;
-            tracing["PMI"] = grid->getPMI(coordinateIter->prb);
-            tracing["SINRoff"] = grid->getSINROffset(user, coordinateIter->prb, coordinateIter->column).get_dB();
-            tracing["Metric"] = grid->getMetric(coordinateIter->prb, coordinateIter->column);
+            if (ltea::mac::PRBTrace::isEnabled())
+            {
+                ltea::mac::PRBTraceRecord& tracing = dci->magic.prbTrace[coordinateIter->prb];
+                tracing.set(ltea::mac::TraceTBsize, grid->getNumPRBsPerUser(user)); // number of PRBs
+                tracing.set(ltea::mac::TraceCI, coordinateIter->column);
+                tracing.set(ltea::mac::TracePMI, grid->getPMI(coordinateIter->prb));
+                tracing.set(ltea::mac::TraceSINRoff, grid->getSINROffset(user, coordinateIter->prb, coordinateIter->column).get_dB());
+                tracing.set(ltea::mac::TraceMetric, grid->getMetric(coordinateIter->prb, coordinateIter->column));
+            }
             
-            dci->magic.prbTracingDict[coordinateIter->prb] = tracing;
             numRetransmissionResources++;
             newPRBPowerPrecoding[coordinateIter->prb].power = resourceIter->second.power;
             newPRBPowerPrecoding[coordinateIter->prb].precoding = codebook->get4TxCodebookColumn(grid->getPMI(coordinateIter->prb), coordinateIter->column);
@@ -883,21 +880,12 @@ PU2RCScheduler::doScheduling()
         allocation.scheduledUser = user;
         allocation.rank = 1;
         
-        imtaphy::receivers::feedback::PU2RCFeedback* pu2rcFeedback = dynamic_cast<imtaphy::receivers::feedback::PU2RCFeedback*>(feedbackManager->getFeedback(user, scheduleForTTI).get());
-        assure(pu2rcFeedback, "No PU2RCFeedback");
+        imtaphy::receivers::feedback::PU2RCFeedback* pu2rcFeedback = usersFeedback[getUserIndex(user)];
 
         for (GridCoordinateSet::iterator coordinateIter = allocatedResources.begin(); coordinateIter != allocatedResources.end(); coordinateIter++)
         {
             numNewTransmissionResources++;
             
-            ltea::mac::SchedulingTracingDict tracing;
-            tracing["TBsize"] = allocatedResources.size(); // number of PRBs
-            tracing["CI"] = coordinateIter->column;
-            tracing["PMI"] = grid->getPMI(coordinateIter->prb);
-            tracing["SINRoff"] = grid->getSINROffset(user, coordinateIter->prb, coordinateIter->column).get_dB();
-            tracing["Metric"] = grid->getMetric(coordinateIter->prb, coordinateIter->column);
-            
-            
             allocation.prbPowerPrecodingMap[coordinateIter->prb].power = txPowerdBmPerPRB;
             allocation.prbPowerPrecodingMap[coordinateIter->prb].precoding = codebook->get4TxCodebookColumn(grid->getPMI(coordinateIter->prb), coordinateIter->column);
             allocation.prbPowerOffsetForLA[coordinateIter->prb] = grid->getSINROffset(user, coordinateIter->prb, coordinateIter->column);
@@ -910,16 +898,22 @@ PU2RCScheduler::doScheduling()
             
             imtaphy::receivers::CodebookColumn bestVector = getPreferredCodebookColumn(user, coordinateIter->prb); 
             
-            tracing["PerfSINRest"] = (*(usersSINRs[user]))[coordinateIter->prb][grid->getPMI(coordinateIter->prb)][coordinateIter->column].get_dB();
-            tracing["best+offset"] = ((*(usersSINRs[user]))[coordinateIter->prb][bestVector.pmi][bestVector.column] +  allocation.prbPowerOffsetForLA[coordinateIter->prb]).get_dB();
+            if (ltea::mac::PRBTrace::isEnabled())
+            {
+                ltea::mac::PRBTraceRecord& tracing = allocation.prbTrace[coordinateIter->prb];
+                tracing.set(ltea::mac::TraceTBsize, allocatedResources.size()); // number of PRBs
+                tracing.set(ltea::mac::TraceCI, coordinateIter->column);
+                tracing.set(ltea::mac::TracePMI, grid->getPMI(coordinateIter->prb));
+                tracing.set(ltea::mac::TraceSINRoff, grid->getSINROffset(user, coordinateIter->prb, coordinateIter->column).get_dB());
+                tracing.set(ltea::mac::TraceMetric, grid->getMetric(coordinateIter->prb, coordinateIter->column));
+                tracing.set(ltea::mac::TracePerfSINRest, usersFeedback[getUserIndex(user)]->sinrMatrix[coordinateIter->prb][grid->getPMI(coordinateIter->prb)][coordinateIter->column].get_dB());
+                tracing.set(ltea::mac::TraceBestPlusOffset, (usersFeedback[getUserIndex(user)]->sinrMatrix[coordinateIter->prb][bestVector.pmi][bestVector.column] +  allocation.prbPowerOffsetForLA[coordinateIter->prb]).get_dB());
+            }
 
             
             // the magic SINR is based on unquantized estimation from the receiver
-            pu2rcFeedback->magicSINRs[coordinateIter->prb][0] = (*(usersSINRs[user]))[coordinateIter->prb][bestVector.pmi][bestVector.column] +  allocation.prbPowerOffsetForLA[coordinateIter->prb];
+            pu2rcFeedback->magicSINRs[coordinateIter->prb][0] = usersFeedback[getUserIndex(user)]->sinrMatrix[coordinateIter->prb][bestVector.pmi][bestVector.column] +  allocation.prbPowerOffsetForLA[coordinateIter->prb];
     
-                      
-            allocation.prbAndTracingInfo[coordinateIter->prb] = tracing;
-                      
         }
         
         scheduledUsers.push_back(allocation);
@@ -927,11 +921,11 @@ PU2RCScheduler::doScheduling()
     
     if (numRetransmissionResources > 0)
     {
-        imperfectReransmissionRatioCollector->put(static_cast<double>(numImperfectRetransmissions) / static_cast<double>(numRetransmissionResources));
+        putProbe(imperfectReransmissionRatioCollector, static_cast<double>(numImperfectRetransmissions) / static_cast<double>(numRetransmissionResources));
     }
     if (numNewTransmissionResources > 0)
     {
-        imperfectTransmissionRatioCollector->put(static_cast<double>(numImperfectTransmissions) / static_cast<double>(numNewTransmissionResources));
+        putProbe(imperfectTransmissionRatioCollector, static_cast<double>(numImperfectTransmissions) / static_cast<double>(numNewTransmissionResources));
     }
     
     MESSAGE_SINGLE(NORMAL, logger, "Grid fill level after fixing is " << static_cast<double>(numRetransmissionResources + numNewTransmissionResources) / static_cast<double>(numPRBs * 4));
@@ -946,10 +940,11 @@ PU2RCScheduler::doScheduling()
     // update based on the final link adaptation decisions
     for (ltea::mac::scheduler::UserSet::const_iterator iter = allUsers.begin(); iter != allUsers.end(); iter++)
     {
-        throughputHistory[*iter] = (1.0 - alpha) * throughputHistory[*iter] + alpha * throughputThisTTI[*iter];
+        unsigned int userIndex = getUserIndex(*iter);
+        updateThroughputHistory(userIndex, alpha);
         
         MESSAGE_SINGLE(NORMAL, logger, "Updating user " << (*iter)->getName() << "'s throughput by current throughput of "
-                                    << throughputThisTTI[*iter] << " to epx. average of " << throughputHistory[*iter] << "\n");
+                                    << userState.throughputThisTTI[userIndex] << " to epx. average of " << userState.throughputHistory[userIndex] << "\n");
     }
 
     
@@ -959,25 +954,24 @@ PU2RCScheduler::doScheduling()
 void 
 PU2RCScheduler::updatePU2RCFeedback(ltea::mac::scheduler::UserSet& allUsers)
 {
-    userToIndexLookup.clear();
-        
     for(ltea::mac::scheduler::UserSet::const_iterator iter = allUsers.begin(); iter!= allUsers.end(); iter++)
     {
         wns::node::Interface* thisUser = *iter;
-        imtaphy::receivers::feedback::PU2RCFeedback* pu2rcFeedback = dynamic_cast<imtaphy::receivers::feedback::PU2RCFeedback*>(feedbackManager->getFeedback(thisUser, scheduleForTTI).get());
-        assure(pu2rcFeedback, "No PU2RCFeedback");
+        unsigned int userIndex = getUserIndex(thisUser);
+        usersFeedback.resize(userState.feedback.size(), NULL);
+        preferredIndex.resize(userState.feedback.size() * numPRBs);
         
-        usersSINRs[thisUser] =  &(pu2rcFeedback->sinrMatrix);
+        userState.feedback[userIndex] = feedbackManager->getFeedback(thisUser, scheduleForTTI);
+        imtaphy::receivers::feedback::PU2RCFeedback* pu2rcFeedback = dynamic_cast<imtaphy::receivers::feedback::PU2RCFeedback*>(userState.feedback[userIndex].get());
+        assure(pu2rcFeedback, "No PU2RCFeedback");
         
+        usersFeedback[userIndex] = pu2rcFeedback;
         
         // TODO: this metric cache should go away and the estimateExpectedThroughput could be done more nicely as well
         
-        userToIndexLookup[thisUser] = std::vector<unsigned int>(numPRBs);
         for (unsigned int prb = 0; prb < numPRBs; prb++)
         {
-            
-            unsigned int index = codebook->getIndex(pu2rcFeedback->pmi[prb], pu2rcFeedback->columnIndicator[prb]);
-            userToIndexLookup[thisUser][prb] = index;
+            preferredIndex[userIndex * numPRBs + prb] = codebook->getIndex(pu2rcFeedback->pmi[prb], pu2rcFeedback->columnIndicator[prb]);
         }
     }
 }
@@ -990,7 +984,7 @@ PU2RCScheduler::userFits(wns::node::Interface* user, unsigned int prb, unsigned
     // a resource that was not returned as the best choice
     if (estimateForNonPreferred == NoEstimation)
     {
-        if ((userToIndexLookup[user][prb] == codebook->getIndex(pmi, column)))
+        if ((getPreferredIndex(user, prb) == codebook->getIndex(pmi, column)))
         {
             return true;
         }
@@ -1009,15 +1003,14 @@ inline
 imtaphy::receivers::CodebookColumn 
 PU2RCScheduler::getPreferredCodebookColumn(wns::node::Interface* user, unsigned int prb)
 {
-    return *(codebook->getCodebookColumns(userToIndexLookup[user][prb]).begin());
+    return *(codebook->getCodebookColumns(getPreferredIndex(user, prb)).begin());
 }
 
 inline
 double 
 PU2RCScheduler::getMetric(wns::node::Interface* user, unsigned int prb, unsigned int pmi, unsigned int column)
 {
-    imtaphy::receivers::feedback::PU2RCFeedback* pu2rcFeedback = dynamic_cast<imtaphy::receivers::feedback::PU2RCFeedback*>(feedbackManager->getFeedback(user, scheduleForTTI).get());
-    assure(pu2rcFeedback, "No PU2RCFeedback");
+    imtaphy::receivers::feedback::PU2RCFeedback* pu2rcFeedback = usersFeedback[getUserIndex(user)];
 
     wns::Ratio expectedSINR = blerModel->getSINRthreshold(pu2rcFeedback->cqiTb1[prb]);
     
@@ -1033,13 +1026,13 @@ PU2RCScheduler::getMetric(wns::node::Interface* user, unsigned int prb, unsigned
     }
     double expectedThroughput = log2(1.0 + expectedSINR.get_factor());
     
-    return expectedThroughput / pow(throughputHistory[user], historyExponent);
+    return expectedThroughput / pow(userState.throughputHistory[getUserIndex(user)], historyExponent);
 }
 
 wns::Ratio 
 PU2RCScheduler::estimateSINROffset(wns::node::Interface* user, unsigned int prb, unsigned int pmi, unsigned int column)
 {
-    if (userToIndexLookup[user][prb] == codebook->getIndex(pmi, column))
+    if (getPreferredIndex(user, prb) == codebook->getIndex(pmi, column))
     {
         // perfect match, no offset
         return wns::Ratio::from_factor(1.0);
@@ -1053,7 +1046,7 @@ PU2RCScheduler::estimateSINROffset(wns::node::Interface* user, unsigned int prb,
                 // this is just the difference between the best and the other
                 // the SINR for the best will still come from the quantized feedback, just the difference is perfect
                 imtaphy::receivers::CodebookColumn bestVector = getPreferredCodebookColumn(user, prb); 
-                return (*(usersSINRs[user]))[prb][pmi][column] - (*(usersSINRs[user]))[prb][bestVector.pmi][bestVector.column];   
+                return usersFeedback[getUserIndex(user)]->sinrMatrix[prb][pmi][column] - usersFeedback[getUserIndex(user)]->sinrMatrix[prb][bestVector.pmi][bestVector.column];   
                 break;
             }
             case InnerProduct:
@@ -1093,7 +1086,7 @@ PU2RCScheduler::doLinkAdapationAndRegisterTransmissions()
         
         assure(iter->rank == 1, "Only suports rank-1 transmission");
         
-        rankContextCollector->put(iter->rank);
+        putProbe(rankContextCollector, iter->rank);
 
         ltea::mac::la::downlink::LinkAdaptationResult laResult0;
         laResult0 = linkAdaptation->performLinkAdaptation(iter->scheduledUser,
@@ -1124,7 +1117,7 @@ PU2RCScheduler::doLinkAdapationAndRegisterTransmissions()
 #endif                                                                     
 
             
-        tbSizeContextCollector->put(tb0Size, boost::make_tuple("Stream", 0));
+        putProbe(tbSizeContextCollector, tb0Size, 0);
 
         ltea::mac::DownlinkControlInformation* dci0 = activateCommand( compound0->getCommandPool() );
         dci0->peer.assignedToLayers = std::vector<unsigned int>(1,1);
@@ -1137,13 +1130,10 @@ PU2RCScheduler::doLinkAdapationAndRegisterTransmissions()
         dci0->magic.direction = imtaphy::Downlink;
         dci0->magic.spatialID = 0;
         dci0->magic.id = iter->scheduledUser->getNodeID() * 100000 + scheduleForTTI* 10 + 0;
-        dci0->magic.prbTracingDict = iter->prbAndTracingInfo;
+        dci0->magic.prbTrace = iter->prbTrace;
 
-        // join scheduling and link adaptation tracing dicts
-        for (ltea::mac::PRBSchedulingTracingDictMap::iterator dictIter = dci0->magic.prbTracingDict.begin(); dictIter != dci0->magic.prbTracingDict.end(); dictIter++)
-        {
-            dictIter->second.insert(laResult0.prbTracingDict[dictIter->first].begin(), laResult0.prbTracingDict[dictIter->first].end());
-        }
+        // join scheduling and link adaptation tracing
+        dci0->magic.prbTrace.complement(laResult0.prbTrace);
         
         imtaphy::receivers::feedback::PU2RCFeedback* feedback = dynamic_cast<imtaphy::receivers::feedback::PU2RCFeedback*>(feedbackManager->getFeedback(iter->scheduledUser, scheduleForTTI).get());
         assure(feedback, "no PU2RC feedback");
@@ -1182,7 +1172,7 @@ PU2RCScheduler::doLinkAdapationAndRegisterTransmissions()
                                         iter->rank, // number of layers
                                         iter->prbPowerPrecodingMap);
         
-        throughputThisTTI[iter->scheduledUser] += user_rate;
+        userState.throughputThisTTI[getUserIndex(iter->scheduledUser)] += user_rate;
     }
     
 #ifndef WNS_NDEBUG
@@ -1210,6 +1200,6 @@ PU2RCScheduler::doLinkAdapationAndRegisterTransmissions()
 #endif
     
     // unblock the queues
-    getReceptor()->wakeup();
+    unblockQueues();
 }
 
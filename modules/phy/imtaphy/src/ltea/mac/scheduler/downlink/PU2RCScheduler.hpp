@@ -35,6 +35,7 @@
 #include <IMTAPHY/receivers/LteRel8Codebook.hpp>
 #include <IMTAPHY/detail/NodePtrCompare.hpp>
 #include <IMTAPHY/link2System/BlockErrorModel.hpp>
+#include <IMTAPHY/receivers/feedback/PU2RCFeedbackManager.hpp>
 #include <iomanip>
 
 namespace ltea { namespace mac { namespace scheduler { namespace downlink {
@@ -351,7 +352,6 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         
         imtaphy::receivers::LteRel8Codebook<float>* codebook;
         
-        std::map<wns::node::Interface*, double, imtaphy::detail::WnsNodeInterfacePtrCompare> throughputHistory;
         double alpha;
         
         void doLinkAdapationAndRegisterTransmissions();
@@ -381,6 +381,10 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         wns::Ratio estimateSINROffset(wns::node::Interface* user, unsigned int prb, unsigned int pmi, unsigned int column);
         
         void updatePU2RCFeedback(ltea::mac::scheduler::UserSet& allUsers);
+        unsigned int getPreferredIndex(wns::node::Interface* user, unsigned int prb)
+        {
+            return preferredIndex[getUserIndex(user) * numPRBs + prb];
+        }
         imtaphy::l2s::BlockErrorModel* blerModel;
         wns::probe::bus::ContextCollectorPtr groupSizeContextCollector;
         wns::probe::bus::ContextCollectorPtr fillLevelContextCollector;
@@ -392,8 +396,10 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         unsigned int numPRBs;
         
         unsigned int numIndices;
-        std::map<wns::node::Interface*, std::vector<unsigned int> > userToIndexLookup;
-        std::map<wns::node::Interface*, boost::multi_array<wns::Ratio, 3>* > usersSINRs;
+        // indexed by user index like userState, whose feedback keeps these alive; filled by updatePU2RCFeedback
+        std::vector<imtaphy::receivers::feedback::PU2RCFeedback*> usersFeedback;
+        // numUsers x numPRBs codebook index of the preferred PMI and column from the feedback
+        std::vector<unsigned int> preferredIndex;
         
         boost::multi_array<wns::Ratio, 2> sinrLosses;
         
@@ -401,7 +407,6 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         double historyExponent;
         bool fillGrid;
         EstimateOther estimateForNonPreferred;
-        std::map<wns::node::Interface*, double> throughputThisTTI;
 
     };
 }}}}
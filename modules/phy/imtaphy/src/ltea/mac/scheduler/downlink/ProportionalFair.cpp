@@ -58,11 +58,7 @@ ProportionalFair::initScheduler()
 
    assure(syncHARQ, "ProportionalFair currently only supports synchronous HARQ operation, i.e., with HARQ retransmissions performed by SchedulerBase");
    
-   // Init the throughput history for exponential averaging
-   for (unsigned int i = 0; i < allUsers.size(); i++)
-   {
-       throughputHistory[allUsers[i]] = 1.0;
-   }
+   // the throughput history for exponential averaging starts at 1.0 in userState
 }
 
 
@@ -71,24 +67,25 @@ ProportionalFair::doScheduling()
 {
     PerUserPrbPowerPrecoderMap resourceMap;
     PerUserPowerOffsetMap powerOffsetMap;
-    typedef std::map<wns::node::Interface*, ltea::mac::PRBSchedulingTracingDictMap> PerUserPRBtracingDictMap;
-    PerUserPRBtracingDictMap userTracing;
     
-    
-    ltea::mac::scheduler::UserSet activeUsers = usersPRBManager.getActiveUsers();
-    std::map<wns::node::Interface*, imtaphy::receivers::feedback::LteRel8DownlinkFeedbackPtr, imtaphy::detail::WnsNodeInterfacePtrCompare> feedback;
-    
-    std::map<wns::node::Interface*, double, imtaphy::detail::WnsNodeInterfacePtrCompare> throughputThisTTI;
-    std::map<wns::node::Interface*, Bit> availableBitsInQueue;
-
     // init counter for scheduled throughput during this TTI needed for updating the history at the end
-    // also, we get the feedback to avoid calling over and over
-    for (UserSet::const_iterator iter = activeUsers.begin(); iter != activeUsers.end(); iter++)
+    // also, we get the feedback and queue sizes to avoid calling over and over
+    collectUserState();
+
+    // per user index, only used if tracing is enabled
+    bool tracing = ltea::mac::PRBTrace::isEnabled();
+    std::vector<ltea::mac::PRBTrace> userTracing(tracing ? usersPRBManager.getNumUsers() : 0);
+
+    unsigned int numUsers = usersPRBManager.getNumUsers();
+    activeUsers.assign(numUsers, false);
+    historyWeight.assign(numUsers, 1.0);
+    prbMetric.resize(numUsers);
+    prbThroughput.resize(numUsers);
+    for (unsigned int u = 0; u < numUsers; u++)
     {
-        throughputThisTTI[*iter] = 0.0;
-        availableBitsInQueue[*iter] = queue->numBitsForUser(*iter);
-        MESSAGE_SINGLE(NORMAL, logger, "According to our queue, user " << (*iter)->getName() << " has " << availableBitsInQueue[*iter] << " bits in the queue.");
-        feedback[*iter] = feedbackManager->getFeedback(*iter, scheduleForTTI);
+        activeUsers[u] = usersPRBManager.isActive(u);
+        if (activeUsers[u])
+            historyWeight[u] = pow(userState.throughputHistory[u], historyExponent);
     }
 
     imtaphy::interface::PRBVector allPrbs = usersPRBManager.getPRBsAvailable();
@@ -98,64 +95,75 @@ ProportionalFair::doScheduling()
     {
         unsigned int prb = allPrbs[i];
         
-        ltea::mac::scheduler::UserSet usersThisPRB = usersPRBManager.getActiveUsers(prb);
-        
-        if (usersThisPRB.size() == 0)
-            continue;
-        
-        std::multimap<double, wns::node::Interface*> ranking;
-        for (UserSet::const_iterator iter = usersThisPRB.begin(); iter != usersThisPRB.end(); iter++)
+        // PF metric of the users allowed on this PRB, the selection is the argmax over them
+        const ltea::mac::scheduler::BitWord* mask = usersPRBManager.getUserMask(prb);
+        double worstMetric = 0.0;
+        bool first = true;
+        for (unsigned int w = 0; w < usersPRBManager.getNumUserWords(); w++)
         {
-            wns::node::Interface* user = *iter;
-            
-            double expectedSpectralEfficiency = estimateExpectedThroughput(feedback[user], prb);
-            
-            double metric = expectedSpectralEfficiency / pow(throughputHistory[user], historyExponent);
-            ranking.insert(std::make_pair<double, wns::node::Interface*>(metric,user));
-            
-            MESSAGE_SINGLE(NORMAL, logger, "Metric for user " << user->getName() << " is: " << metric << " = " << expectedSpectralEfficiency 
-                                            << " / " << throughputHistory[user] << "^" << historyExponent);
+            for (ltea::mac::scheduler::BitWord word = mask[w]; word != 0; word &= word - 1)
+            {
+                unsigned int u = w * ltea::mac::scheduler::bitsPerWord + ltea::mac::scheduler::lowestSetBit(word);
+
+                prbThroughput[u] = estimateExpectedThroughput(userState.feedback[u], prb);
+                prbMetric[u] = prbThroughput[u] / historyWeight[u];
+
+                if (first || (prbMetric[u] < worstMetric))
+                    worstMetric = prbMetric[u];
+                first = false;
+
+                MESSAGE_SINGLE(NORMAL, logger, "Metric for user " << usersPRBManager.getUser(u)->getName() << " is: " << prbMetric[u] << " = " << prbThroughput[u] 
+                                                << " / " << userState.throughputHistory[u] << "^" << historyExponent);
+            }
         }
         
-        // ranking is a std::map that is inheritely sorted from smallest metric to largest; 
-        // "rbegin" return the reverse iterator pointing to the element with the highest metric
-        wns::node::Interface* selectedUser =  ranking.rbegin()->second;
+        unsigned int selected = selectUser(mask, usersPRBManager.getNumUserWords(), prbMetric);
+        if (selected == numUsers)
+            continue;
+
+        double bestMetric = prbMetric[selected];
+        wns::node::Interface* selectedUser = usersPRBManager.getUser(selected);
+        imtaphy::receivers::feedback::LteRel8DownlinkFeedbackPtr feedback = userState.feedback[selected];
 
         MESSAGE_SINGLE(NORMAL, logger, "Selected user " << selectedUser->getName() 
-                                    << " based on metric=" << ranking.rbegin()->first
-                                    << " compared to worst metric " << ranking.begin()->first << " on PRB" << prb);
+                                    << " based on metric=" << bestMetric
+                                    << " compared to worst metric " << worstMetric << " on PRB" << prb);
         
         
         // The LTE Rel8 codebook
         imtaphy::interface::PowerAndPrecoding powerAndPrecoding;
-        powerAndPrecoding.power = usersPRBManager.getAvailablePower(selectedUser, prb);
+        powerAndPrecoding.power = usersPRBManager.getAvailablePower(selected, prb);
         powerAndPrecoding.precoding = codebook->getPrecodingMatrix(numTxAntennas,
-                                                                      feedback[selectedUser]->rank,
-                                                                      feedback[selectedUser]->pmi[prb]);
+                                                                      feedback->rank,
+                                                                      feedback->pmi[prb]);
         resourceMap[selectedUser][prb] = powerAndPrecoding;
         
         powerOffsetMap[selectedUser][prb] = wns::Ratio::from_factor(1.0); // no offset, we honor the feedback's choice
-        throughputThisTTI[selectedUser] += estimateExpectedThroughput(feedback[ranking.rbegin()->second], prb);
+        userState.throughputThisTTI[selected] += prbThroughput[selected];
         
         // provide info for tracing
-        userTracing[selectedUser][prb]["PMI"] = feedback[selectedUser]->pmi[prb];
-        userTracing[selectedUser][prb]["RI"] = feedback[selectedUser]->rank;
-        userTracing[selectedUser][prb]["PFmetric"] = ranking.rbegin()->first;
+        if (tracing)
+        {
+            ltea::mac::PRBTraceRecord& record = userTracing[selected][prb];
+            record.set(ltea::mac::TracePMI, feedback->pmi[prb]);
+            record.set(ltea::mac::TraceRI, feedback->rank);
+            record.set(ltea::mac::TracePFmetric, bestMetric);
+        }
 
         ltea::mac::la::downlink::LinkAdaptationResult provisionalLa 
             = linkAdaptation->performLinkAdaptation(selectedUser, 0, powerOffsetMap[selectedUser], 
-                                                    scheduleForTTI, feedback[selectedUser]->rank, pdcchLength, provideRel10DMRS, numRel10CSIrsSets);
-        Bit currentTBsize = mcsLookup->getSize(provisionalLa.mcsIndex, powerOffsetMap[selectedUser].size(), feedback[selectedUser]->rank);
+                                                    scheduleForTTI, feedback->rank, pdcchLength, provideRel10DMRS, numRel10CSIrsSets);
+        Bit currentTBsize = mcsLookup->getSize(provisionalLa.mcsIndex, powerOffsetMap[selectedUser].size(), feedback->rank);
         
-        if (currentTBsize >= availableBitsInQueue[selectedUser])
+        if (currentTBsize >= userState.queuedBits[selected])
         {
             MESSAGE_SINGLE(NORMAL, logger, "User " << selectedUser->getName() << " removed from scheduling because current allocation is enough to schedule all queued bits");
-            usersPRBManager.removeActiveUser(selectedUser);
+            usersPRBManager.removeActiveUser(selected);
         }
         else
         {
             MESSAGE_SINGLE(NORMAL, logger, "Still not enough resources (currently " << currentTBsize << " bits)for user " 
-                                            << selectedUser->getName() << " (needs " << availableBitsInQueue[selectedUser] << " bits) continue scheduling");
+                                            << selectedUser->getName() << " (needs " << userState.queuedBits[selected] << " bits) continue scheduling");
         }
     } // end of loop over all PRBs
     
@@ -163,10 +171,11 @@ ProportionalFair::doScheduling()
     {
         SchedulingResult allocation;
         allocation.scheduledUser = iter->first;
-        allocation.rank = feedback[allocation.scheduledUser]->rank;
+        allocation.rank = userState.feedback[usersPRBManager.getUserIndex(iter->first)]->rank;
         allocation.prbPowerPrecodingMap = iter->second;
         allocation.prbPowerOffsetForLA = powerOffsetMap[allocation.scheduledUser];
-        allocation.prbAndTracingInfo = userTracing[allocation.scheduledUser];
+        if (tracing)
+            allocation.prbTrace = userTracing[usersPRBManager.getUserIndex(iter->first)];
         
         scheduledUsers.push_back(allocation);
     }
@@ -175,18 +184,41 @@ ProportionalFair::doScheduling()
     // and the others the sum of the spectral efficiencies corresponding to their CQIs
     // As long as the transport block can actually be filled with enough data, this should be a 
     // sufficiently accurate (i.e. proportional) approximation of the throughput they will actuall get
-    for (ltea::mac::scheduler::UserSet::const_iterator iter = activeUsers.begin(); iter != activeUsers.end(); iter++)
+    for (unsigned int u = 0; u < numUsers; u++)
     {
-        throughputHistory[*iter] = (1.0 - alpha) * throughputHistory[*iter] + alpha * throughputThisTTI[*iter];
+        if (!activeUsers[u])
+            continue;
+
+        updateThroughputHistory(u, alpha);
         
-        MESSAGE_SINGLE(NORMAL, logger, "Updating user " << (*iter)->getName() << "'s throughput by current throughput of "
-                                       << throughputThisTTI[*iter] << " to epx. average of " << throughputHistory[*iter] << "\n");
+        MESSAGE_SINGLE(NORMAL, logger, "Updating user " << usersPRBManager.getUser(u)->getName() << "'s throughput by current throughput of "
+                                       << userState.throughputThisTTI[u] << " to epx. average of " << userState.throughputHistory[u] << "\n");
     }
     
     // when scheduling is done, let the base class perform the Link Adaptation and register the transmissions
     doLinkAdapationAndRegisterTransmissions();
 }
 
+unsigned int
+ProportionalFair::selectUser(const ltea::mac::scheduler::BitWord* mask, unsigned int numWords, const std::vector<double>& metric)
+{
+    unsigned int selected = metric.size();
+    
+    for (unsigned int w = 0; w < numWords; w++)
+    {
+        for (ltea::mac::scheduler::BitWord word = mask[w]; word != 0; word &= word - 1)
+        {
+            unsigned int u = w * ltea::mac::scheduler::bitsPerWord + ltea::mac::scheduler::lowestSetBit(word);
+            assure(u < metric.size(), "User index in mask exceeds the metric vector");
+            
+            if ((selected == metric.size()) || (metric[u] >= metric[selected]))
+                selected = u;
+        }
+    }
+    
+    return selected;
+}
+
 inline
 double 
 ProportionalFair::estimateExpectedThroughput(imtaphy::receivers::feedback::LteRel8DownlinkFeedbackPtr feedback, unsigned int prb)
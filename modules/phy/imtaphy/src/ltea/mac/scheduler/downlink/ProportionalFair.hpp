@@ -44,6 +44,15 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
     public:
         ProportionalFair(wns::ldk::fun::FUN*, const wns::pyconfig::View&);
 
+        /**
+         * @brief Index of the user with the largest metric among the numWords words of mask, or
+         * metric.size() if no bit is set. Users are visited in index (i.e., node ID) order and on
+         * ties the last one wins, like taking the top of the former ranking multimap did
+         */
+        static unsigned int selectUser(const ltea::mac::scheduler::BitWord* mask, 
+                                       unsigned int numWords, 
+                                       const std::vector<double>& metric);
+
     protected:
         void initScheduler();
         void doScheduling();
@@ -51,13 +60,18 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         unsigned int currentUser; 
         imtaphy::receivers::LteRel8Codebook<float>* codebook;
         
-        std::map<wns::node::Interface*, double, imtaphy::detail::WnsNodeInterfacePtrCompare> throughputHistory;
         double alpha;
         double historyExponent;
         
     private:
         double estimateExpectedThroughput(imtaphy::receivers::feedback::LteRel8DownlinkFeedbackPtr feedback, unsigned int prb);    
         
+        // per user index, kept as members to reuse their memory over TTIs
+        std::vector<bool> activeUsers;
+        std::vector<double> historyWeight;
+        std::vector<double> prbMetric;      // PF metric on the current PRB, only valid for the users in its mask
+        std::vector<double> prbThroughput;  // expected throughput on the current PRB, same
+        
     };
 }}}}
 
@@ -92,8 +92,11 @@ RoundRobin::doScheduling()
                         iter2 != iter->prbPowerPrecodingMap.end(); iter2++)
                 {
                     unsigned int prb = iter2->first;
-                    iter->prbAndTracingInfo[prb]["PMI"] = feedback->pmi[prb];
-                    iter->prbAndTracingInfo[prb]["RI"] = feedback->rank;
+                    if (ltea::mac::PRBTrace::isEnabled())
+                    {
+                        iter->prbTrace[prb].set(ltea::mac::TracePMI, feedback->pmi[prb]);
+                        iter->prbTrace[prb].set(ltea::mac::TraceRI, feedback->rank);
+                    }
                     iter->rank = feedback->rank;    
                     
                     imtaphy::interface::PowerAndPrecoding powerAndPrecoding;
@@ -198,13 +201,14 @@ RoundRobin::doScheduling()
             else
             {
                 // else continue with new data
-                if (!usersPRBManager.isActive(user))
+                unsigned int userIndex = getUserIndex(user);
+                if (!usersPRBManager.isActive(userIndex))
                 {
                     queueIter++;
                     continue;
                 }
                 
-                imtaphy::interface::PRBVector prbs = usersPRBManager.getPRBsAvailable(user);
+                imtaphy::interface::PRBVector prbs = usersPRBManager.getPRBsAvailable(userIndex);
 
                 if (prbs.size() != 0)
                 {
@@ -242,11 +246,14 @@ RoundRobin::doScheduling()
                     {
                         usersPRBManager.markPRBused(prbs[prb]);
                         
-                        allocation.prbAndTracingInfo[prbs[prb]]["PMI"] = feedback->pmi[prbs[prb]];
-                        allocation.prbAndTracingInfo[prbs[prb]]["RI"] = feedback->rank;
+                        if (ltea::mac::PRBTrace::isEnabled())
+                        {
+                            allocation.prbTrace[prbs[prb]].set(ltea::mac::TracePMI, feedback->pmi[prbs[prb]]);
+                            allocation.prbTrace[prbs[prb]].set(ltea::mac::TraceRI, feedback->rank);
+                        }
     
                         imtaphy::interface::PowerAndPrecoding powerAndPrecoding;
-                        powerAndPrecoding.power = usersPRBManager.getAvailablePower(user, prbs[prb]);
+                        powerAndPrecoding.power = usersPRBManager.getAvailablePower(userIndex, prbs[prb]);
                         powerAndPrecoding.precoding = codebook->getPrecodingMatrix(numTxAntennas,
                                                                                  allocation.rank, // layers
                                                                                  feedback->pmi[prbs[prb]]); //pmi
@@ -256,7 +263,7 @@ RoundRobin::doScheduling()
                     
                     scheduledUsers.push_back(allocation);
 
-                    usersPRBManager.removeActiveUser(user);
+                    usersPRBManager.removeActiveUser(userIndex);
                     
                     // remove him from current position in queue and put him to the back
                     tail.insert(tail.end(), *queueIter);
@@ -56,7 +56,8 @@ SchedulerBase::SchedulerBase(wns::ldk::fun::FUN* fuNet, const wns::pyconfig::Vie
     provideRel10DMRS(config.get<bool>("provideRel10DMRS")), // could/should be overwritten by init and or doScheduling
     syncHARQ(config.get<bool>("syncHARQ")),
     numRel10CSIrsSets(0),     // could/should be overwritten by init and or doScheduling
-    usersPRBManager(spectrum->getNumberOfPRBs(imtaphy::Downlink), wns::Power::from_dBm(config.get<double>("txPowerdBmPerPRB")))
+    usersPRBManager(spectrum->getNumberOfPRBs(imtaphy::Downlink), wns::Power::from_dBm(config.get<double>("txPowerdBmPerPRB"))),
+    wakeupDeferred(false)
 {
     assure(fun, "No valid FUN pointer");
     assure(layer, "Could not get Layer2 pointer");
@@ -135,6 +136,73 @@ SchedulerBase::doWakeup()
     getReceptor()->wakeup();
 }
 
+namespace {
+    // same condition as in MESSAGE_SINGLE(NORMAL, ...)
+    bool
+    logsMessages(const wns::logger::Logger& logger)
+    {
+        return (logger.getMaster() != NULL) && logger.getMaster()->isEnabled() && (logger.getLevel() >= wns::logger::NORMAL);
+    }
+}
+
+bool
+SchedulerBase::supportsParallelNewTTI() const
+{
+    // Apart from the feedback manager (see setReferencePerPRBTxPowerForUser and getFeedback),
+    // scheduling only touches the state of this cell. All loggers write to the same master logger,
+    // which is not thread-safe, so none of the FUs called from doScheduling may log.
+    return queueSupportsParallelNewTTI(queue)
+        && !(logsMessages(logger) || logsMessages(harq->getLogger())
+             || logsMessages(linkAdaptation->getLogger()) || logsMessages(resourceManager->getLogger()));
+}
+
+bool
+SchedulerBase::queueSupportsParallelNewTTI(const ltea::rlc::IQueue* queue)
+{
+    // the probe buses of all cells forward into the same, unsynchronized sinks
+    return !(logsMessages(queue->getLogger()) || queue->hasProbeObservers());
+}
+
+void
+SchedulerBase::afterParallelNewTTI(unsigned int /* ttiNumber */)
+{
+    for (unsigned int i = 0; i < deferredProbes.size(); i++)
+        putProbe(deferredProbes[i].collector, deferredProbes[i].value, deferredProbes[i].stream);
+    deferredProbes.clear();
+
+    if (wakeupDeferred)
+    {
+        wakeupDeferred = false;
+        unblockQueues();
+    }
+}
+
+void
+SchedulerBase::putProbe(const wns::probe::bus::ContextCollectorPtr& collector, double value)
+{
+    putProbe(collector, value, -1);
+}
+
+void
+SchedulerBase::putProbe(const wns::probe::bus::ContextCollectorPtr& collector, double value, int stream)
+{
+    if (channel->isInParallelNewTTI())
+        deferredProbes.push_back(DeferredProbe(collector, value, stream));
+    else if (stream < 0)
+        collector->put(value);
+    else
+        collector->put(value, boost::make_tuple("Stream", stream));
+}
+
+void
+SchedulerBase::unblockQueues()
+{
+    if (channel->isInParallelNewTTI())
+        wakeupDeferred = true;
+    else
+        getReceptor()->wakeup();
+}
+
 void 
 SchedulerBase::determineActiveUsers()
 {
@@ -154,6 +222,35 @@ SchedulerBase::determineActiveUsers()
 }
 
 
+unsigned int
+SchedulerBase::getUserIndex(wns::node::Interface* user)
+{
+    unsigned int userIndex = usersPRBManager.getUserIndex(user);
+    
+    if (userIndex >= userState.throughputHistory.size())
+        userState.resize(usersPRBManager.getNumUsers());
+
+    return userIndex;
+}
+
+void
+SchedulerBase::collectUserState()
+{
+    userState.resize(usersPRBManager.getNumUsers());
+
+    for (unsigned int u = 0; u < usersPRBManager.getNumUsers(); u++)
+    {
+        if (!usersPRBManager.isActive(u))
+            continue;
+
+        wns::node::Interface* user = usersPRBManager.getUser(u);
+        userState.throughputThisTTI[u] = 0.0;
+        userState.queuedBits[u] = queue->numBitsForUser(user);
+        userState.feedback[u] = feedbackManager->getFeedback(user, scheduleForTTI);
+        MESSAGE_SINGLE(NORMAL, logger, "According to our queue, user " << user->getName() << " has " << userState.queuedBits[u] << " bits in the queue.");
+    }
+}
+
 bool 
 SchedulerBase::performRetransmissionsFor(wns::node::Interface* user)
 {
@@ -432,7 +529,7 @@ SchedulerBase::doLinkAdapationAndRegisterTransmissions()
             
         }
         
-        rankContextCollector->put(iter->rank);
+        putProbe(rankContextCollector, iter->rank);
 
         ltea::mac::la::downlink::LinkAdaptationResult laResult0;
         laResult0 = linkAdaptation->performLinkAdaptation(iter->scheduledUser,
@@ -460,7 +557,7 @@ SchedulerBase::doLinkAdapationAndRegisterTransmissions()
 #endif                                                                     
 
             
-        tbSizeContextCollector->put(tb0Size, boost::make_tuple("Stream", 0));
+        putProbe(tbSizeContextCollector, tb0Size, 0);
 
         ltea::mac::DownlinkControlInformation* dci0 = activateCommand( compound0->getCommandPool() );
         dci0->peer.assignedToLayers = tb0AssignedTo;
@@ -473,13 +570,10 @@ SchedulerBase::doLinkAdapationAndRegisterTransmissions()
         dci0->magic.direction = imtaphy::Downlink;
         dci0->magic.spatialID = 0;
         dci0->magic.id = iter->scheduledUser->getNodeID() * 100000 + scheduleForTTI* 10 + 0;
-        dci0->magic.prbTracingDict = iter->prbAndTracingInfo;
+        dci0->magic.prbTrace = iter->prbTrace;
 
-        // join scheduling and link adaptation tracing dicts
-        for (ltea::mac::PRBSchedulingTracingDictMap::iterator dictIter = dci0->magic.prbTracingDict.begin(); dictIter != dci0->magic.prbTracingDict.end(); dictIter++)
-        {
-            dictIter->second.insert(laResult0.prbTracingDict[dictIter->first].begin(), laResult0.prbTracingDict[dictIter->first].end());
-        }
+        // join scheduling and link adaptation tracing
+        dci0->magic.prbTrace.complement(laResult0.prbTrace);
         
          //////////// currently a somewhat dirty hack
         imtaphy::receivers::feedback::LteRel8DownlinkFeedbackPtr feedback = feedbackManager->getFeedback(iter->scheduledUser, scheduleForTTI);
@@ -517,7 +611,7 @@ SchedulerBase::doLinkAdapationAndRegisterTransmissions()
             unsigned int tb1Size = mcsLookup->getSize(laResult1.mcsIndex, numPRBs, tb1AssignedTo.size());
             wns::ldk::CompoundPtr compound1 = queue->getHeadOfLinePDUSegment(iter->scheduledUser, tb1Size);                                                                    
 
-            tbSizeContextCollector->put(tb1Size, boost::make_tuple("Stream", 1));
+            putProbe(tbSizeContextCollector, tb1Size, 1);
 
 
             ltea::mac::DownlinkControlInformation* dci1 = activateCommand( compound1->getCommandPool() );
@@ -531,13 +625,10 @@ SchedulerBase::doLinkAdapationAndRegisterTransmissions()
             dci1->magic.direction = imtaphy::Downlink;
             dci1->magic.spatialID = 1;
             dci1->magic.id = iter->scheduledUser->getNodeID() * 100000 + scheduleForTTI* 10 + 1;
-            dci1->magic.prbTracingDict = iter->prbAndTracingInfo;
+            dci1->magic.prbTrace = iter->prbTrace;
 
-            // join scheduling and link adaptation tracing dicts
-            for (ltea::mac::PRBSchedulingTracingDictMap::iterator dictIter = dci1->magic.prbTracingDict.begin(); dictIter != dci1->magic.prbTracingDict.end(); dictIter++)
-            {
-                dictIter->second.insert(laResult1.prbTracingDict[dictIter->first].begin(), laResult1.prbTracingDict[dictIter->first].end());
-            }
+            // join scheduling and link adaptation tracing
+            dci1->magic.prbTrace.complement(laResult1.prbTrace);
 
             //////////// currently a somewhat dirty hack
             double linearAvgEstSINR = 0.0;
@@ -565,7 +656,7 @@ SchedulerBase::doLinkAdapationAndRegisterTransmissions()
     }
     
     // unblock the queues
-    getReceptor()->wakeup();
+    unblockQueues();
 }
 
 
@@ -581,6 +672,8 @@ SchedulerBase::onNewTTI(unsigned int ttiNumber)
     if (ttiNumber == 1)
     {
         allUsers =  txService->getAssociatedNodes();
+        usersPRBManager.registerUsers(allUsers);
+        userState.resize(usersPRBManager.getNumUsers());
         initScheduler(); // really move this somewhere else. onFunCreated is too early, btw
         linkAdaptation->updateAssociatedUsers(allUsers);
         
@@ -621,10 +714,11 @@ SchedulerBase::onNewTTI(unsigned int ttiNumber)
     // takes these power levels into account
     for (unsigned int u = 0; u < allUsers.size(); u++)
     {
+        unsigned int userIndex = usersPRBManager.getUserIndex(allUsers[u]);
         for (unsigned int prb = 0; prb < spectrum->getNumberOfPRBs(imtaphy::Downlink); prb++)
         {
             feedbackManager->setReferencePerPRBTxPowerForUser(allUsers[u], prb, 
-                                                              usersPRBManager.getAvailablePower(allUsers[u], prb));
+                                                              usersPRBManager.getAvailablePower(userIndex, prb));
         }
     }
     
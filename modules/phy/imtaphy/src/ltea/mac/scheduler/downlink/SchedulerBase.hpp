@@ -69,10 +69,31 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
     {
         unsigned int rank;
         wns::node::Interface* scheduledUser;
-        ltea::mac::PRBSchedulingTracingDictMap prbAndTracingInfo;
+        ltea::mac::PRBTrace prbTrace;
         imtaphy::interface::PrbPowerPrecodingMap prbPowerPrecodingMap;
         ltea::mac::la::downlink::PRBpowerOffsetMap prbPowerOffsetForLA; // just for LinkAdaptation, not for power loading
     };
+
+    /**
+     * @brief Per-user scheduler state as structure of arrays in the user index order of the
+     * UsersPRBManager. The per-TTI entries are only valid for users that were active when
+     * collectUserState() was called.
+     */
+    struct UserState
+    {
+        void resize(unsigned int numUsers)
+        {
+            feedback.resize(numUsers);
+            queuedBits.resize(numUsers, 0);
+            throughputHistory.resize(numUsers, 1.0);
+            throughputThisTTI.resize(numUsers, 0.0);
+        }
+
+        std::vector<imtaphy::receivers::feedback::LteRel8DownlinkFeedbackPtr> feedback;
+        std::vector<Bit> queuedBits;
+        std::vector<double> throughputHistory; // exponentially smoothed over TTIs, starts at 1.0
+        std::vector<double> throughputThisTTI;
+    };
     
     class SchedulerBase:
         public virtual wns::ldk::FunctionalUnit,
@@ -93,6 +114,14 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         // IMTAphy observer interface:
         void onNewTTI(unsigned int ttiNumber);
         void beforeTTIover(unsigned int ttiNumber) {};
+        bool supportsParallelNewTTI() const;
+        void afterParallelNewTTI(unsigned int ttiNumber);
+
+        /**
+         * @brief False if the queue logs or puts into observed probe buses. The queue is
+         * called from doScheduling and its puts cannot be deferred like putProbe.
+         */
+        static bool queueSupportsParallelNewTTI(const ltea::rlc::IQueue* queue);
 
         
     protected:
@@ -105,6 +134,26 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         virtual void doScheduling() = 0;
         
         virtual void doLinkAdapationAndRegisterTransmissions();
+
+        /**
+         * @brief Fetches feedback and queue size of all active users into userState and
+         * resets their throughputThisTTI
+         */
+        void collectUserState();
+
+        /**
+         * @brief Dense index of the user in usersPRBManager and userState
+         */
+        unsigned int getUserIndex(wns::node::Interface* user);
+
+        /**
+         * @brief Exponential smoothing of the throughput history with this TTI's throughput
+         */
+        void updateThroughputHistory(unsigned int userIndex, double alpha)
+        {
+            userState.throughputHistory[userIndex] = (1.0 - alpha) * userState.throughputHistory[userIndex] 
+                                                     + alpha * userState.throughputThisTTI[userIndex];
+        }
         
         //
         // compound handler interface
@@ -112,6 +161,18 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         bool doIsAccepting(const wns::ldk::CompoundPtr& compound) const;
 
         void doWakeup();
+
+        /**
+         * @brief Puts the value into the collector, deferred to afterParallelNewTTI while the
+         * channel runs the schedulers in parallel so that the probes see the sequential order
+         */
+        void putProbe(const wns::probe::bus::ContextCollectorPtr& collector, double value);
+        void putProbe(const wns::probe::bus::ContextCollectorPtr& collector, double value, int stream);
+
+        /**
+         * @brief Wakes up the upper FUs to refill the queues, deferred like putProbe
+         */
+        void unblockQueues();
         
         wns::ldk::fun::FUN* fun;
         ltea::Layer2* layer;
@@ -153,9 +214,22 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         unsigned int numRel10CSIrsSets;
         unsigned int numTxAntennas;
         ltea::mac::scheduler::UsersPRBManager usersPRBManager;
+        UserState userState;
         wns::probe::bus::ContextCollectorPtr rankContextCollector;
         wns::probe::bus::ContextCollectorPtr tbSizeContextCollector;
 
+    private:
+        struct DeferredProbe
+        {
+            DeferredProbe(const wns::probe::bus::ContextCollectorPtr& _collector, double _value, int _stream) :
+                collector(_collector), value(_value), stream(_stream) {}
+
+            wns::probe::bus::ContextCollectorPtr collector;
+            double value;
+            int stream; // negative without "Stream" context
+        };
+        std::vector<DeferredProbe> deferredProbes;
+        bool wakeupDeferred;
     };
 }}}}
 
@@ -68,11 +68,7 @@ ZFScheduler::initScheduler()
 
     assure(syncHARQ == false, "ZFScheduler only supports asynchronous/adaptive HARQ operation, i.e., with HARQ retransmissions controlled by the ZF scheduler");
 
-    // Init the throughput history for exponential averaging
-    for (unsigned int i = 0; i < allUsers.size(); i++)
-    {
-        throughputHistory[allUsers[i]] = 1.0;
-    }
+    // the throughput history for exponential averaging starts at 1.0 in userState
 
 
     codebook = imtaphy::receivers::TheLteRel8CodebookFloat::getInstance();
@@ -197,7 +193,7 @@ ZFScheduler::doScheduling()
                     // this we overwrite multiple times, but who cares
                     re_transmission_allocations[*iter_retrans].scheduledUser = *iter_retrans;
                     re_transmission_allocations[*iter_retrans].rank = 1;
-                    re_transmission_allocations[*iter_retrans].prbAndTracingInfo =  ltea::mac::PRBSchedulingTracingDictMap();
+                    re_transmission_allocations[*iter_retrans].prbTrace.clear();
                     
                     
                     imtaphy::interface::PowerAndPrecoding pap;
@@ -263,10 +259,11 @@ ZFScheduler::doScheduling()
     /*Update throughput history*/
     for (ltea::mac::scheduler::UserSet::const_iterator iter = allUsers.begin(); iter != allUsers.end(); iter++)
     {
-        throughputHistory[*iter] = (1.0 - alpha) * throughputHistory[*iter] + alpha * throughputThisTTI[*iter];
+        unsigned int userIndex = getUserIndex(*iter);
+        updateThroughputHistory(userIndex, alpha);
         
         MESSAGE_SINGLE(NORMAL, logger, "Updating user " << (*iter)->getName() << "'s throughput by current throughput of "
-                                    << throughputThisTTI[*iter] << " to epx. average of " << throughputHistory[*iter] << "\n");
+                                    << userState.throughputThisTTI[userIndex] << " to epx. average of " << userState.throughputHistory[userIndex] << "\n");
     }
     
 
@@ -284,9 +281,13 @@ ZFScheduler::updateZFFeedback(ltea::mac::scheduler::UserSet& allUsers)
                 for(ltea::mac::scheduler::UserSet::const_iterator iter = allUsers.begin(); iter!= allUsers.end(); iter++)
                 {
                     wns::node::Interface* thisUser = *iter;
-                    pu2rcFeedback[thisUser] = dynamic_cast<imtaphy::receivers::feedback::PU2RCFeedback*>(feedbackManager->getFeedback(thisUser, scheduleForTTI).get());
-                    assure(pu2rcFeedback[thisUser], "Expected PU2RC feedback");
-                    throughputThisTTI[thisUser] = 0.0;
+                    unsigned int userIndex = getUserIndex(thisUser);
+                    pu2rcFeedback.resize(userState.feedback.size(), NULL);
+                    
+                    userState.feedback[userIndex] = feedbackManager->getFeedback(thisUser, scheduleForTTI);
+                    pu2rcFeedback[userIndex] = dynamic_cast<imtaphy::receivers::feedback::PU2RCFeedback*>(userState.feedback[userIndex].get());
+                    assure(pu2rcFeedback[userIndex], "Expected PU2RC feedback");
+                    userState.throughputThisTTI[userIndex] = 0.0;
                 }
                 break;
             }
@@ -295,8 +296,9 @@ ZFScheduler::updateZFFeedback(ltea::mac::scheduler::UserSet& allUsers)
                 for(ltea::mac::scheduler::UserSet::const_iterator iter = allUsers.begin(); iter!= allUsers.end(); iter++)
                 {
                     wns::node::Interface* thisUser = *iter;
-                    rel8Feedback[thisUser] = feedbackManager->getFeedback(thisUser, scheduleForTTI);
-                    throughputThisTTI[thisUser] = 0.0;
+                    unsigned int userIndex = getUserIndex(thisUser);
+                    userState.feedback[userIndex] = feedbackManager->getFeedback(thisUser, scheduleForTTI);
+                    userState.throughputThisTTI[userIndex] = 0.0;
                 }
 
                 break;
@@ -366,7 +368,7 @@ ZFScheduler::computeZFforPRB(ltea::mac::scheduler::UserSet newTransmissionUsers,
                             double est_sinr = static_cast<float>(numTxAntennas) / static_cast<float>(n_users) * SINR[member] / precoderNormSquared; 
                             current.setSINROffset(member, getSINRCorrection(member, prb) + wns::Ratio::from_factor( static_cast<float>(numTxAntennas) / (static_cast<float>(n_users) * precoderNormSquared)));
 
-                            currentSumMetric += log2(1.0 + std::min(est_sinr, wns::Ratio::from_dB(20).get_factor())) / throughputHistory[member];
+                            currentSumMetric += log2(1.0 + std::min(est_sinr, wns::Ratio::from_dB(20).get_factor())) / userState.throughputHistory[getUserIndex(member)];
                         }
 
                         if (currentSumMetric > bestMetric)
@@ -407,7 +409,7 @@ ZFScheduler::computeZFforPRB(ltea::mac::scheduler::UserSet newTransmissionUsers,
     //            std::cout << "User at position " << i << " is " << finalGroup[i]->getName() << " with SINR offset " << best.getSINROffset(finalGroup[i]) << "\n";
             
         }
-        groupSizeContextCollector->put(finalGroup.size());
+        putProbe(groupSizeContextCollector, finalGroup.size());
         
     } // if new transmission users exist    
 
@@ -433,7 +435,7 @@ ZFScheduler::computeSchedulingResult(ZFGroup best, std::map<wns::node::Interface
         
         (*col_allocation)[thisUser].scheduledUser = thisUser;
         (*col_allocation)[thisUser].rank = 1;
-        (*col_allocation)[thisUser].prbAndTracingInfo = ltea::mac::PRBSchedulingTracingDictMap();
+        (*col_allocation)[thisUser].prbTrace.clear();
 
         imtaphy::interface::PowerAndPrecoding pap;
         
@@ -494,7 +496,7 @@ ZFScheduler::doLinkAdapationAndRegisterTransmissions()
         
         assure(iter->rank == 1, "Only suports rank-1 transmission");
         
-        rankContextCollector->put(iter->rank);
+        putProbe(rankContextCollector, iter->rank);
 
         ltea::mac::la::downlink::LinkAdaptationResult laResult0;
         laResult0 = linkAdaptation->performLinkAdaptation(iter->scheduledUser,
@@ -525,7 +527,7 @@ ZFScheduler::doLinkAdapationAndRegisterTransmissions()
 #endif                                                                     
 
             
-        tbSizeContextCollector->put(tb0Size, boost::make_tuple("Stream", 0));
+        putProbe(tbSizeContextCollector, tb0Size, 0);
 
         ltea::mac::DownlinkControlInformation* dci0 = activateCommand( compound0->getCommandPool() );
         dci0->peer.assignedToLayers = std::vector<unsigned int>(1,1);
@@ -538,13 +540,10 @@ ZFScheduler::doLinkAdapationAndRegisterTransmissions()
         dci0->magic.direction = imtaphy::Downlink;
         dci0->magic.spatialID = 0;
         dci0->magic.id = iter->scheduledUser->getNodeID() * 100000 + scheduleForTTI* 10 + 0;
-        dci0->magic.prbTracingDict = iter->prbAndTracingInfo;
+        dci0->magic.prbTrace = iter->prbTrace;
 
-        // join scheduling and link adaptation tracing dicts
-        for (ltea::mac::PRBSchedulingTracingDictMap::iterator dictIter = dci0->magic.prbTracingDict.begin(); dictIter != dci0->magic.prbTracingDict.end(); dictIter++)
-        {
-            dictIter->second.insert(laResult0.prbTracingDict[dictIter->first].begin(), laResult0.prbTracingDict[dictIter->first].end());
-        }
+        // join scheduling and link adaptation tracing
+        dci0->magic.prbTrace.complement(laResult0.prbTrace);
         
         
         double linearAvgEstSINR = 0.0;
@@ -570,12 +569,12 @@ ZFScheduler::doLinkAdapationAndRegisterTransmissions()
                                         iter->rank, // number of layers
                                         iter->prbPowerPrecodingMap);
         
-        throughputThisTTI[iter->scheduledUser] += user_rate;
+        userState.throughputThisTTI[getUserIndex(iter->scheduledUser)] += user_rate;
     }
     
     
     // unblock the queues
-    getReceptor()->wakeup();
+    unblockQueues();
 }
 
 inline
@@ -586,14 +585,14 @@ ZFScheduler::getChannelVector(wns::node::Interface* user, unsigned int prb)
     {
         case PU2RC:
         {
-            return codebook->get4TxCodebookColumn(pu2rcFeedback[user]->pmi[prb], 
-                                                  pu2rcFeedback[user]->columnIndicator[prb]);
+            imtaphy::receivers::feedback::PU2RCFeedback* feedback = pu2rcFeedback[getUserIndex(user)];
+            return codebook->get4TxCodebookColumn(feedback->pmi[prb], feedback->columnIndicator[prb]);
             break;
         }
         case Rank1:
         {
             // avoid invalid PMI feedback e.g. during startup
-            unsigned int pmi = rel8Feedback[user]->pmi[prb];
+            unsigned int pmi = userState.feedback[getUserIndex(user)]->pmi[prb];
             pmi = (pmi < 16) ? pmi :  0;
             return codebook->get4TxCodebookColumn(pmi, 0);
 
@@ -614,13 +613,14 @@ ZFScheduler::getChannelVectorId(wns::node::Interface* user, unsigned int prb)
     {
         case PU2RC:
         {
-            return codebook->getIndex(pu2rcFeedback[user]->pmi[prb], pu2rcFeedback[user]->columnIndicator[prb]);
+            imtaphy::receivers::feedback::PU2RCFeedback* feedback = pu2rcFeedback[getUserIndex(user)];
+            return codebook->getIndex(feedback->pmi[prb], feedback->columnIndicator[prb]);
             break;
         }
         case Rank1:
         {
             // avoid invalid PMI feedback e.g. during startup
-            unsigned int pmi = rel8Feedback[user]->pmi[prb];
+            unsigned int pmi = userState.feedback[getUserIndex(user)]->pmi[prb];
             pmi = (pmi < 16) ? pmi :  0;
 
             return pmi;
@@ -641,12 +641,12 @@ ZFScheduler::getEstimatedSINR(wns::node::Interface* user, unsigned int prb)
     {
         case PU2RC:
         {
-            return blerModel->getSINRthreshold(pu2rcFeedback[user]->cqiTb1[prb]);
+            return blerModel->getSINRthreshold(pu2rcFeedback[getUserIndex(user)]->cqiTb1[prb]);
             break;
         }
         case Rank1:
         {
-            return blerModel->getSINRthreshold(rel8Feedback[user]->cqiTb1[prb]) + getSINRCorrection(user, prb);
+            return blerModel->getSINRthreshold(userState.feedback[getUserIndex(user)]->cqiTb1[prb]) + getSINRCorrection(user, prb);
             break;
         }
         default:
@@ -664,12 +664,13 @@ ZFScheduler::getExactSINR(wns::node::Interface* user, unsigned int prb)
     {
         case PU2RC:
         {
-            return pu2rcFeedback[user]->sinrMatrix[prb][pu2rcFeedback[user]->pmi[prb]][pu2rcFeedback[user]->columnIndicator[prb]];
+            imtaphy::receivers::feedback::PU2RCFeedback* feedback = pu2rcFeedback[getUserIndex(user)];
+            return feedback->sinrMatrix[prb][feedback->pmi[prb]][feedback->columnIndicator[prb]];
             break;
         }
         case Rank1:
         {
-            return rel8Feedback[user]->magicSINRs[prb][0];
+            return userState.feedback[getUserIndex(user)]->magicSINRs[prb][0];
             break;
         }
         default:
@@ -695,7 +696,7 @@ ZFScheduler::getSINRCorrection(wns::node::Interface* user, unsigned int prb)
         {
             // TODO: Tx scaling and no array gain at receiver but extra intra interference
             // adapt the SINR to a power normalization for 4 layer transmission
-            return wns::Ratio::from_factor(1.0/4.0) + wns::Ratio::from_factor(static_cast<double>(rel8Feedback[user]->rank) / 4.0);
+            return wns::Ratio::from_factor(1.0/4.0) + wns::Ratio::from_factor(static_cast<double>(userState.feedback[getUserIndex(user)]->rank) / 4.0);
             break;
         }
         default:
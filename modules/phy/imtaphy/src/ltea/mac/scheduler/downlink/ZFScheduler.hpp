@@ -271,7 +271,6 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         
         imtaphy::receivers::LteRel8Codebook<float>* codebook;
         
-        std::map<wns::node::Interface*, double, imtaphy::detail::WnsNodeInterfacePtrCompare> throughputHistory;
         double alpha;
 
         
@@ -294,12 +293,11 @@ namespace ltea { namespace mac { namespace scheduler { namespace downlink {
         void computeSchedulingResult(ZFGroup best, std::map<wns::node::Interface*,SchedulingResult>* col_allocation);
    
         unsigned int numPRBs;  
-        std::map<wns::node::Interface*,double> throughputThisTTI;
         void doLinkAdapationAndRegisterTransmissions();
 
         
-        std::map<wns::node::Interface*,imtaphy::receivers::feedback::PU2RCFeedback*> pu2rcFeedback;
-        std::map<wns::node::Interface*,imtaphy::receivers::feedback::LteRel8DownlinkFeedbackPtr> rel8Feedback;
+        // indexed by user index like userState, whose feedback keeps these alive; Rank1 mode uses userState.feedback
+        std::vector<imtaphy::receivers::feedback::PU2RCFeedback*> pu2rcFeedback;
 
         
         wns::probe::bus::ContextCollectorPtr groupSizeContextCollector;
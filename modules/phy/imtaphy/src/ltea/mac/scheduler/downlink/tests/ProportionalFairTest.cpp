@@ -0,0 +1,175 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/ltea/mac/scheduler/downlink/ProportionalFair.hpp>
+#include <WNS/node/tests/Stub.hpp>
+
+#include <vector>
+
+namespace ltea { namespace mac { namespace scheduler { namespace downlink { namespace tests {
+        class ProportionalFairTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( ProportionalFairTest );
+            CPPUNIT_TEST ( testArgmax );
+            CPPUNIT_TEST ( testTieBreak );
+            CPPUNIT_TEST ( testEmptyMask );
+            CPPUNIT_TEST ( testUserMask );
+            CPPUNIT_TEST_SUITE_END();
+        
+        public:
+            // more than one word of user bits
+            ProportionalFairTest() : numUsers(70), numWords(2) {}
+
+            void setUp();
+            void tearDown();
+
+            void testArgmax();
+            void testTieBreak();
+            void testEmptyMask();
+            void testUserMask();
+
+        private:
+            void set(unsigned int user)
+            {
+                mask[user / bitsPerWord] |= BitWord(1) << (user % bitsPerWord);
+            }
+
+            const unsigned int numUsers;
+            const unsigned int numWords;
+            std::vector<BitWord> mask;
+            std::vector<double> metric;
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( ProportionalFairTest );
+
+        void
+        ProportionalFairTest::setUp()
+        {
+            mask.assign(numWords, 0);
+            metric.assign(numUsers, 0.0);
+        }
+
+        void
+        ProportionalFairTest::tearDown()
+        {
+        }
+
+        void
+        ProportionalFairTest::testArgmax()
+        {
+            for (unsigned int u = 0; u < numUsers; u++)
+                metric[u] = static_cast<double>((u * 37) % numUsers);
+            
+            // the global maximum (user 17 with 69) is not in the mask
+            set(2);  // 4
+            set(20); // 40
+            set(66); // 62
+            set(69); // 33
+            CPPUNIT_ASSERT_EQUAL(66U, ProportionalFair::selectUser(&mask[0], numWords, metric));
+
+            // the maximum moves to the first word
+            metric[2] = 100.0;
+            CPPUNIT_ASSERT_EQUAL(2U, ProportionalFair::selectUser(&mask[0], numWords, metric));
+
+            // metrics of users that are not in the mask do not count
+            metric[21] = 1000.0;
+            CPPUNIT_ASSERT_EQUAL(2U, ProportionalFair::selectUser(&mask[0], numWords, metric));
+        }
+
+        void
+        ProportionalFairTest::testTieBreak()
+        {
+            metric[3] = 2.0;
+            metric[10] = 2.0;
+            metric[65] = 2.0;
+            metric[40] = 1.0;
+
+            // on ties the user with the highest index, i.e., node ID wins
+            set(3);
+            set(10);
+            set(40);
+            CPPUNIT_ASSERT_EQUAL(10U, ProportionalFair::selectUser(&mask[0], numWords, metric));
+
+            // also across words
+            set(65);
+            CPPUNIT_ASSERT_EQUAL(65U, ProportionalFair::selectUser(&mask[0], numWords, metric));
+
+            // a user with a zero metric is still selected if it is the only one
+            setUp();
+            set(7);
+            CPPUNIT_ASSERT_EQUAL(7U, ProportionalFair::selectUser(&mask[0], numWords, metric));
+            
+            // and the last one wins if all metrics are zero
+            set(64);
+            set(12);
+            CPPUNIT_ASSERT_EQUAL(64U, ProportionalFair::selectUser(&mask[0], numWords, metric));
+        }
+
+        void
+        ProportionalFairTest::testEmptyMask()
+        {
+            metric[5] = 1.0;
+            CPPUNIT_ASSERT_EQUAL(numUsers, ProportionalFair::selectUser(&mask[0], numWords, metric));
+        }
+
+        void
+        ProportionalFairTest::testUserMask()
+        {
+            std::vector<wns::node::Interface*> users;
+            for (unsigned int u = 0; u < numUsers; u++)
+                users.push_back(new wns::node::tests::Stub());
+
+            UsersPRBManager manager(4, wns::Power::from_mW(1.0));
+            manager.registerUsers(users);
+            
+            manager.addActiveUser(users[1]);
+            manager.addActiveUser(users[30]);
+            manager.addActiveUser(users[68]);
+            metric[1] = 5.0;
+            metric[30] = 3.0;
+            metric[68] = 4.0;
+            CPPUNIT_ASSERT_EQUAL(1U, ProportionalFair::selectUser(manager.getUserMask(0), manager.getNumUserWords(), metric));
+
+            // like the scheduler does when a user's queue is served
+            manager.removeActiveUser(users[1]);
+            CPPUNIT_ASSERT_EQUAL(68U, ProportionalFair::selectUser(manager.getUserMask(0), manager.getNumUserWords(), metric));
+
+            PRBSet allowed;
+            allowed.insert(2);
+            manager.restrictUserToPRBs(users[68], allowed);
+            CPPUNIT_ASSERT_EQUAL(30U, ProportionalFair::selectUser(manager.getUserMask(0), manager.getNumUserWords(), metric));
+            CPPUNIT_ASSERT_EQUAL(68U, ProportionalFair::selectUser(manager.getUserMask(2), manager.getNumUserWords(), metric));
+
+            for (unsigned int u = 0; u < users.size(); u++)
+                delete users[u];
+        }
+}}}}}
@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/ltea/mac/scheduler/UsersPRBManager.hpp>
+#include <WNS/node/tests/Stub.hpp>
+
+#include <vector>
+
+namespace ltea { namespace mac { namespace scheduler { namespace tests {
+        class UsersPRBManagerTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( UsersPRBManagerTest );
+            CPPUNIT_TEST ( testUserIndices );
+            CPPUNIT_TEST ( testPRBsAndUsers );
+            CPPUNIT_TEST ( testPowerRestrictions );
+            CPPUNIT_TEST_SUITE_END();
+        
+        public:
+            UsersPRBManagerTest() : numUsers(70), numPRBs(10) {}
+
+            void setUp();
+            void tearDown();
+
+            void testUserIndices();
+            void testPRBsAndUsers();
+            void testPowerRestrictions();
+
+        private:
+            // more than one word of user bits
+            const unsigned int numUsers;
+            const unsigned int numPRBs;
+            std::vector<wns::node::Interface*> users;
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( UsersPRBManagerTest );
+
+        void
+        UsersPRBManagerTest::setUp()
+        {
+            for (unsigned int u = 0; u < numUsers; u++)
+                users.push_back(new wns::node::tests::Stub());
+        }
+
+        void
+        UsersPRBManagerTest::tearDown()
+        {
+            for (unsigned int u = 0; u < users.size(); u++)
+                delete users[u];
+            users.clear();
+        }
+    
+        void
+        UsersPRBManagerTest::testUserIndices()
+        {
+            UsersPRBManager manager(numPRBs, wns::Power::from_mW(1.0));
+
+            // registration sorts by node ID, regardless of the order passed in
+            std::vector<wns::node::Interface*> reversed(users.rbegin(), users.rend());
+            manager.registerUsers(reversed);
+
+            CPPUNIT_ASSERT_EQUAL(numUsers, manager.getNumUsers());
+            for (unsigned int u = 0; u < numUsers; u++)
+            {
+                CPPUNIT_ASSERT_EQUAL(u, manager.getUserIndex(users[u]));
+                CPPUNIT_ASSERT(manager.getUser(u) == users[u]);
+            }
+
+            // unknown users are appended
+            wns::node::tests::Stub late;
+            CPPUNIT_ASSERT_EQUAL(numUsers, manager.getUserIndex(&late));
+            CPPUNIT_ASSERT_EQUAL(numUsers + 1, manager.getNumUsers());
+        }
+
+        void
+        UsersPRBManagerTest::testPRBsAndUsers()
+        {
+            UsersPRBManager manager(numPRBs, wns::Power::from_mW(1.0));
+            manager.registerUsers(users);
+
+            manager.addActiveUser(users[3]);
+            manager.addActiveUser(users[67]);
+            CPPUNIT_ASSERT(manager.isActive(users[3]));
+            CPPUNIT_ASSERT(!manager.isActive(users[4]));
+            CPPUNIT_ASSERT_EQUAL(size_t(2), manager.getActiveUsers().size());
+
+            PRBSet allowed;
+            allowed.insert(2);
+            allowed.insert(5);
+            manager.restrictUserToPRBs(users[67], allowed);
+            manager.markPRBused(5);
+
+            CPPUNIT_ASSERT_EQUAL(numPRBs - 1, manager.getNumPRBsAvailable());
+            CPPUNIT_ASSERT(!manager.prbAvailable(5));
+            CPPUNIT_ASSERT(!manager.prbAvailable(numPRBs));
+            CPPUNIT_ASSERT_EQUAL(size_t(1), manager.getPRBsAvailable(users[67]).size());
+            CPPUNIT_ASSERT_EQUAL(2U, manager.getPRBsAvailable(users[67])[0]);
+            CPPUNIT_ASSERT_EQUAL(numPRBs - 1, manager.getNumPRBsAvailable(users[3]));
+            CPPUNIT_ASSERT_EQUAL(size_t(0), manager.getActiveUsers(5).size());
+
+            // the mask of PRB 2 has the bits of both users, in the second word for user 67
+            const BitWord* mask = manager.getUserMask(2);
+            CPPUNIT_ASSERT_EQUAL(2U, manager.getNumUserWords());
+            CPPUNIT_ASSERT(mask[0] == (BitWord(1) << 3));
+            CPPUNIT_ASSERT(mask[1] == (BitWord(1) << 3));
+            CPPUNIT_ASSERT_EQUAL(size_t(1), manager.getActiveUsers(7).size());
+
+            manager.removeActiveUser(users[3]);
+            CPPUNIT_ASSERT(!manager.isActive(users[3]));
+            CPPUNIT_ASSERT(mask[0] == 0);
+
+            // reset frees all PRBs but users have to be added again
+            manager.reset();
+            CPPUNIT_ASSERT_EQUAL(numPRBs, manager.getNumPRBsAvailable());
+            CPPUNIT_ASSERT_EQUAL(0U, manager.getNumPRBsAvailable(users[67]));
+        }
+
+        void
+        UsersPRBManagerTest::testPowerRestrictions()
+        {
+            UsersPRBManager manager(numPRBs, wns::Power::from_mW(1.0));
+            manager.registerUsers(users);
+
+            manager.restrictPower(4, wns::Power::from_mW(0.5));
+            manager.restrictPower(users[1], 6, wns::Power::from_mW(0.25));
+
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, manager.getAvailablePower(4).get_mW(), 1e-12);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, manager.getAvailablePower(users[0], 4).get_mW(), 1e-12);
+            // a user restriction starts from the per PRB restrictions at that time
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, manager.getAvailablePower(users[1], 4).get_mW(), 1e-12);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(0.25, manager.getAvailablePower(1, 6).get_mW(), 1e-12);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, manager.getAvailablePower(users[0], 6).get_mW(), 1e-12);
+
+            manager.reset();
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, manager.getAvailablePower(users[1], 6).get_mW(), 1e-12);
+            CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, manager.getAvailablePower(4).get_mW(), 1e-12);
+        }
+}}}}
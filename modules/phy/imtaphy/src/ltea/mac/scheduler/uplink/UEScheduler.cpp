@@ -251,14 +251,18 @@ UEScheduler::onNewTTI(unsigned int ttiNumber)
                 
                 tbSizeContextCollector->put(blockSize);
                 
-                for (imtaphy::interface::PrbPowerPrecodingMap::const_iterator iter = grant.prbPowerPrecoders.begin(); iter != grant.prbPowerPrecoders.end(); iter++)
+                if (ltea::mac::PRBTrace::isEnabled())
                 {
-                    dci0->magic.prbTracingDict[iter->first]["TxPwrPRBmW"] = iter->second.power.get_mW();
-                    dci0->magic.prbTracingDict[iter->first]["NumPRBs"] = dci0->local.prbPowerPrecoders.size();
-                    dci0->magic.prbTracingDict[iter->first]["TotalPwrmW"] = totalTxPower.get_mW();
+                    for (imtaphy::interface::PrbPowerPrecodingMap::const_iterator iter = grant.prbPowerPrecoders.begin(); iter != grant.prbPowerPrecoders.end(); iter++)
+                    {
+                        ltea::mac::PRBTraceRecord& record = dci0->magic.prbTrace[iter->first];
+                        record.set(ltea::mac::TraceTxPwrPRBmW, iter->second.power.get_mW());
+                        record.set(ltea::mac::TraceNumPRBs, dci0->local.prbPowerPrecoders.size());
+                        record.set(ltea::mac::TraceTotalPwrmW, totalTxPower.get_mW());
+                    }
                     
                     // merge any tracing info coming from eNB
-                    dci0->magic.prbTracingDict[iter->first].insert(grant.prbTracingDict[iter->first].begin(), grant.prbTracingDict[iter->first].end());
+                    dci0->magic.prbTrace.complement(grant.prbTrace);
                 }
                 
                 std::vector<wns::ldk::CompoundPtr> transportBlocks;
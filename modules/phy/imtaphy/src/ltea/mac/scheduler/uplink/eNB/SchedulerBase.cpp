@@ -215,7 +215,7 @@ void ltea::mac::scheduler::uplink::enb::SchedulerBase::doLinkAdapationAndPowerCo
         grant.estimatedSINR = std::min(laResult.estimatedSINR, 
                                        wns::Ratio::from_dB(25));
         
-        grant.prbTracingDict = laResult.prbTracingDict;
+        grant.prbTrace = laResult.prbTrace;
         
         
         assure(schedulingRequests.find(user) != schedulingRequests.end(), "No scheduler pointer for scheduled uplink user");
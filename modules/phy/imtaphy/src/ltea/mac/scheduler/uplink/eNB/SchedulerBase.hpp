@@ -72,7 +72,7 @@ namespace ltea { namespace mac { namespace scheduler { namespace uplink {
         // magic starts here
         wns::Ratio estimatedSINR; // from link adaptation
         wns::Ratio estimatedLinearAvgSINR; // from uplink estimation; linear average
-        PRBSchedulingTracingDictMap prbTracingDict;
+        PRBTrace prbTrace;
     };
     
     struct SchedulingResult 
@@ -0,0 +1,297 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/ltea/mac/PRBTrace.hpp>
+#include <WNS/Exception.hpp>
+#include <WNS/pyconfig/Parser.hpp>
+#include <WNS/pyconfig/View.hpp>
+
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <cstddef>
+#include <iostream>
+
+namespace ltea { namespace mac { namespace tests {
+        class PRBTraceTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( PRBTraceTest );
+#ifndef LTEA_NO_PRBTRACE
+            CPPUNIT_TEST ( testRecords );
+            CPPUNIT_TEST ( testComplement );
+            CPPUNIT_TEST ( testDumpRoundTrip );
+#else
+            CPPUNIT_TEST ( testCompiledOut );
+#endif
+            CPPUNIT_TEST ( testFieldNames );
+            CPPUNIT_TEST_SUITE_END();
+        
+        public:
+            void setUp() {}
+            void tearDown();
+
+            void testRecords();
+            void testComplement();
+            void testDumpRoundTrip();
+            void testCompiledOut();
+            void testFieldNames();
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( PRBTraceTest );
+
+        namespace {
+            const char* dumpFileName = "PRBTraceTest.dat";
+
+            struct DumpRow
+            {
+                unsigned int tti;
+                boost::uint32_t ints[PRBTraceDump::NumIntColumns];
+                double sinrDB;
+                bool hasRecord;
+                double pmi;      // NaN in the dump if hasRecord is false
+                double estInTTI; // only traced on even PRBs
+            };
+
+            // three TTIs (blocks) with 2, 3 and 1 rows, one row without a record
+            const DumpRow dumpRows[] = {
+                // tti  receiver sender tbId attempt decodable layer prb fields   SINR  record PMI  EstInTTI
+                {  5, {  10,     1,     100,  1,     1,        1,    0,  0 },   3.5,  true,  2.0,  4.0 },
+                {  5, {  10,     1,     100,  1,     1,        1,    1,  0 },  -1.25, true,  2.0,  0.0 },
+                {  6, {  11,     2,     101,  2,     0,        2,    4,  0 },  12.0,  true,  7.0,  5.0 },
+                {  6, {  11,     2,     101,  2,     0,        2,    5,  0 },  13.0,  false, 0.0,  0.0 },
+                {  6, {  12,     3,     102,  1,     1,        1,    7,  0 },   0.0,  true, 15.0,  0.0 },
+                {  9, {  10,     1,     103,  4,     1,        1,   49,  0 },  20.75, true,  0.0,  6.0 }
+            };
+            const unsigned int numDumpRows = sizeof(dumpRows) / sizeof(DumpRow);
+        }
+
+        void
+        PRBTraceTest::tearDown()
+        {
+            std::remove(dumpFileName);
+        }
+
+#ifndef LTEA_NO_PRBTRACE
+        void
+        PRBTraceTest::testRecords()
+        {
+            PRBTrace trace;
+            CPPUNIT_ASSERT( trace.empty() );
+
+            // out of order PRBs end up sorted, repeated access returns the same record
+            trace[7].set(TracePMI, 3.0);
+            trace[2].set(TraceRI, 2.0);
+            trace[7].set(TraceRI, 1.0);
+            trace[4];
+
+            CPPUNIT_ASSERT_EQUAL( 3U, trace.size() );
+            unsigned int expectedPRBs[] = {2, 4, 7};
+            unsigned int i = 0;
+            for (PRBTrace::const_iterator iter = trace.begin(); iter != trace.end(); iter++, i++)
+                CPPUNIT_ASSERT_EQUAL( expectedPRBs[i], iter->prb );
+
+            const PRBTraceRecord* record = trace.find(7);
+            CPPUNIT_ASSERT( record != NULL );
+            CPPUNIT_ASSERT( record->has(TracePMI) );
+            CPPUNIT_ASSERT( record->has(TraceRI) );
+            CPPUNIT_ASSERT( !record->has(TracePFmetric) );
+            CPPUNIT_ASSERT_EQUAL( 3.0, record->get(TracePMI) );
+            CPPUNIT_ASSERT_EQUAL( 1.0, record->get(TraceRI) );
+
+            CPPUNIT_ASSERT_EQUAL( 0U, static_cast<unsigned int>(trace.find(4)->fields) );
+            CPPUNIT_ASSERT( trace.find(3) == NULL );
+
+            trace.clear();
+            CPPUNIT_ASSERT( trace.empty() );
+            CPPUNIT_ASSERT( trace.find(7) == NULL );
+        }
+
+        void
+        PRBTraceTest::testComplement()
+        {
+            PRBTrace scheduler;
+            scheduler[1].set(TracePMI, 5.0);
+            scheduler[3].set(TracePMI, 6.0);
+            scheduler[3].set(TraceEstInTTI, 10.0);
+
+            PRBTrace linkAdaptation;
+            linkAdaptation[0].set(TraceEstInTTI, 11.0);
+            linkAdaptation[1].set(TraceEstInTTI, 12.0);
+            linkAdaptation[3].set(TraceEstInTTI, 13.0);
+            linkAdaptation[3].set(TracePMI, 14.0);
+
+            // like std::map::insert: only fields not yet set, only PRBs already traced
+            scheduler.complement(linkAdaptation);
+
+            CPPUNIT_ASSERT_EQUAL( 2U, scheduler.size() );
+            CPPUNIT_ASSERT( scheduler.find(0) == NULL );
+            CPPUNIT_ASSERT_EQUAL( 5.0, scheduler.find(1)->get(TracePMI) );
+            CPPUNIT_ASSERT_EQUAL( 12.0, scheduler.find(1)->get(TraceEstInTTI) );
+            CPPUNIT_ASSERT_EQUAL( 6.0, scheduler.find(3)->get(TracePMI) );
+            CPPUNIT_ASSERT_EQUAL( 10.0, scheduler.find(3)->get(TraceEstInTTI) );
+        }
+
+        void
+        PRBTraceTest::testDumpRoundTrip()
+        {
+            // write with PRBTraceDump, read back with framework/pywns/pywns/PRBTrace.py through the
+            // embedded interpreter, so the reader is checked against what the simulator writes
+            PRBTraceDump& dump = PRBTraceDump::getInstance();
+            dump.close();
+            dump.open(dumpFileName);
+            CPPUNIT_ASSERT( dump.isOpen() );
+            CPPUNIT_ASSERT( PRBTrace::isEnabled() );
+
+            std::vector<boost::uint32_t> expectedFields(numDumpRows, 0);
+            for (unsigned int r = 0; r < numDumpRows; r++)
+            {
+                boost::uint32_t ints[PRBTraceDump::NumIntColumns];
+                for (unsigned int c = 0; c < PRBTraceDump::NumIntColumns; c++)
+                    ints[c] = dumpRows[r].ints[c];
+
+                PRBTrace trace;
+                PRBTraceRecord& record = trace[dumpRows[r].ints[PRBTraceDump::ColPRB]];
+                record.set(TracePMI, dumpRows[r].pmi);
+                if (dumpRows[r].ints[PRBTraceDump::ColPRB] % 2 == 0)
+                    record.set(TraceEstInTTI, dumpRows[r].estInTTI);
+
+                if (dumpRows[r].hasRecord)
+                    expectedFields[r] = record.fields;
+                ints[PRBTraceDump::ColFields] = expectedFields[r];
+
+                dump.append(dumpRows[r].tti, ints, dumpRows[r].sinrDB, dumpRows[r].hasRecord ? &record : NULL);
+            }
+            dump.close();
+            CPPUNIT_ASSERT( !dump.isOpen() );
+
+            // close() patches the number of blocks into the header
+            std::FILE* file = std::fopen(dumpFileName, "rb");
+            CPPUNIT_ASSERT( file != NULL );
+            PRBTraceDump::FileHeader header;
+            CPPUNIT_ASSERT_EQUAL( std::size_t(1), std::fread(&header, sizeof(header), 1, file) );
+            std::fclose(file);
+            CPPUNIT_ASSERT_EQUAL( 3U, static_cast<unsigned int>(header.numBlocks) );
+            CPPUNIT_ASSERT_EQUAL( static_cast<unsigned int>(NumPRBTraceFields), static_cast<unsigned int>(header.numFields) );
+
+            std::stringstream ss;
+            ss << "import math\n"
+               << "try:\n"
+               << "    import numpy\n"
+               << "    haveNumpy = True\n"
+               << "except ImportError:\n"
+               << "    haveNumpy = False\n"
+               << "if haveNumpy:\n"
+               << "    import pywns.PRBTrace\n"
+               << "    trace = pywns.PRBTrace.PRBTrace('" << dumpFileName << "')\n"
+               << "    numBlocks = len(trace)\n"
+               << "    ttis = [int(t) for t in trace.ttis()]\n"
+               << "    blockRows = [len(trace.block(b)['prb']) for b in range(numBlocks)]\n"
+               << "    fieldNames = trace.fieldNames\n"
+               << "    rows = trace.concatenated()\n"
+               << "    for name in pywns.PRBTrace.INT_COLUMNS + ['tti']:\n"
+               << "        globals()['int_' + name] = [int(v) for v in rows[name]]\n"
+               << "    for name in ['SINR'] + fieldNames:\n"
+               << "        globals()['isSet_' + name] = [not math.isnan(v) for v in rows[name]]\n"
+               << "        globals()['double_' + name] = [float(v) for v in numpy.nan_to_num(rows[name])]\n";
+            wns::pyconfig::Parser parser;
+            parser.loadString(ss.str());
+
+            if (!parser.get<bool>("haveNumpy"))
+            {
+                std::cout << "\nPRBTraceTest::testDumpRoundTrip: numpy not available, pywns.PRBTrace not checked" << std::endl;
+                return;
+            }
+
+            CPPUNIT_ASSERT_EQUAL( 3, parser.get<int>("numBlocks") );
+            CPPUNIT_ASSERT_EQUAL( 5, parser.get<int>("ttis", 0) );
+            CPPUNIT_ASSERT_EQUAL( 6, parser.get<int>("ttis", 1) );
+            CPPUNIT_ASSERT_EQUAL( 9, parser.get<int>("ttis", 2) );
+            CPPUNIT_ASSERT_EQUAL( 2, parser.get<int>("blockRows", 0) );
+            CPPUNIT_ASSERT_EQUAL( 3, parser.get<int>("blockRows", 1) );
+            CPPUNIT_ASSERT_EQUAL( 1, parser.get<int>("blockRows", 2) );
+
+            CPPUNIT_ASSERT_EQUAL( static_cast<int>(NumPRBTraceFields), parser.len("fieldNames") );
+            for (unsigned int f = 0; f < NumPRBTraceFields; f++)
+                CPPUNIT_ASSERT_EQUAL( std::string(prbTraceFieldName(static_cast<PRBTraceField>(f))), parser.get<std::string>("fieldNames", f) );
+
+            const char* intColumnNames[PRBTraceDump::NumIntColumns] = {"receiver", "sender", "tbId", "attempt", "decodable", "layer", "prb", "fields"};
+            std::string pmiName = std::string("double_") + prbTraceFieldName(TracePMI);
+            std::string estInTTIName = std::string("double_") + prbTraceFieldName(TraceEstInTTI);
+
+            CPPUNIT_ASSERT_EQUAL( static_cast<int>(numDumpRows), parser.len("int_tti") );
+            for (unsigned int r = 0; r < numDumpRows; r++)
+            {
+                CPPUNIT_ASSERT_EQUAL( dumpRows[r].tti, parser.get<unsigned int>("int_tti", r) );
+                for (unsigned int c = 0; c < PRBTraceDump::NumIntColumns - 1; c++)
+                    CPPUNIT_ASSERT_EQUAL( static_cast<unsigned int>(dumpRows[r].ints[c]), parser.get<unsigned int>(std::string("int_") + intColumnNames[c], r) );
+                CPPUNIT_ASSERT_EQUAL( static_cast<unsigned int>(expectedFields[r]), parser.get<unsigned int>("int_fields", r) );
+
+                CPPUNIT_ASSERT_EQUAL( dumpRows[r].sinrDB, parser.get<double>("double_SINR", r) );
+
+                bool hasEstInTTI = dumpRows[r].hasRecord && (dumpRows[r].ints[PRBTraceDump::ColPRB] % 2 == 0);
+                CPPUNIT_ASSERT_EQUAL( dumpRows[r].hasRecord, parser.get<bool>(std::string("isSet_") + prbTraceFieldName(TracePMI), r) );
+                CPPUNIT_ASSERT_EQUAL( hasEstInTTI, parser.get<bool>(std::string("isSet_") + prbTraceFieldName(TraceEstInTTI), r) );
+                CPPUNIT_ASSERT( !parser.get<bool>(std::string("isSet_") + prbTraceFieldName(TraceTBsize), r) );
+                if (dumpRows[r].hasRecord)
+                    CPPUNIT_ASSERT_EQUAL( dumpRows[r].pmi, parser.get<double>(pmiName, r) );
+                if (hasEstInTTI)
+                    CPPUNIT_ASSERT_EQUAL( dumpRows[r].estInTTI, parser.get<double>(estInTTIName, r) );
+            }
+        }
+#else
+        void
+        PRBTraceTest::testCompiledOut()
+        {
+            PRBTrace::enable();
+            CPPUNIT_ASSERT( !PRBTrace::isEnabled() );
+
+            PRBTrace trace;
+            CPPUNIT_ASSERT( trace.empty() );
+            CPPUNIT_ASSERT( trace.find(0) == NULL );
+            CPPUNIT_ASSERT_THROW( trace[0], wns::Exception );
+            CPPUNIT_ASSERT_THROW( PRBTraceDump::getInstance().open("prbTrace.dump"), wns::Exception );
+            CPPUNIT_ASSERT( !PRBTraceDump::getInstance().isOpen() );
+        }
+#endif
+
+        void
+        PRBTraceTest::testFieldNames()
+        {
+            // the JSON trace keeps the keys of the former dictionaries
+            CPPUNIT_ASSERT_EQUAL( std::string("PMI"), std::string(prbTraceFieldName(TracePMI)) );
+            CPPUNIT_ASSERT_EQUAL( std::string("EstInTTI"), std::string(prbTraceFieldName(TraceEstInTTI)) );
+            CPPUNIT_ASSERT_EQUAL( std::string("best+offset"), std::string(prbTraceFieldName(TraceBestPlusOffset)) );
+
+            for (unsigned int f = 0; f < NumPRBTraceFields; f++)
+                CPPUNIT_ASSERT( std::string(prbTraceFieldName(static_cast<PRBTraceField>(f))).size() < 16 );
+        }
+}}}
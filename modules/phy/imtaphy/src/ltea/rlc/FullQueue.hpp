@@ -99,6 +99,13 @@ namespace ltea { namespace rlc {
         virtual wns::ldk::CompoundPtr 
         getHeadOfLinePDUSegment(UserID user, int bits);
 
+        virtual const wns::logger::Logger&
+        getLogger() const {return logger;}
+
+        // the probes only read the commands activated in getHeadOfLinePDUSegment later on
+        virtual bool
+        hasProbeObservers() const {return false;}
+
     private:
         wns::logger::Logger logger;
         wns::pyconfig::View config;
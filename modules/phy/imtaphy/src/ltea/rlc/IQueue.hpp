@@ -62,6 +62,7 @@
 #include <WNS/ldk/Compound.hpp>
 #include <WNS/node/Interface.hpp>
 #include <WNS/simulator/Bit.hpp>
+#include <WNS/logger/Logger.hpp>
 
 #include <set>
 
@@ -94,6 +95,13 @@ namespace ltea { namespace rlc {
 
         virtual wns::ldk::CompoundPtr 
         getHeadOfLinePDUSegment(UserID user, int bits) = 0;
+
+        virtual const wns::logger::Logger&
+        getLogger() const = 0;
+
+        // true if put or getHeadOfLinePDUSegment write to a probe bus that somebody observes
+        virtual bool
+        hasProbeObservers() const = 0;
     };
 
 
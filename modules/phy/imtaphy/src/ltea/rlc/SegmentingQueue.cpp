@@ -285,6 +285,15 @@ SegmentingQueue::getHeadOfLinePDUSegment(UserID user, int requestedBits)
     return segment;
 }
 
+bool
+SegmentingQueue::hasProbeObservers() const
+{
+    // the delay probe is put by the inner queue in retrieve()
+    return (sizeProbeBus && sizeProbeBus->hasObservers()) ||
+        (overheadProbeBus && overheadProbeBus->hasObservers()) ||
+        (delayProbeBus && delayProbeBus->hasObservers());
+}
+
 bool
 SegmentingQueue::queueHasPDUs(UserID user) const {
     if (queues.find(user) == queues.end())
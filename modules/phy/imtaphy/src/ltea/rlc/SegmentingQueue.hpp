@@ -111,6 +111,12 @@ namespace ltea { namespace rlc {
         virtual wns::ldk::CompoundPtr 
         getHeadOfLinePDUSegment(UserID user, int bits);
 
+        virtual const wns::logger::Logger&
+        getLogger() const {return logger;}
+
+        virtual bool
+        hasProbeObservers() const;
+
     protected:
         void
         probe();
@@ -31,7 +31,8 @@
 #define IMTAPHY_RECEIVERS_INTERFERER_HPP
 
 #include <map>
-#include <set>
+#include <vector>
+#include <algorithm>
 #include <WNS/PowerRatio.hpp>
 #include <IMTAPHY/Transmission.hpp>
 #include <IMTAPHY/Link.hpp>
@@ -45,15 +46,26 @@ namespace imtaphy {
         class Interferer
         {
         public:
-            Interferer(){};
+            Interferer() :
+                interferingLink(NULL),
+                precoding(NULL),
+                txPower_mW(0.0)
+            {};
             Interferer(const Interferer& copy) :
                 interferingTransmission(copy.interferingTransmission),
-                interferingLink(copy.interferingLink)
+                interferingLink(copy.interferingLink),
+                precoding(copy.precoding),
+                txPower_mW(copy.txPower_mW)
             {
             };
            
             imtaphy::TransmissionPtr interferingTransmission;
             imtaphy::Link* interferingLink;
+            
+            // precoding and power of the interfering transmission on the PRB the collection was built for,
+            // NULL if the interferer was not taken from the channel's interference index
+            imtaphy::detail::ComplexFloatMatrix* precoding;
+            float txPower_mW;
         };
                 
         class InterferersCompare
@@ -65,7 +77,9 @@ namespace imtaphy {
             }
         };
 
-        typedef std::set<Interferer, InterferersCompare> InterferersSet;
+        // kept sorted by transmission id and free of duplicates like a set, but as a vector
+        // so that a cleared collection can be refilled without allocating
+        typedef std::vector<Interferer> InterferersSet;
         
         
         class InterferersCollection
@@ -109,7 +123,26 @@ namespace imtaphy {
             
             void insert(const Interferer& interferer)
             {
-                interferers.insert(interferer);
+                InterferersSet::iterator pos = std::lower_bound(interferers.begin(), interferers.end(), interferer, InterferersCompare());
+                if ((pos == interferers.end()) || InterferersCompare()(interferer, *pos))
+                    interferers.insert(pos, interferer);
+            }
+            
+            // amortized constant time if interferers are appended in increasing transmission id order
+            void append(const Interferer& interferer)
+            {
+                if (interferers.empty() || InterferersCompare()(interferers.back(), interferer))
+                    interferers.push_back(interferer);
+                else
+                    insert(interferer);
+            }
+            
+            // empties and unseals the collection but keeps its memory for refilling it
+            void clear()
+            {
+                interferers.clear();
+                hash = static_cast<std::size_t>(0);
+                sealed = false;
             }
             
             InterferersSet& getInterferersSet() 
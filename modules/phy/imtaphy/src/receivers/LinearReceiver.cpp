@@ -29,6 +29,9 @@
 
 #include <IMTAPHY/receivers/LinearReceiver.hpp>
 #include <IMTAPHY/detail/LinearAlgebra.hpp>
+#include <IMTAPHY/detail/SmallMatrix.hpp>
+#include <algorithm>
+#include <functional>
 #include <IMTAPHY/Link.hpp>
 #include <IMTAPHY/Channel.hpp>
 #include <IMTAPHY/interface/TransmissionStatus.hpp>
@@ -61,6 +64,9 @@ LinearReceiver::LinearReceiver(imtaphy::StationPhy* _station, const wns::pyconfi
     perfectCovarianceTimestamp(0),
     estimatedCovarianceTimestamp(0),
     estimatedChannelTimestamp(0),
+    interferenceCacheTimestamp(0),
+    interferenceCacheHits(0),
+    interferenceCacheMisses(0),
     config(pyConfigView)
 {
     // create the filter module and pass its config 
@@ -239,6 +245,8 @@ LinearReceiver::channelInitialized(Channel* _channel)
     numPRBs = channel->getSpectrum()->getNumberOfPRBs(receivingInDirection);
     perfectCovarianceCache.resize(numPRBs);
     estimatedCovarianceCache.resize(numPRBs);
+    interferenceCache.resize(numPRBs);
+    interferenceCacheSize.assign(numPRBs, 0);
     
     filter->initFilterComputation(channel, this);
 }
@@ -251,6 +259,23 @@ LinearReceiver::computeSINRs(imtaphy::detail::ComplexFloatMatrix& precodedH,  //
                              unsigned int numRxAntennas, 
                              unsigned int numServingTxAntennas, 
                              unsigned int numServingLayers) const
+{
+    SINRComputationResultPtr result(new SINRComputationResult());
+    
+    computeSINRs(precodedH, W, Whermitian, iAndNoiseCovariance, numRxAntennas, numServingTxAntennas, numServingLayers, *result);
+    
+    return result;
+}
+
+void
+LinearReceiver::computeSINRs(imtaphy::detail::ComplexFloatMatrix& precodedH,
+                             imtaphy::detail::ComplexFloatMatrix& W,
+                             imtaphy::detail::ComplexFloatMatrix& Whermitian,
+                             imtaphy::detail::ComplexFloatMatrix& iAndNoiseCovariance,
+                             unsigned int numRxAntennas, 
+                             unsigned int numServingTxAntennas, 
+                             unsigned int numServingLayers,
+                             SINRComputationResult& result) const
 {
     assure(precodedH.getColumns() == numServingLayers, "Equivalent channel precodedH has wrong number of columns");
     assure(precodedH.getRows() == numRxAntennas, "Equivalent channel precodedH has wrong number of rows");
@@ -265,14 +290,15 @@ LinearReceiver::computeSINRs(imtaphy::detail::ComplexFloatMatrix& precodedH,  //
     
     // space to hold the result for norm of Whermitian x precodedH, size numServingLayers-by-numServingLayers
     // find a nicer name for this (stream-to-stream power or something)
-    imtaphy::detail::FloatMatrix X(numServingLayers, numServingLayers);
-    imtaphy::detail::ComplexFloatMatrix Y(numServingLayers, numServingLayers);
-    imtaphy::detail::ComplexFloatMatrix temp(numServingLayers, numRxAntennas);
+    // all temporaries are at most 8x8 and live on the stack, this is called per PRB and layer
+    imtaphy::detail::SmallFloatMatrix X(numServingLayers, numServingLayers);
+    imtaphy::detail::SmallComplexFloatMatrix Y(numServingLayers, numServingLayers);
+    imtaphy::detail::SmallComplexFloatMatrix temp(numServingLayers, numRxAntennas);
     
     // the function is called for each PRB, so return list of sinrs per layer for that PRB
-    SINRComputationResultPtr result(new SINRComputationResult(numServingLayers));
+    result.reset(numServingLayers);
 
-    imtaphy::detail::matrixMultiplyCequalsNormOfAB<float>(X, Whermitian, precodedH);
+    imtaphy::detail::smallMatrixMultiplyCequalsNormOfAB<float>(X, Whermitian, precodedH);
 
     // count the diagonal elements in row i as desired power for stream i
     // and count the off-diagonal elements in row i as contributions to interstream interference affecting stream i
@@ -280,20 +306,20 @@ LinearReceiver::computeSINRs(imtaphy::detail::ComplexFloatMatrix& precodedH,  //
     {   
         for (unsigned int j = 0; j < numServingLayers; j++)
             if (i != j)                    
-                result->interferenceAndNoisePower[i] += wns::Power::from_mW(X[i][j]);
+                result.interferenceAndNoisePower[i] += wns::Power::from_mW(X[i][j]);
             else
-                result->rxPower[i] = wns::Power::from_mW(X[i][j]);
+                result.rxPower[i] = wns::Power::from_mW(X[i][j]);
             
         for (unsigned int r = 0; r < numRxAntennas; r++)
         {
-            result->scaledNoisePower[i] += thermalNoiseInclNF * std::norm(Whermitian[i][r]);
+            result.scaledNoisePower[i] += thermalNoiseInclNF * std::norm(Whermitian[i][r]);
         }
     }
 
     
     // Y = W^H * sumH * W, with sumH being the sum of interferers' covaricances plus noise
-    imtaphy::detail::matrixMultiplyCequalsAB<float>(temp, Whermitian, iAndNoiseCovariance);
-    imtaphy::detail::matrixMultiplyCequalsAB<float>(Y, temp, W);
+    imtaphy::detail::smallMatrixMultiplyCequalsAB<float>(temp, Whermitian, iAndNoiseCovariance);
+    imtaphy::detail::smallMatrixMultiplyCequalsAB<float>(Y, temp, W);
    
     // collect the interferer's interference contributions to each of our layers                                                      
     for (unsigned int i = 0; i <  numServingLayers; i++)
@@ -309,10 +335,8 @@ LinearReceiver::computeSINRs(imtaphy::detail::ComplexFloatMatrix& precodedH,  //
 //        assure((Y[i][i].imag() / Y[i][i].real() > -1e-4) && (Y[i][i].imag() / Y[i][i].real() < 1e-4), "The diagonal should be all real");
 
         // in rare cases the I+N covariance can be so ill-conditioned, that the operations above yield slightly negative values
-        result->interferenceAndNoisePower[i] += wns::Power::from_mW(fabs(Y[i][i].real()));
+        result.interferenceAndNoisePower[i] += wns::Power::from_mW(fabs(Y[i][i].real()));
     }
-    
-    return result;
 }
 
 InterferersCollectionPtr
@@ -320,39 +344,172 @@ LinearReceiver::getInterferersOnPRB(imtaphy::interface::PRB prb, InterfererExclu
 {
     InterferersCollectionPtr result(new InterferersCollection());
     
-    TransmissionVector allTransmissions = channel->getTransmissionsOnPRB(receivingInDirection, prb);
+    collectInterferersOnPRB(prb, exclusionMode, interferedTransmission, node, *result);
+    
+    return result;
+}
+
+void
+LinearReceiver::collectInterferersOnPRB(imtaphy::interface::PRB prb, InterfererExclusionMode exclusionMode, TransmissionPtr interferedTransmission, StationPhy* node, InterferersCollection& result)
+{
+    if (linksByChannelIndex.empty())
+    {
+        linksByChannelIndex.resize(channel->getNumStations(), static_cast<imtaphy::Link*>(NULL));
+        for (imtaphy::LinkMap::const_iterator iter = allMyLinks.begin(); iter != allMyLinks.end(); iter++)
+            linksByChannelIndex[iter->first->getChannelIndex()] = iter->second;
+    }
+    
+    const PRBTransmissionVector& allTransmissions = channel->getInterferenceIndexOnPRB(receivingInDirection, prb);
         
     for (unsigned int i = 0; i < allTransmissions.size(); i++)
     {
+        const PRBTransmission& entry = allTransmissions[i];
+        
         if (exclusionMode == ExcludeTransmission)
         {
             // do not count the transmission as interference to itself
-            if (allTransmissions[i] == interferedTransmission)
+            if (entry.transmission == interferedTransmission)
                 continue;
         }
         else
         { // ExcludeNode
             // Exclude transmission from our own cell (the transmission comes from our Base Station (either us (UL) or the node to estimate (DL))
             // as interference
-            if ((allTransmissions[i]->getLink()->getBS() == station) || (allTransmissions[i]->getLink()->getBS() == node))
+            if ((entry.bs == station) || (entry.bs == node))
                 continue;
         }
 
         Interferer interferer;
                     
-        interferer.interferingTransmission = allTransmissions[i];
+        interferer.interferingTransmission = entry.transmission;
 
-        assure(allMyLinks.find(interferer.interferingTransmission->getSource()) != allMyLinks.end(), "No link to interferer");
-        interferer.interferingLink = allMyLinks.find(interferer.interferingTransmission->getSource())->second;
+        assure(entry.sourceIndex < linksByChannelIndex.size() && linksByChannelIndex[entry.sourceIndex], "No link to interferer");
+        interferer.interferingLink = linksByChannelIndex[entry.sourceIndex];
+        interferer.precoding = entry.precoding;
+        interferer.txPower_mW = entry.txPower_mW;
 
-        result->insert(interferer);
+        // the index is sorted by transmission id, so this does not need a search
+        result.append(interferer);
     }
     
-    result->seal();
-    return result;
+    result.seal();
 }
 
 
+const LinearReceiver::InterferenceOnPRB&
+LinearReceiver::getInterferenceOnPRB(imtaphy::interface::PRB prb, InterfererExclusionMode exclusionMode, TransmissionPtr interferedTransmission, StationPhy* node)
+{
+    if (channel->getTTI() != interferenceCacheTimestamp)
+    {
+        // keep the entries for refilling them, but release the matrices they share
+        for (unsigned int i = 0; i < interferenceCache.size(); i++)
+        {
+            for (unsigned int j = 0; j < interferenceCacheSize[i]; j++)
+            {
+                interferenceCache[i][j].interference.perfectCovariance.reset();
+                interferenceCache[i][j].estimatedCovariance.reset();
+            }
+            interferenceCacheSize[i] = 0;
+        }
+        interferenceCacheTimestamp = channel->getTTI();
+    }
+
+    assure(prb < interferenceCache.size(), "Invalid PRB");
+
+    const void* excluded = (exclusionMode == ExcludeTransmission) ? static_cast<const void*>(interferedTransmission.get()) : static_cast<const void*>(node);
+    std::pair<InterfererExclusionMode, const void*> key(exclusionMode, excluded);
+
+    InterferenceCache& cache = interferenceCache[prb];
+    unsigned int& size = interferenceCacheSize[prb];
+
+    for (unsigned int i = 0; i < size; i++)
+    {
+        if (cache[i].key == key)
+        {
+            interferenceCacheHits++;
+            return cache[i].interference;
+        }
+    }
+
+    interferenceCacheMisses++;
+
+    if (size == cache.size())
+        cache.push_back(InterferenceCacheEntry());
+
+    InterferenceCacheEntry& entry = cache[size++];
+    entry.key = key;
+
+    if (entry.interference.interferers && entry.interference.interferers.unique())
+        entry.interference.interferers->clear();
+    else
+        entry.interference.interferers.reset(new InterferersCollection());
+
+    collectInterferersOnPRB(prb, exclusionMode, interferedTransmission, node, *entry.interference.interferers);
+
+    // entries with the same interferers (e.g., the serving BS's transmission excluded or the
+    // serving BS itself) share the covariance, like collections in the perfectCovarianceCache
+    for (unsigned int i = 0; i + 1 < size; i++)
+    {
+        if (cache[i].interference.interferers->getHash() == entry.interference.interferers->getHash())
+        {
+            entry.interference.perfectCovariance = cache[i].interference.perfectCovariance;
+            break;
+        }
+    }
+
+    if (!entry.interference.perfectCovariance)
+    {
+        if (!entry.ownPerfectCovariance || !entry.ownPerfectCovariance.unique())
+            entry.ownPerfectCovariance.reset(new imtaphy::detail::ComplexFloatMatrix(numRxAntennas, numRxAntennas));
+
+        perfectIandNoiseCovariance->writeNoiseAndInterferenceCovariance(entry.interference.interferers, NoiseCovariance, prb, *entry.ownPerfectCovariance);
+        entry.interference.perfectCovariance = entry.ownPerfectCovariance;
+    }
+
+    return entry.interference;
+}
+
+LinearReceiver::InterferenceCacheEntry*
+LinearReceiver::findCachedInterference(imtaphy::interface::PRB prb, InterferersCollectionPtr interferers)
+{
+    if ((channel->getTTI() != interferenceCacheTimestamp) || (prb >= interferenceCacheSize.size()))
+        return NULL;
+
+    for (unsigned int i = 0; i < interferenceCacheSize[prb]; i++)
+    {
+        if (interferenceCache[prb][i].interference.interferers == interferers)
+            return &interferenceCache[prb][i];
+    }
+
+    return NULL;
+}
+
+imtaphy::detail::ComplexFloatMatrixPtr
+LinearReceiver::getEstimatedCovariance(imtaphy::interface::PRB prb, InterferenceCacheEntry& entry)
+{
+    if (entry.estimatedCovariance)
+        return entry.estimatedCovariance;
+
+    // like in the estimatedCovarianceCache, the same interferers get the same estimate (some models draw random errors)
+    for (unsigned int i = 0; i < interferenceCacheSize[prb]; i++)
+    {
+        InterferenceCacheEntry& other = interferenceCache[prb][i];
+        if (other.estimatedCovariance && (other.interference.interferers->getHash() == entry.interference.interferers->getHash()))
+        {
+            entry.estimatedCovariance = other.estimatedCovariance;
+            return entry.estimatedCovariance;
+        }
+    }
+
+    if (!entry.ownEstimatedCovariance || !entry.ownEstimatedCovariance.unique())
+        entry.ownEstimatedCovariance.reset(new imtaphy::detail::ComplexFloatMatrix(numRxAntennas, numRxAntennas));
+
+    imperfectIandNoiseCovariance->writeNoiseAndInterferenceCovariance(entry.interference.interferers, NoiseCovariance, prb, *entry.ownEstimatedCovariance);
+    entry.estimatedCovariance = entry.ownEstimatedCovariance;
+
+    return entry.estimatedCovariance;
+}
+
 /**
  * @brief Computes the best PMI and associated CQIs based on the LTE Rel. precoding codebook
  *
@@ -378,14 +535,14 @@ LinearReceiver::computeFeedback(unsigned int prb,
     result.pmiRanking.resize(precodingsToTest.size());
     
     std::vector<float> bestSINRs(rank, 0.0);
-    
-    imtaphy::TransmissionVector allTransmissions = channel->getTransmissionsOnPRB(receivingInDirection, prb);
+    codebookCapacities.resize(precodingsToTest.size());
 
     // determine all inter-cell interference sources on the considered PRB
-    InterferersCollectionPtr interferers = getInterferersOnPRB(prb, ExcludeNode, TransmissionPtr(static_cast<Transmission*>(NULL)), nodeToEstimate);
-    imtaphy::detail::ComplexFloatMatrixPtr perfectIandNoiseCovarianceMatrix = getPerfectInterferenceAndNoiseCovariance(prb, interferers);
+    // (identical for all ranks and PMIs evaluated in this TTI, so this is mostly a cache hit)
+    const InterferenceOnPRB& interference = getInterferenceOnPRB(prb, ExcludeNode, TransmissionPtr(static_cast<Transmission*>(NULL)), nodeToEstimate);
+    InterferersCollectionPtr interferers = interference.interferers;
+    imtaphy::detail::ComplexFloatMatrixPtr perfectIandNoiseCovarianceMatrix = interference.perfectCovariance;
 
-    std::multimap<double, unsigned int> capacitiesForPMIs;
     double currentBestCapacity = 0.0;
 
     // get serving channel and precode it
@@ -401,10 +558,12 @@ LinearReceiver::computeFeedback(unsigned int prb,
     }
         
     
-    imtaphy::detail::ComplexFloatMatrix precodedServingChannelPerfect(numRxAntennas, rank);
+    imtaphy::detail::SmallComplexFloatMatrix precodedServingChannelPerfect(numRxAntennas, rank);
+    imtaphy::detail::SmallComplexFloatMatrix precodedServingChannelEstimated(numRxAntennas, rank);
 
     // the receiveFilter is a u-by-m complex matrix  
-    imtaphy::detail::ComplexFloatMatrix receiveFilter(numRxAntennas, rank);
+    imtaphy::detail::SmallComplexFloatMatrix receiveFilter(numRxAntennas, rank);
+    imtaphy::detail::SmallComplexFloatMatrix receiveFilterHermitian(rank, numRxAntennas);
     
     
     // loop over all possible precodings to see which one gives the highest capacity
@@ -414,16 +573,15 @@ LinearReceiver::computeFeedback(unsigned int prb,
         imtaphy::detail::ComplexFloatMatrixPtr precoding = precodingsToTest[pmi];
         
         // apply precoding to the serving channel
-        imtaphy::detail::matrixMultiplyCequalsAB(precodedServingChannelPerfect, HsPerfect, *precoding);
+        imtaphy::detail::smallMatrixMultiplyCequalsAB(precodedServingChannelPerfect.matrix(), HsPerfect, *precoding);
 
         // scale the precoded serving channel by the transmit power
-        imtaphy::detail::scaleMatrixA(precodedServingChannelPerfect, 
+        imtaphy::detail::scaleMatrixA(precodedServingChannelPerfect.matrix(), 
                                       static_cast<float>(sqrt(assumedTxPower.get_mW())));
 
         if (channelEstimation)
         {   // compute the filter based on the estimated channel
-            imtaphy::detail::ComplexFloatMatrix precodedServingChannelEstimated(numRxAntennas, rank);
-            imtaphy::detail::matrixMultiplyCequalsAB(precodedServingChannelEstimated, *HsEstimated, *precoding);
+            imtaphy::detail::smallMatrixMultiplyCequalsAB(precodedServingChannelEstimated.matrix(), *HsEstimated, *precoding);
 
             filter->computeFilter(receiveFilter, precodedServingChannelEstimated, interferers, prb, nodeToEstimate, rank);
 
@@ -436,24 +594,26 @@ LinearReceiver::computeFeedback(unsigned int prb,
        
         // W is u-by-m and Hs is u-by-s
         // and the hermitian of it a m-by-u matrix
-        imtaphy::detail::ComplexFloatMatrixPtr receiveFilterHermitian = imtaphy::detail::matrixHermitian<float>(receiveFilter);
+        imtaphy::detail::matrixHermitian<float>(receiveFilter, receiveFilterHermitian);
         
-        SINRComputationResultPtr sinrResult = computeSINRs(precodedServingChannelPerfect,
-                                                            receiveFilter,
-                                                            *receiveFilterHermitian,
-                                                            *perfectIandNoiseCovarianceMatrix,
-                                                            numRxAntennas, 
-                                                            numTxAntennasServingBS, 
-                                                            rank);
-
-        assure((sinrResult->interferenceAndNoisePower.size() == rank) &&
-               (sinrResult->rxPower.size() == rank) &&
-               (sinrResult->scaledNoisePower.size() == rank), "wrong number of layers");
+        computeSINRs(precodedServingChannelPerfect,
+                     receiveFilter,
+                     receiveFilterHermitian,
+                     *perfectIandNoiseCovarianceMatrix,
+                     numRxAntennas, 
+                     numTxAntennasServingBS, 
+                     rank,
+                     sinrScratch);
+
+        assure((sinrScratch.interferenceAndNoisePower.size() == rank) &&
+               (sinrScratch.rxPower.size() == rank) &&
+               (sinrScratch.scaledNoisePower.size() == rank), "wrong number of layers");
         
-        imtaphy::interface::SINRVector sinrs(rank);
+        imtaphy::interface::SINRVector& sinrs = sinrsScratch;
+        sinrs.resize(rank);
         for (unsigned int i = 0; i < rank; i++)
         {
-            sinrs[i] = wns::Ratio::from_factor(sinrResult->rxPower[i].get_mW() / sinrResult->interferenceAndNoisePower[i].get_mW());
+            sinrs[i] = wns::Ratio::from_factor(sinrScratch.rxPower[i].get_mW() / sinrScratch.interferenceAndNoisePower[i].get_mW());
         }
         
         
@@ -475,7 +635,7 @@ LinearReceiver::computeFeedback(unsigned int prb,
             capacity += log(1.0 + sinr.get_factor()) * log2;
         }
         
-        capacitiesForPMIs.insert(std::make_pair<double, unsigned int>(capacity, pmi));
+        codebookCapacities[pmi] = std::make_pair(capacity, pmi);
         
         if (capacity > currentBestCapacity)
         {
@@ -485,10 +645,11 @@ LinearReceiver::computeFeedback(unsigned int prb,
         }
     }
 
-    unsigned int i = 0;
-    for (std::multimap<double, unsigned int>::reverse_iterator iter = capacitiesForPMIs.rbegin(); iter != capacitiesForPMIs.rend(); i++, iter++)
+    // descending capacity, ties go to the higher PMI (like a reverse iteration over a multimap)
+    std::sort(codebookCapacities.begin(), codebookCapacities.end(), std::greater<std::pair<double, unsigned int> >());
+    for (unsigned int i = 0; i < precodingsToTest.size(); i++)
     {
-        result.pmiRanking[i] = iter->second;
+        result.pmiRanking[i] = codebookCapacities[i].second;
     }
 
     result.bestSINRs = bestSINRs;
@@ -496,6 +657,148 @@ LinearReceiver::computeFeedback(unsigned int prb,
     return result;
 }
 
+ReceiverFeedback
+LinearReceiver::computeFeedback(unsigned int prb, 
+                                unsigned int rank,
+                                imtaphy::StationPhy* nodeToEstimate,
+                                wns::Power assumedTxPower,
+                                const PackedCodebook<float>& codebook)
+{
+    assure(channel, "Need access to channel");
+
+    const InterferenceOnPRB& interference = getInterferenceOnPRB(prb, ExcludeNode, TransmissionPtr(static_cast<Transmission*>(NULL)), nodeToEstimate);
+
+    std::complex<float>* HsPerfect = allMyLinks[nodeToEstimate]->getRawChannelMatrix(receivingInDirection, prb);
+
+    imtaphy::detail::ComplexFloatMatrixPtr HsEstimated;
+    if (channelEstimation)
+    {
+        HsEstimated = getEstimatedChannel(prb, allMyLinks[nodeToEstimate], assumedTxPower);
+    }
+
+    return searchCodebook(prb, rank, nodeToEstimate, HsPerfect, HsEstimated.get(), assumedTxPower,
+                          *interference.perfectCovariance, interference.interferers, codebook);
+}
+
+/**
+ * @brief Batched version of the PMI search in computeFeedback
+ *
+ * The serving channel is precoded with all codebook entries in a single u-by-S times S-by-(numPMIs*m)
+ * product. Per PMI only the filter (which may depend on the precoded channel) and the SINRs remain;
+ * the latter only need the diagonal of W^H * R * W. The results (ranking, tie-breaking and SINRs) are
+ * the same as those of the one-matrix-at-a-time version. Must be kept thread safe like computeFeedback.
+ */
+ReceiverFeedback
+LinearReceiver::searchCodebook(unsigned int prb,
+                               unsigned int rank,
+                               imtaphy::StationPhy* nodeToEstimate,
+                               std::complex<float>* HsPerfect,
+                               imtaphy::detail::ComplexFloatMatrix* HsEstimated,
+                               wns::Power assumedTxPower,
+                               imtaphy::detail::ComplexFloatMatrix& iAndNoiseCovariance,
+                               InterferersCollectionPtr interferers,
+                               const PackedCodebook<float>& codebook)
+{
+    assure(codebook.getNumLayers() == rank, "Codebook does not match the rank");
+    assure(iAndNoiseCovariance.getRows() == numRxAntennas, "Noise and interference covariance matrix should be #rxAntennas x #rxAntennas");
+
+    unsigned int numPMIs = codebook.getNumPMIs();
+    unsigned int width = numPMIs * rank;
+
+    // the buffers only grow, so after the first TTI nothing is allocated here anymore
+    if (codebookPrecodedPerfect.size() < numRxAntennas * width)
+    {
+        codebookPrecodedPerfect.resize(numRxAntennas * width);
+        codebookPrecodedEstimated.resize(numRxAntennas * width);
+    }
+    codebookCapacities.resize(numPMIs);
+
+    imtaphy::detail::ComplexFloatMatrix precodedPerfectAll(numRxAntennas, width, &codebookPrecodedPerfect[0]);
+    imtaphy::detail::ComplexFloatMatrix precodedEstimatedAll(numRxAntennas, width, &codebookPrecodedEstimated[0]);
+
+    imtaphy::detail::matrixMultiplyCequalsAB(precodedPerfectAll, HsPerfect, codebook.getPackedMatrix());
+    imtaphy::detail::scaleMatrixA(precodedPerfectAll, static_cast<float>(sqrt(assumedTxPower.get_mW())));
+
+    if (HsEstimated)
+    {
+        imtaphy::detail::matrixMultiplyCequalsAB(precodedEstimatedAll, *HsEstimated, codebook.getPackedMatrix());
+    }
+
+    imtaphy::detail::SmallComplexFloatMatrix precodedPerfect(numRxAntennas, rank);
+    imtaphy::detail::SmallComplexFloatMatrix precodedEstimated(numRxAntennas, rank);
+    imtaphy::detail::SmallComplexFloatMatrix receiveFilter(numRxAntennas, rank);
+    imtaphy::detail::SmallComplexFloatMatrix receiveFilterHermitian(rank, numRxAntennas);
+    imtaphy::detail::SmallComplexFloatMatrix temp(rank, numRxAntennas);
+    imtaphy::detail::SmallFloatMatrix X(rank, rank);
+
+    ReceiverFeedback result;
+    result.bestSINRs.resize(rank, 0.0);
+    result.pmiRanking.resize(numPMIs);
+
+    double sinrs[imtaphy::detail::SmallComplexFloatMatrix::maxDim];
+    double currentBestCapacity = 0.0;
+    double log2 = 1.0 / log(2.0);
+    double maxSINR = wns::Ratio::from_dB(22.0).get_factor();
+
+    assure(rank <= imtaphy::detail::SmallComplexFloatMatrix::maxDim, "Too many layers");
+
+    for (unsigned int pmi = 0; pmi < numPMIs; pmi++)
+    {
+        // this PMI's u-by-m block of the batched product
+        for (unsigned int r = 0; r < numRxAntennas; r++)
+        {
+            unsigned int offset = r * width + pmi * rank;
+            std::copy(precodedPerfectAll.getLocation() + offset, precodedPerfectAll.getLocation() + offset + rank, precodedPerfect[r]);
+            if (HsEstimated)
+                std::copy(precodedEstimatedAll.getLocation() + offset, precodedEstimatedAll.getLocation() + offset + rank, precodedEstimated[r]);
+        }
+
+        filter->computeFilter(receiveFilter, HsEstimated ? precodedEstimated : precodedPerfect, interferers, prb, nodeToEstimate, rank);
+        imtaphy::detail::matrixHermitian<float>(receiveFilter, receiveFilterHermitian);
+
+        // same arithmetic as computeSINRs, but only the diagonal of Y = W^H * R * W
+        imtaphy::detail::smallMatrixMultiplyCequalsNormOfAB<float>(X, receiveFilterHermitian, precodedPerfect);
+        imtaphy::detail::smallMatrixMultiplyCequalsAB<float>(temp, receiveFilterHermitian, iAndNoiseCovariance);
+
+        double capacity = 0.0;
+        for (unsigned int i = 0; i < rank; i++)
+        {
+            double interferenceAndNoise = 1e-42; // avoid division by zero
+            for (unsigned int j = 0; j < rank; j++)
+                if (i != j)
+                    interferenceAndNoise += X[i][j];
+
+            float y = 0;
+            for (unsigned int k = 0; k < numRxAntennas; k++)
+                y += temp[i][k].real() * receiveFilter[k][i].real() - temp[i][k].imag() * receiveFilter[k][i].imag();
+            interferenceAndNoise += fabs(y);
+
+            sinrs[i] = X[i][i] / interferenceAndNoise;
+
+            // limit the contribution to the useful range in LTE below 22 dB
+            // in the case where we have to report a common PMI for multiple layers
+            double sinr = ((rank > 1) && (sinrs[i] > maxSINR)) ? maxSINR : sinrs[i];
+            capacity += log(1.0 + sinr) * log2;
+        }
+
+        codebookCapacities[pmi] = std::make_pair(capacity, pmi);
+
+        if (capacity > currentBestCapacity)
+        {
+            currentBestCapacity = capacity;
+            for (unsigned int layer = 0; layer < rank; layer++)
+                result.bestSINRs[layer] = sinrs[layer];
+        }
+    }
+
+    // descending capacity, ties go to the higher PMI (like the reverse iteration over the multimap)
+    std::sort(codebookCapacities.begin(), codebookCapacities.end(), std::greater<std::pair<double, unsigned int> >());
+    for (unsigned int i = 0; i < numPMIs; i++)
+        result.pmiRanking[i] = codebookCapacities[i].second;
+
+    return result;
+}
+
 /**
  * @brief Computes the SINR vectors for the indicated transmission
  *
@@ -530,9 +833,11 @@ LinearReceiver::receive(TransmissionPtr transmission)
                                                                                                           prbs));
     
     // the receiveFilter is a u-by-m complex matrix
-    imtaphy::detail::ComplexFloatMatrix receiveFilter(numRxAntennas, numberOfLayers);
+    imtaphy::detail::SmallComplexFloatMatrix receiveFilter(numRxAntennas, numberOfLayers);
+    imtaphy::detail::SmallComplexFloatMatrix receiveFilterHermitian(numberOfLayers, numRxAntennas);
     // the precoded channel is also a u-by-m complex matrix
-    imtaphy::detail::ComplexFloatMatrix precodedServingChannelPerfect(numRxAntennas, numberOfLayers);
+    imtaphy::detail::SmallComplexFloatMatrix precodedServingChannelPerfect(numRxAntennas, numberOfLayers);
+    imtaphy::detail::SmallComplexFloatMatrix precodedServingChannelEstimated(numRxAntennas, numberOfLayers);
     
     
     
@@ -545,21 +850,21 @@ LinearReceiver::receive(TransmissionPtr transmission)
         imtaphy::detail::ComplexFloatMatrixPtr precoding = transmission->getPrecodingMatrix(prb);
 
         // apply precoding to the serving channel
-        imtaphy::detail::matrixMultiplyCequalsAB(precodedServingChannelPerfect, Hs, *precoding);
+        imtaphy::detail::smallMatrixMultiplyCequalsAB(precodedServingChannelPerfect.matrix(), Hs, *precoding);
 
         // scale the precoded serving channel by the transmit power
-        imtaphy::detail::scaleMatrixA(precodedServingChannelPerfect, 
+        imtaphy::detail::scaleMatrixA(precodedServingChannelPerfect.matrix(), 
                                       static_cast<float>(sqrt(transmission->getTxPower(prb).get_mW())));
         // get a list of interfering transmissions
-        InterferersCollectionPtr interferers = getInterferersOnPRB(prb, ExcludeTransmission, transmission, static_cast<StationPhy*>(NULL));
+        const InterferenceOnPRB& interference = getInterferenceOnPRB(prb, ExcludeTransmission, transmission, static_cast<StationPhy*>(NULL));
+        InterferersCollectionPtr interferers = interference.interferers;
 
         if (channelEstimation)
         {   // compute the filter based on the estimated channel
             
             imtaphy::detail::ComplexFloatMatrixPtr Hestimated = getEstimatedChannel(prb, link, transmission->getTxPower(prb));
-            imtaphy::detail::ComplexFloatMatrix precodedServingChannelEstimated(numRxAntennas, numberOfLayers);
             // apply precoding to the serving channel
-            imtaphy::detail::matrixMultiplyCequalsAB(precodedServingChannelEstimated, *Hestimated, *precoding);
+            imtaphy::detail::smallMatrixMultiplyCequalsAB(precodedServingChannelEstimated.matrix(), *Hestimated, *precoding);
 
             filter->computeFilter(receiveFilter, precodedServingChannelEstimated, interferers, prb, transmission->getSource(), numberOfLayers);
         }
@@ -569,28 +874,31 @@ LinearReceiver::receive(TransmissionPtr transmission)
         }
             
         // X is m-by-m, W is u-by-m and Hs is u-by-s
-        imtaphy::detail::ComplexFloatMatrixPtr receiveFilterHermitian = imtaphy::detail::matrixHermitian<float>(receiveFilter);
+        imtaphy::detail::matrixHermitian<float>(receiveFilter, receiveFilterHermitian);
         
         // 
-        SINRComputationResultPtr sinrResult = computeSINRs(precodedServingChannelPerfect,
-                                                            receiveFilter,
-                                                            *receiveFilterHermitian,
-                                                            *getPerfectInterferenceAndNoiseCovariance(prb, interferers),
-                                                            numRxAntennas, 
-                                                            numTxAntennas,
-                                                            numberOfLayers);
-
-        assure((sinrResult->interferenceAndNoisePower.size() == numberOfLayers) &&
-               (sinrResult->rxPower.size() == numberOfLayers) &&
-               (sinrResult->scaledNoisePower.size() == numberOfLayers), "wrong number of layers");
+        computeSINRs(precodedServingChannelPerfect,
+                     receiveFilter,
+                     receiveFilterHermitian,
+                     *interference.perfectCovariance,
+                     numRxAntennas, 
+                     numTxAntennas,
+                     numberOfLayers,
+                     sinrScratch);
+
+        assure((sinrScratch.interferenceAndNoisePower.size() == numberOfLayers) &&
+               (sinrScratch.rxPower.size() == numberOfLayers) &&
+               (sinrScratch.scaledNoisePower.size() == numberOfLayers), "wrong number of layers");
         
         
-        imtaphy::interface::SINRVector sinrs(numberOfLayers);
-        imtaphy::interface::IoTVector interferenceOverThermal(numberOfLayers);
+        imtaphy::interface::SINRVector& sinrs = sinrsScratch;
+        imtaphy::interface::IoTVector& interferenceOverThermal = iotsScratch;
+        sinrs.resize(numberOfLayers);
+        interferenceOverThermal.resize(numberOfLayers);
         for (unsigned int i = 0; i < numberOfLayers; i++)
         {
-            sinrs[i] = wns::Ratio::from_factor(sinrResult->rxPower[i].get_mW() / sinrResult->interferenceAndNoisePower[i].get_mW());
-            interferenceOverThermal[i] = wns::Ratio::from_factor(sinrResult->interferenceAndNoisePower[i].get_mW() / sinrResult->scaledNoisePower[i].get_mW());
+            sinrs[i] = wns::Ratio::from_factor(sinrScratch.rxPower[i].get_mW() / sinrScratch.interferenceAndNoisePower[i].get_mW());
+            interferenceOverThermal[i] = wns::Ratio::from_factor(sinrScratch.interferenceAndNoisePower[i].get_mW() / sinrScratch.scaledNoisePower[i].get_mW());
 
             if (perUserLinSINR.find(source) == perUserLinSINR.end())
             {
@@ -647,6 +955,8 @@ void LinearReceiver::deliverReception(TransmissionPtr transmission)
 void 
 LinearReceiver::onShutdown()
 {
+    MESSAGE_SINGLE(NORMAL, logger, "Interference cache: " << interferenceCacheHits << " hits, " << interferenceCacheMisses << " misses");
+
     probeOnShutdown();
 }
 
@@ -44,6 +44,8 @@
 #include <WNS/evaluation/statistics/moments.hpp>
 #include <IMTAPHY/Channel.hpp>
 
+#include <deque>
+
 namespace imtaphy {
 
     namespace receivers {
@@ -55,6 +57,8 @@ namespace imtaphy {
             class QuantizedChannelTest;
         }
         
+        template <typename PRECISION> class PackedCodebook;
+
         struct ReceiverFeedback
         {
             std::vector<unsigned int> pmiRanking; // pmiRanking[0] gives best capacity
@@ -91,12 +95,21 @@ namespace imtaphy {
         class SINRComputationResult
         {
         public:
-            SINRComputationResult(unsigned int numServingLayers) :
-                rxPower(numServingLayers, wns::Power::from_mW(0.0)),
-                interferenceAndNoisePower(numServingLayers, wns::Power::from_mW(1e-42)), // avoid division by zero
-                scaledNoisePower(numServingLayers, wns::Power::from_mW(0.0))
+            SINRComputationResult() {}
+            
+            SINRComputationResult(unsigned int numServingLayers)
+            {
+                reset(numServingLayers);
+            }
+            
+            // reinitializes all entries, a result reused as scratch space only allocates when the number of layers grows
+            void reset(unsigned int numServingLayers)
             {
+                rxPower.assign(numServingLayers, wns::Power::from_mW(0.0));
+                interferenceAndNoisePower.assign(numServingLayers, wns::Power::from_mW(1e-42)); // avoid division by zero
+                scaledNoisePower.assign(numServingLayers, wns::Power::from_mW(0.0));
             }
+            
             std::vector<wns::Power> rxPower;
             std::vector<wns::Power> interferenceAndNoisePower;
             std::vector<wns::Power> scaledNoisePower;
@@ -120,6 +133,15 @@ namespace imtaphy {
                                                      imtaphy::StationPhy* nodeToEstimate,
                                                      wns::Power assumedTxPower,
                                                      std::vector<imtaphy::detail::ComplexFloatMatrixPtr>& precodingsToTest);
+
+            /**
+             * @brief Same as above, but evaluates the whole packed codebook in one batched pass
+             */
+            virtual ReceiverFeedback computeFeedback(unsigned int prb, 
+                                                     unsigned int rank,
+                                                     imtaphy::StationPhy* nodeToEstimate,
+                                                     wns::Power assumedTxPower,
+                                                     const PackedCodebook<float>& codebook);
                                           
             void setMaxRank(unsigned int rank) {
                 maxRank = rank;
@@ -142,10 +164,35 @@ namespace imtaphy {
                 ExcludeNode
             } InterfererExclusionMode;
             InterferersCollectionPtr getInterferersOnPRB(imtaphy::interface::PRB prb, InterfererExclusionMode exclusionMode, TransmissionPtr interferedTransmission, StationPhy* node);
+
+            struct InterferenceOnPRB
+            {
+                InterferersCollectionPtr interferers;
+                imtaphy::detail::ComplexFloatMatrixPtr perfectCovariance;
+            };
+
+            /**
+             * @brief Interferers and perfect I+N covariance on a PRB, cached for the current TTI
+             *
+             * The feedback computation asks for the same PRB once per rank (and computeIPNVariation once more),
+             * so the result is cached per PRB, exclusion mode and excluded transmission/node. The cache is
+             * invalidated on the first access in a new TTI, but its entries keep their interferers collection
+             * and covariance matrices, which are refilled in place. So once the cache has grown to the number
+             * of entries per PRB a TTI needs, looking up the interference does not allocate anymore.
+             */
+            const InterferenceOnPRB& getInterferenceOnPRB(imtaphy::interface::PRB prb, InterfererExclusionMode exclusionMode, TransmissionPtr interferedTransmission, StationPhy* node);
+
+            unsigned long int getInterferenceCacheHits() const {return interferenceCacheHits;}
+            unsigned long int getInterferenceCacheMisses() const {return interferenceCacheMisses;}
            
             
             imtaphy::detail::ComplexFloatMatrixPtr getPerfectInterferenceAndNoiseCovariance(imtaphy::interface::PRB prb, InterferersCollectionPtr interferers)
             {
+                // collections from getInterferenceOnPRB come with their covariance
+                InterferenceCacheEntry* cached = findCachedInterference(prb, interferers);
+                if (cached)
+                    return cached->interference.perfectCovariance;
+                
                 if (channel->getTTI() != perfectCovarianceTimestamp)
                 {
                     perfectCovarianceCache.clear();
@@ -166,6 +213,11 @@ namespace imtaphy {
             
             imtaphy::detail::ComplexFloatMatrixPtr getEstimatedInterferenceAndNoiseCovariance(imtaphy::interface::PRB prb, InterferersCollectionPtr interferers)
             {
+                // collections from getInterferenceOnPRB keep their estimate in the reused cache entry
+                InterferenceCacheEntry* cached = findCachedInterference(prb, interferers);
+                if (cached)
+                    return getEstimatedCovariance(prb, *cached);
+                
                 if (channel->getTTI() != estimatedCovarianceTimestamp)
                 {
                     estimatedCovarianceCache.clear();
@@ -275,6 +327,26 @@ namespace imtaphy {
                                                   unsigned int numRxAntennas, 
                                                   unsigned int numServingTxAntennas, 
                                                   unsigned int numServingLayers) const;
+
+            // same as above, but fills a result the caller reuses
+            void computeSINRs(imtaphy::detail::ComplexFloatMatrix& precodedH,
+                              imtaphy::detail::ComplexFloatMatrix& W,
+                              imtaphy::detail::ComplexFloatMatrix& Whermitian,
+                              imtaphy::detail::ComplexFloatMatrix& iAndNoiseCovariance,
+                              unsigned int numRxAntennas, 
+                              unsigned int numServingTxAntennas, 
+                              unsigned int numServingLayers,
+                              SINRComputationResult& result) const;
+
+            ReceiverFeedback searchCodebook(unsigned int prb,
+                                            unsigned int rank,
+                                            imtaphy::StationPhy* nodeToEstimate,
+                                            std::complex<float>* HsPerfect, // u-by-S serving channel
+                                            imtaphy::detail::ComplexFloatMatrix* HsEstimated, // NULL without channel estimation
+                                            wns::Power assumedTxPower,
+                                            imtaphy::detail::ComplexFloatMatrix& iAndNoiseCovariance,
+                                            InterferersCollectionPtr interferers,
+                                            const PackedCodebook<float>& codebook);
                                 
             void probeOnShutdown();
             
@@ -307,6 +379,10 @@ namespace imtaphy {
 
             imtaphy::detail::ComplexFloatMatrixPtr NoiseCovariance;
             imtaphy::LinkMap allMyLinks;
+            
+            // allMyLinks indexed by the peer's StationPhy::getChannelIndex(), NULL where there is no link;
+            // built on first use because derived receivers set up allMyLinks themselves
+            std::vector<imtaphy::Link*> linksByChannelIndex;
 
             
             std::map<TransmissionPtr, Reception> currentReceptions;
@@ -339,16 +415,51 @@ namespace imtaphy {
             typedef std::map<InterferersCollectionPtr, imtaphy::detail::ComplexFloatMatrixPtr, InterferersCollectionCompare> CovarianceCache;
             typedef std::map<imtaphy::Link*, imtaphy::detail::ComplexFloatMatrixPtr> ChannelCache;
             typedef std::map<imtaphy::Link*, wns::Power> TxPowerCache;
+
+            // An entry of the interference cache. In a new TTI the entries are refilled in place: the collection
+            // and the matrices are only replaced if somebody outside the cache still holds them.
+            struct InterferenceCacheEntry
+            {
+                std::pair<InterfererExclusionMode, const void*> key;
+                InterferenceOnPRB interference;
+                imtaphy::detail::ComplexFloatMatrixPtr estimatedCovariance; // NULL until a filter asks for it
+                imtaphy::detail::ComplexFloatMatrixPtr ownPerfectCovariance; // may be shared with entries with the same interferers
+                imtaphy::detail::ComplexFloatMatrixPtr ownEstimatedCovariance;
+            };
+            // the first interferenceCacheSize[prb] entries are valid in the current TTI, there are only a few per PRB;
+            // a deque because getInterferenceOnPRB hands out references to the entries
+            typedef std::deque<InterferenceCacheEntry> InterferenceCache;
+
+            void collectInterferersOnPRB(imtaphy::interface::PRB prb, InterfererExclusionMode exclusionMode, TransmissionPtr interferedTransmission, StationPhy* node, InterferersCollection& result);
+            InterferenceCacheEntry* findCachedInterference(imtaphy::interface::PRB prb, InterferersCollectionPtr interferers);
+            imtaphy::detail::ComplexFloatMatrixPtr getEstimatedCovariance(imtaphy::interface::PRB prb, InterferenceCacheEntry& entry);
             
             
             std::vector<CovarianceCache> perfectCovarianceCache;
             std::vector<CovarianceCache> estimatedCovarianceCache;
             std::vector<ChannelCache> estimatedChannelCache;
             std::vector<TxPowerCache> txPowerUsedForEstimation;
+            std::vector<InterferenceCache> interferenceCache;
+            std::vector<unsigned int> interferenceCacheSize;
             
             unsigned int perfectCovarianceTimestamp;
             unsigned int estimatedCovarianceTimestamp;
             unsigned int estimatedChannelTimestamp;
+            unsigned int interferenceCacheTimestamp;
+
+            unsigned long int interferenceCacheHits;
+            unsigned long int interferenceCacheMisses;
+
+            // reused by searchCodebook: the channel precoded with the whole codebook and the capacity ranking
+            std::vector<std::complex<float> > codebookPrecodedPerfect;
+            std::vector<std::complex<float> > codebookPrecodedEstimated;
+            std::vector<std::pair<double, unsigned int> > codebookCapacities;
+
+            // reused by receive and computeFeedback for every PRB, which is safe because a receiver is only
+            // ever handled by one thread at a time (the channel and the feedback managers split by receiver)
+            SINRComputationResult sinrScratch;
+            imtaphy::interface::SINRVector sinrsScratch;
+            imtaphy::interface::IoTVector iotsScratch;
 
             wns::pyconfig::View config;
             };
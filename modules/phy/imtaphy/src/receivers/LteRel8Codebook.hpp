@@ -39,6 +39,7 @@
 #include <IMTAPHY/detail/LinearAlgebra.hpp>
 #include <IMTAPHY/receivers/feedback/LteFeedback.hpp>
 #include <map>
+#include <vector>
 
 namespace imtaphy {
 
@@ -86,6 +87,53 @@ namespace imtaphy {
         };
 
         
+        /**
+         * All precoding matrices of one rank side by side in one contiguous S-by-(numPMIs*m) matrix:
+         * columns p*m .. p*m+m-1 hold the precoding of PMI firstPMI+p. A single product H * P then
+         * precodes the channel with the whole codebook at once.
+         */
+        template <typename PRECISION>
+        class PackedCodebook
+        {
+            typedef boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<PRECISION> > > MatrixPtr;
+        public:
+            PackedCodebook(const std::vector<MatrixPtr>& matrices_, unsigned int firstPMI_) :
+                matrices(matrices_),
+                firstPMI(firstPMI_)
+            {
+                assure(matrices.size() > 0, "Cannot pack an empty codebook");
+
+                numTxAntennas = matrices[0]->getRows();
+                numLayers = matrices[0]->getColumns();
+                packed = MatrixPtr(new imtaphy::detail::MKLMatrix<std::complex<PRECISION> >(numTxAntennas, matrices.size() * numLayers));
+
+                for (unsigned int p = 0; p < matrices.size(); p++)
+                {
+                    assure((matrices[p]->getRows() == numTxAntennas) && (matrices[p]->getColumns() == numLayers), "All precodings must have the same size");
+                    for (unsigned int s = 0; s < numTxAntennas; s++)
+                        for (unsigned int m = 0; m < numLayers; m++)
+                            (*packed)[s][p * numLayers + m] = (*matrices[p])[s][m];
+                }
+            }
+
+            unsigned int getFirstPMI() const {return firstPMI;}
+            unsigned int getNumPMIs() const {return matrices.size();}
+            unsigned int getNumTxAntennas() const {return numTxAntennas;}
+            unsigned int getNumLayers() const {return numLayers;}
+
+            imtaphy::detail::MKLMatrix<std::complex<PRECISION> >& getPackedMatrix() const {return *packed;}
+
+            // the individual matrices, e.g. for receivers that evaluate one PMI at a time
+            const std::vector<MatrixPtr>& getMatrices() const {return matrices;}
+
+        private:
+            std::vector<MatrixPtr> matrices;
+            unsigned int firstPMI;
+            unsigned int numTxAntennas;
+            unsigned int numLayers;
+            MatrixPtr packed;
+        };
+
         typedef struct CC {
             
             CC (unsigned int pmi_, unsigned int column_) :
@@ -971,6 +1019,7 @@ namespace imtaphy {
                 (*fourTxCodebook[3][15])[3][3] = std::complex<PRECISION>( 0.250000000000000, 0.000000000000000);
                 
                 build4x4CodebookIndex();
+                buildPackedCodebooks();
             }
 
             // TODO: make const and make it return pre-build Matrix pointers
@@ -1041,6 +1090,21 @@ namespace imtaphy {
                 return indexLookup[pmi][column];
             }
             
+            /**
+             * The codebook subset evaluated for closed-loop feedback, packed for a batched search:
+             * 2Tx rank 1 uses PMIs 0..3, 2Tx rank 2 PMIs 1..2 (PMI 0 is open-loop only) and 4Tx all 16 PMIs
+             */
+            const PackedCodebook<PRECISION>& getPackedCodebook(unsigned int numTxAntennas, unsigned int layers) const
+            {
+                assure((numTxAntennas == 2) || (numTxAntennas == 4), "Codebook only contains entries for 2 or 4 Tx antennas");
+                assure((layers > 0) && (layers <= numTxAntennas), "Invalid rank for the codebook");
+
+                if (numTxAntennas == 2)
+                    return *packedTwoTx[layers - 1];
+                else
+                    return *packedFourTx[layers - 1];
+            }
+
             std::map<unsigned int, CodebookColumnSet> columnLookup;
 
         private:
@@ -1050,6 +1114,9 @@ namespace imtaphy {
            AntennaSelection<float> antennaSelection;
            
            unsigned int indexLookup[16][4];
+
+           std::vector<boost::shared_ptr<PackedCodebook<PRECISION> > > packedTwoTx;
+           std::vector<boost::shared_ptr<PackedCodebook<PRECISION> > > packedFourTx;
            imtaphy::detail::ComplexFloatMatrixPtr individual4TxColumns[16][4];
            
            bool identicalColumns(unsigned int firstPMI, unsigned int firstColumn, unsigned int secondPMI, unsigned int secondColumn)
@@ -1065,6 +1132,31 @@ namespace imtaphy {
                }
            }
            
+           // built once up front, the (parallel) feedback computation only reads them
+           void buildPackedCodebooks()
+           {
+               for (unsigned int layers = 1; layers <= 2; layers++)
+               {
+                   unsigned int firstPMI = (layers == 1) ? 0 : 1;
+                   unsigned int numPMIs = (layers == 1) ? 4 : 2;
+
+                   std::vector<boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<PRECISION> > > > matrices;
+                   for (unsigned int pmi = firstPMI; pmi < firstPMI + numPMIs; pmi++)
+                       matrices.push_back(twoTxCodebook[layers - 1][pmi]);
+
+                   packedTwoTx.push_back(boost::shared_ptr<PackedCodebook<PRECISION> >(new PackedCodebook<PRECISION>(matrices, firstPMI)));
+               }
+
+               for (unsigned int layers = 1; layers <= 4; layers++)
+               {
+                   std::vector<boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<PRECISION> > > > matrices;
+                   for (unsigned int pmi = 0; pmi < 16; pmi++)
+                       matrices.push_back(fourTxCodebook[layers - 1][pmi]);
+
+                   packedFourTx.push_back(boost::shared_ptr<PackedCodebook<PRECISION> >(new PackedCodebook<PRECISION>(matrices, 0)));
+               }
+           }
+
            void build4x4CodebookIndex()
            {
                unsigned int index = 0;
@@ -82,6 +82,18 @@ ProbingReceiver::channelInitialized(Channel* _channel)
 }
 
 
+ReceiverFeedback
+ProbingReceiver::computeFeedback(unsigned int prb, 
+                                unsigned int rank,
+                                imtaphy::StationPhy* nodeToEstimate,
+                                wns::Power assumedTxPower,
+                                const PackedCodebook<float>& codebook)
+{
+    std::vector<imtaphy::detail::ComplexFloatMatrixPtr> precodingsToTest(codebook.getMatrices());
+
+    return computeFeedback(prb, rank, nodeToEstimate, assumedTxPower, precodingsToTest);
+}
+
 ReceiverFeedback
 ProbingReceiver::computeFeedback(unsigned int prb, 
                                 unsigned int rank,
@@ -100,11 +112,11 @@ ProbingReceiver::computeFeedback(unsigned int prb,
     
     std::vector<float> bestSINRs(rank, 0.0);
     
-    imtaphy::TransmissionVector allTransmissions = channel->getTransmissionsOnPRB(receivingInDirection, prb);
 
     // determine all inter-cell interference sources on the considered PRB
-    InterferersCollectionPtr interferers = getInterferersOnPRB(prb, ExcludeNode, TransmissionPtr(static_cast<Transmission*>(NULL)), nodeToEstimate);
-    imtaphy::detail::ComplexFloatMatrixPtr perfectIandNoiseCovarianceMatrix = getPerfectInterferenceAndNoiseCovariance(prb, interferers);
+    const InterferenceOnPRB& interference = getInterferenceOnPRB(prb, ExcludeNode, TransmissionPtr(static_cast<Transmission*>(NULL)), nodeToEstimate);
+    InterferersCollectionPtr interferers = interference.interferers;
+    imtaphy::detail::ComplexFloatMatrixPtr perfectIandNoiseCovarianceMatrix = interference.perfectCovariance;
 
     std::multimap<double, unsigned int> capacitiesForPMIs;
     double currentBestCapacity = 0.0;
@@ -54,6 +54,14 @@ namespace imtaphy {
                                 imtaphy::StationPhy* nodeToEstimate,
                                 wns::Power assumedTxPower,
                                 std::vector<imtaphy::detail::ComplexFloatMatrixPtr>& precodingsToTest);            
+
+            // probes every PMI, so it does not use the batched search
+            ReceiverFeedback
+            computeFeedback(unsigned int prb, 
+                                unsigned int rank,
+                                imtaphy::StationPhy* nodeToEstimate,
+                                wns::Power assumedTxPower,
+                                const PackedCodebook<float>& codebook);
             
             void onShutdown();
            
@@ -71,3 +71,18 @@ DiagonalIandNCovariance::computeNoiseAndInterferenceCovariance(imtaphy::receiver
     
     return IandNoiseCovariance;
 }
+
+void
+DiagonalIandNCovariance::writeNoiseAndInterferenceCovariance(imtaphy::receivers::InterferersCollectionPtr interferers, const imtaphy::detail::ComplexFloatMatrixPtr noiseOnlyMatrix, unsigned int prb, imtaphy::detail::ComplexFloatMatrix& IandNoiseCovariance)
+{
+    // same as above, but only the diagonal of the perfect IandNoiseCovariance matrix is copied
+    imtaphy::detail::ComplexFloatMatrixPtr perfectCovariance = receiver->getPerfectInterferenceAndNoiseCovariance(prb, interferers);
+    
+    assure((IandNoiseCovariance.getRows() == perfectCovariance->getRows()) && (IandNoiseCovariance.getColumns() == perfectCovariance->getColumns()), "Result matrix has the wrong size");
+    
+    for (unsigned int i =  0; i < IandNoiseCovariance.getRows(); i++)
+        for (unsigned int j = 0; j < IandNoiseCovariance.getColumns(); j++)
+        {
+            IandNoiseCovariance[i][j] = (i == j) ? (*perfectCovariance)[i][i] : std::complex<float>(0.0, 0.0);
+        }
+}
@@ -76,3 +76,20 @@ EqualDiagonalIandNCovariance::computeNoiseAndInterferenceCovariance(imtaphy::rec
     
     return IandNoiseCovariance;
 }
+
+void
+EqualDiagonalIandNCovariance::writeNoiseAndInterferenceCovariance(imtaphy::receivers::InterferersCollectionPtr interferers, const imtaphy::detail::ComplexFloatMatrixPtr noiseOnlyMatrix, unsigned int prb, imtaphy::detail::ComplexFloatMatrix& IandNoiseCovariance)
+{
+    // same as above without copying the perfect IandNoiseCovariance matrix first
+    imtaphy::detail::ComplexFloatMatrixPtr perfectCovariance = receiver->getPerfectInterferenceAndNoiseCovariance(prb, interferers);
+    
+    assure((IandNoiseCovariance.getRows() == perfectCovariance->getRows()) && (IandNoiseCovariance.getColumns() == perfectCovariance->getColumns()), "Result matrix has the wrong size");
+    
+    std::complex<float> trace = imtaphy::detail::trace(*perfectCovariance);
+    
+    for (unsigned int i =  0; i < IandNoiseCovariance.getRows(); i++)
+        for (unsigned int j = 0; j < IandNoiseCovariance.getColumns(); j++)
+        {
+            IandNoiseCovariance[i][j] = (i == j) ? trace / static_cast<float>(IandNoiseCovariance.getColumns()) : std::complex<float>(0.0, 0.0);
+        }
+}
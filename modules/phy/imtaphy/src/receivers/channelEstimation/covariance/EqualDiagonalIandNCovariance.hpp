@@ -52,6 +52,7 @@ namespace imtaphy {
             EqualDiagonalIandNCovariance(LinearReceiver* receiver, const wns::pyconfig::View& pyConfigView);
 
             imtaphy::detail::ComplexFloatMatrixPtr computeNoiseAndInterferenceCovariance(InterferersCollectionPtr interferers, const imtaphy::detail::ComplexFloatMatrixPtr noiseOnlyMatrix, unsigned int prb);
+            void writeNoiseAndInterferenceCovariance(InterferersCollectionPtr interferers, const imtaphy::detail::ComplexFloatMatrixPtr noiseOnlyMatrix, unsigned int prb, imtaphy::detail::ComplexFloatMatrix& result);
             
         protected:
             unsigned int numRxAntennas;
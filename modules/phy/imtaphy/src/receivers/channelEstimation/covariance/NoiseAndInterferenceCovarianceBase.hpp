@@ -54,6 +54,22 @@ namespace imtaphy {
             virtual 
             imtaphy::detail::ComplexFloatMatrixPtr computeNoiseAndInterferenceCovariance(InterferersCollectionPtr interferers, const imtaphy::detail::ComplexFloatMatrixPtr noiseOnlyMatrix, unsigned int prb) = 0;
 
+            /**
+             * @brief Same as computeNoiseAndInterferenceCovariance, but writes into a numRxAntennas-by-numRxAntennas
+             * matrix owned by the caller, which the receiver reuses from TTI to TTI
+             *
+             * The default copies the result of computeNoiseAndInterferenceCovariance, models that do not need a
+             * temporary override it.
+             */
+            virtual
+            void writeNoiseAndInterferenceCovariance(InterferersCollectionPtr interferers, const imtaphy::detail::ComplexFloatMatrixPtr noiseOnlyMatrix, unsigned int prb, imtaphy::detail::ComplexFloatMatrix& result)
+            {
+                imtaphy::detail::ComplexFloatMatrixPtr covariance = computeNoiseAndInterferenceCovariance(interferers, noiseOnlyMatrix, prb);
+                
+                assure((covariance->getRows() == result.getRows()) && (covariance->getColumns() == result.getColumns()), "Result matrix has the wrong size");
+                std::copy(covariance->getLocation(), covariance->getLocation() + covariance->getRows() * covariance->getColumns(), result.getLocation());
+            }
+
         };
         
     } // end of channelEstimation namespace
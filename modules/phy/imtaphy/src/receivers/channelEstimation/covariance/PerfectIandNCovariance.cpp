@@ -30,6 +30,7 @@
 #include <IMTAPHY/receivers/channelEstimation/covariance/PerfectIandNCovariance.hpp>
 #include <IMTAPHY/receivers/LinearReceiver.hpp>
 #include <IMTAPHY/receivers/Interferer.hpp>
+#include <IMTAPHY/detail/SmallMatrix.hpp>
 
 STATIC_FACTORY_REGISTER_WITH_CREATOR(
     imtaphy::receivers::channelEstimation::covariance::PerfectInterferenceAndNoiseCovariance,
@@ -56,8 +57,19 @@ PerfectInterferenceAndNoiseCovariance::PerfectInterferenceAndNoiseCovariance(Lin
 imtaphy::detail::ComplexFloatMatrixPtr
 PerfectInterferenceAndNoiseCovariance::computeNoiseAndInterferenceCovariance(imtaphy::receivers::InterferersCollectionPtr interferers, const imtaphy::detail::ComplexFloatMatrixPtr noiseOnlyMatrix, unsigned int prb)
 {
-    imtaphy::detail::ComplexFloatMatrixPtr IandNoiseCovariance(new imtaphy::detail::ComplexFloatMatrix(*noiseOnlyMatrix));
+    imtaphy::detail::ComplexFloatMatrixPtr IandNoiseCovariance(new imtaphy::detail::ComplexFloatMatrix(noiseOnlyMatrix->getRows(), noiseOnlyMatrix->getColumns()));
     
+    writeNoiseAndInterferenceCovariance(interferers, noiseOnlyMatrix, prb, *IandNoiseCovariance);
+    
+    return IandNoiseCovariance;
+}
+
+void
+PerfectInterferenceAndNoiseCovariance::writeNoiseAndInterferenceCovariance(imtaphy::receivers::InterferersCollectionPtr interferers, const imtaphy::detail::ComplexFloatMatrixPtr noiseOnlyMatrix, unsigned int prb, imtaphy::detail::ComplexFloatMatrix& IandNoiseCovariance)
+{
+    assure((IandNoiseCovariance.getRows() == noiseOnlyMatrix->getRows()) && (IandNoiseCovariance.getColumns() == noiseOnlyMatrix->getColumns()), "Result matrix has the wrong size");
+    
+    std::copy(noiseOnlyMatrix->getLocation(), noiseOnlyMatrix->getLocation() + noiseOnlyMatrix->getRows() * noiseOnlyMatrix->getColumns(), IandNoiseCovariance.getLocation());
 
     for (imtaphy::receivers::InterferersSet::const_iterator iter = interferers->getInterferersSet().begin(); iter != interferers->getInterferersSet().end(); iter++)
     {
@@ -66,29 +78,33 @@ PerfectInterferenceAndNoiseCovariance::computeNoiseAndInterferenceCovariance(imt
         unsigned int mI = interferer.interferingTransmission->getNumLayers();
         
         std::complex<float>* rawChannel = interferer.interferingLink->getRawChannelMatrix(direction, prb);
-        imtaphy::detail::ComplexFloatMatrixPtr precoding = interferer.interferingTransmission->getPrecodingMatrix(prb);
+        // prefer what the channel's interference index already resolved for this PRB over the map lookups
+        imtaphy::detail::ComplexFloatMatrix* precoding = interferer.precoding;
+        float interferingTxPower = interferer.txPower_mW;
+        if (precoding == NULL)
+        {
+            precoding = interferer.interferingTransmission->getPrecodingMatrix(prb).get();
+            interferingTxPower = interferer.interferingTransmission->getTxPower(prb).get_mW();
+        }
         
-        assure(precoding != imtaphy::detail::ComplexFloatMatrixPtr(), "Invalid precoding matrix");
+        assure(precoding != NULL, "Invalid precoding matrix");
         assure(precoding->getRows() == interferer.interferingTransmission->getNumTxAntennas(), "Inconsistent info about Tx antennas");
         assure(precoding->getColumns() == mI, "Inconsistent info about num layers");
         
-        imtaphy::detail::ComplexFloatMatrixPtr interferersEffectiveChannel = imtaphy::detail::ComplexFloatMatrixPtr(new imtaphy::detail::ComplexFloatMatrix(numRxAntennas, mI));
+        // stack temporary, this runs for every interferer on every PRB
+        imtaphy::detail::SmallComplexFloatMatrix interferersEffectiveChannel(numRxAntennas, mI);
         
         // precodedChannel = Hi * precoding with Hi being u-by-s and precoding bying s-by-mI
-        imtaphy::detail::matrixMultiplyCequalsAB(*interferersEffectiveChannel, 
-                                                 rawChannel,
-                                                 *precoding);
-        
-        float interferingTxPower = interferer.interferingTransmission->getTxPower(prb).get_mW();
+        imtaphy::detail::smallMatrixMultiplyCequalsAB(interferersEffectiveChannel.matrix(), 
+                                                      rawChannel,
+                                                      *precoding);
         
         // sum = (alpha*A) * (alpha*A)^H + sum
-        imtaphy::detail::matrixMultiplyCequalsAlphaSquareTimesAAhermitianPlusC(*IandNoiseCovariance, // increment this
-                                                                               *interferersEffectiveChannel, // add the alpha^2 * AA^H
-                                                                               interferingTxPower // alpha^2
-                                                                              );
+        imtaphy::detail::smallMatrixMultiplyCequalsAlphaSquareTimesAAhermitianPlusC(IandNoiseCovariance, // increment this
+                                                                                    interferersEffectiveChannel.matrix(), // add the alpha^2 * AA^H
+                                                                                    interferingTxPower // alpha^2
+                                                                                   );
    
     }
-    
-    return IandNoiseCovariance;
 }
 
@@ -220,9 +220,9 @@ LteRel8DownlinkFeedbackManager::performRankUpdate(imtaphy::StationPhy* receiving
                     assure(0, "Unsupported number of tx antennas");
             }
             
-            std::vector<imtaphy::detail::ComplexFloatMatrixPtr> precodings;
-            for (unsigned int pmi = firstPMI; pmi < firstPMI + numPMIs; pmi++)
-                precodings.push_back(codebook->getPrecodingMatrix(numTxAntennas, rank, pmi));
+            // all PMIs of this rank are evaluated in one batched pass
+            const imtaphy::receivers::PackedCodebook<float>& precodings = codebook->getPackedCodebook(numTxAntennas, rank);
+            assure((precodings.getFirstPMI() == firstPMI) && (precodings.getNumPMIs() == numPMIs), "Packed codebook does not match the PMI range");
             
             imtaphy::receivers::ReceiverFeedback best = receiver->computeFeedback(prb, rank, 
                                                                                   transmitterToEstimate, 
@@ -303,9 +303,8 @@ LteRel8DownlinkFeedbackManager::determinePMIsAndCQIs(imtaphy::StationPhy* receiv
                 assure(0, "Unsupported number of tx antennas for spatial multiplexing mode");
         }
         
-        std::vector<imtaphy::detail::ComplexFloatMatrixPtr> precodings;
-        for (unsigned int pmi = firstPMI; pmi < firstPMI + numPMIs; pmi++)
-            precodings.push_back(codebook->getPrecodingMatrix(numTxAntennas, rank, pmi));
+        const imtaphy::receivers::PackedCodebook<float>& precodings = codebook->getPackedCodebook(numTxAntennas, rank);
+        assure((precodings.getFirstPMI() == firstPMI) && (precodings.getNumPMIs() == numPMIs), "Packed codebook does not match the PMI range");
                 
         imtaphy::receivers::ReceiverFeedback best = receiver->computeFeedback(midPRB, rank, 
                                                                               transmitterToEstimate, 
@@ -539,7 +538,9 @@ LteRel8DownlinkFeedbackManager::setReferencePerPRBTxPowerForUser(wns::node::Inte
 {
     assure(node2StationLookup.find(node) != node2StationLookup.end(), "Got reference power for unknown node");
 
-    referencePowerMap[node2StationLookup[node]] = std::vector<wns::Power>(numPRBs, referencePower);
+    std::map<imtaphy::StationPhy*, std::vector<wns::Power> >::iterator iter = referencePowerMap.find(node2StationLookup.find(node)->second);
+    assure(iter != referencePowerMap.end(), "No reference power entry for node, registerMS has to create it");
+    iter->second.assign(numPRBs, referencePower);
 }
 
 void 
@@ -548,14 +549,11 @@ LteRel8DownlinkFeedbackManager::setReferencePerPRBTxPowerForUser(wns::node::Inte
     assure(node2StationLookup.find(node) != node2StationLookup.end(), "Got reference power for unknown node");
     assure(prb < numPRBs, "Invalid PRB");
     
-    if (referencePowerMap.find(node2StationLookup[node]) == referencePowerMap.end())
-    {
-        referencePowerMap[node2StationLookup[node]] = std::vector<wns::Power>(numPRBs, referencePower);
-    }
-    else
-    {
-        referencePowerMap[node2StationLookup[node]][prb] = referencePower;
-    }
+    // the schedulers call this from parallel onNewTTIs, so the map must not be modified here; each
+    // scheduler only writes the entries of its own users, which registerMS created
+    std::map<imtaphy::StationPhy*, std::vector<wns::Power> >::iterator iter = referencePowerMap.find(node2StationLookup.find(node)->second);
+    assure(iter != referencePowerMap.end(), "No reference power entry for node, registerMS has to create it");
+    iter->second[prb] = referencePower;
 }
 
 
@@ -590,6 +588,9 @@ LteRel8DownlinkFeedbackManager::registerMS(imtaphy::StationPhy* station, wns::no
     lastIPNCovariances[node] = std::vector<imtaphy::detail::ComplexFloatMatrixPtr>(numPRBs, dummyIPNPtr);
     ipnDifferences[node] = std::vector<double>();
     
+    // created here because setReferencePerPRBTxPowerForUser is called concurrently by the schedulers
+    // and must not insert; the schedulers set the actual powers before the first feedback update
+    referencePowerMap[station] = std::vector<wns::Power>(numPRBs);
     
     node2StationLookup[node] = station;
 }
@@ -610,7 +611,8 @@ LteRel8DownlinkFeedbackManager::getFeedback(wns::node::Interface* node, unsigned
     // the scheduler would have to get it at TTI=106 so that it will take effect immediately in TTI=106
 
     
-    if (perNodeFeedback.find(node) == perNodeFeedback.end())
+    NodeFeedbackMap::const_iterator iter = perNodeFeedback.find(node); // read-only, schedulers call this in parallel
+    if (iter == perNodeFeedback.end())
     {
         std::cout << "Requested receiver not found, returning default feedback\n";
         return defaultFeedback;
@@ -618,7 +620,7 @@ LteRel8DownlinkFeedbackManager::getFeedback(wns::node::Interface* node, unsigned
     else
     {
 
-        FeedbackContainer* feedbackContainer = perNodeFeedback[node];
+        FeedbackContainer* feedbackContainer = iter->second;
         unsigned int index = (ttiNumber + feedbackContainer->bufferLength - feedbackTotalDelay) % feedbackContainer->bufferLength;
 
         return feedbackContainer->ringBuffer[index];
@@ -682,8 +684,7 @@ LteRel8DownlinkFeedbackManager::computeIPNVariation(imtaphy::StationPhy* receivi
     for (unsigned int prb = 0; prb < numPRBs; prb++)
     {
         // determine all inter-cell interference sources on the considered PRB
-        InterferersCollectionPtr interferers = receiver->getInterferersOnPRB(prb, imtaphy::receivers::LinearReceiver::ExcludeNode, imtaphy::TransmissionPtr(static_cast<imtaphy::Transmission*>(NULL)), receivingStation);
-        imtaphy::detail::ComplexFloatMatrixPtr newIPNcovariance = receiver->getPerfectInterferenceAndNoiseCovariance(prb, interferers);
+        imtaphy::detail::ComplexFloatMatrixPtr newIPNcovariance = receiver->getInterferenceOnPRB(prb, imtaphy::receivers::LinearReceiver::ExcludeNode, imtaphy::TransmissionPtr(static_cast<imtaphy::Transmission*>(NULL)), receivingStation).perfectCovariance;
 
         if (lastIPNCovariances[node][prb].get() == dummyIPNPtr.get())
         {
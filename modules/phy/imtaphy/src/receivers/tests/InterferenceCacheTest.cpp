@@ -0,0 +1,262 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <WNS/pyconfig/Parser.hpp>
+#include <WNS/node/Registry.hpp>
+#include <WNS/simulator/ISimulator.hpp>
+
+#include <IMTAPHY/tests/ChannelStub.hpp>
+#include <IMTAPHY/tests/StationPhyStub.hpp>
+#include <IMTAPHY/spatialChannel/m2135/M2135.hpp>
+#include <IMTAPHY/pathloss/M2135Pathloss.hpp>
+#include <IMTAPHY/lsParams/LSCorrelation.hpp>
+#include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <IMTAPHY/receivers/LinearReceiver.hpp>
+#include <IMTAPHY/receivers/channelEstimation/covariance/PerfectIandNCovariance.hpp>
+#include <IMTAPHY/Link.hpp>
+#include <IMTAPHY/Spectrum.hpp>
+
+#include <itpp/itbase.h>
+#include <vector>
+#include <sstream>
+#include <cmath>
+
+namespace imtaphy { namespace receivers { namespace tests {
+
+        class InterferenceCacheTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( InterferenceCacheTest );
+            CPPUNIT_TEST( entriesAreRefilledInPlace );
+            CPPUNIT_TEST_SUITE_END();
+
+        public:
+            void setUp();
+            void tearDown();
+
+            void entriesAreRefilledInPlace();
+
+        private:
+            // registers the uplink transmissions of all mobiles for a new TTI, all users of a cell share its PRBs
+            void startTTI(unsigned int tti);
+
+            // checks the cached interference on all PRBs of the transmissions towards base station c against a
+            // fresh computation and returns the addresses of the cached collections and perfect covariances
+            std::vector<const void*> checkInterference(unsigned int c);
+
+            static const unsigned int numCells = 2;
+            static const unsigned int numUsersPerCell = 2;
+            static const unsigned int numPRBs = 6;
+
+            wns::pyconfig::Parser config;
+            imtaphy::tests::ChannelStub* channel;
+            std::vector<imtaphy::tests::StationPhyStub*> baseStations;
+            std::vector<imtaphy::tests::StationPhyStub*> mobiles;
+            std::vector<imtaphy::Link*> servingLinks;
+            imtaphy::detail::ComplexFloatMatrixPtr precoding;
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( InterferenceCacheTest );
+
+        void
+        InterferenceCacheTest::setUp()
+        {
+            config.loadString("import imtaphy.Pathloss\n"
+                              "import imtaphy.SCM\n"
+                              "import imtaphy.Logger\n"
+                              "pathloss = imtaphy.Pathloss.M2135Pathloss()\n"
+                              "scm = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"))\n");
+
+            itpp::RNG_reset(4711);
+            wns::simulator::getRNG()->seed(4711);
+
+            imtaphy::Spectrum* spectrum = new imtaphy::Spectrum(2E09, 180000.0, numPRBs, numPRBs);
+            channel = new imtaphy::tests::ChannelStub();
+            channel->setSpectrum(spectrum);
+            channel->initTransmissionLists();
+
+            imtaphy::LinkManagerStub* linkManager = new imtaphy::LinkManagerStub();
+            channel->setLinkManager(linkManager);
+            channel->setPathlossModel(new imtaphy::pathloss::M2135Pathloss(channel, wns::pyconfig::View(config, "pathloss")));
+
+            wns::node::Registry* registry = new wns::node::Registry();
+            double lambda = spectrum->getSystemCenterFrequencyWavelenghtMeters(imtaphy::Downlink);
+
+            baseStations.clear();
+            mobiles.clear();
+            for (unsigned int c = 0; c < numCells; c++)
+            {
+                std::stringstream name;
+                name << "BS" << c;
+                baseStations.push_back(imtaphy::tests::createStationStub(name.str(), wns::Position(200.0 * c, 0, 25), "BS", 4, 0.5 * lambda, 0, registry, channel));
+            }
+            for (unsigned int m = 0; m < numCells * numUsersPerCell; m++)
+            {
+                std::stringstream name;
+                name << "MS" << m;
+                mobiles.push_back(imtaphy::tests::createStationStub(name.str(), wns::Position(50.0 + 40.0 * m, 60, 1.5), "MS", 2, 0.5 * lambda, 3.0, registry, channel));
+            }
+
+            servingLinks.assign(mobiles.size(), static_cast<imtaphy::Link*>(NULL));
+            for (unsigned int m = 0; m < mobiles.size(); m++)
+                for (unsigned int c = 0; c < numCells; c++)
+                {
+                    imtaphy::Link* link = new imtaphy::LinkStub(baseStations[c], mobiles[m], imtaphy::Link::UMa, imtaphy::Link::NLoS, imtaphy::Link::NLoS,
+                                                                imtaphy::Link::NotApplicable, mobiles[m]->getPosition(), wns::Ratio::from_dB(0.0), 0);
+                    linkManager->addLink(link, true);
+                    if (c == m / numUsersPerCell)
+                        servingLinks[m] = link;
+                }
+
+            imtaphy::lsparams::LSCorrelation lsCorrelation(linkManager->getAllLinks(), linkManager, new imtaphy::lsparams::RandomMatrix());
+            imtaphy::lsparams::LSmap* largeScaleParams = lsCorrelation.generateLSCorrelation();
+
+            imtaphy::scm::m2135::M2135<float>* scm = new imtaphy::scm::m2135::M2135<float>(channel, wns::pyconfig::View(config, "scm"));
+            scm->onWorldCreated(linkManager, largeScaleParams, false);
+            channel->setSpatialChannelModel(scm);
+
+            imtaphy::LinkVector links = linkManager->getAllLinks();
+            for (unsigned int i = 0; i < links.size(); i++)
+                links[i]->initComplexFloatChannelMatrices<float>(spectrum, scm);
+            scm->evolve(0.0);
+
+            // the base stations receive the uplink, which does not need a feedback manager
+            for (unsigned int c = 0; c < numCells; c++)
+                baseStations[c]->getReceiver()->channelInitialized(channel);
+
+            precoding = imtaphy::detail::ComplexFloatMatrixPtr(new imtaphy::detail::ComplexFloatMatrix(2, 1));
+            (*precoding)[0][0] = std::complex<float>(1.0 / sqrt(2.0), 0.0);
+            (*precoding)[1][0] = std::complex<float>(0.0, 1.0 / sqrt(2.0));
+        }
+
+        void
+        InterferenceCacheTest::tearDown()
+        {
+        }
+
+        void
+        InterferenceCacheTest::startTTI(unsigned int tti)
+        {
+            channel->startTTI(tti);
+
+            for (unsigned int m = 0; m < mobiles.size(); m++)
+            {
+                imtaphy::interface::PrbPowerPrecodingMap prbMap;
+                for (unsigned int prb = m % numUsersPerCell; prb < numPRBs; prb += numUsersPerCell)
+                {
+                    imtaphy::interface::PowerAndPrecoding entry;
+                    entry.power = wns::Power::from_dBm(10.0 + m + tti);
+                    entry.precoding = precoding;
+                    prbMap[prb] = entry;
+                }
+                channel->registerTransmission(TransmissionPtr(new Transmission(imtaphy::Uplink, std::vector<wns::ldk::CompoundPtr>(),
+                                                                               servingLinks[m], mobiles[m], servingLinks[m]->getBS(),
+                                                                               prbMap, 2, 1)));
+            }
+        }
+
+        std::vector<const void*>
+        InterferenceCacheTest::checkInterference(unsigned int c)
+        {
+            LinearReceiver* receiver = dynamic_cast<LinearReceiver*>(baseStations[c]->getReceiver());
+            CPPUNIT_ASSERT(receiver);
+
+            imtaphy::receivers::channelEstimation::covariance::PerfectInterferenceAndNoiseCovariance perfect(receiver);
+
+            std::vector<const void*> addresses;
+            const TransmissionVector& transmissions = channel->getAllTransmissions();
+            for (unsigned int t = 0; t < transmissions.size(); t++)
+            {
+                if (transmissions[t]->getDestination() != baseStations[c])
+                    continue;
+
+                const imtaphy::interface::PrbPowerPrecodingMap& prbMap = transmissions[t]->getPrbPowerPrecodingMap();
+                for (imtaphy::interface::PrbPowerPrecodingMap::const_iterator iter = prbMap.begin(); iter != prbMap.end(); iter++)
+                {
+                    unsigned int prb = iter->first;
+
+                    const LinearReceiver::InterferenceOnPRB& interference = receiver->getInterferenceOnPRB(prb, LinearReceiver::ExcludeTransmission, transmissions[t], NULL);
+
+                    InterferersCollectionPtr reference = receiver->getInterferersOnPRB(prb, LinearReceiver::ExcludeTransmission, transmissions[t], NULL);
+                    InterferersSet& cached = interference.interferers->getInterferersSet();
+                    CPPUNIT_ASSERT_EQUAL(reference->getInterferersSet().size(), cached.size());
+                    CPPUNIT_ASSERT_EQUAL(reference->getHash(), interference.interferers->getHash());
+                    // one interferer per PRB from the other cell
+                    CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(numCells - 1), cached.size());
+
+                    imtaphy::detail::ComplexFloatMatrixPtr expected = perfect.computeNoiseAndInterferenceCovariance(reference, receiver->getNoiseCovariance(), prb);
+                    imtaphy::detail::ComplexFloatMatrixPtr estimated = receiver->getEstimatedInterferenceAndNoiseCovariance(prb, interference.interferers);
+                    for (unsigned int i = 0; i < expected->getRows(); i++)
+                        for (unsigned int j = 0; j < expected->getColumns(); j++)
+                        {
+                            CPPUNIT_ASSERT_EQUAL((*expected)[i][j], (*interference.perfectCovariance)[i][j]);
+                            // the default estimation model keeps the diagonal
+                            CPPUNIT_ASSERT_EQUAL((i == j) ? (*expected)[i][j] : std::complex<float>(0.0, 0.0), (*estimated)[i][j]);
+                        }
+
+                    addresses.push_back(interference.interferers.get());
+                    addresses.push_back(interference.perfectCovariance.get());
+                    addresses.push_back(estimated.get());
+                }
+            }
+
+            return addresses;
+        }
+
+        void
+        InterferenceCacheTest::entriesAreRefilledInPlace()
+        {
+            startTTI(1);
+            std::vector<const void*> first = checkInterference(0);
+            CPPUNIT_ASSERT(!first.empty());
+
+            // same transmission pattern, different powers: the entries and their matrices are reused
+            startTTI(2);
+            std::vector<const void*> second = checkInterference(0);
+            CPPUNIT_ASSERT(first == second);
+
+            // a collection somebody still holds must not be overwritten in the next TTI
+            LinearReceiver* receiver = dynamic_cast<LinearReceiver*>(baseStations[0]->getReceiver());
+            TransmissionPtr held = channel->getAllTransmissions()[0];
+            CPPUNIT_ASSERT(held->getDestination() == baseStations[0]);
+            unsigned int prb = held->getPrbPowerPrecodingMap().begin()->first;
+            InterferersCollectionPtr kept = receiver->getInterferenceOnPRB(prb, LinearReceiver::ExcludeTransmission, held, NULL).interferers;
+            std::size_t keptHash = kept->getHash();
+
+            startTTI(3);
+            std::vector<const void*> third = checkInterference(0);
+            CPPUNIT_ASSERT_EQUAL(second.size(), third.size());
+            CPPUNIT_ASSERT(third[0] != static_cast<const void*>(kept.get()));
+            CPPUNIT_ASSERT(std::equal(second.begin() + 1, second.end(), third.begin() + 1));
+            CPPUNIT_ASSERT_EQUAL(keptHash, kept->getHash());
+            CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(numCells - 1), kept->getInterferersSet().size());
+        }
+}}}
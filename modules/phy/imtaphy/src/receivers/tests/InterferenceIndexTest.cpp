@@ -0,0 +1,312 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <WNS/StopWatch.hpp>
+#include <WNS/node/Registry.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/tests/ChannelStub.hpp>
+#include <IMTAPHY/tests/StationPhyStub.hpp>
+#include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <IMTAPHY/receivers/LinearReceiver.hpp>
+#include <IMTAPHY/Transmission.hpp>
+#include <IMTAPHY/receivers/Interferer.hpp>
+#include <IMTAPHY/Link.hpp>
+#include <IMTAPHY/Spectrum.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <set>
+
+namespace imtaphy { namespace receivers { namespace tests {
+
+        // An uplink drop on a ChannelStub: every cell has a few mobiles that take turns on the PRBs, every
+        // mobile has a link to every base station and all transmissions go through Channel::registerTransmission.
+        // The base stations' LinearReceivers look up their interferers from the channel's interference index.
+        class UplinkDrop
+        {
+        public:
+            UplinkDrop(unsigned int numCells, unsigned int numMobilesPerCell, unsigned int numPRBs, unsigned int busyCellsModulo)
+            {
+                imtaphy::Spectrum* spectrum = new imtaphy::Spectrum(2E09, 180000.0, numPRBs, numPRBs);
+                channel = new imtaphy::tests::ChannelStub();
+                channel->setSpectrum(spectrum);
+                channel->initTransmissionLists();
+
+                imtaphy::LinkManagerStub* linkManager = new imtaphy::LinkManagerStub();
+                channel->setLinkManager(linkManager);
+
+                wns::node::Registry* registry = new wns::node::Registry();
+                double lambda = spectrum->getSystemCenterFrequencyWavelenghtMeters(imtaphy::Uplink);
+
+                for (unsigned int c = 0; c < numCells; c++)
+                {
+                    std::stringstream name;
+                    name << "BS" << c;
+                    baseStations.push_back(imtaphy::tests::createStationStub(name.str(), wns::Position(200.0 * c, 0, 25), "BS", 2, 0.5 * lambda, 0, registry, channel));
+                }
+                for (unsigned int m = 0; m < numCells * numMobilesPerCell; m++)
+                {
+                    std::stringstream name;
+                    name << "MS" << m;
+                    mobiles.push_back(imtaphy::tests::createStationStub(name.str(), wns::Position(10.0 * m, 60, 1.5), "MS", 1, 0.5 * lambda, 3.0, registry, channel));
+                }
+
+                servingLinks.resize(mobiles.size());
+                for (unsigned int m = 0; m < mobiles.size(); m++)
+                    for (unsigned int c = 0; c < numCells; c++)
+                    {
+                        imtaphy::Link* link = new imtaphy::LinkStub(baseStations[c], mobiles[m], imtaphy::Link::UMa, imtaphy::Link::NLoS, imtaphy::Link::NLoS,
+                                                                    imtaphy::Link::NotApplicable, mobiles[m]->getPosition(), wns::Ratio::from_dB(0.0), 0);
+                        linkManager->addLink(link, false);
+                        if (c == m / numMobilesPerCell)
+                            servingLinks[m] = link;
+                    }
+
+                for (unsigned int c = 0; c < numCells; c++)
+                {
+                    baseStations[c]->getReceiver()->channelInitialized(channel);
+                    receivers.push_back(dynamic_cast<LinearReceiver*>(baseStations[c]->getReceiver()));
+                    CPPUNIT_ASSERT(receivers.back());
+                }
+
+                // PRB p is used by mobile p % numMobilesPerCell of every cell c with (c + p) % busyCellsModulo == 0
+                imtaphy::detail::ComplexFloatMatrixPtr precoding(new imtaphy::detail::ComplexFloatMatrix(1, 1));
+                (*precoding)[0][0] = std::complex<float>(1.0, 0.0);
+                for (unsigned int m = 0; m < mobiles.size(); m++)
+                {
+                    unsigned int cell = m / numMobilesPerCell;
+                    imtaphy::interface::PrbPowerPrecodingMap prbMap;
+                    for (unsigned int prb = m % numMobilesPerCell; prb < numPRBs; prb += numMobilesPerCell)
+                    {
+                        if ((cell + prb) % busyCellsModulo != 0)
+                            continue;
+                        imtaphy::interface::PowerAndPrecoding entry;
+                        entry.power = wns::Power::from_dBm(static_cast<double>(prb + m));
+                        entry.precoding = precoding;
+                        prbMap[prb] = entry;
+                    }
+                    if (prbMap.empty())
+                        continue;
+                    channel->registerTransmission(TransmissionPtr(new Transmission(imtaphy::Uplink, std::vector<wns::ldk::CompoundPtr>(),
+                                                                                   servingLinks[m], mobiles[m], servingLinks[m]->getBS(),
+                                                                                   prbMap, 1, 1)));
+                }
+            }
+
+            // what LinearReceiver::getInterferersOnPRB did before the interference index: copy the PRB's transmission
+            // vector, look up the link in the receiver's link map and insert into a sorted set
+            static std::set<Interferer, InterferersCompare>
+            interferersBeforeIndex(imtaphy::Channel* channel, LinearReceiver* receiver, imtaphy::interface::PRB prb,
+                                   LinearReceiver::InterfererExclusionMode exclusionMode, TransmissionPtr interferedTransmission, StationPhy* node)
+            {
+                std::set<Interferer, InterferersCompare> result;
+                TransmissionVector allTransmissions = channel->getTransmissionsOnPRB(receiver->getDirection(), prb);
+
+                for (unsigned int i = 0; i < allTransmissions.size(); i++)
+                {
+                    if (exclusionMode == LinearReceiver::ExcludeTransmission)
+                    {
+                        if (allTransmissions[i] == interferedTransmission)
+                            continue;
+                    }
+                    else
+                    {
+                        if ((allTransmissions[i]->getLink()->getBS() == receiver->getStation()) || (allTransmissions[i]->getLink()->getBS() == node))
+                            continue;
+                    }
+
+                    Interferer interferer;
+                    interferer.interferingTransmission = allTransmissions[i];
+                    interferer.interferingLink = receiver->getLinkToBS(allTransmissions[i]->getSource());
+                    result.insert(interferer);
+                }
+
+                return result;
+            }
+
+            // the own cell's transmission on the PRB, NULL if the cell is idle there
+            TransmissionPtr ownTransmission(unsigned int c, imtaphy::interface::PRB prb) const
+            {
+                const TransmissionVector& transmissions = channel->getTransmissionsOnPRB(imtaphy::Uplink, prb);
+                for (unsigned int i = 0; i < transmissions.size(); i++)
+                    if (transmissions[i]->getDestination() == baseStations[c])
+                        return transmissions[i];
+
+                return TransmissionPtr();
+            }
+
+            imtaphy::tests::ChannelStub* channel;
+            std::vector<imtaphy::tests::StationPhyStub*> baseStations;
+            std::vector<imtaphy::tests::StationPhyStub*> mobiles;
+            std::vector<imtaphy::Link*> servingLinks;
+            std::vector<LinearReceiver*> receivers;
+        };
+
+        class InterferenceIndexTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( InterferenceIndexTest );
+            CPPUNIT_TEST( sameInterferersAsBeforeIndex );
+            CPPUNIT_TEST_SUITE_END();
+
+        public:
+            void setUp() {}
+            void tearDown() {}
+
+            void sameInterferersAsBeforeIndex();
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( InterferenceIndexTest );
+
+        void
+        InterferenceIndexTest::sameInterferersAsBeforeIndex()
+        {
+            // every second cell is idle on a PRB, so the exclusion has something to skip besides the own cell
+            UplinkDrop drop(4, 2, 6, 2);
+            unsigned int numPRBs = 6;
+
+            unsigned int compared = 0;
+            for (unsigned int c = 0; c < drop.baseStations.size(); c++)
+                for (unsigned int prb = 0; prb < numPRBs; prb++)
+                {
+                    LinearReceiver* receiver = drop.receivers[c];
+                    TransmissionPtr own = drop.ownTransmission(c, prb);
+
+                    // ExcludeNode with another base station as the node to estimate drops that cell as well
+                    StationPhy* otherBS = drop.baseStations[(c + 1) % drop.baseStations.size()];
+
+                    for (int mode = 0; mode < 2; mode++)
+                    {
+                        if ((mode == 0) && (own == TransmissionPtr()))
+                            continue;
+
+                        LinearReceiver::InterfererExclusionMode exclusionMode = (mode == 0) ? LinearReceiver::ExcludeTransmission : LinearReceiver::ExcludeNode;
+                        StationPhy* node = (mode == 0) ? static_cast<StationPhy*>(NULL) : otherBS;
+
+                        std::set<Interferer, InterferersCompare> expected = UplinkDrop::interferersBeforeIndex(drop.channel, receiver, prb, exclusionMode, own, node);
+                        InterferersCollectionPtr interferers = receiver->getInterferersOnPRB(prb, exclusionMode, own, node);
+                        InterferersSet& actual = interferers->getInterferersSet();
+
+                        CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+
+                        InterferersCollection expectedCollection;
+                        unsigned int i = 0;
+                        for (std::set<Interferer, InterferersCompare>::const_iterator iter = expected.begin(); iter != expected.end(); iter++, i++)
+                        {
+                            CPPUNIT_ASSERT(iter->interferingTransmission == actual[i].interferingTransmission);
+                            CPPUNIT_ASSERT(iter->interferingLink == actual[i].interferingLink);
+                            // the index resolves precoding and power the covariance would otherwise look up per PRB
+                            CPPUNIT_ASSERT(actual[i].precoding == iter->interferingTransmission->getPrecodingMatrix(prb).get());
+                            CPPUNIT_ASSERT_DOUBLES_EQUAL(iter->interferingTransmission->getTxPower(prb).get_mW(), actual[i].txPower_mW, 1e-6 * actual[i].txPower_mW);
+                            expectedCollection.insert(*iter);
+                        }
+                        expectedCollection.seal();
+                        CPPUNIT_ASSERT_EQUAL(expectedCollection.getHash(), interferers->getHash());
+                        compared++;
+                    }
+                }
+
+            CPPUNIT_ASSERT(compared > drop.baseStations.size() * numPRBs);
+        }
+
+        // Times the interferer lookup of the base stations in a fully loaded 57-cell uplink drop (every cell
+        // receives on every PRB) with the real receivers and channel against the lookup before the interference
+        // index. Registered in the Performance registry.
+        class InterferenceIndexPerformanceTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( InterferenceIndexPerformanceTest );
+            CPPUNIT_TEST( fullyLoaded57CellDrop );
+            CPPUNIT_TEST_SUITE_END();
+
+        public:
+            void setUp() {}
+            void tearDown() {}
+
+            void fullyLoaded57CellDrop();
+
+        private:
+            static const unsigned int numCells = 57;
+            static const unsigned int numMobilesPerCell = 10;
+            static const unsigned int numPRBs = 50;
+            static const unsigned int numRepetitions = 10;
+        };
+
+        CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( InterferenceIndexPerformanceTest, wns::testsuite::Performance() );
+
+        void
+        InterferenceIndexPerformanceTest::fullyLoaded57CellDrop()
+        {
+            UplinkDrop drop(numCells, numMobilesPerCell, numPRBs, 1);
+
+            std::vector<TransmissionPtr> own(numCells * numPRBs);
+            for (unsigned int c = 0; c < numCells; c++)
+                for (unsigned int prb = 0; prb < numPRBs; prb++)
+                {
+                    own[c * numPRBs + prb] = drop.ownTransmission(c, prb);
+                    CPPUNIT_ASSERT(own[c * numPRBs + prb] != TransmissionPtr());
+                }
+
+            // keep the results alive so that nothing gets optimized away
+            std::size_t checksumOld = 0;
+            std::size_t checksumIndex = 0;
+
+            wns::StopWatch old;
+            old.start();
+            for (unsigned int r = 0; r < numRepetitions; r++)
+                for (unsigned int c = 0; c < numCells; c++)
+                    for (unsigned int prb = 0; prb < numPRBs; prb++)
+                    {
+                        std::set<Interferer, InterferersCompare> result =
+                            UplinkDrop::interferersBeforeIndex(drop.channel, drop.receivers[c], prb, LinearReceiver::ExcludeTransmission, own[c * numPRBs + prb], NULL);
+                        checksumOld += result.size() + result.begin()->interferingTransmission->getId();
+                    }
+            old.stop();
+
+            wns::StopWatch index;
+            index.start();
+            for (unsigned int r = 0; r < numRepetitions; r++)
+                for (unsigned int c = 0; c < numCells; c++)
+                    for (unsigned int prb = 0; prb < numPRBs; prb++)
+                    {
+                        InterferersCollectionPtr result = drop.receivers[c]->getInterferersOnPRB(prb, LinearReceiver::ExcludeTransmission, own[c * numPRBs + prb], NULL);
+                        checksumIndex += result->getInterferersSet().size() + result->getInterferersSet().begin()->interferingTransmission->getId();
+                    }
+            index.stop();
+
+            std::cout << "\n" << numCells << " cells, " << numCells * numMobilesPerCell << " mobiles, " << numPRBs << " PRBs: "
+                      << "copy+map+set " << old.toString() << ", interference index " << index.toString()
+                      << " (speedup " << old.getInSeconds() / index.getInSeconds() << ")" << std::endl;
+
+            // both must find the same interferers
+            CPPUNIT_ASSERT_EQUAL(checksumOld, checksumIndex);
+        }
+}}}
@@ -41,19 +41,26 @@
 
 #include <itpp/itbase.h>
 #include <algorithm>
+#include <map>
 
 #include <WNS/pyconfig/Parser.hpp>
+#include <WNS/simulator/ISimulator.hpp>
 
 #include <IMTAPHY/receivers/Interferer.hpp>
 #include <IMTAPHY/Transmission.hpp>
 #include <IMTAPHY/Link.hpp>
 
 #include <IMTAPHY/receivers/LinearReceiver.hpp>
+#include <IMTAPHY/receivers/LteRel8Codebook.hpp>
+#include <IMTAPHY/receivers/filters/MMSE.hpp>
 #include <IMTAPHY/tests/StationPhyStub.hpp>
 
 #include <IMTAPHY/Spectrum.hpp>
 #include <IMTAPHY/tests/ChannelStub.hpp>
 #include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <IMTAPHY/spatialChannel/m2135/M2135.hpp>
+#include <IMTAPHY/pathloss/M2135Pathloss.hpp>
+#include <IMTAPHY/lsParams/LSCorrelation.hpp>
 
 namespace imtaphy { namespace receivers { namespace tests {
     
@@ -77,6 +84,8 @@ namespace imtaphy { namespace receivers { namespace tests {
                 
                     CPPUNIT_TEST_SUITE( LinearReceiverTest );
                     CPPUNIT_TEST( testComputeSINR );
+                    CPPUNIT_TEST( testBatchedCodebookSearch );
+                    CPPUNIT_TEST( testBatchedCodebookSearchWithInterferers );
                     CPPUNIT_TEST_SUITE_END();
 
                     typedef boost::multi_array_ref<std::complex<float>, 2> MatrixType;
@@ -86,9 +95,18 @@ namespace imtaphy { namespace receivers { namespace tests {
                     void setUp();
                     void tearDown();
                     void testComputeSINR();
+                    void testBatchedCodebookSearch();
+                    void testBatchedCodebookSearchWithInterferers();
                     
         
                 private:
+                    // the batched search over the packed 4Tx codebook has to rank the PMIs like the evaluation
+                    // of one precoding at a time (computeFeedback) with the testee's filter and report the SINRs
+                    // of its best PMI
+                    void checkCodebookSearch(LinearReceiver* testee, StationPhy* nodeToEstimate, unsigned int prb, unsigned int rank,
+                                             std::complex<float>* H, wns::Power txPower,
+                                             imtaphy::detail::ComplexFloatMatrix& covariance, InterferersCollectionPtr interferers);
+
                     imtaphy::tests::ChannelStub* channel;
                     imtaphy::tests::StationPhyStub *servingBS, *interferingBS1, *interferingBS2, *interferingBS3, *ms;
                     wns::node::Registry* registry;
@@ -126,7 +144,8 @@ namespace imtaphy { namespace receivers { namespace tests {
                     ss_config << "import imtaphy.Receiver\n"
                                  << "import imtaphy.Logger\n"
                                  << "logger = imtaphy.Logger.Logger(\"LinearReceiverForUnitTesting\")\n"
-                                 << "receiver = imtaphy.Receiver.LinearReceiver(logger, filter = imtaphy.Receiver.MMSEFilter())\n";
+                                 << "receiver = imtaphy.Receiver.LinearReceiver(logger, filter = imtaphy.Receiver.MMSEFilter())\n"
+                                 << "mrcReceiver = imtaphy.Receiver.LinearReceiver(logger, filter = imtaphy.Receiver.MRCFilter())\n";
                                  
                     ;
                     all_config.loadString(ss_config.str());
@@ -228,7 +247,7 @@ namespace imtaphy { namespace receivers { namespace tests {
                     iAndNoiseCovariance44[3][2] = std::complex<float>( 0.000000000000000, 0.000000000000000);
                     iAndNoiseCovariance44[3][3] = std::complex<float>( 0.000000010000000, 0.000000000000000);
 
-                    float* SINRsMatlab = static_cast<float*>(mkl_malloc(sizeof(float) * m, 32));
+                    float* SINRsMatlab = static_cast<float*>(imtaphy::detail::alignedMalloc(sizeof(float) * m, 32));
                     SINRsMatlab[0] = 10.496728029789855;
                     SINRsMatlab[1] = 9.770056829109816;
                     SINRsMatlab[2] = 9.350008008959703;
@@ -264,8 +283,249 @@ namespace imtaphy { namespace receivers { namespace tests {
                     for (unsigned int j = 0; j < sinrs.size(); j++)
                         CPPUNIT_ASSERT_DOUBLES_EQUAL(SINRsMatlab[j], sinrs[j].get_dB(), 1e-04);
                     
+                    // the overload filling a reused result has to give the same, also if that was sized for fewer layers
+                    SINRComputationResult scratch(1);
+                    testee->computeSINRs(precodedHs44, receiveFilter44Matlab, *receiveFilter44hermitian, iAndNoiseCovariance44, U, S, m, scratch);
+                    CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(m), scratch.rxPower.size());
+                    for (unsigned int i = 0; i < m; i++)
+                    {
+                        CPPUNIT_ASSERT_EQUAL(sinrResult->rxPower[i].get_mW(), scratch.rxPower[i].get_mW());
+                        CPPUNIT_ASSERT_EQUAL(sinrResult->interferenceAndNoisePower[i].get_mW(), scratch.interferenceAndNoisePower[i].get_mW());
+                        CPPUNIT_ASSERT_EQUAL(sinrResult->scaledNoisePower[i].get_mW(), scratch.scaledNoisePower[i].get_mW());
+                    }
+                    
                     // test outputs
                     
                }
-}}}
 
+                void
+                LinearReceiverTest::checkCodebookSearch(LinearReceiver* testee, StationPhy* nodeToEstimate, unsigned int prb, unsigned int rank,
+                                                        std::complex<float>* H, wns::Power txPower,
+                                                        imtaphy::detail::ComplexFloatMatrix& covariance, InterferersCollectionPtr interferers)
+                {
+                    unsigned int U = testee->numRxAntennas;
+                    unsigned int S = 4;
+
+                    const PackedCodebook<float>& codebook = TheLteRel8CodebookFloat::Instance().getPackedCodebook(S, rank);
+                    CPPUNIT_ASSERT_EQUAL(16U, codebook.getNumPMIs());
+
+                    ReceiverFeedback batched = testee->searchCodebook(prb, rank, nodeToEstimate, H, NULL, txPower,
+                                                                      covariance, interferers, codebook);
+
+                    // reference: one precoding matrix at a time
+                    double maxSINR = wns::Ratio::from_dB(22.0).get_factor();
+                    std::vector<double> capacities(codebook.getNumPMIs());
+                    std::vector<std::vector<double> > sinrs(codebook.getNumPMIs(), std::vector<double>(rank));
+                    std::multimap<double, unsigned int> ranking;
+                    for (unsigned int pmi = 0; pmi < codebook.getNumPMIs(); pmi++)
+                    {
+                        imtaphy::detail::ComplexFloatMatrix precoded(U, rank);
+                        imtaphy::detail::ComplexFloatMatrix W(U, rank);
+
+                        imtaphy::detail::matrixMultiplyCequalsAB(precoded, H, *codebook.getMatrices()[pmi]);
+                        imtaphy::detail::scaleMatrixA(precoded, static_cast<float>(sqrt(txPower.get_mW())));
+                        testee->filter->computeFilter(W, precoded, interferers, prb, nodeToEstimate, rank);
+                        imtaphy::detail::ComplexFloatMatrixPtr Whermitian = imtaphy::detail::matrixHermitian<float>(W);
+
+                        SINRComputationResultPtr sinrResult = testee->computeSINRs(precoded, W, *Whermitian, covariance, U, S, rank);
+
+                        capacities[pmi] = 0.0;
+                        for (unsigned int layer = 0; layer < rank; layer++)
+                        {
+                            sinrs[pmi][layer] = sinrResult->rxPower[layer].get_mW() / sinrResult->interferenceAndNoisePower[layer].get_mW();
+
+                            // a common PMI for multiple layers only counts SINRs up to 22 dB
+                            double sinr = ((rank > 1) && (sinrs[pmi][layer] > maxSINR)) ? maxSINR : sinrs[pmi][layer];
+                            capacities[pmi] += log(1.0 + sinr) / log(2.0);
+                        }
+                        ranking.insert(std::make_pair(capacities[pmi], pmi));
+                    }
+
+                    CPPUNIT_ASSERT_EQUAL(codebook.getNumPMIs(), static_cast<unsigned int>(batched.pmiRanking.size()));
+                    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(rank), batched.bestSINRs.size());
+
+                    // every PMI is ranked exactly once
+                    std::vector<unsigned int> pmis(batched.pmiRanking);
+                    std::sort(pmis.begin(), pmis.end());
+                    for (unsigned int pmi = 0; pmi < codebook.getNumPMIs(); pmi++)
+                        CPPUNIT_ASSERT_EQUAL(pmi, pmis[pmi]);
+
+                    // PMIs may only swap places where their capacities are (numerically) equal
+                    unsigned int i = 0;
+                    for (std::multimap<double, unsigned int>::reverse_iterator iter = ranking.rbegin(); iter != ranking.rend(); iter++, i++)
+                    {
+                        CPPUNIT_ASSERT_DOUBLES_EQUAL(iter->first, capacities[batched.pmiRanking[i]], 1e-5 * iter->first);
+                    }
+
+                    // the reported SINRs are those of the PMI ranked first
+                    for (unsigned int layer = 0; layer < rank; layer++)
+                    {
+                        double expected = sinrs[batched.pmiRanking[0]][layer];
+                        CPPUNIT_ASSERT_DOUBLES_EQUAL(expected, batched.bestSINRs[layer], 1e-4 * expected);
+                    }
+                }
+
+                void
+                LinearReceiverTest::testBatchedCodebookSearch()
+                {
+                    // MRC only supports a single layer, without interferers the filter only sees the channel
+                    wns::pyconfig::View receiverConfig(all_config, "mrcReceiver");
+
+                    unsigned int U = 2;
+                    unsigned int S = 4;
+
+                    imtaphy::tests::StationPhyStub* batchMS = imtaphy::tests::createStationStub("BatchMS", wns::Position(60,30,1.5), "MS", U, 0.5 * lambda, 3.0, registry, channel);
+
+                    LinearReceiverForUnitTesting* testee = new LinearReceiverForUnitTesting(batchMS, receiverConfig);
+                    testee->channelInitialized(channel);
+                    testee->numRxAntennas = U;
+                    testee->filter->initFilterComputation(channel, testee);
+
+                    InterferersCollectionPtr noInterferers(new InterferersCollection());
+                    noInterferers->seal();
+
+                    wns::Power txPower = wns::Power::from_mW(100.0);
+
+                    itpp::RNG_reset(4711);
+                    for (int trial = 0; trial < 20; trial++)
+                    {
+                        imtaphy::detail::ComplexFloatMatrix H(U, S);
+                        for (unsigned int u = 0; u < U; u++)
+                            for (unsigned int s = 0; s < S; s++)
+                                H[u][s] = std::complex<float>(1e-5 * itpp::randn(), 1e-5 * itpp::randn());
+
+                        // some spatially colored interference on top of the noise
+                        imtaphy::detail::ComplexFloatMatrix interference(U, 2);
+                        for (unsigned int u = 0; u < U; u++)
+                            for (unsigned int i = 0; i < 2; i++)
+                                interference[u][i] = std::complex<float>(1e-5 * itpp::randn(), 1e-5 * itpp::randn());
+                        imtaphy::detail::ComplexFloatMatrix covariance(U, U);
+                        imtaphy::detail::matrixMultiplyCequalsAAhermitian<float>(covariance, interference);
+                        for (unsigned int u = 0; u < U; u++)
+                            covariance[u][u] += 1e-10;
+
+                        checkCodebookSearch(testee, batchMS, 0, 1, H.getLocation(), txPower, covariance, noInterferers);
+                    }
+                }
+
+                void
+                LinearReceiverTest::testBatchedCodebookSearchWithInterferers()
+                {
+                    // Two cells with 4 antennas at all stations and the default (MMSE) receivers, like the
+                    // InterferenceCacheTest. The base stations search the uplink codebook for their own mobiles
+                    // with ranks 1..4 while the other cell's mobile interferes on the same PRB, so the MMSE
+                    // filter depends on the interferers and the layers interfere with each other.
+                    const unsigned int numCells = 2;
+                    const unsigned int numUsersPerCell = 2;
+                    const unsigned int numPRBs = 4;
+                    const unsigned int numAntennas = 4;
+
+                    wns::pyconfig::Parser config;
+                    config.loadString("import imtaphy.Pathloss\n"
+                                      "import imtaphy.SCM\n"
+                                      "import imtaphy.Logger\n"
+                                      "pathloss = imtaphy.Pathloss.M2135Pathloss()\n"
+                                      "scm = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"))\n");
+
+                    itpp::RNG_reset(4711);
+                    wns::simulator::getRNG()->seed(4711);
+
+                    imtaphy::Spectrum* spectrum = new imtaphy::Spectrum(2E09, 180000.0, numPRBs, numPRBs);
+                    imtaphy::tests::ChannelStub* world = new imtaphy::tests::ChannelStub();
+                    world->setSpectrum(spectrum);
+                    world->initTransmissionLists();
+
+                    imtaphy::LinkManagerStub* links = new imtaphy::LinkManagerStub();
+                    world->setLinkManager(links);
+                    world->setPathlossModel(new imtaphy::pathloss::M2135Pathloss(world, wns::pyconfig::View(config, "pathloss")));
+
+                    double wavelength = spectrum->getSystemCenterFrequencyWavelenghtMeters(imtaphy::Downlink);
+
+                    std::vector<imtaphy::tests::StationPhyStub*> baseStations;
+                    std::vector<imtaphy::tests::StationPhyStub*> mobiles;
+                    for (unsigned int c = 0; c < numCells; c++)
+                    {
+                        std::stringstream name;
+                        name << "BatchBS" << c;
+                        baseStations.push_back(imtaphy::tests::createStationStub(name.str(), wns::Position(200.0 * c, 0, 25), "BS", numAntennas, 0.5 * wavelength, 0, registry, world));
+                    }
+                    for (unsigned int m = 0; m < numCells * numUsersPerCell; m++)
+                    {
+                        std::stringstream name;
+                        name << "BatchMS" << m;
+                        mobiles.push_back(imtaphy::tests::createStationStub(name.str(), wns::Position(50.0 + 40.0 * m, 60, 1.5), "MS", numAntennas, 0.5 * wavelength, 3.0, registry, world));
+                    }
+
+                    std::vector<imtaphy::Link*> servingLinks(mobiles.size(), static_cast<imtaphy::Link*>(NULL));
+                    for (unsigned int m = 0; m < mobiles.size(); m++)
+                        for (unsigned int c = 0; c < numCells; c++)
+                        {
+                            imtaphy::Link* link = new imtaphy::LinkStub(baseStations[c], mobiles[m], imtaphy::Link::UMa, imtaphy::Link::NLoS, imtaphy::Link::NLoS,
+                                                                        imtaphy::Link::NotApplicable, mobiles[m]->getPosition(), wns::Ratio::from_dB(0.0), 0);
+                            links->addLink(link, true);
+                            if (c == m / numUsersPerCell)
+                                servingLinks[m] = link;
+                        }
+
+                    imtaphy::lsparams::LSCorrelation lsCorrelation(links->getAllLinks(), links, new imtaphy::lsparams::RandomMatrix());
+                    imtaphy::lsparams::LSmap* largeScaleParams = lsCorrelation.generateLSCorrelation();
+
+                    imtaphy::scm::m2135::M2135<float>* scm = new imtaphy::scm::m2135::M2135<float>(world, wns::pyconfig::View(config, "scm"));
+                    scm->onWorldCreated(links, largeScaleParams, false);
+                    world->setSpatialChannelModel(scm);
+
+                    imtaphy::LinkVector allLinks = links->getAllLinks();
+                    for (unsigned int i = 0; i < allLinks.size(); i++)
+                        allLinks[i]->initComplexFloatChannelMatrices<float>(spectrum, scm);
+                    scm->evolve(0.0);
+
+                    // the base stations receive the uplink, which does not need a feedback manager
+                    for (unsigned int c = 0; c < numCells; c++)
+                        baseStations[c]->getReceiver()->channelInitialized(world);
+
+                    // same power for the assumed own transmission and the interferers, so the SINRs are
+                    // limited by the other cell and not by the noise
+                    wns::Power txPower = wns::Power::from_dBm(10.0);
+                    imtaphy::detail::ComplexFloatMatrixPtr precoding(new imtaphy::detail::ComplexFloatMatrix(numAntennas, 1));
+                    for (unsigned int s = 0; s < numAntennas; s++)
+                        (*precoding)[s][0] = std::complex<float>(0.5, 0.0);
+
+                    // the users of a cell share its PRBs, so each PRB has one transmission per cell
+                    world->startTTI(1);
+                    for (unsigned int m = 0; m < mobiles.size(); m++)
+                    {
+                        imtaphy::interface::PrbPowerPrecodingMap prbMap;
+                        for (unsigned int prb = m % numUsersPerCell; prb < numPRBs; prb += numUsersPerCell)
+                        {
+                            imtaphy::interface::PowerAndPrecoding entry;
+                            entry.power = txPower;
+                            entry.precoding = precoding;
+                            prbMap[prb] = entry;
+                        }
+                        world->registerTransmission(TransmissionPtr(new Transmission(imtaphy::Uplink, std::vector<wns::ldk::CompoundPtr>(),
+                                                                                     servingLinks[m], mobiles[m], servingLinks[m]->getBS(),
+                                                                                     prbMap, numAntennas, 1)));
+                    }
+
+                    for (unsigned int m = 0; m < mobiles.size(); m++)
+                    {
+                        LinearReceiver* testee = dynamic_cast<LinearReceiver*>(servingLinks[m]->getBS()->getReceiver());
+                        CPPUNIT_ASSERT(testee);
+                        CPPUNIT_ASSERT(dynamic_cast<imtaphy::receivers::filters::MMSE*>(testee->filter));
+                        CPPUNIT_ASSERT_EQUAL(numAntennas, testee->numRxAntennas);
+
+                        for (unsigned int prb = m % numUsersPerCell; prb < numPRBs; prb += numUsersPerCell)
+                        {
+                            // like computeFeedback: everybody but the mobile itself interferes
+                            const LinearReceiver::InterferenceOnPRB& interference = testee->getInterferenceOnPRB(prb, LinearReceiver::ExcludeNode,
+                                                                                                                 TransmissionPtr(), mobiles[m]);
+                            CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(numCells - 1), interference.interferers->getInterferersSet().size());
+
+                            std::complex<float>* H = servingLinks[m]->getRawChannelMatrix(imtaphy::Uplink, prb);
+                            for (unsigned int rank = 1; rank <= numAntennas; rank++)
+                                checkCodebookSearch(testee, mobiles[m], prb, rank, H, txPower,
+                                                    *interference.perfectCovariance, interference.interferers);
+                        }
+                    }
+                }
+}}}
@@ -46,23 +46,107 @@ STATIC_FACTORY_REGISTER_WITH_CREATOR(
     wns::node::component::ConfigCreator);
 
 ChannelDumper::ChannelDumper(wns::node::Interface* _node, const wns::pyconfig::View& _pyco) : 
-    LteScanner(_node, _pyco)
+    LteScanner(_node, _pyco),
+    dump(_pyco.get<std::string>("format") == "binary",
+         _pyco.get<std::string>("fileName"),
+         trace::codecFromString(_pyco.get<std::string>("codec")),
+         _pyco.get<int>("compressionLevel"),
+         _pyco.get<bool>("backgroundWriter"))
 {
- 
+    assure((_pyco.get<std::string>("format") == "binary") || (_pyco.get<std::string>("format") == "matlab"),
+           "ChannelDumper format has to be 'binary' or 'matlab'");
 }
 
 
-// This is to be used in a pseudo mobile that simply writes the CIR of all links to a file
-// the file can be loaded into matlab by saying eval('CIRCTFdump')
+// This is to be used in a pseudo mobile that simply writes the CIR and CTF of all links to a file.
+// The binary trace (see ChannelTrace.hpp) can be read with trace::ChannelTraceReader or with
+// pywns.ChannelTrace, the MATLAB dump can be loaded into matlab by saying eval('CIRCTFdump')
 
 void 
 ChannelDumper::beforeTTIover(unsigned int tti)
 {
-    if (tti == 3) // start from TTI=3 because before we don't know how long this is going
+    dump.beforeTTIover(tti, numTTIs, channel->getSpatialChannelModel());
+}
+
+void
+ChannelDumper::onShutdown()
+{
+    dump.close();
+}
+
+ChannelDump::ChannelDump(bool _binary, const std::string& _fileName, trace::Codec _codec,
+                         int _compressionLevel, bool _backgroundWriter) :
+    binary(_binary),
+    fileName(_fileName),
+    codec(_codec),
+    compressionLevel(_compressionLevel),
+    backgroundWriter(_backgroundWriter),
+    closed(false)
+{
+}
+
+void
+ChannelDump::beforeTTIover(unsigned int tti, unsigned int numTTIs,
+                           imtaphy::scm::SpatialChannelModelInterface<SCMPRECISION>* scm)
+{
+    if (closed || (tti < firstTTI) || (tti >= numTTIs))
+        return;
+
+    if (tti == firstTTI)
+        layout = scm->getChannelLayout();
+
+    if (binary)
+        writeBinary(tti, scm);
+    else
+        writeMatlab(tti, numTTIs, scm);
+    
+    if (tti == numTTIs - 1)
+        close();
+}
+
+void
+ChannelDump::close()
+{
+    closed = true;
+
+    if (writer)
+        writer->close();
+    if (ff.is_open())
+        ff.close();
+}
+
+void
+ChannelDump::writeBinary(unsigned int tti, imtaphy::scm::SpatialChannelModelInterface<SCMPRECISION>* scm)
+{
+    if (tti == firstTTI)
+        writer.reset(new trace::ChannelTraceWriter(fileName, layout, codec, compressionLevel, backgroundWriter));
+
+    // fills the buffer while the background writer is still busy with the last frame
+    trace::Sample* cir = writer->beginFrame(tti);
+    for(unsigned int k=0; k < layout.K; k++)
+        for(unsigned int u=0; u < layout.U; u++)
+            for(unsigned int s=0; s < layout.S; s++)
+                for (unsigned int n = 0; n < layout.N; n++)
+                    *cir++ = scm->getCurrentCIR(k, imtaphy::Downlink, u, s, n);
+
+    trace::Sample* ctf = writer->getCTF();
+    for(unsigned int k=0; k < layout.K; k++)
+        for(unsigned int u=0; u < layout.U; u++)
+            for(unsigned int s=0; s < layout.S; s++)
+                for (unsigned int f = 0; f < layout.F[imtaphy::Downlink]; f++)
+                    *ctf++ = scm->getCurrentCTF(k, imtaphy::Downlink, u, s, f);
+
+    writer->commitFrame();
+}
+
+void
+ChannelDump::writeMatlab(unsigned int tti, unsigned int numTTIs,
+                         imtaphy::scm::SpatialChannelModelInterface<SCMPRECISION>* scm)
+{
+    if (tti == firstTTI)
     {
-        ff.open("CIRCTFdump.m");
+        ff.open(fileName.c_str());
         
-        layout = channel->getSpatialChannelModel()->getChannelLayout();
         ff << "K = " << layout.K                << ";\n";
         ff << "U = " << layout.U                << ";\n";
         ff << "S = " << layout.S                << ";\n";
@@ -73,51 +157,43 @@ ChannelDumper::beforeTTIover(unsigned int tti)
         ff << "CTF = zeros(K,U,S,F,T);\n";
     }
     
-    if (tti >= 3)
-    {        
-        for(unsigned int k=0; k < layout.K; k++)
-            for(unsigned int u=0; u < layout.U; u++)
-                for(unsigned int s=0; s < layout.S; s++)
-                    for (unsigned int n = 0; n < layout.N; n++)
-                    {
-                        ff  << "CIR("
-                            << k + 1
-                            << ", "
-                            << u + 1
-                            << ", "
-                            << s + 1
-                            << ", "
-                            << n + 1
-                            << ", "
-                            << tti - 2
-                            << ") = "
-                            << channel->getSpatialChannelModel()->getCurrentCIR(k, imtaphy::Downlink, u, s, n)
-                            << ";\n";
-                    }
-                    
-         for(unsigned int k=0; k < layout.K; k++)
-            for(unsigned int u=0; u < layout.U; u++)
-                for(unsigned int s=0; s < layout.S; s++)
-                    for (unsigned int f = 0; f < layout.F[0]; f++)
-                    {
-                        ff  << "CTF("
-                            << k + 1
-                            << ", "
-                            << u + 1
-                            << ", "
-                            << s + 1
-                            << ", "
-                            << f + 1
-                            << ", "
-                            << tti - 2
-                            << ") = "
-                            << channel->getSpatialChannelModel()->getCurrentCTF(k, imtaphy::Downlink, u, s, f)
-                            << ";\n";
-                    }
-                   
-    }
-    
-    if (tti > numTTIs - 2)
-        ff.close();
+    for(unsigned int k=0; k < layout.K; k++)
+        for(unsigned int u=0; u < layout.U; u++)
+            for(unsigned int s=0; s < layout.S; s++)
+                for (unsigned int n = 0; n < layout.N; n++)
+                {
+                    ff  << "CIR("
+                        << k + 1
+                        << ", "
+                        << u + 1
+                        << ", "
+                        << s + 1
+                        << ", "
+                        << n + 1
+                        << ", "
+                        << tti - 2
+                        << ") = "
+                        << scm->getCurrentCIR(k, imtaphy::Downlink, u, s, n)
+                        << ";\n";
+                }
+                
+     for(unsigned int k=0; k < layout.K; k++)
+        for(unsigned int u=0; u < layout.U; u++)
+            for(unsigned int s=0; s < layout.S; s++)
+                for (unsigned int f = 0; f < layout.F[0]; f++)
+                {
+                    ff  << "CTF("
+                        << k + 1
+                        << ", "
+                        << u + 1
+                        << ", "
+                        << s + 1
+                        << ", "
+                        << f + 1
+                        << ", "
+                        << tti - 2
+                        << ") = "
+                        << scm->getCurrentCTF(k, imtaphy::Downlink, u, s, f)
+                        << ";\n";
+                }
 }
-
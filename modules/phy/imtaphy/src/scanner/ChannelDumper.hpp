@@ -44,8 +44,50 @@
 #include <WNS/evaluation/statistics/moments.hpp>
 
 #include <IMTAPHY/spatialChannel/SpatialChannelModelInterface.hpp>
+#include <IMTAPHY/scanner/ChannelTrace.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <fstream>
 
 namespace imtaphy { namespace scanner {
+
+        // Writes the downlink channel of the TTIs firstTTI..numTTIs-1 either as a binary trace
+        // (see ChannelTrace.hpp) or as a MATLAB script. The channel keeps calling beforeTTIover
+        // after numTTIs, those TTIs are ignored. Kept apart from the ChannelDumper component so
+        // that it can be driven without the channel singleton.
+        class ChannelDump
+        {
+        public:
+            // start from TTI=3 because before we don't know how long this is going
+            static const unsigned int firstTTI = 3;
+
+            ChannelDump(bool binary, const std::string& fileName, trace::Codec codec,
+                        int compressionLevel, bool backgroundWriter);
+
+            void beforeTTIover(unsigned int tti, unsigned int numTTIs,
+                               imtaphy::scm::SpatialChannelModelInterface<SCMPRECISION>* scm);
+
+            // idempotent
+            void close();
+
+            bool isClosed() const {return closed;}
+
+        private:
+            void writeMatlab(unsigned int tti, unsigned int numTTIs,
+                             imtaphy::scm::SpatialChannelModelInterface<SCMPRECISION>* scm);
+            void writeBinary(unsigned int tti,
+                             imtaphy::scm::SpatialChannelModelInterface<SCMPRECISION>* scm);
+
+            bool binary;
+            std::string fileName;
+            trace::Codec codec;
+            int compressionLevel;
+            bool backgroundWriter;
+            bool closed;
+
+            std::ofstream ff;
+            boost::scoped_ptr<trace::ChannelTraceWriter> writer;
+            imtaphy::scm::ChannelLayout layout;
+        };
     
         class ChannelDumper :
             public LteScanner
@@ -56,11 +98,13 @@ namespace imtaphy { namespace scanner {
             // LTEPhyObserver interface
 	    void onNewTTI(unsigned int ttiNumber) {};
             void beforeTTIover(unsigned int ttiNumber);
+
+            void onShutdown();
         
         private:
             void initProbes() {}; // no probes for dumper
-            std::ofstream ff;
-            imtaphy::scm::ChannelLayout layout;
+
+            ChannelDump dump;
         };
     
     
@@ -0,0 +1,474 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <IMTAPHY/scanner/ChannelTrace.hpp>
+#include <WNS/Assure.hpp>
+#include <WNS/Exception.hpp>
+
+#ifdef IMTAPHY_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+
+using namespace imtaphy::scanner::trace;
+
+namespace {
+    const char fileMagic[8] = {'I', 'M', 'T', 'A', 'T', 'R', 'C', 0};
+    const boost::uint32_t frameMagic = 0x454d5246; // "FRME"
+    const unsigned int sampleBytes = sizeof(Sample);
+
+    inline unsigned int padding(unsigned int bytes)
+    {
+        return (8 - bytes % 8) % 8;
+    }
+
+    // the destructor does not run for a constructor that throws, so the file is closed here
+    void
+    throwTraceError(FILE* file, const std::string& message)
+    {
+        if (file != NULL)
+            fclose(file);
+        throw wns::Exception(message);
+    }
+}
+
+Codec
+imtaphy::scanner::trace::codecFromString(const std::string& name)
+{
+    if (name == "none")
+        return NoCompression;
+    if (name == "deflate")
+        return Deflate;
+
+    assure(false, "Unknown channel trace codec " << name << ", use 'none' or 'deflate'");
+    return NoCompression;
+}
+
+bool
+imtaphy::scanner::trace::codecAvailable(Codec codec)
+{
+#ifdef IMTAPHY_HAVE_ZLIB
+    return (codec == NoCompression) || (codec == Deflate);
+#else
+    return codec == NoCompression;
+#endif
+}
+
+ChannelTraceWriter::ChannelTraceWriter(const std::string& fileName,
+                                       const imtaphy::scm::ChannelLayout& layout,
+                                       Codec _codec,
+                                       int _compressionLevel,
+                                       bool backgroundWriter) :
+    file(NULL),
+    codec(_codec),
+    compressionLevel(_compressionLevel),
+    background(backgroundWriter),
+    numCIRSamples(layout.K * layout.U * layout.S * layout.N),
+    numSamples(samplesPerFrame(layout)),
+    current(0),
+    slotFull(false),
+    slot(0),
+    stopping(false),
+    closed(false),
+    bytesWritten(0)
+{
+    assure(codecAvailable(codec), "Channel trace codec not available, IMTAphy has been built without zlib");
+
+    file = fopen(fileName.c_str(), "wb");
+    if (file == NULL)
+        throwTraceError(NULL, "Could not open channel trace file " + fileName + " for writing");
+    // large stdio buffer, the writes per frame are big anyway
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    memset(&header, 0, sizeof(FileHeader));
+    memcpy(header.magic, fileMagic, sizeof(fileMagic));
+    header.version = formatVersion;
+    header.byteOrder = byteOrderMark;
+    header.K = layout.K;
+    header.U = layout.U;
+    header.S = layout.S;
+    header.N = layout.N;
+    header.F = layout.F[imtaphy::Downlink];
+    header.codec = codec;
+    writeBytes(&header, sizeof(FileHeader));
+
+    for (unsigned int b = 0; b < 2; b++)
+        buffers[b].samples.resize(numSamples);
+
+    pthread_mutex_init(&mutex, 0);
+    pthread_cond_init(&slotChanged, 0);
+    if (background)
+        pthread_create(&thread, 0, ChannelTraceWriter::writerThread, this);
+}
+
+ChannelTraceWriter::~ChannelTraceWriter()
+{
+    close();
+    pthread_cond_destroy(&slotChanged);
+    pthread_mutex_destroy(&mutex);
+}
+
+Sample*
+ChannelTraceWriter::beginFrame(unsigned int tti)
+{
+    assure(!closed, "Channel trace has already been closed");
+    buffers[current].tti = tti;
+    return getCIR();
+}
+
+void
+ChannelTraceWriter::commitFrame()
+{
+    if (!background)
+    {
+        writeFrame(buffers[current]);
+        return;
+    }
+
+    // wait until the writer is done with the previous frame, i.e. with the other buffer
+    pthread_mutex_lock(&mutex);
+    while (slotFull)
+        pthread_cond_wait(&slotChanged, &mutex);
+    slot = current;
+    slotFull = true;
+    pthread_cond_broadcast(&slotChanged);
+    pthread_mutex_unlock(&mutex);
+
+    current = 1 - current;
+}
+
+void*
+ChannelTraceWriter::writerThread(void* arg)
+{
+    ChannelTraceWriter* writer = static_cast<ChannelTraceWriter*>(arg);
+
+    while (true)
+    {
+        pthread_mutex_lock(&writer->mutex);
+        while (!writer->slotFull && !writer->stopping)
+            pthread_cond_wait(&writer->slotChanged, &writer->mutex);
+        if (!writer->slotFull)
+        {
+            // stopping and nothing left to write
+            pthread_mutex_unlock(&writer->mutex);
+            break;
+        }
+        unsigned int b = writer->slot;
+        pthread_mutex_unlock(&writer->mutex);
+
+        writer->writeFrame(writer->buffers[b]);
+
+        pthread_mutex_lock(&writer->mutex);
+        writer->slotFull = false;
+        pthread_cond_broadcast(&writer->slotChanged);
+        pthread_mutex_unlock(&writer->mutex);
+    }
+    return NULL;
+}
+
+void
+ChannelTraceWriter::writeFrame(const Frame& frame)
+{
+    unsigned int rawBytes = numSamples * sampleBytes;
+    const unsigned char* payload = reinterpret_cast<const unsigned char*>(&frame.samples[0]);
+    unsigned int storedBytes = rawBytes;
+
+#ifdef IMTAPHY_HAVE_ZLIB
+    if (codec == Deflate)
+    {
+        // byte shuffle: all first bytes of the floats, then all second bytes, ...
+        unsigned int numFloats = 2 * numSamples;
+        shuffled.resize(rawBytes);
+        for (unsigned int b = 0; b < sizeof(float); b++)
+        {
+            unsigned char* out = &shuffled[b * numFloats];
+            for (unsigned int i = 0; i < numFloats; i++)
+                out[i] = payload[i * sizeof(float) + b];
+        }
+
+        uLongf compressedBytes = compressBound(rawBytes);
+        compressed.resize(compressedBytes);
+        int status = compress2(&compressed[0], &compressedBytes, &shuffled[0], rawBytes, compressionLevel);
+        assure(status == Z_OK, "zlib failed to compress a channel trace frame");
+
+        payload = &compressed[0];
+        storedBytes = compressedBytes;
+    }
+#endif
+
+    IndexEntry entry;
+    entry.offset = bytesWritten;
+    entry.tti = frame.tti;
+    entry.storedBytes = storedBytes;
+    index.push_back(entry);
+
+    FrameHeader frameHeader;
+    frameHeader.magic = frameMagic;
+    frameHeader.tti = frame.tti;
+    frameHeader.rawBytes = rawBytes;
+    frameHeader.storedBytes = storedBytes;
+
+    static const unsigned char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    writeBytes(&frameHeader, sizeof(FrameHeader));
+    writeBytes(payload, storedBytes);
+    writeBytes(zeros, padding(storedBytes));
+}
+
+void
+ChannelTraceWriter::writeBytes(const void* data, unsigned int bytes)
+{
+    if (bytes == 0)
+        return;
+    size_t written = fwrite(data, 1, bytes, file);
+    assure(written == bytes, "Writing the channel trace failed");
+    bytesWritten += bytes;
+}
+
+void
+ChannelTraceWriter::close()
+{
+    if (closed)
+        return;
+
+    if (background)
+    {
+        pthread_mutex_lock(&mutex);
+        stopping = true;
+        pthread_cond_broadcast(&slotChanged);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(thread, NULL);
+    }
+
+    header.indexOffset = bytesWritten;
+    header.numFrames = index.size();
+    if (!index.empty())
+        writeBytes(&index[0], index.size() * sizeof(IndexEntry));
+
+    fseeko(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(FileHeader), 1, file);
+    fclose(file);
+    file = NULL;
+    closed = true;
+}
+
+ChannelTraceReader::ChannelTraceReader(const std::string& fileName, bool memoryMapped) :
+    file(NULL),
+    map(NULL),
+    mapBytes(0)
+{
+    // the trace is user input, so it is checked in opt builds, too
+    file = fopen(fileName.c_str(), "rb");
+    if (file == NULL)
+        throwTraceError(NULL, "Could not open channel trace file " + fileName);
+
+    std::stringstream message;
+    size_t headerRead = fread(&header, sizeof(FileHeader), 1, file);
+    if (headerRead != 1)
+        message << "Channel trace " << fileName << " is truncated";
+    else if (memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0)
+        message << fileName << " is not a channel trace";
+    else if (header.version != formatVersion)
+        message << "Unsupported channel trace version " << header.version << " in " << fileName;
+    else if (header.byteOrder != byteOrderMark)
+        message << "Channel trace " << fileName << " was written with a different byte order";
+    else if (header.indexOffset == 0)
+        message << "Channel trace " << fileName << " has not been closed properly";
+    else if (!codecAvailable(getCodec()))
+        message << "Channel trace codec not available, IMTAphy has been built without zlib";
+
+    if (!message.str().empty())
+        throwTraceError(file, message.str());
+
+    layout.K = header.K;
+    layout.U = header.U;
+    layout.S = header.S;
+    layout.N = header.N;
+    layout.F[imtaphy::Downlink] = header.F;
+    layout.F[imtaphy::Uplink] = 0;
+    numSamples = samplesPerFrame(layout);
+
+    index.resize(header.numFrames);
+    if (!index.empty())
+        readBytes(header.indexOffset, &index[0], index.size() * sizeof(IndexEntry));
+
+    if (memoryMapped)
+    {
+        struct stat fileStatus;
+        fstat(fileno(file), &fileStatus);
+        mapBytes = fileStatus.st_size;
+
+        void* mapping = mmap(NULL, mapBytes, PROT_READ, MAP_SHARED, fileno(file), 0);
+        if (mapping == MAP_FAILED)
+            throwTraceError(file, "Could not memory map channel trace " + fileName);
+        map = static_cast<const unsigned char*>(mapping);
+
+        // the mapping stays valid after closing the file
+        fclose(file);
+        file = NULL;
+    }
+
+    frameBuffer.resize(numSamples);
+}
+
+ChannelTraceReader::~ChannelTraceReader()
+{
+    if (map)
+        munmap(const_cast<unsigned char*>(map), mapBytes);
+    if (file)
+        fclose(file);
+}
+
+const Sample*
+ChannelTraceReader::readFrame(unsigned int frame)
+{
+    assure(frame < index.size(), "Invalid channel trace frame");
+
+    // uncompressed frames can be used in place
+    if (map && (getCodec() == NoCompression))
+        return reinterpret_cast<const Sample*>(map + index[frame].offset + sizeof(FrameHeader));
+
+    readFrame(frame, &frameBuffer[0]);
+    return &frameBuffer[0];
+}
+
+unsigned int
+ChannelTraceReader::findFrame(unsigned int tti) const
+{
+    // the frames are recorded in TTI order
+    unsigned int lower = 0;
+    unsigned int upper = index.size();
+    while (lower < upper)
+    {
+        unsigned int middle = (lower + upper) / 2;
+        if (index[middle].tti < tti)
+            lower = middle + 1;
+        else
+            upper = middle;
+    }
+    return lower;
+}
+
+unsigned int
+ChannelTraceReader::willNeed(unsigned int firstFrame, unsigned int numFrames) const
+{
+    if ((firstFrame >= index.size()) || (numFrames == 0))
+        return 0;
+    unsigned int lastFrame = std::min<unsigned int>(firstFrame + numFrames, index.size()) - 1;
+
+    boost::uint64_t begin = index[firstFrame].offset;
+    boost::uint64_t end = index[lastFrame].offset + sizeof(FrameHeader) + index[lastFrame].storedBytes;
+
+    if (map)
+    {
+        // madvise needs a page aligned start address
+        boost::uint64_t pageSize = sysconf(_SC_PAGESIZE);
+        boost::uint64_t alignedBegin = begin - begin % pageSize;
+        madvise(const_cast<unsigned char*>(map) + alignedBegin, end - alignedBegin, MADV_WILLNEED);
+    }
+    else
+    {
+        posix_fadvise(fileno(file), begin, end - begin, POSIX_FADV_WILLNEED);
+    }
+    return lastFrame - firstFrame + 1;
+}
+
+void
+ChannelTraceReader::readFrame(unsigned int frame, Sample* target) const
+{
+    assure(frame < index.size(), "Invalid channel trace frame");
+    const IndexEntry& entry = index[frame];
+
+    FrameHeader frameHeader;
+    readBytes(entry.offset, &frameHeader, sizeof(FrameHeader));
+    assure(frameHeader.magic == frameMagic, "Corrupt channel trace frame " << frame);
+    assure(frameHeader.rawBytes == numSamples * sampleBytes, "Channel trace frame " << frame << " has the wrong size");
+
+    if (map)
+    {
+        decode(map + entry.offset + sizeof(FrameHeader), entry.storedBytes, target);
+    }
+    else
+    {
+        storedBuffer.resize(entry.storedBytes);
+        readBytes(entry.offset + sizeof(FrameHeader), &storedBuffer[0], entry.storedBytes);
+        decode(&storedBuffer[0], entry.storedBytes, target);
+    }
+}
+
+void
+ChannelTraceReader::readBytes(boost::uint64_t offset, void* target, unsigned int bytes) const
+{
+    if (map)
+    {
+        assure(offset + bytes <= mapBytes, "Channel trace is truncated");
+        memcpy(target, map + offset, bytes);
+        return;
+    }
+
+    fseeko(file, offset, SEEK_SET);
+    size_t read = fread(target, 1, bytes, file);
+    assure(read == bytes, "Channel trace is truncated");
+}
+
+void
+ChannelTraceReader::decode(const unsigned char* stored, unsigned int storedBytes, Sample* target) const
+{
+    unsigned int rawBytes = numSamples * sampleBytes;
+
+    if (getCodec() == NoCompression)
+    {
+        assure(storedBytes == rawBytes, "Channel trace frame has the wrong size");
+        memcpy(target, stored, rawBytes);
+        return;
+    }
+
+#ifdef IMTAPHY_HAVE_ZLIB
+    std::vector<unsigned char> shuffled(rawBytes);
+    uLongf uncompressedBytes = rawBytes;
+    int status = uncompress(&shuffled[0], &uncompressedBytes, stored, storedBytes);
+    assure((status == Z_OK) && (uncompressedBytes == rawBytes), "zlib failed to decompress a channel trace frame");
+
+    unsigned int numFloats = 2 * numSamples;
+    unsigned char* out = reinterpret_cast<unsigned char*>(target);
+    for (unsigned int b = 0; b < sizeof(float); b++)
+    {
+        const unsigned char* in = &shuffled[b * numFloats];
+        for (unsigned int i = 0; i < numFloats; i++)
+            out[i * sizeof(float) + b] = in[i];
+    }
+#endif
+}
@@ -0,0 +1,269 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef IMTAPHY_SCANNER_CHANNELTRACE_HPP
+#define IMTAPHY_SCANNER_CHANNELTRACE_HPP
+
+#include <IMTAPHY/spatialChannel/SpatialChannelModelInterface.hpp>
+
+#include <boost/cstdint.hpp>
+#include <pthread.h>
+#include <complex>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+namespace imtaphy { namespace scanner { namespace trace {
+
+    // Binary channel trace with one frame of CIR/CTF snapshots per TTI. Layout on disk
+    // (native little endian, every block a multiple of 8 bytes so that an uncompressed
+    // payload can be used in place from a memory mapping):
+    //
+    //   FileHeader
+    //   frame 0: FrameHeader, payload (storedBytes, padded to 8 bytes)
+    //   frame 1: ...
+    //   IndexEntry[numFrames]       (written on close, located by FileHeader::indexOffset)
+    //
+    // An uncompressed payload holds K*U*S*N CIR samples followed by K*U*S*F CTF samples
+    // (std::complex<float>, row-major with the last index running fastest, i.e. the same order
+    // as the loops of the old MATLAB dump). The Deflate codec byte-shuffles the payload
+    // (all first bytes of the floats, then all second bytes, ...) before compressing it with
+    // zlib, which compresses floating point data much better than plain deflate.
+    // framework/pywns/pywns/ChannelTrace.py reads the same format with numpy.
+
+    enum Codec
+    {
+        NoCompression = 0,
+        Deflate = 1
+    };
+
+    Codec
+    codecFromString(const std::string& name);
+
+    bool
+    codecAvailable(Codec codec);
+
+    static const boost::uint32_t formatVersion = 1;
+    static const boost::uint32_t byteOrderMark = 0x01020304;
+
+    struct FileHeader
+    {
+        char magic[8];               // "IMTATRC"
+        boost::uint32_t version;
+        boost::uint32_t byteOrder;
+        boost::uint32_t K;
+        boost::uint32_t U;
+        boost::uint32_t S;
+        boost::uint32_t N;
+        boost::uint32_t F;
+        boost::uint32_t codec;
+        boost::uint32_t numFrames;   // 0 until the trace has been closed
+        boost::uint32_t reserved;
+        boost::uint64_t indexOffset; // 0 until the trace has been closed
+    };
+
+    struct FrameHeader
+    {
+        boost::uint32_t magic;       // "FRME"
+        boost::uint32_t tti;
+        boost::uint32_t rawBytes;
+        boost::uint32_t storedBytes;
+    };
+
+    struct IndexEntry
+    {
+        boost::uint64_t offset;      // of the FrameHeader
+        boost::uint32_t tti;
+        boost::uint32_t storedBytes;
+    };
+
+    typedef std::complex<float> Sample;
+
+    inline unsigned int
+    samplesPerFrame(const imtaphy::scm::ChannelLayout& layout)
+    {
+        return layout.K * layout.U * layout.S * (layout.N + layout.F[imtaphy::Downlink]);
+    }
+
+    // Writes a trace. The producer fills the buffer returned by beginFrame and hands it over
+    // with commitFrame. With a background writer, compression and file I/O of that frame run
+    // on a separate thread while the producer fills the other of the two buffers; commitFrame
+    // only blocks if the writer is still busy with the frame before.
+    class ChannelTraceWriter
+    {
+    public:
+        ChannelTraceWriter(const std::string& fileName,
+                           const imtaphy::scm::ChannelLayout& layout,
+                           Codec codec,
+                           int compressionLevel,
+                           bool backgroundWriter);
+
+        ~ChannelTraceWriter();
+
+        // K*U*S*N CIR samples followed by K*U*S*F CTF samples
+        Sample*
+        beginFrame(unsigned int tti);
+
+        Sample*
+        getCIR() {return buffers[current].samples.empty() ? NULL : &buffers[current].samples[0];}
+
+        Sample*
+        getCTF() {return getCIR() + numCIRSamples;}
+
+        void
+        commitFrame();
+
+        // waits for the writer, appends the index and finalizes the header; idempotent
+        void
+        close();
+
+        unsigned int
+        getNumFrames() const {return index.size();}
+
+        unsigned long long int
+        getBytesWritten() const {return bytesWritten;}
+
+    private:
+        struct Frame
+        {
+            unsigned int tti;
+            std::vector<Sample> samples;
+        };
+
+        static void*
+        writerThread(void* arg);
+
+        void
+        writeFrame(const Frame& frame);
+
+        void
+        writeBytes(const void* data, unsigned int bytes);
+
+        FILE* file;
+        FileHeader header;
+        Codec codec;
+        int compressionLevel;
+        bool background;
+        unsigned int numCIRSamples;
+        unsigned int numSamples;
+
+        Frame buffers[2];
+        unsigned int current;
+
+        // hand-over slot between producer and writer thread
+        pthread_t thread;
+        pthread_mutex_t mutex;
+        pthread_cond_t slotChanged;
+        bool slotFull;
+        unsigned int slot;
+        bool stopping;
+        bool closed;
+
+        std::vector<unsigned char> shuffled;
+        std::vector<unsigned char> compressed;
+        std::vector<IndexEntry> index;
+        unsigned long long int bytesWritten;
+    };
+
+    // Random access to the frames of a closed trace, either through stdio reads or by memory
+    // mapping the whole file. With the mapping, uncompressed frames are returned in place
+    // without any copy.
+    class ChannelTraceReader
+    {
+    public:
+        ChannelTraceReader(const std::string& fileName, bool memoryMapped);
+
+        ~ChannelTraceReader();
+
+        const imtaphy::scm::ChannelLayout&
+        getChannelLayout() const {return layout;}
+
+        Codec
+        getCodec() const {return static_cast<Codec>(header.codec);}
+
+        unsigned int
+        getNumFrames() const {return index.size();}
+
+        unsigned int
+        getTTI(unsigned int frame) const {return index[frame].tti;}
+
+        // returns the samples of the frame (CIR followed by CTF), valid until the next call
+        const Sample*
+        readFrame(unsigned int frame);
+
+        // index of the first frame recorded at or after tti, getNumFrames() if there is none
+        unsigned int
+        findFrame(unsigned int tti) const;
+
+        // asks the kernel to start reading the given frames (clipped to the trace) in the background,
+        // returns the number of frames it asked for
+        unsigned int
+        willNeed(unsigned int firstFrame, unsigned int numFrames) const;
+
+        // decodes the frame into a caller-owned buffer of samplesPerFrame(layout) samples,
+        // safe to call concurrently with readFrame calls for other frames in mmap mode
+        void
+        readFrame(unsigned int frame, Sample* target) const;
+
+        static std::complex<float>
+        cir(const Sample* frame, const imtaphy::scm::ChannelLayout& layout,
+            unsigned int k, unsigned int u, unsigned int s, unsigned int n)
+        {
+            return frame[((k * layout.U + u) * layout.S + s) * layout.N + n];
+        }
+
+        static std::complex<float>
+        ctf(const Sample* frame, const imtaphy::scm::ChannelLayout& layout,
+            unsigned int k, unsigned int u, unsigned int s, unsigned int f)
+        {
+            return frame[layout.K * layout.U * layout.S * layout.N
+                         + ((k * layout.U + u) * layout.S + s) * layout.F[imtaphy::Downlink] + f];
+        }
+
+    private:
+        void
+        readBytes(boost::uint64_t offset, void* target, unsigned int bytes) const;
+
+        void
+        decode(const unsigned char* stored, unsigned int storedBytes, Sample* target) const;
+
+        FILE* file;
+        const unsigned char* map;
+        unsigned long long int mapBytes;
+        FileHeader header;
+        imtaphy::scm::ChannelLayout layout;
+        unsigned int numSamples;
+        std::vector<IndexEntry> index;
+        std::vector<Sample> frameBuffer;
+        mutable std::vector<unsigned char> storedBuffer;
+    };
+
+}}}
+
+#endif
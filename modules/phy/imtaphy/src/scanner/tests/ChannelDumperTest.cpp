@@ -0,0 +1,194 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <IMTAPHY/scanner/ChannelDumper.hpp>
+#include <WNS/pyconfig/Parser.hpp>
+
+#include <cstdio>
+
+namespace imtaphy { namespace scanner { namespace tests {
+
+    // channel model whose CIR/CTF encode the TTI it was last "evolved" to
+    class SCMStub :
+        public imtaphy::scm::SpatialChannelModelInterface<SCMPRECISION>
+    {
+    public:
+        SCMStub() :
+            imtaphy::scm::SpatialChannelModelInterface<SCMPRECISION>(NULL, wns::pyconfig::Parser()),
+            tti(0)
+        {
+            layout.K = 2;
+            layout.U = 2;
+            layout.S = 3;
+            layout.N = 4;
+            layout.F[imtaphy::Downlink] = 5;
+            layout.F[imtaphy::Uplink] = 5;
+        }
+
+        void onWorldCreated(LinkManager*, lsparams::LSmap*, bool) {}
+
+        imtaphy::scm::ChannelLayout getChannelLayout() {return layout;}
+
+        std::complex<SCMPRECISION> getCurrentCIR(unsigned int k, imtaphy::Direction, unsigned int u, unsigned int s, int n)
+        {
+            return std::complex<SCMPRECISION>(tti, ((k * layout.U + u) * layout.S + s) * layout.N + n);
+        }
+
+        std::complex<SCMPRECISION> getCurrentCTF(unsigned int k, imtaphy::Direction, unsigned int u, unsigned int s, unsigned int f)
+        {
+            return std::complex<SCMPRECISION>(-static_cast<SCMPRECISION>(tti), ((k * layout.U + u) * layout.S + s) * layout.F[imtaphy::Downlink] + f);
+        }
+
+        boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<SCMPRECISION> > >
+        getChannelMatrix(imtaphy::Link*, imtaphy::Direction, unsigned int)
+        {
+            return boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<SCMPRECISION> > >();
+        }
+
+        void evolve(double t) {tti = static_cast<unsigned int>(t);}
+
+        imtaphy::scm::ChannelLayout layout;
+        unsigned int tti;
+    };
+
+    class ChannelDumperTest :
+        public CppUnit::TestFixture
+    {
+        CPPUNIT_TEST_SUITE( ChannelDumperTest );
+        CPPUNIT_TEST( beyondLastTTI );
+        CPPUNIT_TEST( beyondLastTTIBackground );
+        CPPUNIT_TEST( closeBeforeLastTTI );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        void beyondLastTTI();
+        void beyondLastTTIBackground();
+        void closeBeforeLastTTI();
+
+    private:
+        void run(bool background);
+
+        std::string fileName;
+        unsigned int numTTIs;
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( ChannelDumperTest );
+
+    void
+    ChannelDumperTest::setUp()
+    {
+        fileName = "ChannelDumperTest.trc";
+        numTTIs = 12;
+    }
+
+    void
+    ChannelDumperTest::tearDown()
+    {
+        std::remove(fileName.c_str());
+    }
+
+    void
+    ChannelDumperTest::run(bool background)
+    {
+        SCMStub scm;
+        ChannelDump dump(true, fileName, trace::NoCompression, 1, background);
+
+        // the channel goes on calling beforeTTIover after the last dumped TTI numTTIs - 1
+        for (unsigned int tti = 1; tti <= numTTIs + 2; tti++)
+        {
+            scm.evolve(tti);
+            dump.beforeTTIover(tti, numTTIs, &scm);
+            CPPUNIT_ASSERT_EQUAL(tti >= numTTIs - 1, dump.isClosed());
+        }
+        dump.close();
+
+        unsigned int firstTTI = ChannelDump::firstTTI;
+        trace::ChannelTraceReader reader(fileName, false);
+        CPPUNIT_ASSERT_EQUAL(numTTIs - firstTTI, reader.getNumFrames());
+        CPPUNIT_ASSERT_EQUAL(firstTTI, reader.getTTI(0));
+        CPPUNIT_ASSERT_EQUAL(numTTIs - 1, reader.getTTI(reader.getNumFrames() - 1));
+
+        const imtaphy::scm::ChannelLayout& layout = reader.getChannelLayout();
+        for (unsigned int frame = 0; frame < reader.getNumFrames(); frame++)
+        {
+            const trace::Sample* samples = reader.readFrame(frame);
+            SCMPRECISION tti = frame + firstTTI;
+
+            for (unsigned int k = 0; k < layout.K; k++)
+                for (unsigned int u = 0; u < layout.U; u++)
+                    for (unsigned int s = 0; s < layout.S; s++)
+                    {
+                        for (unsigned int n = 0; n < layout.N; n++)
+                            CPPUNIT_ASSERT_EQUAL(tti, trace::ChannelTraceReader::cir(samples, layout, k, u, s, n).real());
+                        for (unsigned int f = 0; f < layout.F[imtaphy::Downlink]; f++)
+                            CPPUNIT_ASSERT_EQUAL(-tti, trace::ChannelTraceReader::ctf(samples, layout, k, u, s, f).real());
+                    }
+        }
+    }
+
+    void
+    ChannelDumperTest::beyondLastTTI()
+    {
+        run(false);
+    }
+
+    void
+    ChannelDumperTest::beyondLastTTIBackground()
+    {
+        run(true);
+    }
+
+    void
+    ChannelDumperTest::closeBeforeLastTTI()
+    {
+        // e.g., the simulation is shut down early
+        SCMStub scm;
+        ChannelDump dump(true, fileName, trace::NoCompression, 1, true);
+
+        for (unsigned int tti = 1; tti <= 5; tti++)
+        {
+            scm.evolve(tti);
+            dump.beforeTTIover(tti, numTTIs, &scm);
+        }
+        dump.close();
+        dump.beforeTTIover(6, numTTIs, &scm);
+        dump.close();
+
+        trace::ChannelTraceReader reader(fileName, false);
+        CPPUNIT_ASSERT_EQUAL(3U, reader.getNumFrames());
+        CPPUNIT_ASSERT_EQUAL(5U, reader.getTTI(2));
+    }
+
+}}}
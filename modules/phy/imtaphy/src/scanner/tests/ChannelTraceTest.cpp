@@ -0,0 +1,220 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <IMTAPHY/scanner/ChannelTrace.hpp>
+#include <WNS/Exception.hpp>
+
+#include <cmath>
+#include <cstdio>
+
+namespace imtaphy { namespace scanner { namespace trace { namespace tests {
+
+    class ChannelTraceTest :
+        public CppUnit::TestFixture
+    {
+        CPPUNIT_TEST_SUITE( ChannelTraceTest );
+        CPPUNIT_TEST( roundTrip );
+        CPPUNIT_TEST( roundTripBackground );
+        CPPUNIT_TEST( roundTripDeflate );
+        CPPUNIT_TEST( memoryMapped );
+        CPPUNIT_TEST( findFrame );
+        CPPUNIT_TEST( invalidFile );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        void roundTrip();
+        void roundTripBackground();
+        void roundTripDeflate();
+        void memoryMapped();
+        void findFrame();
+        void invalidFile();
+
+    private:
+        static Sample sample(unsigned int frame, unsigned int i)
+        {
+            return Sample(std::sin(0.01 * i + frame), std::cos(0.003 * i * frame));
+        }
+
+        void write(Codec codec, bool background);
+        void check(bool memoryMapped);
+
+        std::string fileName;
+        imtaphy::scm::ChannelLayout layout;
+        unsigned int numFrames;
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( ChannelTraceTest );
+
+    void
+    ChannelTraceTest::setUp()
+    {
+        fileName = "ChannelTraceTest.trc";
+        layout.K = 3;
+        layout.U = 2;
+        layout.S = 4;
+        layout.N = 20;
+        layout.F[imtaphy::Downlink] = 6;
+        layout.F[imtaphy::Uplink] = 6;
+        numFrames = 10;
+    }
+
+    void
+    ChannelTraceTest::tearDown()
+    {
+        std::remove(fileName.c_str());
+    }
+
+    void
+    ChannelTraceTest::write(Codec codec, bool background)
+    {
+        ChannelTraceWriter writer(fileName, layout, codec, 1, background);
+        for (unsigned int frame = 0; frame < numFrames; frame++)
+        {
+            Sample* samples = writer.beginFrame(frame + 3);
+            for (unsigned int i = 0; i < samplesPerFrame(layout); i++)
+                samples[i] = sample(frame, i);
+            writer.commitFrame();
+        }
+        writer.close();
+        CPPUNIT_ASSERT_EQUAL(numFrames, writer.getNumFrames());
+    }
+
+    void
+    ChannelTraceTest::check(bool memoryMapped)
+    {
+        ChannelTraceReader reader(fileName, memoryMapped);
+        CPPUNIT_ASSERT_EQUAL(numFrames, reader.getNumFrames());
+        CPPUNIT_ASSERT_EQUAL(layout.K, reader.getChannelLayout().K);
+        CPPUNIT_ASSERT_EQUAL(layout.N, reader.getChannelLayout().N);
+        CPPUNIT_ASSERT_EQUAL(layout.F[imtaphy::Downlink], reader.getChannelLayout().F[imtaphy::Downlink]);
+
+        // random access in reverse order
+        for (int frame = numFrames - 1; frame >= 0; frame--)
+        {
+            CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(frame + 3), reader.getTTI(frame));
+            const Sample* samples = reader.readFrame(frame);
+            for (unsigned int i = 0; i < samplesPerFrame(layout); i++)
+                CPPUNIT_ASSERT(samples[i] == sample(frame, i));
+
+            unsigned int numCIRSamples = layout.K * layout.U * layout.S * layout.N;
+            CPPUNIT_ASSERT(ChannelTraceReader::cir(samples, layout, 2, 1, 3, 7) ==
+                           sample(frame, ((2 * layout.U + 1) * layout.S + 3) * layout.N + 7));
+            CPPUNIT_ASSERT(ChannelTraceReader::ctf(samples, layout, 1, 0, 2, 5) ==
+                           sample(frame, numCIRSamples + ((1 * layout.U + 0) * layout.S + 2) * layout.F[imtaphy::Downlink] + 5));
+        }
+    }
+
+    void
+    ChannelTraceTest::roundTrip()
+    {
+        write(NoCompression, false);
+        check(false);
+    }
+
+    void
+    ChannelTraceTest::roundTripBackground()
+    {
+        write(NoCompression, true);
+        check(false);
+    }
+
+    void
+    ChannelTraceTest::roundTripDeflate()
+    {
+        if (!codecAvailable(Deflate))
+            return;
+
+        write(Deflate, true);
+        check(false);
+        check(true);
+    }
+
+    void
+    ChannelTraceTest::memoryMapped()
+    {
+        write(NoCompression, true);
+        check(true);
+    }
+
+    void
+    ChannelTraceTest::findFrame()
+    {
+        write(NoCompression, false);
+        ChannelTraceReader reader(fileName, true);
+
+        // frames were recorded in TTIs 3..12
+        CPPUNIT_ASSERT_EQUAL(0U, reader.findFrame(0));
+        CPPUNIT_ASSERT_EQUAL(0U, reader.findFrame(3));
+        CPPUNIT_ASSERT_EQUAL(4U, reader.findFrame(7));
+        CPPUNIT_ASSERT_EQUAL(9U, reader.findFrame(12));
+        CPPUNIT_ASSERT_EQUAL(numFrames, reader.findFrame(13));
+
+        CPPUNIT_ASSERT_EQUAL(3U, reader.willNeed(0, 3));
+        CPPUNIT_ASSERT_EQUAL(0U, reader.willNeed(4, 0));
+
+        // read-ahead past the end is clipped
+        CPPUNIT_ASSERT_EQUAL(2U, reader.willNeed(8, 5));
+        CPPUNIT_ASSERT_EQUAL(0U, reader.willNeed(numFrames, 1));
+
+        // same without the memory mapping
+        ChannelTraceReader unmapped(fileName, false);
+        CPPUNIT_ASSERT_EQUAL(5U, unmapped.willNeed(2, 5));
+        CPPUNIT_ASSERT_EQUAL(1U, unmapped.willNeed(numFrames - 1, 8));
+    }
+
+    void
+    ChannelTraceTest::invalidFile()
+    {
+        CPPUNIT_ASSERT_THROW(ChannelTraceReader("ChannelTraceTestMissing.trc", true), wns::Exception);
+
+        // not a channel trace
+        FILE* file = fopen(fileName.c_str(), "wb");
+        for (unsigned int i = 0; i < 256; i++)
+            fputc('x', file);
+        fclose(file);
+        CPPUNIT_ASSERT_THROW(ChannelTraceReader(fileName, true), wns::Exception);
+        CPPUNIT_ASSERT_THROW(ChannelTraceReader(fileName, false), wns::Exception);
+
+        // shorter than the file header
+        file = fopen(fileName.c_str(), "wb");
+        fputc('I', file);
+        fclose(file);
+        CPPUNIT_ASSERT_THROW(ChannelTraceReader(fileName, false), wns::Exception);
+
+        CPPUNIT_ASSERT_THROW(ChannelTraceWriter("no/such/directory/ChannelTraceTest.trc", layout, NoCompression, 1, false),
+                             wns::Exception);
+    }
+
+}}}}
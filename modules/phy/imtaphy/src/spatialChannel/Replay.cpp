@@ -0,0 +1,314 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <IMTAPHY/spatialChannel/Replay.hpp>
+#include <IMTAPHY/ChannelModuleCreator.hpp>
+#include <IMTAPHY/Channel.hpp>
+#include <IMTAPHY/StationPhy.hpp>
+#include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <WNS/StopWatch.hpp>
+#include <WNS/Assure.hpp>
+#include <WNS/Exception.hpp>
+
+#include <cmath>
+#include <sstream>
+
+using namespace imtaphy::scm;
+using imtaphy::scanner::trace::ChannelTraceReader;
+
+STATIC_FACTORY_REGISTER_WITH_CREATOR(
+    imtaphy::scm::Replay,
+    imtaphy::scm::SpatialChannelModelInterface<float>,
+    "imtaphy.SCM.Replay",
+    imtaphy::ChannelModuleCreator);
+
+Replay::Replay(Channel* _channel, wns::pyconfig::View config) :
+    imtaphy::scm::SpatialChannelModelInterface<float>(_channel, config),
+    channel(_channel),
+    fileName(config.get<std::string>("fileName")),
+    memoryMapped(config.get<bool>("memoryMapped")),
+    readAheadTTIs(config.get<unsigned int>("readAheadTTIs")),
+    loop(config.get<bool>("loop")),
+    currentFrame(0),
+    frame(NULL),
+    T(2),
+    stale(2),
+    lastEvolveSeconds(0.0),
+    lastTransformSeconds(0.0),
+    materializedSeconds(0.0),
+    logger(config.get("logger"))
+{
+#ifdef _OPENMP
+    for (unsigned int i = 0; i < NumLinkLocks; i++)
+        omp_init_lock(&linkLocks[i]);
+#endif
+}
+
+Replay::~Replay()
+{
+#ifdef _OPENMP
+    for (unsigned int i = 0; i < NumLinkLocks; i++)
+        omp_destroy_lock(&linkLocks[i]);
+#endif
+}
+
+void
+Replay::onWorldCreated(LinkManager* linkManager, lsparams::LSmap* lsParams, bool keepIntermediates)
+{
+    scmLinks = linkManager->getSCMLinks();
+
+    reader.reset(new ChannelTraceReader(fileName, memoryMapped));
+    traceLayout = reader->getChannelLayout();
+
+    // T is sized from the trace but indexed by the scenario's link IDs and PRBs, so a trace recorded
+    // for a different scenario has to be rejected in opt builds, too
+    std::stringstream message;
+    if (reader->getNumFrames() == 0)
+    {
+        message << "Channel trace " << fileName << " does not contain any frames";
+        throw wns::Exception(message.str());
+    }
+    if (traceLayout.K != scmLinks.size())
+    {
+        message << "Channel trace " << fileName << " has " << traceLayout.K
+                << " links but the scenario has " << scmLinks.size() << " SCM links";
+        throw wns::Exception(message.str());
+    }
+
+    for (unsigned int d = 0; d <= 1; d++)
+    {
+        imtaphy::Direction direction = static_cast<imtaphy::Direction>(d);
+        numPRBs[d] = channel->getSpectrum()->getNumberOfPRBs(direction);
+        directionsEnabled[d] = (numPRBs[d] > 0);
+
+        if (!directionsEnabled[d])
+            continue;
+
+        // the uplink is replayed as the transposed downlink, so it needs the same PRBs
+        if (numPRBs[d] != traceLayout.F[imtaphy::Downlink])
+        {
+            message << "Channel trace " << fileName << " has " << traceLayout.F[imtaphy::Downlink]
+                    << " PRBs but the spectrum has " << numPRBs[d];
+            throw wns::Exception(message.str());
+        }
+
+        T[d].resize(traceLayout.K * numPRBs[d] * traceLayout.U * traceLayout.S);
+        stale[d].assign(traceLayout.K, true);
+    }
+
+    for (unsigned int k = 0; k < scmLinks.size(); k++)
+    {
+        unsigned int u = scmLinks[k]->getMS()->getAntenna()->getNumberOfElements();
+        unsigned int s = scmLinks[k]->getBS()->getAntenna()->getNumberOfElements();
+        if ((u > traceLayout.U) || (s > traceLayout.S))
+        {
+            message << "Channel trace " << fileName << " has " << traceLayout.U << " MS and " << traceLayout.S
+                    << " BS antennas but link " << k << " needs " << u << " and " << s;
+            throw wns::Exception(message.str());
+        }
+    }
+
+    MESSAGE_SINGLE(NORMAL, logger, "Replaying " << reader->getNumFrames() << " TTIs of " << traceLayout.K
+                   << " links from " << fileName << (memoryMapped ? " (memory mapped)" : ""));
+}
+
+ChannelLayout
+Replay::getChannelLayout()
+{
+    ChannelLayout layout = traceLayout;
+    layout.F[imtaphy::Uplink] = numPRBs[imtaphy::Uplink];
+
+    return layout;
+}
+
+void
+Replay::evolve(double t)
+{
+    wns::StopWatch watch;
+    watch.start();
+
+    unsigned int tti = static_cast<unsigned int>(floor(t * 1000.0 + 0.5));
+    unsigned int firstTTI = reader->getTTI(0);
+    unsigned int lastTTI = reader->getTTI(reader->getNumFrames() - 1);
+
+    if (tti > lastTTI)
+    {
+        if (!loop)
+        {
+            // readFrame would read past the index otherwise, so this is checked in opt builds, too
+            std::stringstream message;
+            message << "Channel trace " << fileName << " ends at TTI " << lastTTI << ", cannot replay TTI " << tti
+                    << ", set loop to replay it repeatedly";
+            throw wns::Exception(message.str());
+        }
+        tti = firstTTI + (tti - firstTTI) % (lastTTI - firstTTI + 1);
+    }
+
+    // TTIs before the first recorded frame (the ChannelDumper starts in TTI 3) use the first frame
+    currentFrame = reader->findFrame(tti);
+    frame = reader->readFrame(currentFrame);
+    reader->willNeed(currentFrame + 1, readAheadTTIs);
+
+    for (unsigned int d = 0; d <= 1; d++)
+        if (directionsEnabled[d])
+            stale[d].markAllStale();
+
+    lastTransformSeconds = materializedSeconds;
+    materializedSeconds = 0.0;
+
+    lastEvolveSeconds = watch.stop();
+    MESSAGE_SINGLE(VERBOSE, logger, "Replaying frame " << currentFrame << " (recorded in TTI " << reader->getTTI(currentFrame)
+                   << ") at t=" << t);
+}
+
+void
+Replay::materializeStaleChannel(unsigned int k, imtaphy::Direction d)
+{
+    assure(k < stale[d].size(), "invalid link ID or direction not enabled");
+    assure(frame, "evolve has to be called before the channel can be accessed");
+
+#ifdef _OPENMP
+    omp_lock_t* lock = &linkLocks[k % NumLinkLocks];
+    omp_set_lock(lock);
+#endif
+    // another thread might have copied the link while we were waiting for the lock
+    if (stale[d].isStale(k))
+    {
+        wns::StopWatch watch;
+        watch.start();
+
+        unsigned int U = traceLayout.U;
+        unsigned int S = traceLayout.S;
+        unsigned int F = numPRBs[d];
+        std::complex<float>* target = &T[d][k * F * U * S];
+
+        // the trace holds the downlink CTF of link k as [u][s][f], the links need [f][u][s] matrices
+        // in the downlink and the transposed [f][s][u] ones in the uplink
+        for (unsigned int u = 0; u < U; u++)
+            for (unsigned int s = 0; s < S; s++)
+            {
+                const std::complex<float>* ctf = &frame[traceLayout.K * U * S * traceLayout.N + ((k * U + u) * S + s) * F];
+
+                if (d == imtaphy::Downlink)
+                    for (unsigned int f = 0; f < F; f++)
+                        target[(f * U + u) * S + s] = ctf[f];
+                else
+                    for (unsigned int f = 0; f < F; f++)
+                        target[(f * S + s) * U + u] = ctf[f];
+            }
+
+        double seconds = watch.stop();
+#pragma omp atomic
+        materializedSeconds += seconds;
+
+        // publishes T to the threads taking the fast path in materializeChannel
+        stale[d].markFresh(k);
+    }
+#ifdef _OPENMP
+    omp_unset_lock(lock);
+#endif
+}
+
+std::complex<float>
+Replay::getCurrentCIR(unsigned int k, imtaphy::Direction d, unsigned int u, unsigned int s, int n)
+{
+    assure(k < traceLayout.K, "invalid link ID");
+    assure(frame, "evolve has to be called before the channel can be accessed");
+
+    if (n >= static_cast<int>(traceLayout.N))
+        return std::complex<float>(0.0, 0.0);
+
+    if (d == imtaphy::Downlink)
+        return ChannelTraceReader::cir(frame, traceLayout, k, u, s, n);
+    else
+        return ChannelTraceReader::cir(frame, traceLayout, k, s, u, n);
+}
+
+std::complex<float>
+Replay::getCurrentCTF(unsigned int k, imtaphy::Direction d, unsigned int u, unsigned int s, unsigned int f)
+{
+    assure(k < traceLayout.K, "invalid link ID");
+    assure(f < numPRBs[d], "invalid PRB ID f");
+
+    materializeChannel(k, d);
+    if (d == imtaphy::Downlink)
+        return T[d][((k * numPRBs[d] + f) * traceLayout.U + u) * traceLayout.S + s];
+    else
+        return T[d][((k * numPRBs[d] + f) * traceLayout.S + u) * traceLayout.U + s];
+}
+
+boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<float> > >
+Replay::getChannelMatrix(imtaphy::Link* link, imtaphy::Direction direction, unsigned int f)
+{
+    typedef imtaphy::detail::MKLMatrix<std::complex<float> > Matrix;
+
+    unsigned int u = link->getMS()->getAntenna()->getNumberOfElements();
+    unsigned int s = link->getBS()->getAntenna()->getNumberOfElements();
+
+    assure(f < numPRBs[direction], "Invalid PRB index");
+
+    if (link->isSCM())
+    {
+        unsigned int k = link->getSCMlinkId();
+        std::complex<float>* location = &T[direction][(k * numPRBs[direction] + f) * traceLayout.U * traceLayout.S];
+
+        // as in M2135, matrices with less rx antennas than recorded are the first rows of the
+        // recorded ones, we cannot support less tx antennas
+        if ((direction == imtaphy::Downlink) && (s == traceLayout.S))
+            return boost::shared_ptr<Matrix>(new Matrix(u, traceLayout.S, location));
+        if ((direction == imtaphy::Uplink) && (u == traceLayout.U))
+            return boost::shared_ptr<Matrix>(new Matrix(s, traceLayout.U, location));
+
+        // the returned matrix would have the wrong stride, so this is checked in opt builds, too
+        std::stringstream message;
+        message << "Channel trace replay does not support less tx antennas than recorded (" << fileName
+                << " has " << traceLayout.S << " BS and " << traceLayout.U << " MS antennas, link "
+                << k << " has " << s << " and " << u << ")";
+        throw wns::Exception(message.str());
+    }
+
+    // link is not SCM so return a static channel matrix
+    Matrix* matrix;
+    if (direction == imtaphy::Downlink)
+        matrix = new Matrix(u, s);
+    else
+        matrix = new Matrix(s, u);
+
+    std::complex<float> value(1.0 / sqrt(link->getWidebandLoss().get_factor()), 0.0);
+    for (unsigned int i = 0; i < u; i++)
+        for (unsigned int j = 0; j < s; j++)
+        {
+            if (direction == imtaphy::Downlink)
+                (*matrix)[i][j] = value;
+            else
+                (*matrix)[j][i] = value;
+        }
+
+    return boost::shared_ptr<Matrix>(matrix);
+}
@@ -0,0 +1,150 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef SPATIALCHANNELMODELINTERFACE_REPLAY_HPP
+#define SPATIALCHANNELMODELINTERFACE_REPLAY_HPP
+
+#include <WNS/pyconfig/View.hpp>
+#include <WNS/logger/Logger.hpp>
+
+#include <IMTAPHY/spatialChannel/SpatialChannelModelInterface.hpp>
+#include <IMTAPHY/scanner/ChannelTrace.hpp>
+#include <IMTAPHY/Link.hpp>
+#include <IMTAPHY/detail/LinearAlgebra.hpp>
+#include <IMTAPHY/detail/StaleFlags.hpp>
+
+#include <boost/scoped_ptr.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace imtaphy { 
+    class StationPhy;
+    class Channel;
+    
+    namespace scm {
+
+        /**
+         * @brief Replays the downlink channel transfer functions recorded by the ChannelDumper
+         * (see scanner/ChannelTrace.hpp) instead of computing a channel model. The scenario has to
+         * be the same as in the recording run (same SCM links in the same order, same antennas and
+         * number of PRBs). In TTI t the frame recorded in TTI t is used, TTIs before the first
+         * recorded frame use the first frame. Running past the end of the trace throws a
+         * wns::Exception unless loop is set.
+         *
+         * The trace is memory mapped and the kernel is asked to read ahead the next frames. A link's
+         * channel is only copied out of the trace (into the [f][u][s] order the links expect) when
+         * its channel matrices are accessed in a TTI. The uplink channel is the transposed downlink
+         * channel (reciprocity) because the trace only contains the downlink.
+         */
+        class Replay:
+                public SpatialChannelModelInterface<float>
+        {
+        public:
+            Replay(Channel* channel, wns::pyconfig::View config);
+            virtual ~Replay();
+
+            void onWorldCreated(LinkManager* linkManager, lsparams::LSmap* lsParams, bool keepIntermediates);
+
+            scm::ChannelLayout getChannelLayout();
+
+            std::complex<float> getCurrentCIR(unsigned int k, // SCM link ID
+                                              imtaphy::Direction d, // Uplink or Downlink
+                                              unsigned int u, // Rx antenna ID
+                                              unsigned int s, // Tx antenna ID
+                                              int n  // cluster/path ID
+                );
+
+            std::complex<float> getCurrentCTF(unsigned int k, // SCM link ID
+                                              imtaphy::Direction d, // Uplink or Downlink
+                                              unsigned int u, // Rx antenna ID
+                                              unsigned int s, // Tx antenna ID
+                                              unsigned int f  // frequency bin (PRB) index
+                );
+
+            boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<float> > >
+            getChannelMatrix(imtaphy::Link* link,
+                             imtaphy::Direction direction,
+                             unsigned int f);  // frequency bin (PRB) index
+
+            void evolve(double t);
+
+            double getLastEvolveSeconds() const { return lastEvolveSeconds; }
+            double getLastTransformSeconds() const { return lastTransformSeconds; }
+
+            bool transformsLazily() const { return true; }
+
+            void materializeChannel(unsigned int k, imtaphy::Direction d)
+            {
+                // fast path: already copied in this TTI
+                if (!stale[d].isStale(k))
+                    return;
+
+                materializeStaleChannel(k, d);
+            }
+
+            unsigned int getCurrentFrame() const { return currentFrame; }
+
+        private:
+            void materializeStaleChannel(unsigned int k, imtaphy::Direction d);
+
+            imtaphy::Channel* channel;
+            imtaphy::LinkVector scmLinks;
+            std::string fileName;
+            bool memoryMapped;
+            unsigned int readAheadTTIs;
+            bool loop;
+
+            boost::scoped_ptr<imtaphy::scanner::trace::ChannelTraceReader> reader;
+            imtaphy::scm::ChannelLayout traceLayout;
+            unsigned int currentFrame;
+            const imtaphy::scanner::trace::Sample* frame;
+
+            bool directionsEnabled[2];
+            unsigned int numPRBs[2];
+
+            // per direction: K x F x Rx antennas x Tx antennas, the links' channel matrices point here
+            std::vector<std::vector<std::complex<float> > > T;
+            std::vector<imtaphy::detail::StaleFlags> stale;
+
+            double lastEvolveSeconds;
+            double lastTransformSeconds; // copying the links of the previous frame into T, summed over all threads
+            double materializedSeconds;
+
+#ifdef _OPENMP
+            static const unsigned int NumLinkLocks = 64;
+            omp_lock_t linkLocks[NumLinkLocks];
+#endif
+
+            wns::logger::Logger logger;
+        };
+
+    }}
+#endif
@@ -90,6 +90,50 @@ namespace imtaphy {
                             ) = 0;
             
             virtual void evolve(double t) = 0;
+
+            /**
+             * @brief Channel models that can evolve the next TTI into a separate buffer while the
+             * current channel is being read return true here and implement the two methods below.
+             */
+            virtual bool supportsPipelinedEvolution() const { return false; }
+
+            /**
+             * @brief Like evolve(t) but without changing what the getters return until swapBuffers
+             * is called. May run concurrently with readers of the current channel.
+             */
+            virtual void evolveBackBuffer(double t) {}
+
+            /**
+             * @brief Makes the result of the last evolveBackBuffer call the current channel
+             */
+            virtual void swapBuffers() {}
+
+            /**
+             * @brief Wall time in seconds that the last evolution (computing the impulse responses) and
+             * the last transformation into the frequency domain took, 0 if not measured. Models that
+             * transform lazily report the time materializeChannel spent in the TTI before the last
+             * evolution, summed over all threads.
+             */
+            virtual double getLastEvolveSeconds() const { return 0.0; }
+            virtual double getLastTransformSeconds() const { return 0.0; }
+
+            /**
+             * @brief Channel models that compute the channel transfer function on demand return true here.
+             * Links then call materializeChannel before handing out their channel matrices.
+             */
+            virtual bool transformsLazily() const { return false; }
+
+            /**
+             * @brief Makes sure that the channel transfer function of SCM link k in direction d is up to date
+             * for the current TTI. Has to be thread-safe because receivers run in parallel.
+             */
+            virtual void materializeChannel(unsigned int k, imtaphy::Direction d) {}
+
+            /**
+             * @brief Bytes of fast-fading state the model keeps per SCM link (0 if unknown), 
+             * used to report the memory saved by not modeling links as SCM links
+             */
+            virtual unsigned long int getStateBytesPerLink() const { return 0; }
         };
         
     }}
@@ -38,6 +38,9 @@
 #include <IMTAPHY/spatialChannel/m2135/ClusterPowers.hpp>
 #include <IMTAPHY/spatialChannel/m2135/RayAngles.hpp>
 #include <IMTAPHY/spatialChannel/m2135/Delays.hpp>
+#include <IMTAPHY/detail/SinCos.hpp>
+#include <WNS/probe/bus/ContextCollector.hpp>
+#include <WNS/StopWatch.hpp>
 
 
 #include <iostream>
@@ -71,55 +74,6 @@ STATIC_FACTORY_REGISTER_WITH_CREATOR(
     imtaphy::ChannelModuleCreator);
 
 namespace imtaphy { namespace scm { namespace m2135 {
-            // Template specialization for MKL's CIS function: 
-            // Computes complex exponent of real vector elements 
-            // (cosine and sine of real vector elements combined to complex value)
-            // http://software.intel.com/sites/products/documentation/hpc/mkl/vml/functions/CIS_c.html
-            template <> void MKLCis<float>::execute(const int n, 
-                                                    const float* a, 
-                                                    std::complex<float>* y 
-                ) 
-            { 
-                vmlClearErrStatus();
-
-                // low accuracy  / enhanced performance versions of VML functions
-                vmlSetMode( VML_EP );
-                vcCIS(n, a, y);  // c stands for MKL_COMPLEX8 / std::complex<float>
-        
-                assure(vmlGetErrStatus() == 0, "MKL CIS gave an error. vmlGetErrStatus()=" << vmlGetErrStatus());
-            } 
-            template <> void MKLCis<double>::execute(const int n, 
-                                                     const double* a, 
-                                                     std::complex<double>* y 
-                )  
-            { 
-                vmlClearErrStatus();
-                
-                // high accuracy
-                vmlSetMode( VML_HA );
-                vzCIS(n, a, y); // z stands for MKL_COMPLEX16 / std::complex<double>
-        
-                assure(vmlGetErrStatus() == 0, "MKL CIS gave an error. vmlGetErrStatus()=" << vmlGetErrStatus());
-
-            }
-            // explicit instantiation
-            template class MKLCis<float>;
-            template class MKLCis<double>;
-    
-    
-            // same thing for cblas_?scal functions:
-            template <> void MKLscal<float>::execute(const int N, const float alpha, float *X, const int incX)
-            {
-                cblas_sscal(N, alpha, X, incX);
-            }
-            template <> void MKLscal<double>::execute(const int N, const double alpha, double *X, const int incX)
-            {
-                cblas_dscal(N, alpha, X, incX);
-            }
-            // explicit instatiation
-            template class MKLscal<float>;
-            template class MKLscal<double>;
-
             // ?gemm matrix-matrix multiplication routines
             template <> void MKLgemm<float>::execute(const CBLAS_ORDER Order, const CBLAS_TRANSPOSE TransA, 
                                                      const CBLAS_TRANSPOSE TransB, const int M, const int N, 
@@ -139,20 +93,6 @@ namespace imtaphy { namespace scm { namespace m2135 {
             template class MKLgemm<float>;
             template class MKLgemm<double>;
     
-            template <> void MKLdotu<float>::execute(const int N, const void *X, const int incX, 
-                                                     const void *Y, const int incY, void *dotu)
-            {
-                // cblas_cdotu_sub works on MKL_COMPLEX8, i.e., std::complex<float> values
-                cblas_cdotu_sub(N, X, incX, Y, incY, dotu);
-            }
-            template <> void MKLdotu<double>::execute(const int N, const void *X, const int incX, 
-                                                      const void *Y, const int incY, void *dotu)
-            {
-                // cblas_zdotu_sub works on MKL_COMPLEX16, i.e., std::complex<double> values
-                cblas_zdotu_sub(N, X, incX, Y, incY, dotu);
-            }
-            template class MKLdotu<float>;
-            template class MKLdotu<double>;
         }}}
 
 
@@ -171,29 +111,87 @@ M2135<PRECISION>::M2135(imtaphy::Channel* _channel, wns::pyconfig::View config)
     calibrationOutputFileName(config.get<std::string>("calibrationOutputFileName")),
     directionsEnabled(2),
     computeEffectiveAntennaGains(config.get<bool>("computeEffectiveAntennaGains")),
-    allSpeedsZero(true)
+    allSpeedsZero(true),
+    incrementalEvolution(config.get<bool>("incrementalEvolution")),
+    renormalizationInterval(config.get<unsigned int>("renormalizationInterval")),
+    phasors(2),
+    phasorSteps(2),
+    phasorsValid(false),
+    lastEvolutionTime(0.0),
+    evolutionTimeStep(0.0),
+    stepsSinceRenormalization(0),
+    lazyTransformation(config.get<bool>("lazyTransformation")),
+    stale(2),
+    materializedThisTTI(2, 0),
+    materializedTotal(2, 0),
+    materializedSeconds(0.0),
+    compactFactor(2),
+    compactFactorScale(2),
+    pipelinedEvolution(config.get<bool>("pipelinedEvolution")),
+    backH(2),
+    backT(2),
+    backBufferPending(false),
+    lastEvolveSeconds(0.0),
+    lastTransformSeconds(0.0)
 {
+    assure(renormalizationInterval > 0, "renormalizationInterval must be at least 1");
+
+    std::string storage = config.get<std::string>("tInvariantFactorStorage");
+    if (storage == "full")
+        factorStorage = FullStorage;
+    else if (storage == "half")
+        factorStorage = HalfStorage;
+    else if (storage == "quantized")
+        factorStorage = QuantizedStorage;
+    else
+        assure(0, "Unknown tInvariantFactorStorage " << storage << ", use full, half or quantized");
+
+    // with lazy transformation, the receivers themselves write T
+    assure(!(pipelinedEvolution && lazyTransformation), "pipelinedEvolution cannot be combined with lazyTransformation");
+
+#ifdef _OPENMP
+    for (unsigned int i = 0; i < NumLinkLocks; i++)
+        omp_init_lock(&linkLocks[i]);
+#endif
 }
 
 template <typename PRECISION>    
 M2135<PRECISION>::~M2135()
 {
-    // release dynamically allocated memory according to how it was allocated (mkl_malloc or new)
+    // release dynamically allocated memory according to how it was allocated: the arrays' data 
+    // via alignedMalloc and the multi_array_ref wrappers via new
     // we don't need to check for null ptrs before deleting according to the c++ FAQ
-    mkl_free(tVariantCoeff[0]);
-    mkl_free(tVariantCoeff[1]);
+    for (unsigned int d = 0; d <= 1; d++)
+    {
+        releaseArray(tVariantCoeff[d]);
+        releaseArray(tInvariantFactor[d]);
+        releaseArray(frequencyCoeff[d]);
+        releaseArray(H[d]);
+        releaseArray(T[d]);
+        releaseArray(phasors[d]);
+        releaseArray(phasorSteps[d]);
+        releaseArray(compactFactor[d]);
+        releaseArray(compactFactorScale[d]);
+        releaseArray(backH[d]);
+        releaseArray(backT[d]);
+    }
 
-    mkl_free(tInvariantFactor[0]);
-    mkl_free(tInvariantFactor[1]);
+#ifdef _OPENMP
+    for (unsigned int i = 0; i < NumLinkLocks; i++)
+        omp_destroy_lock(&linkLocks[i]);
+#endif
+}
 
-    mkl_free(frequencyCoeff[0]);
-    mkl_free(frequencyCoeff[1]);
-   
-    mkl_free(H[0]);
-    mkl_free(H[1]);
-    
-    mkl_free(T[0]);
-    mkl_free(T[1]);
+template <typename PRECISION>
+template <typename ArrayType>
+void
+M2135<PRECISION>::releaseArray(ArrayType*& array)
+{
+    if (array != NULL)
+        imtaphy::detail::alignedFree(array->data());
+
+    delete array;
+    array = NULL;
 }
 
 template <typename PRECISION> 
@@ -398,6 +396,11 @@ M2135<PRECISION>::onWorldCreated(imtaphy::LinkManager* linkManager, imtaphy::lsp
     timer.toc();
     MESSAGE_SINGLE(VERBOSE, logger,"Took "<<timer.get_time()<<" seconds for computing time-invariant coefficients for "<<scmLinks.size()<<" links");
 
+    if (factorStorage != FullStorage)
+        compactInvariantFactors();
+
+    reportMemoryFootprint();
+
     if (!keepIntermediates)
     {
         // if we don't need them (e.g. for testing), we can throw all intermediate variables 
@@ -453,39 +456,124 @@ M2135<PRECISION>::sizeMultiDimArrays()
     
     if (directionsEnabled[Downlink])
     {
-        tVariantCoeff[Downlink] = new boost::multi_array_ref<PRECISION, 5>(static_cast<PRECISION*>(mkl_malloc(sizeof(PRECISION) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters * (NumRays + 1), 32)),
+        tVariantCoeff[Downlink] = new boost::multi_array_ref<PRECISION, 5>(static_cast<PRECISION*>(imtaphy::detail::alignedMalloc(sizeof(PRECISION) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters * (NumRays + 1), 32)),
                                                                            boost::extents[scmLinks.size()][maxMsAntennas][maxBsAntennas][MaxClusters][NumRays + 1]);
                                                                            
-        tInvariantFactor[Downlink] = new boost::multi_array_ref<std::complex<PRECISION>, 5>(static_cast<std::complex<PRECISION>*>(mkl_malloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters * (NumRays + 1), 32)),
+        tInvariantFactor[Downlink] = new boost::multi_array_ref<std::complex<PRECISION>, 5>(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters * (NumRays + 1), 32)),
                                                                                             boost::extents[scmLinks.size()][maxMsAntennas][maxBsAntennas][MaxClusters][NumRays + 1]);
                                                                                             
-        frequencyCoeff[Downlink] = new boost::multi_array_ref<std::complex<PRECISION>, 3>(static_cast<std::complex<PRECISION>*>(mkl_malloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * channel->getSpectrum()->getNumberOfPRBs(imtaphy::Downlink) * MaxClusters, 32)),
+        frequencyCoeff[Downlink] = new boost::multi_array_ref<std::complex<PRECISION>, 3>(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * channel->getSpectrum()->getNumberOfPRBs(imtaphy::Downlink) * MaxClusters, 32)),
                                                                                           boost::extents[scmLinks.size()][channel->getSpectrum()->getNumberOfPRBs(imtaphy::Downlink)][MaxClusters]);
                                                                                           
-        H[Downlink] = new boost::multi_array_ref<std::complex<PRECISION>, 4>(static_cast<std::complex<PRECISION>*>(mkl_malloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters , 32)), 
+        H[Downlink] = new boost::multi_array_ref<std::complex<PRECISION>, 4>(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters , 32)), 
                                                                              boost::extents[scmLinks.size()][maxMsAntennas][maxBsAntennas][MaxClusters]);
                                                                              
-        T[Downlink] = new boost::multi_array_ref<std::complex<PRECISION>, 4>(static_cast<std::complex<PRECISION>*>(mkl_malloc(sizeof(std::complex<PRECISION>) * scmLinks.size() *  channel->getSpectrum()->getNumberOfPRBs(imtaphy::Downlink) * maxMsAntennas * maxBsAntennas , 32)), 
+        T[Downlink] = new boost::multi_array_ref<std::complex<PRECISION>, 4>(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * scmLinks.size() *  channel->getSpectrum()->getNumberOfPRBs(imtaphy::Downlink) * maxMsAntennas * maxBsAntennas , 32)), 
                                                                              boost::extents[scmLinks.size()][channel->getSpectrum()->getNumberOfPRBs(imtaphy::Downlink)][maxMsAntennas][maxBsAntennas]);
     }
     
     // channel matrices for Uplink are transposed compared to Donwlink -> exchange Ms and Bs indices:
     if (directionsEnabled[Uplink])
     {
-        tVariantCoeff[Uplink] = new boost::multi_array_ref<PRECISION, 5>(static_cast<PRECISION*>(mkl_malloc(sizeof(PRECISION) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters * (NumRays + 1), 32)),
+        tVariantCoeff[Uplink] = new boost::multi_array_ref<PRECISION, 5>(static_cast<PRECISION*>(imtaphy::detail::alignedMalloc(sizeof(PRECISION) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters * (NumRays + 1), 32)),
                                                                          boost::extents[scmLinks.size()][maxMsAntennas][maxBsAntennas][MaxClusters][NumRays + 1]);
-        tInvariantFactor[Uplink] = new boost::multi_array_ref<std::complex<PRECISION>, 5>(static_cast<std::complex<PRECISION>*>(mkl_malloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters * (NumRays + 1), 32)),
+        tInvariantFactor[Uplink] = new boost::multi_array_ref<std::complex<PRECISION>, 5>(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters * (NumRays + 1), 32)),
                                                                                           boost::extents[scmLinks.size()][maxMsAntennas][maxBsAntennas][MaxClusters][NumRays + 1]);
 
-        frequencyCoeff[Uplink] = new boost::multi_array_ref<std::complex<PRECISION>, 3>(static_cast<std::complex<PRECISION>*>(mkl_malloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * channel->getSpectrum()->getNumberOfPRBs(imtaphy::Uplink) * MaxClusters, 32)),
+        frequencyCoeff[Uplink] = new boost::multi_array_ref<std::complex<PRECISION>, 3>(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * channel->getSpectrum()->getNumberOfPRBs(imtaphy::Uplink) * MaxClusters, 32)),
                                                                                           boost::extents[scmLinks.size()][channel->getSpectrum()->getNumberOfPRBs(imtaphy::Uplink)][MaxClusters]);
                                                                                           
-        H[Uplink] = new boost::multi_array_ref<std::complex<PRECISION>, 4>(static_cast<std::complex<PRECISION>*>(mkl_malloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters , 32)), 
+        H[Uplink] = new boost::multi_array_ref<std::complex<PRECISION>, 4>(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * scmLinks.size() * maxMsAntennas * maxBsAntennas * MaxClusters , 32)), 
                                                                              boost::extents[scmLinks.size()][maxBsAntennas][maxMsAntennas][MaxClusters]);
 
-        T[Uplink] = new boost::multi_array_ref<std::complex<PRECISION>, 4>(static_cast<std::complex<PRECISION>*>(mkl_malloc(sizeof(std::complex<PRECISION>) * scmLinks.size() *  channel->getSpectrum()->getNumberOfPRBs(imtaphy::Uplink) * maxMsAntennas * maxBsAntennas , 32)), 
+        T[Uplink] = new boost::multi_array_ref<std::complex<PRECISION>, 4>(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * scmLinks.size() *  channel->getSpectrum()->getNumberOfPRBs(imtaphy::Uplink) * maxMsAntennas * maxBsAntennas , 32)), 
                                                                            boost::extents[scmLinks.size()][channel->getSpectrum()->getNumberOfPRBs(imtaphy::Uplink)][maxBsAntennas][maxMsAntennas]);
     }
+
+    // the back buffers for the pipelined evolution have the same shape as H and T
+    if (pipelinedEvolution)
+    {
+        for (unsigned int d = 0; d <= 1; d++)
+        {
+            if (!directionsEnabled[d])
+                continue;
+
+            backH[d] = new ComplexArray4D(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * H[d]->num_elements(), 32)),
+                                          boost::extents[H[d]->shape()[0]][H[d]->shape()[1]][H[d]->shape()[2]][H[d]->shape()[3]]);
+            backT[d] = new ComplexArray4D(static_cast<std::complex<PRECISION>*>(imtaphy::detail::alignedMalloc(sizeof(std::complex<PRECISION>) * T[d]->num_elements(), 32)),
+                                          boost::extents[T[d]->shape()[0]][T[d]->shape()[1]][T[d]->shape()[2]][T[d]->shape()[3]]);
+        }
+    }
+
+    // initially, nothing has been transformed yet
+    for (unsigned int d = 0; d <= 1; d++)
+        stale[d].assign(directionsEnabled[d] ? scmLinks.size() : 0, true);
+
+    // the rotating phasors are only needed for the incremental evolution mode
+    if (incrementalEvolution)
+    {
+        for (unsigned int d = 0; d <= 1; d++)
+        {
+            if (!directionsEnabled[d])
+                continue;
+
+            phasors[d] = new boost::multi_array_ref<PRECISION, 5>(static_cast<PRECISION*>(imtaphy::detail::alignedMalloc(sizeof(PRECISION) * scmLinks.size() * maxMsAntennas * maxBsAntennas * 2 * MaxClusters * (NumRays + 1), 32)),
+                                                                  boost::extents[scmLinks.size()][maxMsAntennas][maxBsAntennas][2][MaxClusters * (NumRays + 1)]);
+            phasorSteps[d] = new boost::multi_array_ref<PRECISION, 5>(static_cast<PRECISION*>(imtaphy::detail::alignedMalloc(sizeof(PRECISION) * scmLinks.size() * maxMsAntennas * maxBsAntennas * 2 * MaxClusters * (NumRays + 1), 32)),
+                                                                      boost::extents[scmLinks.size()][maxMsAntennas][maxBsAntennas][2][MaxClusters * (NumRays + 1)]);
+        }
+    }
+
+    // The memory returned by alignedMalloc is not touched yet, so its pages will be placed on the
+    // NUMA node of the thread that writes them first. Do that with the same static link-to-thread
+    // mapping that evolve, transformChannel etc. use (see imtaphy::detail::StaticPartition)
+    for (unsigned int d = 0; d <= 1; d++)
+    {
+        if (!directionsEnabled[d])
+            continue;
+
+        firstTouch(tVariantCoeff[d]);
+        firstTouch(tInvariantFactor[d]);
+        firstTouch(frequencyCoeff[d]);
+        firstTouch(H[d]);
+        firstTouch(T[d]);
+        firstTouch(phasors[d]);
+        firstTouch(phasorSteps[d]);
+        firstTouch(backH[d]);
+        firstTouch(backT[d]);
+    }
+}
+
+template <typename PRECISION>
+unsigned long int
+M2135<PRECISION>::getStateBytesPerLink() const
+{
+    unsigned long int bytes = 0;
+    unsigned long int antennaPairs = maxMsAntennas * maxBsAntennas;
+    
+    for (unsigned int d = 0; d <= 1; d++)
+    {
+        if (!directionsEnabled[d])
+            continue;
+        
+        unsigned long int prbs = channel->getSpectrum()->getNumberOfPRBs(static_cast<imtaphy::Direction>(d));
+
+        bytes += antennaPairs * MaxClusters * (NumRays + 1) * sizeof(PRECISION);                 // tVariantCoeff
+        if (factorStorage == FullStorage)                                                        // tInvariantFactor
+            bytes += antennaPairs * MaxClusters * (NumRays + 1) * sizeof(std::complex<PRECISION>);
+        else
+            bytes += antennaPairs * (MaxClusters * (NumRays + 1) * 2 * sizeof(boost::uint16_t) + sizeof(float));
+        bytes += prbs * MaxClusters * sizeof(std::complex<PRECISION>);                           // frequencyCoeff
+        bytes += antennaPairs * MaxClusters * sizeof(std::complex<PRECISION>);                   // H
+        bytes += prbs * antennaPairs * sizeof(std::complex<PRECISION>);                          // T
+        
+        if (incrementalEvolution)
+            bytes += 2 * antennaPairs * 2 * MaxClusters * (NumRays + 1) * sizeof(PRECISION);    // phasors and steps
+
+        if (pipelinedEvolution)
+            bytes += (MaxClusters + prbs) * antennaPairs * sizeof(std::complex<PRECISION>);      // back buffers of H and T
+    }
+    return bytes;
 }
 
 template <typename PRECISION>
@@ -522,7 +610,7 @@ M2135<PRECISION>::computeTimeInvariantCoefficients(RayAngles3DArray& aoas, RayAn
 
     int K = links.size();
     int k; // signed int for OpenMP parallel for loop
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
     for (k = 0; k < K ; k++)
     {
         // we get the electrical (!) field pattern of the antenna depending on the azimuth angle of the
@@ -795,7 +883,7 @@ M2135<PRECISION>::computeTimeInvariantCoefficients(RayAngles3DArray& aoas, RayAn
     itpp::Real_Timer timer;
     timer.tic();
 
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
     for (k = 0; k < K ; k++)
     {
         for (unsigned int d = 0; d <= 1; d++)
@@ -873,149 +961,472 @@ M2135<PRECISION>::evolve(double t)
     if(allSpeedsZero && t > 0.0)
         return;
 
+    evolveInto(t, H, T);
+}
+
+template <typename PRECISION>
+void
+M2135<PRECISION>::evolveBackBuffer(double t)
+{
+    assure(pipelinedEvolution, "evolveBackBuffer requires pipelinedEvolution");
+    assure(!backBufferPending, "Back buffer has not been swapped in yet");
+
+    if(allSpeedsZero && t > 0.0)
+        return;
+    
+    evolveInto(t, backH, backT);
+    backBufferPending = true;
+}
+
+template <typename PRECISION>
+void
+M2135<PRECISION>::swapBuffers()
+{
+    if (!backBufferPending)
+        return;
+
+    for (unsigned int d = 0; d <= 1; d++)
+    {
+        if (!directionsEnabled[d])
+            continue;
+
+        std::swap(H[d], backH[d]);
+        std::swap(T[d], backT[d]);
+    }
+
+    // the links' channel matrices point into the old front buffer, move them over and
+    // forget the ones that are no longer referenced
+    unsigned int alive = 0;
+    for (unsigned int i = 0; i < frontBufferViews.size(); i++)
+    {
+        boost::shared_ptr<ChannelMatrix> matrix = frontBufferViews[i].matrix.lock();
+        if (!matrix)
+            continue;
+
+        matrix->relocate(T[frontBufferViews[i].direction]->data() + frontBufferViews[i].offset);
+        frontBufferViews[alive++] = frontBufferViews[i];
+    }
+    frontBufferViews.resize(alive);
+
+    backBufferPending = false;
+}
+
+template <typename PRECISION>
+boost::shared_ptr<typename M2135<PRECISION>::ChannelMatrix>
+M2135<PRECISION>::frontBufferView(imtaphy::Direction d, unsigned int k, unsigned int f, unsigned int rows, unsigned int columns)
+{
+    std::complex<PRECISION>* location = &((*T[d])[k][f][0][0]);
+    boost::shared_ptr<ChannelMatrix> matrix(new ChannelMatrix(rows, columns, location));
+
+    if (pipelinedEvolution)
+    {
+        FrontBufferView view;
+        view.matrix = matrix;
+        view.direction = d;
+        view.offset = location - T[d]->data();
+        frontBufferViews.push_back(view);
+    }
+    return matrix;
+}
+
+template <typename PRECISION>
+void
+M2135<PRECISION>::evolveInto(double t, std::vector<ComplexArray4D*>& targetH, std::vector<ComplexArray4D*>& targetT)
+{
     itpp::Real_Timer timer;
     timer.tic();
 
-    // TODO: choose suitable value
-    const unsigned int chunkSize = 1000;
-    unsigned int thisChunkSize;
+    // Here, we only want to do the minimum number of computations that are required when time t changes.
+    // Each link is evolved by a fused kernel that computes exp(j*tVariant*t) on the fly and directly
+    // accumulates the rays into H, so no temporary chunk buffers are needed.
+    
+    int K = static_cast<int>(scmLinks.size()); // signed int for OpenMP parallel for loop
+
+    // In the incremental mode, the phasors are only rotated by exp(j*w*dt) if evolve is called with the
+    // same time step as before (which is the case for the periodic per-TTI evolution). Otherwise, they
+    // are recomputed exactly at t and the rotation for the new time step is precomputed.
+    bool advance = false;
+    bool renormalize = false;
+    PRECISION dt = 0.0;
+    if (incrementalEvolution)
+    {
+        double step = t - lastEvolutionTime;
 
-    unsigned int K = scmLinks.size();
-    unsigned int elementsPerLink = maxMsAntennas * maxBsAntennas * MaxClusters * (NumRays + 1);
+        if (phasorsValid && (step > 0.0) && (std::fabs(step - evolutionTimeStep) < 1e-9))
+        {
+            advance = true;
+            if (++stepsSinceRenormalization >= renormalizationInterval)
+            {
+                renormalize = true;
+                stepsSinceRenormalization = 0;
+            }
+        }
+        else
+        {
+            evolutionTimeStep = phasorsValid ? step : 0.0;
+            stepsSinceRenormalization = 0;
+        }
+        dt = static_cast<PRECISION>(evolutionTimeStep);
+    }
 
-    PRECISION* scaled = static_cast<PRECISION*>(mkl_malloc(sizeof(PRECISION) *
-                                                           chunkSize * elementsPerLink, 32));
-                                    
-    // we need a vector to store the intermediate step (tVariantVec)
-    std::complex<PRECISION>* tVariantVec = static_cast<std::complex<PRECISION>* >(mkl_malloc(sizeof(std::complex<PRECISION>) * chunkSize * elementsPerLink, 32));
-    
     for (unsigned int d = 0; d <= 1; d++)
     {
         imtaphy::Direction direction = static_cast<imtaphy::Direction>(d);
         if (!directionsEnabled[direction])
             continue;
     
-        // Here, we only want to do the minimum number of computations that are required when time t changes
-        // In order not to use too much temporary memory, we operate on large chunks of links at once.
+        int k;
+        if (incrementalEvolution)
+        {
+#pragma omp parallel for schedule(static)
+            for (k = 0; k < K; k++)
+                evolveLinkIncremental(direction, k, static_cast<PRECISION>(t), dt, advance, renormalize, *targetH[direction]);
+        }
+        else
+        {
+#pragma omp parallel for schedule(static)
+            for (k = 0; k < K; k++)
+                evolveLink(direction, k, static_cast<PRECISION>(t), *targetH[direction]);
+        }
+    }
 
-        for (unsigned int chunk = 0; chunk < (K / chunkSize) + 1; chunk++)
+    phasorsValid = incrementalEvolution;
+    lastEvolutionTime = t;
+    
+    timer.toc();
+    lastEvolveSeconds = timer.get_time();
+    MESSAGE_SINGLE(VERBOSE, logger, "Took " << lastEvolveSeconds << "seconds for evolving CIR at t=" << t);
+//    std::cout << "Took " << timer.get_time() << "seconds for evolving CIR at t=" << t << "\n";
+
+    // now, compute frequency response, either for all links or on demand
+    if (lazyTransformation)
+    {
+        // the transformations of the TTI that just ended happened on demand in the receivers
+        lastTransformSeconds = materializedSeconds;
+        materializedSeconds = 0.0;
+
+        for (unsigned int d = 0; d <= 1; d++)
         {
-            // determine how many links and elements are in this chunk
-            if (chunk == (K / chunkSize))
-                thisChunkSize = K % chunkSize;
-            else
-                thisChunkSize = chunkSize;
+            if (!directionsEnabled[d])
+                continue;
 
-            // in case that the number of links is a multiple of chunkSize we would get an emptyChunk
-            // so we skip the "last" iteration:
-            if (thisChunkSize == 0)
-                break;
-            
-            // copy the unscaled tVariantCoefficients into "scaled" to later scale them
-            // using memcpy should be  safe because it is a plain-old-data type (array of floats/doubles)
-            // with current time t; this is the exponent
-            memcpy(scaled, tVariantCoeff[direction]->data() + chunk * chunkSize * elementsPerLink,
-                   sizeof(PRECISION) * thisChunkSize * elementsPerLink);
-                
-            assure(scaled[0] == tVariantCoeff[direction]->data()[chunk * chunkSize * elementsPerLink], "mid not working correctly");
-            assure(scaled[thisChunkSize * elementsPerLink - 1] ==
-                   tVariantCoeff[direction]->data()[chunk * chunkSize * elementsPerLink + thisChunkSize * elementsPerLink - 1],
-                   "mid not working correctly");
+            MESSAGE_SINGLE(VERBOSE, logger, "Lazily transformed " << materializedThisTTI[d] << " of " << scmLinks.size()
+                           << " links in " << (d == imtaphy::Downlink ? "downlink" : "uplink") << " in the previous TTI, "
+                           << materializedTotal[d] << " in total");
 
-            // here we scale the exponent (scaled from tVariantCoeffVector) with the current time t and compute the complex exponential:
-            // exp(0 + j*tVariant*t)
-            
-            MKLscal<PRECISION> mklscal;
-            mklscal.execute(thisChunkSize * elementsPerLink, t, scaled, 1);
-            
-            MKLCis<PRECISION> mklcis;
-            mklcis.execute(thisChunkSize * elementsPerLink, scaled, tVariantVec);
-            
-            // to easily acces the result
-            boost::multi_array_ref<std::complex<PRECISION>, 5> result(tVariantVec, boost::extents[thisChunkSize][maxMsAntennas][maxBsAntennas][MaxClusters][NumRays+1]);
+            stale[d].markAllStale();
+            materializedThisTTI[d] = 0;
+        }
+    }
+    else
+        transformChannel(targetH, targetT);
+}
 
-            MKLdotu<PRECISION> mkldotu;
+template <typename PRECISION>
+void
+M2135<PRECISION>::materializeStaleChannel(unsigned int k, imtaphy::Direction d)
+{
+    assure(k < stale[d].size(), "invalid link ID or direction not enabled");
+
+#ifdef _OPENMP
+    omp_lock_t* lock = &linkLocks[k % NumLinkLocks];
+    omp_set_lock(lock);
+#endif
+    // another thread might have transformed the link while we were waiting for the lock
+    if (stale[d].isStale(k))
+    {
+        wns::StopWatch watch;
+        watch.start();
+        transformLink(d, k, *H[d], *T[d]);
+        double seconds = watch.stop();
+
+        // publishes T to the threads taking the fast path in materializeChannel
+        stale[d].markFresh(k);
+
+#pragma omp atomic
+        materializedThisTTI[d]++;
+#pragma omp atomic
+        materializedTotal[d]++;
+#pragma omp atomic
+        materializedSeconds += seconds;
+    }
+#ifdef _OPENMP
+    omp_unset_lock(lock);
+#endif
+}
+
+template <typename PRECISION>
+int
+M2135<PRECISION>::numActiveClusters(unsigned int k) const
+{
+    return std::min(static_cast<int>(FixParSingleton::Instance()(scmLinks[k]->getScenario(), scmLinks[k]->getPropagation())->NumClusters), 20);
+}
+
+template <typename PRECISION>
+const PRECISION*
+M2135<PRECISION>::invariantFactor(imtaphy::Direction direction, unsigned int k, unsigned int u, unsigned int s, PRECISION* buffer) const
+{
+    const unsigned int raysPerAntennaPair = MaxClusters * (NumRays + 1);
+
+    switch (factorStorage)
+    {
+    case HalfStorage:
+        imtaphy::detail::decodeHalf<PRECISION>(&((*compactFactor[direction])[k][u][s][0]), raysPerAntennaPair, buffer);
+        return buffer;
+    case QuantizedStorage:
+        imtaphy::detail::decodeQuantized<PRECISION>(reinterpret_cast<const boost::int16_t*>(&((*compactFactor[direction])[k][u][s][0])),
+                                                    (*compactFactorScale[direction])[k][u][s], raysPerAntennaPair, buffer);
+        return buffer;
+    default:
+        // std::complex is layout-compatible with PRECISION[2] (real, imag)
+        return reinterpret_cast<const PRECISION*>(&((*tInvariantFactor[direction])[k][u][s][0][0]));
+    }
+}
+
+template <typename PRECISION>
+void
+M2135<PRECISION>::compactInvariantFactors()
+{
+    const unsigned int raysPerAntennaPair = MaxClusters * (NumRays + 1);
+
+    for (unsigned int d = 0; d <= 1; d++)
+    {
+        if (!directionsEnabled[d])
+            continue;
+
+        compactFactor[d] = new boost::multi_array_ref<boost::uint16_t, 4>(static_cast<boost::uint16_t*>(imtaphy::detail::alignedMalloc(sizeof(boost::uint16_t) * scmLinks.size() * maxMsAntennas * maxBsAntennas * 2 * raysPerAntennaPair, 32)),
+                                                                         boost::extents[scmLinks.size()][maxMsAntennas][maxBsAntennas][2 * raysPerAntennaPair]);
+        if (factorStorage == QuantizedStorage)
+            compactFactorScale[d] = new boost::multi_array_ref<float, 3>(static_cast<float*>(imtaphy::detail::alignedMalloc(sizeof(float) * scmLinks.size() * maxMsAntennas * maxBsAntennas, 32)),
+                                                                         boost::extents[scmLinks.size()][maxMsAntennas][maxBsAntennas]);
+
+        int k; // signed int for OpenMP parallel for loop
+#pragma omp parallel for schedule(static)
+        for (k = 0; k < static_cast<int>(scmLinks.size()); k++)
+            for (unsigned int u = 0; u < maxMsAntennas; u++)
+                for (unsigned int s = 0; s < maxBsAntennas; s++)
+                {
+                    const std::complex<PRECISION>* full = &((*tInvariantFactor[d])[k][u][s][0][0]);
+                    if (factorStorage == HalfStorage)
+                        imtaphy::detail::encodeHalf<PRECISION>(full, raysPerAntennaPair, &((*compactFactor[d])[k][u][s][0]));
+                    else
+                        (*compactFactorScale[d])[k][u][s] = imtaphy::detail::encodeQuantized<PRECISION>(full, raysPerAntennaPair,
+                                                                                                       reinterpret_cast<boost::int16_t*>(&((*compactFactor[d])[k][u][s][0])));
+                }
+
+        // the full precision version is not needed anymore
+        releaseArray(tInvariantFactor[d]);
+    }
+}
+
+template <typename PRECISION>
+template <typename ArrayType>
+void
+M2135<PRECISION>::firstTouch(ArrayType* array)
+{
+    if ((array == NULL) || (array->num_elements() == 0))
+        return;
+
+    typename ArrayType::element* data = array->data();
+    const unsigned long int perLink = array->num_elements() / array->shape()[0];
+    
+    int k; // signed int for OpenMP parallel for loop
+#pragma omp parallel for schedule(static)
+    for (k = 0; k < static_cast<int>(array->shape()[0]); k++)
+        std::fill(data + k * perLink, data + (k + 1) * perLink, typename ArrayType::element());
+}
+
+template <typename PRECISION>
+template <typename ArrayType>
+unsigned long int
+M2135<PRECISION>::arrayBytes(const ArrayType* array) const
+{
+    if (array == NULL)
+        return 0;
+    
+    return array->num_elements() * sizeof(typename ArrayType::element);
+}
+
+template <typename PRECISION>
+void
+M2135<PRECISION>::reportMemoryFootprint()
+{
+    wns::probe::bus::ContextCollector memoryCollector("imtaphy.scm.memoryFootprint");
+    unsigned long int total = 0;
+
+    MESSAGE_BEGIN(NORMAL, logger, m, "Memory footprint of the channel state for " << scmLinks.size() << " links:\n");
+    for (unsigned int d = 0; d <= 1; d++)
+    {
+        if (!directionsEnabled[d])
+            continue;
+
+        std::string dir = (d == imtaphy::Downlink) ? "DL" : "UL";
+        
+        std::vector<std::pair<std::string, unsigned long int> > arrays;
+        arrays.push_back(std::make_pair(std::string("tVariantCoeff"), arrayBytes(tVariantCoeff[d])));
+        arrays.push_back(std::make_pair(std::string("tInvariantFactor"), arrayBytes(tInvariantFactor[d]) + arrayBytes(compactFactor[d]) + arrayBytes(compactFactorScale[d])));
+        arrays.push_back(std::make_pair(std::string("frequencyCoeff"), arrayBytes(frequencyCoeff[d])));
+        arrays.push_back(std::make_pair(std::string("H"), arrayBytes(H[d])));
+        arrays.push_back(std::make_pair(std::string("T"), arrayBytes(T[d])));
+        arrays.push_back(std::make_pair(std::string("phasors"), arrayBytes(phasors[d]) + arrayBytes(phasorSteps[d])));
+        arrays.push_back(std::make_pair(std::string("backBuffers"), arrayBytes(backH[d]) + arrayBytes(backT[d])));
+
+        for (unsigned int i = 0; i < arrays.size(); i++)
+        {
+            m << "  " << dir << " " << arrays[i].first << ": " << arrays[i].second << " bytes ("
+              << static_cast<double>(arrays[i].second) / (1024.0 * 1024.0) << " MB)\n";
+            memoryCollector.put(static_cast<double>(arrays[i].second), boost::make_tuple("array", arrays[i].first, "direction", dir));
+            total += arrays[i].second;
+        }
+    }
+    m << "  total: " << total << " bytes (" << static_cast<double>(total) / (1024.0 * 1024.0) << " MB)";
+    MESSAGE_END();
+}
+
+template <typename PRECISION>
+void
+M2135<PRECISION>::accumulateRays(const PRECISION* cosines, const PRECISION* sines, const PRECISION* factor, 
+                                 int nClusters, std::complex<PRECISION>* h) const
+{
+    const int raysPerCluster = NumRays + 1; // LoS case is handled by the additional ray
+
+    // factor points to the interleaved (real, imag) std::complex tInvariantFactor values
+    for (int n = 0; n < MaxClusters; n++)
+    {
+        // only compute coefficients for clusters that exist in this link's scenario
+        if ((n >= nClusters) && (n < 20))
+        {
+            h[n] = std::complex<PRECISION>(0.0, 0.0);
+            continue;
+        }
+
+        const int offset = n * raysPerCluster;
+        PRECISION re = 0.0;
+        PRECISION im = 0.0;
+        for (int r = offset; r < offset + raysPerCluster; r++)
+        {
+            re += cosines[r] * factor[2 * r] - sines[r] * factor[2 * r + 1];
+            im += cosines[r] * factor[2 * r + 1] + sines[r] * factor[2 * r];
+        }
+        h[n] = std::complex<PRECISION>(re, im);
+    }
+}
+
+template <typename PRECISION>
+void
+M2135<PRECISION>::evolveLink(imtaphy::Direction direction, unsigned int k, PRECISION t, ComplexArray4D& targetH)
+{
+    const int raysPerCluster = NumRays + 1;
+    const int raysPerAntennaPair = MaxClusters * raysPerCluster;
+    
+    // only the first nClusters and the sub-clusters 20..23 of the two strongest clusters exist,
+    // both ranges are contiguous in memory
+    int nClusters = numActiveClusters(k);
+    const int segmentBegin[2] = {0, 20 * raysPerCluster};
+    const int segmentEnd[2] = {nClusters * raysPerCluster, raysPerAntennaPair};
+
+    // per-thread scratch space for one antenna pair, small enough to stay in L1
+    PRECISION cosines[raysPerAntennaPair];
+    PRECISION sines[raysPerAntennaPair];
+    PRECISION factorBuffer[2 * raysPerAntennaPair]; // only used for compact tInvariantFactor storage
+
+    for (unsigned int u = 0; u < maxMsAntennas; u++)
+    {
+        for (unsigned int s = 0; s < maxBsAntennas; s++)
+        {
+            const PRECISION* exponent = &((*tVariantCoeff[direction])[k][u][s][0][0]);
+            const PRECISION* factor = invariantFactor(direction, k, u, s, factorBuffer);
             
-            int kOffset; // signed int for OpenMP parallel for loop
-#pragma omp parallel for
-            for (kOffset = 0; kOffset < static_cast<int>(thisChunkSize); kOffset++)
-            {
-                // compute the absolute k
-                unsigned int k = chunk * chunkSize + kOffset;
-                int nClusters = FixParSingleton::Instance()(scmLinks[k]->getScenario(), scmLinks[k]->getPropagation())->NumClusters;
+            // we flip the order of u and s for the uplink H matrix
+            std::complex<PRECISION>* h = (direction == imtaphy::Downlink) ? 
+                &(targetH[k][u][s][0]) : 
+                &(targetH[k][s][u][0]);
 
-                if (direction == imtaphy::Downlink)
-                {                
-                    for (unsigned int u = 0; u < maxMsAntennas; u++)
+            // branch-free loop that the compiler vectorizes
+            for (int seg = 0; seg < 2; seg++)
+                for (int i = segmentBegin[seg]; i < segmentEnd[seg]; i++)
+                    imtaphy::detail::sinCos<PRECISION>(exponent[i] * t, sines[i], cosines[i]);
+
+            accumulateRays(cosines, sines, factor, nClusters, h);
+        }
+    }
+}
+
+template <typename PRECISION>
+void
+M2135<PRECISION>::evolveLinkIncremental(imtaphy::Direction direction, unsigned int k, PRECISION t, PRECISION dt, 
+                                        bool advance, bool renormalize, ComplexArray4D& targetH)
+{
+    const int raysPerCluster = NumRays + 1;
+    const int raysPerAntennaPair = MaxClusters * raysPerCluster;
+    
+    int nClusters = numActiveClusters(k);
+    const int segmentBegin[2] = {0, 20 * raysPerCluster};
+    const int segmentEnd[2] = {nClusters * raysPerCluster, raysPerAntennaPair};
+
+    PRECISION factorBuffer[2 * raysPerAntennaPair]; // only used for compact tInvariantFactor storage
+
+    for (unsigned int u = 0; u < maxMsAntennas; u++)
+    {
+        for (unsigned int s = 0; s < maxBsAntennas; s++)
+        {
+            PRECISION* cosines = &((*phasors[direction])[k][u][s][0][0]);
+            PRECISION* sines = &((*phasors[direction])[k][u][s][1][0]);
+            PRECISION* stepCosines = &((*phasorSteps[direction])[k][u][s][0][0]);
+            PRECISION* stepSines = &((*phasorSteps[direction])[k][u][s][1][0]);
+
+            if (advance)
+            {
+                // exp(j*w*(t+dt)) = exp(j*w*t) * exp(j*w*dt): one complex multiply instead of sin/cos
+                for (int seg = 0; seg < 2; seg++)
+                    for (int i = segmentBegin[seg]; i < segmentEnd[seg]; i++)
                     {
-                        for (unsigned int s = 0; s < maxBsAntennas; s++)
-                        {
-                            for (int n = 0; n < MaxClusters; n++)
-                            {
-                                (*H[imtaphy::Downlink])[k][u][s][n] = std::complex<PRECISION>(0.0, 0.0);
-
-                                // only compute coefficients for clusters that exist in this link's scenario
-                                if ((n < nClusters) || (n >= 20))
-                                    mkldotu.execute(NumRays+1, // number of elements in vectors
-                                                    &(result[kOffset][u][s][n][0]), // pointer to beginning of vector x
-                                                    1, // incx
-                                                    &((*tInvariantFactor[imtaphy::Downlink])[k][u][s][n][0]), // pointer to beginning of vector y
-                                                    1, // incy
-                                                    &((*H[imtaphy::Downlink])[k][u][s][n]));
-                                
-                            }   // LoS case is handled by looping over NumRays+1
-                        }
+                        PRECISION c = cosines[i] * stepCosines[i] - sines[i] * stepSines[i];
+                        PRECISION si = cosines[i] * stepSines[i] + sines[i] * stepCosines[i];
+                        cosines[i] = c;
+                        sines[i] = si;
                     }
-                }
-                else // uplink -> we flip the order of u and s for the H matrix
-                {                
-                    for (unsigned int s = 0; s < maxBsAntennas; s++)
-                    {
-                        for (unsigned int u = 0; u < maxMsAntennas; u++)
+
+                // rounding errors make the magnitude drift away from 1, pull it back periodically
+                if (renormalize)
+                    for (int seg = 0; seg < 2; seg++)
+                        for (int i = segmentBegin[seg]; i < segmentEnd[seg]; i++)
                         {
-                            for (int n = 0; n < MaxClusters; n++)
-                            {
-                                (*H[imtaphy::Uplink])[k][s][u][n] = std::complex<PRECISION>(0.0, 0.0);
-
-                                // only compute coefficients for clusters that exist in this link's scenario
-                                if ((n < nClusters) || (n >= 20))
-                                    mkldotu.execute(NumRays+1, // number of elements in vectors
-                                                    &(result[kOffset][u][s][n][0]), // pointer to beginning of vector x
-                                                    1, // incx
-                                                    &((*tInvariantFactor[imtaphy::Uplink])[k][u][s][n][0]), // pointer to beginning of vector y
-                                                    1, // incy
-                                                    &((*H[imtaphy::Uplink])[k][s][u][n]));
-                                
-                            }   // LoS case is handled by looping over NumRays+1
+                            PRECISION scale = static_cast<PRECISION>(1.0) / std::sqrt(cosines[i] * cosines[i] + sines[i] * sines[i]);
+                            cosines[i] *= scale;
+                            sines[i] *= scale;
                         }
+            }
+            else
+            {
+                // (re)start: exact phasors at t and the rotation per time step
+                const PRECISION* exponent = &((*tVariantCoeff[direction])[k][u][s][0][0]);
+                for (int seg = 0; seg < 2; seg++)
+                    for (int i = segmentBegin[seg]; i < segmentEnd[seg]; i++)
+                    {
+                        imtaphy::detail::sinCos<PRECISION>(exponent[i] * t, sines[i], cosines[i]);
+                        imtaphy::detail::sinCos<PRECISION>(exponent[i] * dt, stepSines[i], stepCosines[i]);
                     }
-                }
-                    
-            } // end of parallel for loop
-        } // end of the loop over all chunks
-    }
-    
-    timer.toc();
-    MESSAGE_SINGLE(VERBOSE, logger, "Took " << timer.get_time() << "seconds for evolving CIR at t=" << t);
-//    std::cout << "Took " << timer.get_time() << "seconds for evolving CIR at t=" << t << "\n";
+            }
 
-    mkl_free(scaled);
-    mkl_free(tVariantVec);
-    
-    // now, compute frequency response:
-    transformChannel();
+            const PRECISION* factor = invariantFactor(direction, k, u, s, factorBuffer);
+            std::complex<PRECISION>* h = (direction == imtaphy::Downlink) ? 
+                &(targetH[k][u][s][0]) : 
+                &(targetH[k][s][u][0]);
+
+            accumulateRays(cosines, sines, factor, nClusters, h);
+        }
+    }
 }
 
 template <typename PRECISION>
 void
-M2135<PRECISION>::transformChannel()
+M2135<PRECISION>::transformChannel(std::vector<ComplexArray4D*>& targetH, std::vector<ComplexArray4D*>& targetT)
 {
     itpp::Real_Timer timer;
     timer.reset();
     timer.tic();
     
-    MKLgemm<PRECISION> mklgemm;
-
     for (unsigned int d = 0; d <= 1; d++)
     {
         imtaphy::Direction direction = static_cast<imtaphy::Direction>(d);
@@ -1024,57 +1435,21 @@ M2135<PRECISION>::transformChannel()
     
         MESSAGE_SINGLE(NORMAL, logger, "Now transforming channel on " << scmLinks.size() << " links and " << channel->getSpectrum()->getNumberOfPRBs(direction) << " frequency channels");
 
-        std::complex<PRECISION> one = std::complex<PRECISION>(1.0, 0.0);
-        std::complex<PRECISION> zero = std::complex<PRECISION>(0.0, 0.0);
-        
         int k; // signed int for OpenMP parallel for loop
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
         for (k = 0; k < static_cast<int>(scmLinks.size()); k++)
         {
-            // compute the Fourier transformation by doing a matrix multiplication of the
-            // channel impulse response matrix H (matrix A) and the precomputed frequrencyCoefficient 
-            // matrix (matrix B): C = 1A*B + 0*C
-            // A is the k=k submatrix of H (rows contain antenna pairs, cols contain clusters)
-            // B is the k=k submatrix of the freqCoeff matrix (rows contain clusters and cols contain frequency bins (PRBs))
-            // C is the sub-matrix T[k][0][0][0] that contains #antenna pairs rows and #PRBs columns
-            // Note that the U and S dimensions are treated as if they are one dimension of antenna pairs. The chosen
-            // storage order allows us to do that.
-            
-            // We want T to hold links X frequency bins X rx antennas U X tx antennas S so that a U-by-S channel
-            // matrix for a given link and frequency bin would be stored adjacent in memory.
-            // Because T is stored in row-major-mode, we need u*s to be the number of columns and k*PRBs the 
-            // number of rows. So for this matrix multiplication we have the result T as a (k*PRBs)X(u*s) matrix
-            // in memory.
-            // H is stored k X u X s X n and frequencyCoeff is stored as k X f X n
-            // Because in each loop iteration we fix k to k=1..K, we work with submatrices
-            // H is then u X s X n and frequencyCoeff is f X n
-            // To get (for a fixed k) T f X u X s, we multiply 
-            // frequency coeff f X n with H^T n X (u*s)
-            // So we have C = A * B with
-            // A is frequency coeff as an f X n matrix
-            // B is H^T as n X (u*s) matrix
-            // The resulting C will then be f X (u X s) so M==f and N==u*s with the shared dimension K==MaxClusters
-            
-            mklgemm.execute(CblasRowMajor, // const enum CBLAS_ORDER Order, matrix storage mode
-                            CblasNoTrans, // CBLAS_TRANSPOSE TransA: (no) transpose mode for matrix A
-                            CblasTrans,  // transpose for B: should be transpose because it is multiplied via "clusters"
-                            channel->getSpectrum()->getNumberOfPRBs(direction), // M 
-                            maxMsAntennas * maxBsAntennas, // N: 
-                            MaxClusters, // K: number of columns to multiply over: Number of Clusters
-                            &one, // alpha = (1,0), i.e. no scaling 
-                            &((*frequencyCoeff[direction])[k][0][0]), //*A pointer to matrix A
-                            MaxClusters, // lda: size of leading dimension of A: noTrans and row major-> number of columns of A, thus MaxClusters
-                            &((*H[direction])[k][0][0][0]), // *B pointer to matrix B
-                            MaxClusters, // ldb: size of leading dimension of B: Transpose and row major-> number of rows of B, thus MaxClusters
-                            &zero, // *beta 0 because C should not be added and does not need to be zeroed then
-                            &((*T[direction])[k][0][0][0]), // *C pointer to matrix C
-                            maxMsAntennas * maxBsAntennas // ldc: size of leading dimension of C: NoTrans and row major-> number of cols of C, thus u*s
-                ); 
+            transformLink(direction, k, *targetH[direction], *targetT[direction]);
         } // end of parallel for
+
+        // the back buffers are written while others read the stale flags of the current channel
+        if (&targetT == &T)
+            stale[direction].markAllFresh();
     } // uplink / downlink
     
     timer.toc();
-    MESSAGE_SINGLE(VERBOSE, logger, "transformChannel via Matrix Multiplication takes " << timer.get_time() << " seconds");
+    lastTransformSeconds = timer.get_time();
+    MESSAGE_SINGLE(VERBOSE, logger, "transformChannel via Matrix Multiplication takes " << lastTransformSeconds << " seconds");
 //    std::cout << "transformChannel via Matrix Multiplication takes " << timer.get_time() << " seconds\n";    
 
 //#else // we don't have MKL
@@ -1097,6 +1472,56 @@ M2135<PRECISION>::transformChannel()
 //
 //#endif
 }
+
+template <typename PRECISION>
+void
+M2135<PRECISION>::transformLink(imtaphy::Direction direction, unsigned int k, const ComplexArray4D& sourceH, ComplexArray4D& targetT)
+{
+    MKLgemm<PRECISION> mklgemm;
+
+    std::complex<PRECISION> one = std::complex<PRECISION>(1.0, 0.0);
+    std::complex<PRECISION> zero = std::complex<PRECISION>(0.0, 0.0);
+
+    // compute the Fourier transformation by doing a matrix multiplication of the
+    // channel impulse response matrix H (matrix A) and the precomputed frequrencyCoefficient 
+    // matrix (matrix B): C = 1A*B + 0*C
+    // A is the k=k submatrix of H (rows contain antenna pairs, cols contain clusters)
+    // B is the k=k submatrix of the freqCoeff matrix (rows contain clusters and cols contain frequency bins (PRBs))
+    // C is the sub-matrix T[k][0][0][0] that contains #antenna pairs rows and #PRBs columns
+    // Note that the U and S dimensions are treated as if they are one dimension of antenna pairs. The chosen
+    // storage order allows us to do that.
+    
+    // We want T to hold links X frequency bins X rx antennas U X tx antennas S so that a U-by-S channel
+    // matrix for a given link and frequency bin would be stored adjacent in memory.
+    // Because T is stored in row-major-mode, we need u*s to be the number of columns and k*PRBs the 
+    // number of rows. So for this matrix multiplication we have the result T as a (k*PRBs)X(u*s) matrix
+    // in memory.
+    // H is stored k X u X s X n and frequencyCoeff is stored as k X f X n
+    // Because in each loop iteration we fix k to k=1..K, we work with submatrices
+    // H is then u X s X n and frequencyCoeff is f X n
+    // To get (for a fixed k) T f X u X s, we multiply 
+    // frequency coeff f X n with H^T n X (u*s)
+    // So we have C = A * B with
+    // A is frequency coeff as an f X n matrix
+    // B is H^T as n X (u*s) matrix
+    // The resulting C will then be f X (u X s) so M==f and N==u*s with the shared dimension K==MaxClusters
+    
+    mklgemm.execute(CblasRowMajor, // const enum CBLAS_ORDER Order, matrix storage mode
+                    CblasNoTrans, // CBLAS_TRANSPOSE TransA: (no) transpose mode for matrix A
+                    CblasTrans,  // transpose for B: should be transpose because it is multiplied via "clusters"
+                    channel->getSpectrum()->getNumberOfPRBs(direction), // M 
+                    maxMsAntennas * maxBsAntennas, // N: 
+                    MaxClusters, // K: number of columns to multiply over: Number of Clusters
+                    &one, // alpha = (1,0), i.e. no scaling 
+                    &((*frequencyCoeff[direction])[k][0][0]), //*A pointer to matrix A
+                    MaxClusters, // lda: size of leading dimension of A: noTrans and row major-> number of columns of A, thus MaxClusters
+                    &(sourceH[k][0][0][0]), // *B pointer to matrix B
+                    MaxClusters, // ldb: size of leading dimension of B: Transpose and row major-> number of rows of B, thus MaxClusters
+                    &zero, // *beta 0 because C should not be added and does not need to be zeroed then
+                    &(targetT[k][0][0][0]), // *C pointer to matrix C
+                    maxMsAntennas * maxBsAntennas // ldc: size of leading dimension of C: NoTrans and row major-> number of cols of C, thus u*s
+        ); 
+}
                 
 
 
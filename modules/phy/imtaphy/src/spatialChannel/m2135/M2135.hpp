@@ -47,14 +47,16 @@
 #define BOOST_DISABLE_ASSERTS
 #endif
 #include <boost/multi_array.hpp>
+#include <boost/weak_ptr.hpp>
 
 
-#define MKL_Complex8 std::complex<float>
-#define MKL_Complex16 std::complex<double>
-#include <mkl_vml_functions.h>
-#include <mkl_service.h>
-#include <mkl_cblas.h>
-#include <mkl_vml_defines.h>
+#include <IMTAPHY/detail/MathBackend.hpp>
+#include <IMTAPHY/detail/CompactComplex.hpp>
+#include <IMTAPHY/detail/StaleFlags.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace imtaphy { namespace scm { namespace m2135 {
     
@@ -69,28 +71,6 @@ namespace imtaphy { namespace scm { namespace m2135 {
                 class M2135TapsStatisticsTest;
             }
 
-            template <typename T> 
-            class MKLCis 
-            {
-            public:
-                void execute(const int n, // Specifies the number of elements to be calculated.
-                             const T* a, // Pointer to an array that contains the input vector a
-                             std::complex<T>* y // Pointer to an array that contains the output vector y.
-                    );
-            };
-    
-            template <typename T>
-            class MKLscal // the ?scal routines perform a vector operation defined as x = a*x
-            {
-            public:
-                void execute(const int N, // Specifies the number of elements in vector x.
-                             const T alpha, // Specifies the scalar a.
-                             T *X, // points to the vector x to be scaled
-                             const int incX // Specifies the increment for the elements of x
-                    );
-        
-            };
-    
             template <typename T>
             class MKLgemm // The ?gemm routines perform a matrix-matrix operation with general matrices. The operation is defined as C := alpha*op(A)*op(B) + beta*C
             {
@@ -111,19 +91,6 @@ namespace imtaphy { namespace scm { namespace m2135 {
                              const int ldc); 
             };
     
-            template <typename T>
-            class MKLdotu // The ?dotu_sub routines compute a vector-vector dot product
-            {
-            public:
-                void execute(const int N, // Specifies the number of elements in vectors x and y.
-                             const void *X, // points to vector X
-                             const int incX, // specifies the increment for vector X
-                             const void *Y,  // points to vector Y
-                             const int incY, // specifies the increment for vector Y
-                             void *dotu      // points to the memory for the result
-                    );
-            };
-    
             // Note: Even though M2135 is templated, we do not have to put the implementation into the 
             // header file. The reason is that inside the cpp file we explicitely instantiate the 
             // M2135<double> and the M2135<float> version in the StaticFactory macro.
@@ -151,6 +118,29 @@ namespace imtaphy { namespace scm { namespace m2135 {
                 void onWorldCreated(LinkManager* linkManager, lsparams::LSmap* lsParams, bool keepIntermediates);
         
                 void evolve(double t);
+
+                bool supportsPipelinedEvolution() const { return pipelinedEvolution; }
+                void evolveBackBuffer(double t);
+                void swapBuffers();
+
+                double getLastEvolveSeconds() const { return lastEvolveSeconds; }
+                double getLastTransformSeconds() const { return lastTransformSeconds; }
+
+                unsigned long int getStateBytesPerLink() const;
+
+                bool transformsLazily() const { return lazyTransformation; }
+                void materializeChannel(unsigned int k, imtaphy::Direction d)
+                {
+                    // fast path: already up to date in this TTI
+                    if (!stale[d].isStale(k))
+                        return;
+
+                    materializeStaleChannel(k, d);
+                }
+
+                // number of links whose transfer function was computed in the current / over all TTIs
+                unsigned int getMaterializedLinks(imtaphy::Direction d) const { return materializedThisTTI[d]; }
+                unsigned long int getTotalMaterializedLinks(imtaphy::Direction d) const { return materializedTotal[d]; }
         
 
             protected:
@@ -225,6 +215,7 @@ namespace imtaphy { namespace scm { namespace m2135 {
                     }
                     assure(f < channel->getSpectrum()->getNumberOfPRBs(d), "invalid PRB ID f");
 
+                    materializeChannel(k, d);
                     return (*T[d])[k][f][rxAntenna][txAntenna];
                 }
 
@@ -266,13 +257,11 @@ namespace imtaphy { namespace scm { namespace m2135 {
                             // for this link
                             if (direction == imtaphy::Downlink)
                             {
-                                return boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<PRECISION> > >
-                                    (new imtaphy::detail::MKLMatrix<std::complex<PRECISION> >(maxMsAntennas, maxBsAntennas, &((*T[imtaphy::Downlink])[k][f][0][0])));
+                                return frontBufferView(imtaphy::Downlink, k, f, maxMsAntennas, maxBsAntennas);
                             }
                             else // uplink
                             {
-                                return boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<PRECISION> > >
-                                    (new imtaphy::detail::MKLMatrix<std::complex<PRECISION> >(maxBsAntennas, maxMsAntennas, &((*T[imtaphy::Uplink])[k][f][0][0])));
+                                return frontBufferView(imtaphy::Uplink, k, f, maxBsAntennas, maxMsAntennas);
                             }
                         }
                         else 
@@ -291,13 +280,11 @@ namespace imtaphy { namespace scm { namespace m2135 {
                               
                                 if (direction == imtaphy::Downlink)
                                 {
-                                    return boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<PRECISION> > >
-                                        (new imtaphy::detail::MKLMatrix<std::complex<PRECISION> >(u, maxBsAntennas, &((*T[imtaphy::Downlink])[k][f][0][0])));
+                                    return frontBufferView(imtaphy::Downlink, k, f, u, maxBsAntennas);
                                 }
                                 else // uplink
                                 {
-                                    return boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<PRECISION> > >
-                                        (new imtaphy::detail::MKLMatrix<std::complex<PRECISION> >(s, maxMsAntennas, &((*T[imtaphy::Uplink])[k][f][0][0])));
+                                    return frontBufferView(imtaphy::Uplink, k, f, s, maxMsAntennas);
                                 }
 
                             }
@@ -341,11 +328,32 @@ namespace imtaphy { namespace scm { namespace m2135 {
 
 
             private:
+                typedef imtaphy::detail::MKLMatrix<std::complex<PRECISION> > ChannelMatrix;
+
+                // a matrix on the (front) T buffer of link k, PRB f that stays valid across swapBuffers()
+                boost::shared_ptr<ChannelMatrix> frontBufferView(imtaphy::Direction d, unsigned int k, unsigned int f,
+                                                                 unsigned int rows, unsigned int columns);
                 void dumpSmallScaleCalibration(RayAngles3DArray& aoas, RayAngles3DArray& aods, itpp::mat* sigmas, 
                                             itpp::mat* scaledDelays, itpp::mat* clusterPowers, itpp::mat* scaledClusterPowers);
                 void sizeMultiDimArrays();
+                template <typename ArrayType> void releaseArray(ArrayType*& array);
                 void setRiceanKterms(itpp::Vec<double> sigmaK);
-                void transformChannel();
+                typedef boost::multi_array_ref<std::complex<PRECISION>, 4> ComplexArray4D;
+                void evolveInto(double t, std::vector<ComplexArray4D*>& targetH, std::vector<ComplexArray4D*>& targetT);
+                void transformChannel(std::vector<ComplexArray4D*>& targetH, std::vector<ComplexArray4D*>& targetT);
+                void transformLink(imtaphy::Direction direction, unsigned int k, const ComplexArray4D& sourceH, ComplexArray4D& targetT);
+                void materializeStaleChannel(unsigned int k, imtaphy::Direction d);
+                void evolveLink(imtaphy::Direction direction, unsigned int k, PRECISION t, ComplexArray4D& targetH);
+                void evolveLinkIncremental(imtaphy::Direction direction, unsigned int k, PRECISION t, PRECISION dt, bool advance, bool renormalize,
+                                           ComplexArray4D& targetH);
+                void accumulateRays(const PRECISION* cosines, const PRECISION* sines, const PRECISION* factor, 
+                                    int nClusters, std::complex<PRECISION>* h) const;
+                int numActiveClusters(unsigned int k) const;
+                const PRECISION* invariantFactor(imtaphy::Direction direction, unsigned int k, unsigned int u, unsigned int s, PRECISION* buffer) const;
+                void compactInvariantFactors();
+                void reportMemoryFootprint();
+                template <typename ArrayType> unsigned long int arrayBytes(const ArrayType* array) const;
+                template <typename ArrayType> void firstTouch(ArrayType* array);
                 bool checkZeroRays(std::complex<double> c, int cluster, int ray, int link) const;
         
                 imtaphy::Channel* channel;
@@ -391,6 +399,55 @@ namespace imtaphy { namespace scm { namespace m2135 {
                 bool computeEffectiveAntennaGains;
 
                 bool allSpeedsZero;
+
+                // incremental evolution: per direction, the current phasors exp(j*w*t) and the
+                // per-step rotations exp(j*w*dt) with extents [K][U][S][cos/sin][MaxClusters * (NumRays+1)]
+                bool incrementalEvolution;
+                unsigned int renormalizationInterval;
+                std::vector<boost::multi_array_ref<PRECISION, 5>*> phasors;
+                std::vector<boost::multi_array_ref<PRECISION, 5>*> phasorSteps;
+                bool phasorsValid;
+                double lastEvolutionTime;
+                double evolutionTimeStep;
+                unsigned int stepsSinceRenormalization;
+
+                // lazy transformation: T[d][k] is only computed when a link's channel matrix is accessed
+                bool lazyTransformation;
+                std::vector<imtaphy::detail::StaleFlags> stale;
+                std::vector<unsigned int> materializedThisTTI;
+                std::vector<unsigned long int> materializedTotal;
+                double materializedSeconds; // spent in transformLink since the last evolve, summed over all threads
+
+                // optional reduced-precision storage of tInvariantFactor (which then is released after
+                // initialization): IEEE half or 16 bit block-scaled fixed point per antenna pair
+                typedef enum {FullStorage, HalfStorage, QuantizedStorage} FactorStorage;
+                FactorStorage factorStorage;
+                std::vector<boost::multi_array_ref<boost::uint16_t, 4>*> compactFactor;
+                std::vector<boost::multi_array_ref<float, 3>*> compactFactorScale;
+
+                // pipelined evolution: the next TTI is evolved into backH/backT while H/T are still read
+                bool pipelinedEvolution;
+                std::vector<ComplexArray4D*> backH;
+                std::vector<ComplexArray4D*> backT;
+                bool backBufferPending;
+                // the matrices handed out by getChannelMatrix, swapBuffers() swaps T and backT and
+                // re-points them to the new front buffer instead of copying the back buffer
+                struct FrontBufferView
+                {
+                    boost::weak_ptr<ChannelMatrix> matrix;
+                    unsigned int direction;
+                    std::size_t offset;
+                };
+                std::vector<FrontBufferView> frontBufferViews;
+
+                double lastEvolveSeconds;
+                double lastTransformSeconds;
+
+#ifdef _OPENMP
+                // links are mapped onto a small set of locks to allow concurrent transformations
+                static const unsigned int NumLinkLocks = 64;
+                omp_lock_t linkLocks[NumLinkLocks];
+#endif
             };
         
         }}}
@@ -30,6 +30,7 @@
 #include <WNS/CppUnit.hpp>
 #include <cppunit/extensions/HelperMacros.h>
 #include <IMTAPHY/lsParams/LSCorrelation.hpp>
+#include <IMTAPHY/lsParams/SumOfSinusoids.hpp>
 #include <IMTAPHY/tests/ChannelStub.hpp>
 #include <IMTAPHY/tests/StationPhyStub.hpp>
 
@@ -54,6 +55,7 @@ namespace imtaphy { namespace scm { namespace m2135 { namespace tests {
                     CPPUNIT_TEST( testSmallScenario );
                     CPPUNIT_TEST( testLargeScenario );
                     CPPUNIT_TEST( testNothing );
+                    CPPUNIT_TEST( testSumOfSinusoids );
                     CPPUNIT_TEST_SUITE_END();
 
                 public:
@@ -63,6 +65,7 @@ namespace imtaphy { namespace scm { namespace m2135 { namespace tests {
                     void testSmallScenario();
                     void testLargeScenario();
                     void testNothing() { }
+                    void testSumOfSinusoids();
     
                 private:
                     imtaphy::tests::ChannelStub* channel;
@@ -344,4 +347,44 @@ namespace imtaphy { namespace scm { namespace m2135 { namespace tests {
 
                 }
 
+                void
+                LSCorrelationTest::testSumOfSinusoids()
+                {
+                    // the sum of sinusoids has to reproduce the unit variance and the correlation
+                    // r(dx) * r(dy) of the filtered grids, checked over many realizations
+                    double delta = 10.0;
+                    unsigned int filterLength = 101;
+                    unsigned int numSinusoids = 256;
+                    unsigned int realizations = 2000;
+
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, imtaphy::lsparams::SumOfSinusoids::autocorrelation(delta, filterLength, 0), 1e-12);
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, imtaphy::lsparams::SumOfSinusoids::autocorrelation(delta, filterLength, 101), 1e-12);
+                    // close to exp(-d/delta) as long as the filter is long compared to delta
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(-0.5), imtaphy::lsparams::SumOfSinusoids::autocorrelation(delta, filterLength, 5), 1e-3);
+
+                    itpp::RNG_reset(4711);
+                    double power = 0.0;
+                    double nearby = 0.0;
+                    double far = 0.0;
+                    for (unsigned int r = 0; r < realizations; r++)
+                    {
+                        itpp::vec random = itpp::randu(3 * numSinusoids);
+                        std::vector<double> uniforms(random._data(), random._data() + random.size());
+                        imtaphy::lsparams::SumOfSinusoids field(delta, filterLength, numSinusoids, uniforms);
+
+                        double value = field(20, 30);
+                        power += value * value;
+                        nearby += value * field(23, 35);
+                        far += value * field(220, 30);
+                    }
+
+                    double expectedNearby = imtaphy::lsparams::SumOfSinusoids::autocorrelation(delta, filterLength, 3) *
+                        imtaphy::lsparams::SumOfSinusoids::autocorrelation(delta, filterLength, 5);
+
+                    // the standard error of the estimates is at most sqrt(2 / realizations) = 0.03
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, power / realizations, 0.1);
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(expectedNearby, nearby / realizations, 0.1);
+                    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, far / realizations, 0.1);
+                }
+
             }}}}
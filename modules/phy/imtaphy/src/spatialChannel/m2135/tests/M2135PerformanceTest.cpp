@@ -0,0 +1,348 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <WNS/TestFixture.hpp>
+#include <WNS/StopWatch.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <IMTAPHY/spatialChannel/m2135/M2135.hpp>
+#include <IMTAPHY/tests/ChannelStub.hpp>
+#include <IMTAPHY/tests/StationPhyStub.hpp>
+#include <IMTAPHY/pathloss/M2135Pathloss.hpp>
+#include <IMTAPHY/Spectrum.hpp>
+#include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <IMTAPHY/detail/MathBackend.hpp>
+#include <IMTAPHY/detail/StaticPartition.hpp>
+#include <IMTAPHY/detail/SinCos.hpp>
+
+#include <WNS/pyconfig/View.hpp>
+#include <WNS/pyconfig/Parser.hpp>
+#include <WNS/node/Registry.hpp>
+
+#include <itpp/itbase.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <complex>
+#include <cmath>
+
+#if defined(_OPENMP) && !defined(__APPLE__)
+#include <omp.h>
+#endif
+
+namespace imtaphy { namespace scm { namespace m2135 { namespace tests {
+
+                // Measures the throughput of M2135::evolve (including the per-PRB channel transformation)
+                // on a layout that is big enough to leave the caches. Registered in the Performance registry
+                // so it only runs on demand. The evolve timings print the math backend, so running the
+                // suite from an MKL and an OpenBLAS build compares the two; cisBackends compares the
+                // complex exponential kernels of both backends within one build.
+                class M2135PerformanceTest :
+            public CppUnit::TestFixture
+                {
+                    CPPUNIT_TEST_SUITE( M2135PerformanceTest );
+                    CPPUNIT_TEST( evolveFloat );
+                    CPPUNIT_TEST( evolveDouble );
+                    CPPUNIT_TEST( threadScaling );
+                    CPPUNIT_TEST( cisBackendsFloat );
+                    CPPUNIT_TEST( cisBackendsDouble );
+                    CPPUNIT_TEST_SUITE_END();
+
+                public:
+                    void setUp();
+                    void tearDown();
+                    void evolveFloat();
+                    void evolveDouble();
+                    void threadScaling();
+                    void cisBackendsFloat();
+                    void cisBackendsDouble();
+
+                private:
+                    template <typename PRECISION> void benchmarkEvolve(std::string precisionName);
+                    template <typename PRECISION> void benchmarkCis(std::string precisionName);
+
+                    imtaphy::tests::ChannelStub* channel;
+                    wns::node::Registry* registry;
+                    imtaphy::LinkManagerStub* linkManager;
+                    lsparams::LSCorrelation* lsCorrelation;
+                    lsparams::LSmap* largeScaleParams;
+                    wns::pyconfig::Parser wholeConfig;
+
+                    static const int numBaseStations = 3;
+                    static const int numMobileStations = 60;
+                    static const int numAntennas = 4;
+                    static const int numTTIs = 20;
+                    static const int numCisRepetitions = 50;
+                };
+
+                CPPUNIT_TEST_SUITE_NAMED_REGISTRATION( M2135PerformanceTest, wns::testsuite::Performance() );
+
+                void
+                M2135PerformanceTest::setUp()
+                {
+                    itpp::RNG_reset(8041979);
+                    wns::simulator::getRNG()->seed(8041979);
+
+                    imtaphy::Spectrum* spectrum = new imtaphy::Spectrum(2E09, 180000.0, 50, 0);
+
+                    channel = new imtaphy::tests::ChannelStub();
+                    channel->setSpectrum(spectrum);
+
+                    double lambda = spectrum->getSystemCenterFrequencyWavelenghtMeters(imtaphy::Downlink);
+
+                    registry = new wns::node::Registry();
+                    linkManager = new imtaphy::LinkManagerStub();
+
+                    for (int b = 0; b < numBaseStations; b++)
+                    {
+                        std::stringstream name; name << "BS" << b;
+                        createStationStub(name.str(), wns::Position(500.0 * b, 0, 25), "BS", numAntennas, 0.5 * lambda, 0, registry, channel);
+                    }
+                    for (int m = 0; m < numMobileStations; m++)
+                    {
+                        std::stringstream name; name << "MS" << m;
+                        createStationStub(name.str(), wns::Position(20.0 * m, 100.0 + 3.0 * m, 1.5), "MS", numAntennas, 0.5 * lambda, 3.0, registry, channel);
+                    }
+
+                    imtaphy::StationList bsList = channel->getAllBaseStations();
+                    imtaphy::StationList msList = channel->getAllMobileStations();
+
+                    int i = 0;
+                    for (imtaphy::StationList::const_iterator msIter=msList.begin(); msIter!=msList.end() ; msIter++)
+                        for (imtaphy::StationList::const_iterator bsIter=bsList.begin(); bsIter!=bsList.end() ; bsIter++)
+                        {
+                            Link::Propagation propagation = (i % 3 == 0) ? Link::LoS : Link::NLoS;
+
+                            LinkStub* link = new LinkStub(*bsIter, *msIter, Link::UMa, propagation, propagation, Link::InVehicle,
+                                                          (*msIter)->getPosition(), wns::Ratio::from_dB(0.0), i);
+                            i++;
+                            linkManager->addLink(link, true);
+                        }
+
+                    std::stringstream ss;
+                    ss << "import openwns\n"
+                       << "import imtaphy.Pathloss\n"
+                       << "import imtaphy.Logger\n"
+                       << "import imtaphy.SCM\n"
+                       << "m2135Pathloss = imtaphy.Pathloss.M2135Pathloss()\n"
+                       << "m2135 = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"))\n";
+                    wholeConfig.loadString(ss.str());
+
+                    wns::pyconfig::View pathlossConfig(wholeConfig, "m2135Pathloss");
+                    channel->setPathlossModel(new imtaphy::pathloss::M2135Pathloss(channel, pathlossConfig));
+
+                    imtaphy::lsparams::RandomMatrix* rnGen = new imtaphy::lsparams::RandomMatrix();
+                    lsCorrelation = new lsparams::LSCorrelation(linkManager->getAllLinks(), linkManager, rnGen);
+                    largeScaleParams = lsCorrelation->generateLSCorrelation();
+                }
+
+                void
+                M2135PerformanceTest::tearDown()
+                {
+                }
+
+                template <typename PRECISION>
+                void
+                M2135PerformanceTest::benchmarkEvolve(std::string precisionName)
+                {
+                    wns::pyconfig::View m2135Config(wholeConfig, "m2135");
+
+                    itpp::RNG_reset(8041979);
+                    wns::simulator::getRNG()->seed(8041979);
+
+                    M2135<PRECISION>* scm = new M2135<PRECISION>(channel, m2135Config);
+                    scm->onWorldCreated(linkManager, largeScaleParams, false);
+
+                    // warm up (first touch of all arrays)
+                    scm->evolve(0.0);
+
+                    wns::StopWatch sw;
+                    sw.start();
+                    for (int t = 1; t <= numTTIs; t++)
+                        scm->evolve(double(t) * 0.001);
+                    sw.stop();
+
+                    unsigned int numLinks = linkManager->getAllLinks().size();
+                    std::cout << "\nM2135<" << precisionName << ">::evolve with the "
+                              << imtaphy::detail::mathBackendName() << " backend: "
+                              << numLinks << " links, " << numAntennas << "x" << numAntennas << " antennas, "
+                              << numTTIs << " TTIs took " << sw.toString() << std::endl;
+                    std::cout << "Link-TTIs/s: " << double(numLinks * numTTIs) / sw.getInSeconds() << std::endl;
+
+                    delete scm;
+                }
+
+                void
+                M2135PerformanceTest::evolveFloat()
+                {
+                    benchmarkEvolve<float>("float");
+                }
+
+                void
+                M2135PerformanceTest::evolveDouble()
+                {
+                    benchmarkEvolve<double>("double");
+                }
+
+                void
+                M2135PerformanceTest::threadScaling()
+                {
+                    // Runs evolve with 1, 2, 4, ... up to the maximum number of OpenMP threads. Each run
+                    // creates its own M2135 instance so that the arrays are first touched by the same
+                    // number of threads that evolve them. Pin the threads (e.g. OMP_PROC_BIND=spread
+                    // OMP_PLACES=cores) to see the effect of the NUMA-aware placement on multi-socket machines.
+#if defined(_OPENMP) && !defined(__APPLE__)
+                    const int maxThreads = imtaphy::detail::StaticPartition::maxThreads();
+                    wns::pyconfig::View m2135Config(wholeConfig, "m2135");
+                    unsigned int numLinks = linkManager->getAllLinks().size();
+                    double singleThreadSeconds = 0.0;
+
+                    std::cout << "\nM2135<float>::evolve thread scaling, " << numLinks << " links, "
+                              << numTTIs << " TTIs:" << std::endl;
+
+                    for (int threads = 1; threads <= maxThreads; threads = (threads == maxThreads) ? threads + 1 : std::min(2 * threads, maxThreads))
+                    {
+                        omp_set_num_threads(threads);
+
+                        itpp::RNG_reset(8041979);
+                        wns::simulator::getRNG()->seed(8041979);
+
+                        M2135<float>* scm = new M2135<float>(channel, m2135Config);
+                        scm->onWorldCreated(linkManager, largeScaleParams, false);
+                        scm->evolve(0.0);
+
+                        wns::StopWatch sw;
+                        sw.start();
+                        for (int t = 1; t <= numTTIs; t++)
+                            scm->evolve(double(t) * 0.001);
+                        sw.stop();
+
+                        if (threads == 1)
+                            singleThreadSeconds = sw.getInSeconds();
+
+                        double speedup = singleThreadSeconds / sw.getInSeconds();
+                        std::cout << "  " << threads << " threads: " << sw.toString()
+                                  << ", speedup " << speedup << ", efficiency " << speedup / double(threads) << std::endl;
+
+                        delete scm;
+                    }
+
+                    omp_set_num_threads(maxThreads);
+#else
+                    std::cout << "\nM2135 thread scaling benchmark skipped (built without OpenMP)" << std::endl;
+#endif
+                }
+
+                template <typename PRECISION>
+                void
+                M2135PerformanceTest::benchmarkCis(std::string precisionName)
+                {
+                    // One cis per ray and antenna pair like the Doppler rotation in evolve, whose kernel is
+                    // the portable detail::sinCos. libm is the accuracy reference; on MKL builds the VML
+                    // ?CIS routines are timed as well to show what a backend-specific kernel would gain.
+                    const int n = linkManager->getAllLinks().size() * 20 * 20 * numAntennas * numAntennas;
+
+                    std::vector<PRECISION> phases(n);
+                    for (int i = 0; i < n; i++)
+                        phases[i] = PRECISION(2.0 * M_PI * (itpp::randu() - 0.5) * 100.0);
+
+                    std::vector<std::complex<PRECISION> > reference(n);
+                    std::vector<std::complex<PRECISION> > result(n);
+
+                    wns::StopWatch libmWatch;
+                    libmWatch.start();
+                    for (int r = 0; r < numCisRepetitions; r++)
+                        for (int i = 0; i < n; i++)
+                            reference[i] = std::complex<PRECISION>(std::cos(phases[i]), std::sin(phases[i]));
+                    libmWatch.stop();
+
+                    wns::StopWatch portableWatch;
+                    portableWatch.start();
+                    for (int r = 0; r < numCisRepetitions; r++)
+                        imtaphy::detail::vectorCis<PRECISION>(n, &phases[0], &result[0]);
+                    portableWatch.stop();
+
+                    double maxError = 0.0;
+                    for (int i = 0; i < n; i++)
+                        maxError = std::max(maxError, double(std::abs(result[i] - reference[i])));
+
+                    std::cout << "\ncis<" << precisionName << "> of " << n << " phases, "
+                              << numCisRepetitions << " repetitions:" << std::endl;
+                    std::cout << "  libm sin/cos:        " << libmWatch.toString() << std::endl;
+                    std::cout << "  portable vectorCis:  " << portableWatch.toString()
+                              << ", speedup " << libmWatch.getInSeconds() / portableWatch.getInSeconds()
+                              << ", max error " << maxError << std::endl;
+
+                    CPPUNIT_ASSERT(maxError < (sizeof(PRECISION) == sizeof(float) ? 1E-5 : 1E-12));
+
+#ifdef MKL
+                    const MKL_INT modes[2] = {VML_EP, VML_HA};
+                    const char* modeNames[2] = {"VML_EP", "VML_HA"};
+                    for (int m = 0; m < 2; m++)
+                    {
+                        vmlSetMode(modes[m]);
+
+                        wns::StopWatch vmlWatch;
+                        vmlWatch.start();
+                        for (int r = 0; r < numCisRepetitions; r++)
+                        {
+                            if (sizeof(PRECISION) == sizeof(float))
+                                vcCIS(n, reinterpret_cast<const float*>(&phases[0]), reinterpret_cast<MKL_Complex8*>(&result[0]));
+                            else
+                                vzCIS(n, reinterpret_cast<const double*>(&phases[0]), reinterpret_cast<MKL_Complex16*>(&result[0]));
+                        }
+                        vmlWatch.stop();
+
+                        double vmlError = 0.0;
+                        for (int i = 0; i < n; i++)
+                            vmlError = std::max(vmlError, double(std::abs(result[i] - reference[i])));
+
+                        std::cout << "  MKL " << modeNames[m] << " ?CIS:     " << vmlWatch.toString()
+                                  << ", speedup " << libmWatch.getInSeconds() / vmlWatch.getInSeconds()
+                                  << ", max error " << vmlError << std::endl;
+                    }
+                    vmlSetMode(VML_HA);
+#else
+                    std::cout << "  MKL VML ?CIS:        not available with the "
+                              << imtaphy::detail::mathBackendName() << " backend" << std::endl;
+#endif
+                }
+
+                void
+                M2135PerformanceTest::cisBackendsFloat()
+                {
+                    benchmarkCis<float>("float");
+                }
+
+                void
+                M2135PerformanceTest::cisBackendsDouble()
+                {
+                    benchmarkCis<double>("double");
+                }
+}}}}
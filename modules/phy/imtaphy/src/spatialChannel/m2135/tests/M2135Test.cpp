@@ -76,6 +76,10 @@ namespace imtaphy { namespace scm { namespace m2135 { namespace tests {
                     CPPUNIT_TEST( testNothing );
                     CPPUNIT_TEST( testEvolveDouble );
                     CPPUNIT_TEST( testEvolveFloat );
+                    CPPUNIT_TEST( testIncrementalEvolution );
+                    CPPUNIT_TEST( testLazyTransformation );
+                    CPPUNIT_TEST( testCompactInvariantFactor );
+                    CPPUNIT_TEST( testPipelinedEvolution );
                 
                     CPPUNIT_TEST_SUITE_END();
 
@@ -90,6 +94,11 @@ namespace imtaphy { namespace scm { namespace m2135 { namespace tests {
                     void testEvolveDouble();
                     void testEvolveFloat();
                     void compareFloatDouble();
+                    void testIncrementalEvolution();
+                    void testLazyTransformation();
+                    void testCompactInvariantFactor();
+                    void testPipelinedEvolution();
+                    std::vector<double> sinrTrace(imtaphy::scm::m2135::M2135<float>* scm);
         
                 private:
                     imtaphy::tests::ChannelStub* channel;
@@ -186,7 +195,12 @@ namespace imtaphy { namespace scm { namespace m2135 { namespace tests {
                     ss << "import openwns\n"
                        << "import imtaphy.Logger\n"
                        << "import imtaphy.SCM\n"
-                       << "m2135 = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"))\n";
+                       << "m2135 = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"))\n"
+                       << "m2135incremental = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"), incrementalEvolution = True, renormalizationInterval = 25)\n"
+                       << "m2135lazy = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"), lazyTransformation = True)\n"
+                       << "m2135half = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"), tInvariantFactorStorage = \"half\")\n"
+                       << "m2135quantized = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"), tInvariantFactorStorage = \"quantized\")\n"
+                       << "m2135pipelined = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"), pipelinedEvolution = True)\n";
         
                     wholeConfig.loadString(ss.str());
                     imtaphy::lsparams::RandomMatrix* rnGen = new imtaphy::lsparams::RandomMatrix();
@@ -256,6 +270,217 @@ namespace imtaphy { namespace scm { namespace m2135 { namespace tests {
                 }
 
 
+                void
+                M2135Test::testIncrementalEvolution()
+                {
+                    // the incremental (phasor rotation) evolution has to track the exact evolution closely,
+                    // also when the time step changes and across several renormalizations
+                    itpp::RNG_reset(8041979);
+                    wns::simulator::getRNG()->seed(8041979);
+                    wns::pyconfig::View exactConfig(wholeConfig, "m2135");
+                    imtaphy::scm::m2135::M2135<float>* exact = new imtaphy::scm::m2135::M2135<float>(channel, exactConfig);
+                    exact->onWorldCreated(linkManager, largeScaleParams, true);
+
+                    itpp::RNG_reset(8041979);
+                    wns::simulator::getRNG()->seed(8041979);
+                    wns::pyconfig::View incrementalConfig(wholeConfig, "m2135incremental");
+                    imtaphy::scm::m2135::M2135<float>* incremental = new imtaphy::scm::m2135::M2135<float>(channel, incrementalConfig);
+                    incremental->onWorldCreated(linkManager, largeScaleParams, true);
+
+                    double time = 0.0;
+                    for (int tti = 0; tti < 300; tti++)
+                    {
+                        // switch to a different time step half-way to trigger the re-initialization
+                        time += (tti < 150) ? 0.001 : 0.0005;
+                        exact->evolve(time);
+                        incremental->evolve(time);
+
+                        for(unsigned int k=0; k < exact->scmLinks.size(); k++)
+                            for (unsigned int u=0; u < exact->maxMsAntennas; u++)
+                                for (unsigned int s=0; s < exact->maxBsAntennas; s++)
+                                    for (int n=0; n < exact->MaxClusters; n++)
+                                    {
+                                        CPPUNIT_ASSERT_DOUBLES_EQUAL((*(exact->H[imtaphy::Downlink]))[k][u][s][n].real(), (*(incremental->H[imtaphy::Downlink]))[k][u][s][n].real(), 1.0e-03);
+                                        CPPUNIT_ASSERT_DOUBLES_EQUAL((*(exact->H[imtaphy::Downlink]))[k][u][s][n].imag(), (*(incremental->H[imtaphy::Downlink]))[k][u][s][n].imag(), 1.0e-03);
+                                    }
+                    }
+
+                    delete exact;
+                    delete incremental;
+                }
+
+                void
+                M2135Test::testLazyTransformation()
+                {
+                    itpp::RNG_reset(8041979);
+                    wns::simulator::getRNG()->seed(8041979);
+                    wns::pyconfig::View eagerConfig(wholeConfig, "m2135");
+                    imtaphy::scm::m2135::M2135<float>* eager = new imtaphy::scm::m2135::M2135<float>(channel, eagerConfig);
+                    eager->onWorldCreated(linkManager, largeScaleParams, true);
+
+                    itpp::RNG_reset(8041979);
+                    wns::simulator::getRNG()->seed(8041979);
+                    wns::pyconfig::View lazyConfig(wholeConfig, "m2135lazy");
+                    imtaphy::scm::m2135::M2135<float>* lazy = new imtaphy::scm::m2135::M2135<float>(channel, lazyConfig);
+                    lazy->onWorldCreated(linkManager, largeScaleParams, true);
+
+                    CPPUNIT_ASSERT(lazy->transformsLazily());
+                    CPPUNIT_ASSERT(!eager->transformsLazily());
+
+                    for (int t = 1; t <= 3; t++)
+                    {
+                        eager->evolve(double(t) * 0.001);
+                        lazy->evolve(double(t) * 0.001);
+
+                        // nothing is transformed until somebody asks for it
+                        CPPUNIT_ASSERT_EQUAL(0U, lazy->getMaterializedLinks(imtaphy::Downlink));
+
+                        // only touch every other link
+                        for (unsigned int k = 0; k < lazy->scmLinks.size(); k += 2)
+                            for (unsigned int f = 0; f < 100; f++)
+                                for (unsigned int u = 0; u < lazy->maxMsAntennas; u++)
+                                    for (unsigned int s = 0; s < lazy->maxBsAntennas; s++)
+                                    {
+                                        std::complex<float> expected = eager->getCurrentCTF(k, imtaphy::Downlink, u, s, f);
+                                        std::complex<float> actual = lazy->getCurrentCTF(k, imtaphy::Downlink, u, s, f);
+                                        CPPUNIT_ASSERT_EQUAL(expected, actual);
+                                    }
+
+                        CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>((lazy->scmLinks.size() + 1) / 2), lazy->getMaterializedLinks(imtaphy::Downlink));
+                    }
+                    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long int>(3 * ((lazy->scmLinks.size() + 1) / 2)), lazy->getTotalMaterializedLinks(imtaphy::Downlink));
+
+                    delete eager;
+                    delete lazy;
+                }
+
+                void
+                M2135Test::testCompactInvariantFactor()
+                {
+                    // the reduced precision tInvariantFactor storage must not change the per-PRB channel
+                    // gains by more than a few hundredths of a dB, i.e. well below any SINR resolution we care about
+                    itpp::RNG_reset(8041979);
+                    wns::simulator::getRNG()->seed(8041979);
+                    wns::pyconfig::View fullConfig(wholeConfig, "m2135");
+                    imtaphy::scm::m2135::M2135<float>* full = new imtaphy::scm::m2135::M2135<float>(channel, fullConfig);
+                    full->onWorldCreated(linkManager, largeScaleParams, true);
+
+                    const char* compactConfigs[2] = {"m2135half", "m2135quantized"};
+                    for (int c = 0; c < 2; c++)
+                    {
+                        itpp::RNG_reset(8041979);
+                        wns::simulator::getRNG()->seed(8041979);
+                        wns::pyconfig::View compactConfig(wholeConfig, compactConfigs[c]);
+                        imtaphy::scm::m2135::M2135<float>* compact = new imtaphy::scm::m2135::M2135<float>(channel, compactConfig);
+                        compact->onWorldCreated(linkManager, largeScaleParams, true);
+
+                        // the full precision array is gone and the compact state is half as big
+                        CPPUNIT_ASSERT(compact->tInvariantFactor[imtaphy::Downlink] == NULL);
+                        CPPUNIT_ASSERT(compact->getStateBytesPerLink() < full->getStateBytesPerLink());
+
+                        for (int t = 1; t <= 5; t++)
+                        {
+                            full->evolve(double(t) * 0.001);
+                            compact->evolve(double(t) * 0.001);
+
+                            for (unsigned int k = 0; k < full->scmLinks.size(); k++)
+                                for (unsigned int f = 0; f < 100; f++)
+                                {
+                                    double fullGain = 0.0;
+                                    double compactGain = 0.0;
+                                    for (unsigned int u = 0; u < full->maxMsAntennas; u++)
+                                        for (unsigned int s = 0; s < full->maxBsAntennas; s++)
+                                        {
+                                            fullGain += std::norm((*(full->T[imtaphy::Downlink]))[k][f][u][s]);
+                                            compactGain += std::norm((*(compact->T[imtaphy::Downlink]))[k][f][u][s]);
+                                        }
+                                    CPPUNIT_ASSERT_DOUBLES_EQUAL(10.0 * log10(fullGain), 10.0 * log10(compactGain), 0.05);
+                                }
+                        }
+                        delete compact;
+                    }
+
+                    delete full;
+                }
+
+                std::vector<double>
+                M2135Test::sinrTrace(imtaphy::scm::m2135::M2135<float>* scm)
+                {
+                    // per PRB and link: channel gain of the link over the sum of the gains of all other links
+                    std::vector<double> trace;
+                    for (unsigned int f = 0; f < 100; f++)
+                    {
+                        std::vector<double> gains(scm->scmLinks.size(), 0.0);
+                        double total = 0.0;
+                        for (unsigned int k = 0; k < scm->scmLinks.size(); k++)
+                        {
+                            for (unsigned int u = 0; u < scm->maxMsAntennas; u++)
+                                for (unsigned int s = 0; s < scm->maxBsAntennas; s++)
+                                    gains[k] += std::norm(scm->getCurrentCTF(k, imtaphy::Downlink, u, s, f));
+                            total += gains[k];
+                        }
+                        for (unsigned int k = 0; k < scm->scmLinks.size(); k++)
+                            trace.push_back(gains[k] / (total - gains[k] + 1e-12));
+                    }
+                    return trace;
+                }
+
+                void
+                M2135Test::testPipelinedEvolution()
+                {
+                    // evolving the next TTI into the back buffers while the current channel is read
+                    // must give exactly the same SINRs as the sequential receive-then-evolve
+                    itpp::RNG_reset(8041979);
+                    wns::simulator::getRNG()->seed(8041979);
+                    wns::pyconfig::View sequentialConfig(wholeConfig, "m2135");
+                    imtaphy::scm::m2135::M2135<float>* sequential = new imtaphy::scm::m2135::M2135<float>(channel, sequentialConfig);
+                    sequential->onWorldCreated(linkManager, largeScaleParams, true);
+
+                    itpp::RNG_reset(8041979);
+                    wns::simulator::getRNG()->seed(8041979);
+                    wns::pyconfig::View pipelinedConfig(wholeConfig, "m2135pipelined");
+                    imtaphy::scm::m2135::M2135<float>* pipelined = new imtaphy::scm::m2135::M2135<float>(channel, pipelinedConfig);
+                    pipelined->onWorldCreated(linkManager, largeScaleParams, true);
+
+                    CPPUNIT_ASSERT(pipelined->supportsPipelinedEvolution());
+                    CPPUNIT_ASSERT(!sequential->supportsPipelinedEvolution());
+
+                    sequential->evolve(0.0);
+                    pipelined->evolve(0.0);
+
+                    for (int tti = 0; tti < 5; tti++)
+                    {
+                        std::vector<double> expected = sinrTrace(sequential);
+                        sequential->evolve(double(tti + 1) * 0.001);
+
+                        std::vector<double> actual;
+#pragma omp parallel sections num_threads(2)
+                        {
+#pragma omp section
+                            actual = sinrTrace(pipelined);
+#pragma omp section
+                            pipelined->evolveBackBuffer(double(tti + 1) * 0.001);
+                        }
+                        
+                        // the back buffer is not visible before the swap
+                        CPPUNIT_ASSERT(sinrTrace(pipelined) == actual);
+                        pipelined->swapBuffers();
+
+                        CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+                        for (unsigned int i = 0; i < expected.size(); i++)
+                            CPPUNIT_ASSERT_EQUAL(expected[i], actual[i]);
+                    }
+                    
+                    // and the channels are still in sync after the last swap
+                    std::vector<double> expected = sinrTrace(sequential);
+                    std::vector<double> actual = sinrTrace(pipelined);
+                    for (unsigned int i = 0; i < expected.size(); i++)
+                        CPPUNIT_ASSERT_EQUAL(expected[i], actual[i]);
+
+                    delete sequential;
+                    delete pipelined;
+                }
+
                 void 
                 M2135Test::testEvolveFloat()
                 {
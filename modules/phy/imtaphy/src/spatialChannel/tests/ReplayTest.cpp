@@ -0,0 +1,337 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <WNS/pyconfig/Parser.hpp>
+#include <WNS/node/Registry.hpp>
+#include <WNS/Exception.hpp>
+
+#include <IMTAPHY/spatialChannel/Replay.hpp>
+#include <IMTAPHY/scanner/ChannelTrace.hpp>
+#include <IMTAPHY/tests/ChannelStub.hpp>
+#include <IMTAPHY/tests/StationPhyStub.hpp>
+#include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <IMTAPHY/Spectrum.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace imtaphy { namespace scm { namespace tests {
+
+    using namespace imtaphy::scanner::trace;
+
+    class ReplayTest :
+        public CppUnit::TestFixture
+    {
+        CPPUNIT_TEST_SUITE( ReplayTest );
+        CPPUNIT_TEST( roundTrip );
+        CPPUNIT_TEST( roundTripStdio );
+        CPPUNIT_TEST( beforeFirstFrame );
+        CPPUNIT_TEST( endOfTrace );
+        CPPUNIT_TEST( mismatchedScenario );
+        CPPUNIT_TEST( loop );
+        CPPUNIT_TEST( concurrentMaterialization );
+        CPPUNIT_TEST_SUITE_END();
+
+    public:
+        void setUp();
+        void tearDown();
+
+        void roundTrip();
+        void roundTripStdio();
+        void beforeFirstFrame();
+        void endOfTrace();
+        void mismatchedScenario();
+        void loop();
+        void concurrentMaterialization();
+
+    private:
+        static Sample sample(unsigned int tti, unsigned int i)
+        {
+            return Sample(std::sin(0.01 * i + tti), std::cos(0.003 * i * tti));
+        }
+
+        Replay* createReplay(bool memoryMapped, bool loop);
+
+        // compares the replayed CIRs, CTFs and channel matrices of all links with the frame recorded in TTI tti
+        void checkFrame(Replay* replay, unsigned int tti);
+
+        std::string fileName;
+        imtaphy::scm::ChannelLayout layout;
+        static const unsigned int firstTTI = 3;
+        static const unsigned int numFrames = 8;
+
+        imtaphy::tests::ChannelStub* channel;
+        imtaphy::LinkManagerStub* linkManager;
+        wns::node::Registry* registry;
+        wns::pyconfig::Parser config;
+    };
+
+    CPPUNIT_TEST_SUITE_REGISTRATION( ReplayTest );
+
+    void
+    ReplayTest::setUp()
+    {
+        fileName = "ReplayTest.trc";
+        layout.K = 4;
+        layout.U = 2;
+        layout.S = 4;
+        layout.N = 5;
+        layout.F[imtaphy::Downlink] = 6;
+        layout.F[imtaphy::Uplink] = 6;
+
+        channel = new imtaphy::tests::ChannelStub();
+        channel->setSpectrum(new imtaphy::Spectrum(2E09, 180000.0, layout.F[imtaphy::Downlink], layout.F[imtaphy::Uplink]));
+        linkManager = new imtaphy::LinkManagerStub();
+        channel->setLinkManager(linkManager);
+        registry = new wns::node::Registry();
+
+        double lambda = channel->getSpectrum()->getSystemCenterFrequencyWavelenghtMeters(imtaphy::Downlink);
+        imtaphy::tests::StationPhyStub* bs = imtaphy::tests::createStationStub("BS", wns::Position(0, 0, 10), "BS", layout.S, 10.0 * lambda, 0, registry, channel);
+        for (unsigned int k = 0; k < layout.K; k++)
+        {
+            std::stringstream name;
+            name << "MS" << k;
+            imtaphy::tests::StationPhyStub* ms = imtaphy::tests::createStationStub(name.str(), wns::Position(20.0 * k, 50, 1.5), "MS", layout.U, 0.5 * lambda, 3.0, registry, channel);
+            linkManager->addLink(new imtaphy::LinkStub(bs, ms, imtaphy::Link::UMa, imtaphy::Link::NLoS, imtaphy::Link::NLoS, imtaphy::Link::NotApplicable,
+                                                       ms->getPosition(), wns::Ratio::from_dB(0.0), k),
+                                 true);
+        }
+
+        // frames recorded in TTIs 3..10
+        ChannelTraceWriter writer(fileName, layout, NoCompression, 1, false);
+        for (unsigned int tti = firstTTI; tti < firstTTI + numFrames; tti++)
+        {
+            Sample* samples = writer.beginFrame(tti);
+            for (unsigned int i = 0; i < samplesPerFrame(layout); i++)
+                samples[i] = sample(tti, i);
+            writer.commitFrame();
+        }
+        writer.close();
+
+        config.loadString("import imtaphy.SCM\n"
+                          "import imtaphy.Logger\n"
+                          "logger = imtaphy.Logger.Logger(\"Replay\")\n"
+                          "mapped = imtaphy.SCM.Replay(logger, fileName = \"ReplayTest.trc\", memoryMapped = True, loop = False)\n"
+                          "stdio = imtaphy.SCM.Replay(logger, fileName = \"ReplayTest.trc\", memoryMapped = False, loop = False)\n"
+                          "looped = imtaphy.SCM.Replay(logger, fileName = \"ReplayTest.trc\", memoryMapped = True, loop = True)\n"
+                          "mismatched = imtaphy.SCM.Replay(logger, fileName = \"ReplayTestMismatched.trc\", memoryMapped = True, loop = False)\n");
+    }
+
+    void
+    ReplayTest::tearDown()
+    {
+        std::remove(fileName.c_str());
+    }
+
+    Replay*
+    ReplayTest::createReplay(bool memoryMapped, bool loop)
+    {
+        Replay* replay = new Replay(channel, wns::pyconfig::View(config, loop ? "looped" : (memoryMapped ? "mapped" : "stdio")));
+        replay->onWorldCreated(linkManager, NULL, false);
+
+        imtaphy::scm::ChannelLayout replayed = replay->getChannelLayout();
+        CPPUNIT_ASSERT_EQUAL(layout.K, replayed.K);
+        CPPUNIT_ASSERT_EQUAL(layout.U, replayed.U);
+        CPPUNIT_ASSERT_EQUAL(layout.S, replayed.S);
+        CPPUNIT_ASSERT_EQUAL(layout.F[imtaphy::Uplink], replayed.F[imtaphy::Uplink]);
+
+        return replay;
+    }
+
+    void
+    ReplayTest::checkFrame(Replay* replay, unsigned int tti)
+    {
+        std::vector<Sample> frame(samplesPerFrame(layout));
+        for (unsigned int i = 0; i < frame.size(); i++)
+            frame[i] = sample(tti, i);
+
+        imtaphy::LinkVector links = linkManager->getSCMLinks();
+        for (unsigned int k = 0; k < layout.K; k++)
+        {
+            replay->materializeChannel(k, imtaphy::Downlink);
+            replay->materializeChannel(k, imtaphy::Uplink);
+
+            for (unsigned int f = 0; f < layout.F[imtaphy::Downlink]; f++)
+            {
+                boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<float> > > downlink = replay->getChannelMatrix(links[k], imtaphy::Downlink, f);
+                boost::shared_ptr<imtaphy::detail::MKLMatrix<std::complex<float> > > uplink = replay->getChannelMatrix(links[k], imtaphy::Uplink, f);
+
+                for (unsigned int u = 0; u < layout.U; u++)
+                    for (unsigned int s = 0; s < layout.S; s++)
+                    {
+                        Sample ctf = ChannelTraceReader::ctf(&frame[0], layout, k, u, s, f);
+                        CPPUNIT_ASSERT(replay->getCurrentCTF(k, imtaphy::Downlink, u, s, f) == ctf);
+                        CPPUNIT_ASSERT((*downlink)[u][s] == ctf);
+
+                        // the uplink is the transposed downlink
+                        CPPUNIT_ASSERT(replay->getCurrentCTF(k, imtaphy::Uplink, s, u, f) == ctf);
+                        CPPUNIT_ASSERT((*uplink)[s][u] == ctf);
+                    }
+            }
+
+            for (unsigned int n = 0; n < layout.N; n++)
+                CPPUNIT_ASSERT(replay->getCurrentCIR(k, imtaphy::Downlink, 1, 2, n) == ChannelTraceReader::cir(&frame[0], layout, k, 1, 2, n));
+            CPPUNIT_ASSERT(replay->getCurrentCIR(k, imtaphy::Downlink, 1, 2, layout.N) == Sample(0.0, 0.0));
+        }
+    }
+
+    void
+    ReplayTest::roundTrip()
+    {
+        Replay* replay = createReplay(true, false);
+        for (unsigned int tti = firstTTI; tti < firstTTI + numFrames; tti++)
+        {
+            replay->evolve(tti * 0.001);
+            CPPUNIT_ASSERT_EQUAL(tti - firstTTI, replay->getCurrentFrame());
+            checkFrame(replay, tti);
+        }
+        delete replay;
+    }
+
+    void
+    ReplayTest::roundTripStdio()
+    {
+        Replay* replay = createReplay(false, false);
+        // random access
+        for (int tti = firstTTI + numFrames - 1; tti >= static_cast<int>(firstTTI); tti -= 3)
+        {
+            replay->evolve(tti * 0.001);
+            checkFrame(replay, tti);
+        }
+        delete replay;
+    }
+
+    void
+    ReplayTest::beforeFirstFrame()
+    {
+        Replay* replay = createReplay(true, false);
+        for (unsigned int tti = 0; tti <= firstTTI; tti++)
+        {
+            replay->evolve(tti * 0.001);
+            CPPUNIT_ASSERT_EQUAL(0U, replay->getCurrentFrame());
+            checkFrame(replay, firstTTI);
+        }
+        delete replay;
+    }
+
+    void
+    ReplayTest::endOfTrace()
+    {
+        Replay* replay = createReplay(true, false);
+        unsigned int lastTTI = firstTTI + numFrames - 1;
+
+        replay->evolve(lastTTI * 0.001);
+        checkFrame(replay, lastTTI);
+
+        CPPUNIT_ASSERT_THROW(replay->evolve((lastTTI + 1) * 0.001), wns::Exception);
+        CPPUNIT_ASSERT_THROW(replay->evolve((lastTTI + 100) * 0.001), wns::Exception);
+        delete replay;
+    }
+
+    void
+    ReplayTest::mismatchedScenario()
+    {
+        // recorded with one PRB less than the scenario's spectrum
+        imtaphy::scm::ChannelLayout recorded = layout;
+        recorded.F[imtaphy::Downlink] = layout.F[imtaphy::Downlink] - 1;
+        recorded.F[imtaphy::Uplink] = layout.F[imtaphy::Uplink] - 1;
+
+        ChannelTraceWriter writer("ReplayTestMismatched.trc", recorded, NoCompression, 1, false);
+        Sample* samples = writer.beginFrame(firstTTI);
+        for (unsigned int i = 0; i < samplesPerFrame(recorded); i++)
+            samples[i] = sample(firstTTI, i);
+        writer.commitFrame();
+        writer.close();
+
+        Replay* replay = new Replay(channel, wns::pyconfig::View(config, "mismatched"));
+        CPPUNIT_ASSERT_THROW(replay->onWorldCreated(linkManager, NULL, false), wns::Exception);
+        delete replay;
+        std::remove("ReplayTestMismatched.trc");
+    }
+
+    void
+    ReplayTest::loop()
+    {
+        Replay* replay = createReplay(true, true);
+        unsigned int lastTTI = firstTTI + numFrames - 1;
+
+        replay->evolve(lastTTI * 0.001);
+        CPPUNIT_ASSERT_EQUAL(numFrames - 1, replay->getCurrentFrame());
+
+        // starts over with the first recorded TTI
+        replay->evolve((lastTTI + 1) * 0.001);
+        CPPUNIT_ASSERT_EQUAL(0U, replay->getCurrentFrame());
+        checkFrame(replay, firstTTI);
+
+        replay->evolve((lastTTI + 5) * 0.001);
+        CPPUNIT_ASSERT_EQUAL(4U, replay->getCurrentFrame());
+        checkFrame(replay, firstTTI + 4);
+
+        // after several rounds
+        replay->evolve((lastTTI + 3 * numFrames + 2) * 0.001);
+        CPPUNIT_ASSERT_EQUAL(2U, replay->getCurrentFrame());
+        checkFrame(replay, firstTTI + 2);
+        delete replay;
+    }
+
+    void
+    ReplayTest::concurrentMaterialization()
+    {
+        // all threads access all links right after evolve, so most of them take the lock free
+        // fast path while another thread is still copying the link
+        Replay* replay = createReplay(true, false);
+        for (unsigned int tti = firstTTI; tti < firstTTI + numFrames; tti++)
+        {
+            replay->evolve(tti * 0.001);
+
+            int mismatches = 0;
+#pragma omp parallel for reduction(+:mismatches)
+            for (int i = 0; i < 64; i++)
+            {
+                unsigned int k = (i * 7) % layout.K;
+                imtaphy::Direction d = (i % 2 == 0) ? imtaphy::Downlink : imtaphy::Uplink;
+                for (unsigned int f = 0; f < layout.F[imtaphy::Downlink]; f++)
+                    for (unsigned int u = 0; u < layout.U; u++)
+                        for (unsigned int s = 0; s < layout.S; s++)
+                        {
+                            unsigned int sampleIndex = layout.K * layout.U * layout.S * layout.N + ((k * layout.U + u) * layout.S + s) * layout.F[imtaphy::Downlink] + f;
+                            Sample replayed = (d == imtaphy::Downlink) ? replay->getCurrentCTF(k, d, u, s, f) : replay->getCurrentCTF(k, d, s, u, f);
+                            if (replayed != sample(tti, sampleIndex))
+                                mismatches++;
+                        }
+            }
+            CPPUNIT_ASSERT_EQUAL(0, mismatches);
+        }
+        delete replay;
+    }
+
+}}}
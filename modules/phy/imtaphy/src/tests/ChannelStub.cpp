@@ -44,9 +44,42 @@ void imtaphy::tests::ChannelStub::setSpectrum(imtaphy::Spectrum* _spectrum)
 }
 
 
+void
+ChannelStub::initTransmissionLists()
+{
+    tti = 0;
+    transmissionIdCounter = 0;
+
+    transmissionsPerPRB.resize(2);
+    interferenceIndex.resize(2);
+    for (unsigned int d = 0; d <= 1; d++)
+    {
+        imtaphy::Direction direction = static_cast<imtaphy::Direction>(d);
+        transmissionsPerPRB[d].assign(spectrum->getNumberOfPRBs(direction), TransmissionVector());
+        interferenceIndex[d].assign(spectrum->getNumberOfPRBs(direction), PRBTransmissionVector());
+    }
+}
+
+void
+ChannelStub::startTTI(unsigned int ttiNumber)
+{
+    allCurrentTransmissions.clear();
+    for (unsigned int d = 0; d <= 1; d++)
+        for (unsigned int prb = 0; prb < transmissionsPerPRB[d].size(); prb++)
+        {
+            transmissionsPerPRB[d][prb].clear();
+            interferenceIndex[d][prb].clear();
+        }
+
+    tti = ttiNumber;
+    notifyNewTTI();
+}
+
 void
 ChannelStub::registerStationPhy(StationPhyStub* station)
 { 
+    station->setChannelIndex(getNumStations());
+    
     if (station->getStationType() == BASESTATION)
         baseStations.push_back(station);
     else
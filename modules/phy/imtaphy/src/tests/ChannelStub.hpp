@@ -35,6 +35,7 @@
 #include <IMTAPHY/tests/StationPhyStub.hpp>
 #include <IMTAPHY/pathloss/PathlossModelInterface.hpp>
 #include <IMTAPHY/Spectrum.hpp>
+#include <IMTAPHY/linkManagement/LinkManager.hpp>
 
 namespace imtaphy { namespace tests {
     
@@ -50,6 +51,27 @@ namespace imtaphy { namespace tests {
     
             void setSpectrum(imtaphy::Spectrum* spectrum);
             void setLinkManager(imtaphy::LinkManager* linkManager_) {linkManager = linkManager_;}
+
+            // sizes the per-PRB transmission lists like the regular constructor, call after setSpectrum
+            void initTransmissionLists();
+
+            void setParallelScheduling(bool enabled) {parallelScheduling = enabled;}
+
+            // call after setLinkManager, the links' channel matrices still have to be initialized
+            void setSpatialChannelModel(imtaphy::scm::SpatialChannelModelInterface<SCMPRECISION>* scm)
+            {
+                spatialChannelModel = scm;
+                numSCMLinks = linkManager->getSCMLinks().size();
+            }
+
+            // lets periodically() evolve the channel during the reception like onWorldCreated does for models supporting it
+            void enablePipelinedEvolution(unsigned int evolutionThreads) {initPipelinedEvolution(evolutionThreads);}
+
+            // forgets the transmissions of the last TTI and notifies the observers about the new one,
+            // like the end of Channel::periodically but without receiving and evolving the channel
+            void startTTI(unsigned int ttiNumber);
+
+            const TransmissionVector& getAllTransmissions() const {return allCurrentTransmissions;}
         };
 
     }}
@@ -0,0 +1,337 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <WNS/pyconfig/Parser.hpp>
+#include <WNS/Observer.hpp>
+#include <WNS/node/Registry.hpp>
+
+#include <IMTAPHY/tests/ChannelStub.hpp>
+#include <IMTAPHY/tests/StationPhyStub.hpp>
+#include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <IMTAPHY/Link.hpp>
+#include <IMTAPHY/Spectrum.hpp>
+#include <IMTAPHY/interface/IMTAphyObserver.hpp>
+#include <IMTAPHY/receivers/feedback/LteRel8DLFeedbackManager.hpp>
+#include <IMTAPHY/ltea/Layer2.hpp>
+#include <IMTAPHY/ltea/rlc/SegmentingQueue.hpp>
+#include <IMTAPHY/ltea/mac/scheduler/downlink/SchedulerBase.hpp>
+#include <WNS/ldk/fun/Main.hpp>
+#include <WNS/ldk/tools/Stub.hpp>
+#include <WNS/node/tests/Stub.hpp>
+#include <WNS/probe/bus/tests/ProbeBusStub.hpp>
+#include <WNS/simulator/ISimulator.hpp>
+
+#include <vector>
+#include <sstream>
+
+namespace imtaphy { namespace tests {
+
+        // gives the test access to the reference powers
+        class FeedbackManagerForUnitTesting :
+            public imtaphy::receivers::feedback::LteRel8DownlinkFeedbackManager
+        {
+        public:
+            FeedbackManagerForUnitTesting(const wns::pyconfig::View& config) :
+                imtaphy::receivers::feedback::LteRel8DownlinkFeedbackManager(config)
+            {}
+
+            double getReferencePower_mW(imtaphy::StationPhy* station, unsigned int prb)
+            {
+                return referencePowerMap.find(station)->second[prb].get_mW();
+            }
+        };
+
+        // Does what matters for the channel of a downlink scheduler's onNewTTI: updates the feedback
+        // manager's reference powers of its users and registers one transmission per user
+        class CellStub :
+            public wns::Observer<imtaphy::interface::IMTAphyObserver>
+        {
+        public:
+            CellStub(unsigned int _cell, imtaphy::Channel* _channel,
+                     imtaphy::receivers::feedback::DownlinkFeedbackManagerInterface* _feedbackManager) :
+                cell(_cell),
+                channel(_channel),
+                feedbackManager(_feedbackManager)
+            {
+                this->startObserving(channel);
+            }
+
+            void onNewTTI(unsigned int ttiNumber)
+            {
+                unsigned int numPRBs = channel->getSpectrum()->getNumberOfPRBs(imtaphy::Downlink);
+
+                for (unsigned int u = 0; u < links.size(); u++)
+                {
+                    imtaphy::interface::PrbPowerPrecodingMap prbMap;
+                    for (unsigned int prb = 0; prb < numPRBs; prb++)
+                    {
+                        wns::Power power = wns::Power::from_mW(power_mW(cell, u, prb, ttiNumber));
+                        feedbackManager->setReferencePerPRBTxPowerForUser(links[u]->getMS()->getNode(), prb, power);
+
+                        // the users share the PRBs round robin
+                        if (prb % links.size() == (u + ttiNumber) % links.size())
+                        {
+                            imtaphy::interface::PowerAndPrecoding entry;
+                            entry.power = power;
+                            prbMap[prb] = entry;
+                        }
+                    }
+
+                    channel->registerTransmission(TransmissionPtr(new Transmission(imtaphy::Downlink, std::vector<wns::ldk::CompoundPtr>(),
+                                                                                   links[u], links[u]->getBS(), links[u]->getMS(),
+                                                                                   prbMap, 1, 1)));
+                }
+            }
+
+            void beforeTTIover(unsigned int) {}
+
+            bool supportsParallelNewTTI() const {return true;}
+
+            static double power_mW(unsigned int cell, unsigned int user, unsigned int prb, unsigned int ttiNumber)
+            {
+                return 1.0 + cell + 0.1 * user + 0.01 * prb + 0.001 * ttiNumber;
+            }
+
+            std::vector<imtaphy::Link*> links;
+
+        private:
+            unsigned int cell;
+            imtaphy::Channel* channel;
+            imtaphy::receivers::feedback::DownlinkFeedbackManagerInterface* feedbackManager;
+        };
+
+        class ParallelNewTTITest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( ParallelNewTTITest );
+            CPPUNIT_TEST( sameRegistrationsAsSequential );
+            CPPUNIT_TEST( segmentingQueueProbes );
+            CPPUNIT_TEST_SUITE_END();
+
+        public:
+            void setUp();
+            void tearDown();
+
+            void sameRegistrationsAsSequential();
+            void segmentingQueueProbes();
+
+        private:
+            // transmission ids relative to the first one of the TTI, source and destination
+            // channel index and the transmission ids per PRB
+            std::vector<unsigned int> recordTTI();
+
+            static const unsigned int numCells = 6;
+            static const unsigned int numUsersPerCell = 3;
+            static const unsigned int numPRBs = 12;
+
+            ChannelStub* channel;
+            imtaphy::LinkManagerStub* linkManager;
+            wns::node::Registry* registry;
+            wns::pyconfig::Parser config;
+            FeedbackManagerForUnitTesting* feedbackManager;
+            std::vector<CellStub*> cells;
+            std::vector<StationPhyStub*> mobiles;
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( ParallelNewTTITest );
+
+        void
+        ParallelNewTTITest::setUp()
+        {
+            channel = new ChannelStub();
+            channel->setSpectrum(new imtaphy::Spectrum(2E09, 180000.0, numPRBs, 0));
+            channel->initTransmissionLists();
+
+            linkManager = new imtaphy::LinkManagerStub();
+            channel->setLinkManager(linkManager);
+
+            registry = new wns::node::Registry();
+
+            config.loadString("import imtaphy.Feedback\n"
+                              "feedbackManager = imtaphy.Feedback.LTERel8DownlinkFeedbackManager(enabled = False)\n");
+            feedbackManager = new FeedbackManagerForUnitTesting(wns::pyconfig::View(config, "feedbackManager"));
+
+            double lambda = channel->getSpectrum()->getSystemCenterFrequencyWavelenghtMeters(imtaphy::Downlink);
+            for (unsigned int c = 0; c < numCells; c++)
+            {
+                std::stringstream name;
+                name << "BS" << c;
+                StationPhyStub* bs = createStationStub(name.str(), wns::Position(100.0 * c, 0, 10), "BS", 1, 10.0 * lambda, 0, registry, channel);
+
+                cells.push_back(new CellStub(c, channel, feedbackManager));
+                for (unsigned int u = 0; u < numUsersPerCell; u++)
+                {
+                    name.str("");
+                    name << "MS" << c << "." << u;
+                    StationPhyStub* ms = createStationStub(name.str(), wns::Position(100.0 * c + 10.0 * u, 50, 1.5), "MS", 1, 0.5 * lambda, 3.0, registry, channel);
+
+                    imtaphy::Link* link = new imtaphy::LinkStub(bs, ms, imtaphy::Link::UMa, imtaphy::Link::NLoS, imtaphy::Link::NLoS,
+                                                                imtaphy::Link::NotApplicable, ms->getPosition(), wns::Ratio::from_dB(0.0),
+                                                                c * numUsersPerCell + u);
+                    linkManager->setServingLink(link, ms);
+                    feedbackManager->registerMS(ms, ms->getNode(), NULL, channel);
+                    cells[c]->links.push_back(link);
+                    mobiles.push_back(ms);
+                }
+            }
+        }
+
+        void
+        ParallelNewTTITest::tearDown()
+        {
+            for (unsigned int c = 0; c < cells.size(); c++)
+                delete cells[c];
+            cells.clear();
+            mobiles.clear();
+        }
+
+        std::vector<unsigned int>
+        ParallelNewTTITest::recordTTI()
+        {
+            std::vector<unsigned int> record;
+
+            const TransmissionVector& transmissions = channel->getAllTransmissions();
+            CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(numCells * numUsersPerCell), transmissions.size());
+            unsigned int firstId = transmissions[0]->getId();
+            for (unsigned int i = 0; i < transmissions.size(); i++)
+            {
+                record.push_back(transmissions[i]->getId() - firstId);
+                record.push_back(transmissions[i]->getSource()->getChannelIndex());
+                record.push_back(transmissions[i]->getDestination()->getChannelIndex());
+            }
+
+            for (unsigned int prb = 0; prb < numPRBs; prb++)
+            {
+                const PRBTransmissionVector& index = channel->getInterferenceIndexOnPRB(imtaphy::Downlink, prb);
+                CPPUNIT_ASSERT_EQUAL(channel->getTransmissionsOnPRB(imtaphy::Downlink, prb).size(), index.size());
+                for (unsigned int i = 0; i < index.size(); i++)
+                {
+                    CPPUNIT_ASSERT(index[i].transmission == channel->getTransmissionsOnPRB(imtaphy::Downlink, prb)[i]);
+                    record.push_back(index[i].transmission->getId() - firstId);
+                    record.push_back(index[i].sourceIndex);
+                }
+            }
+
+            return record;
+        }
+
+        void
+        ParallelNewTTITest::sameRegistrationsAsSequential()
+        {
+            // the first TTI is always notified sequentially
+            channel->startTTI(1);
+
+            const unsigned int lastTTI = 40;
+            std::vector<std::vector<unsigned int> > sequential;
+
+            channel->setParallelScheduling(false);
+            for (unsigned int tti = 2; tti <= lastTTI; tti++)
+            {
+                channel->startTTI(tti);
+                sequential.push_back(recordTTI());
+            }
+
+            channel->setParallelScheduling(true);
+            for (unsigned int tti = 2; tti <= lastTTI; tti++)
+            {
+                channel->startTTI(tti);
+                CPPUNIT_ASSERT(!channel->isInParallelNewTTI());
+
+                std::vector<unsigned int> parallel = recordTTI();
+                CPPUNIT_ASSERT_EQUAL(sequential[tti - 2].size(), parallel.size());
+                for (unsigned int i = 0; i < parallel.size(); i++)
+                    CPPUNIT_ASSERT_EQUAL(sequential[tti - 2][i], parallel[i]);
+
+                // every cell updated the reference powers of its own users only
+                for (unsigned int m = 0; m < mobiles.size(); m++)
+                    for (unsigned int prb = 0; prb < numPRBs; prb++)
+                        CPPUNIT_ASSERT_DOUBLES_EQUAL(CellStub::power_mW(m / numUsersPerCell, m % numUsersPerCell, prb, tti),
+                                                     feedbackManager->getReferencePower_mW(mobiles[m], prb), 1e-9);
+            }
+        }
+
+        void
+        ParallelNewTTITest::segmentingQueueProbes()
+        {
+            // the downlink schedulers' default queue with the FUs it needs from an eNB's FUN
+            wns::pyconfig::Parser queueConfig;
+            queueConfig.loadString("import openwns.logger\n"
+                                   "import ltea.dll.rlc\n"
+                                   "class Layer2:\n"
+                                   "  name = \"L2\"\n"
+                                   "  logger = openwns.logger.Logger(\"DLL\", \"L2\", False)\n"
+                                   "  stationID = 1\n"
+                                   "  stationType = \"eNB\"\n"
+                                   "  address = 1\n"
+                                   "  ring = -1\n"
+                                   "  phyNotifyServiceName = \"rx\"\n"
+                                   "  phyDataTransmissionName = \"tx\"\n"
+                                   "layer2 = Layer2()\n"
+                                   "queue = ltea.dll.rlc.SegmentingQueue(\"rlcUnacknowledgedMode\", \"rlcUnacknowledgedMode\", 100000)\n"
+                                   "queue.logger.enabled = False\n");
+
+            // not deleted, dll::Layer2 does not initialize its FUN pointer before startup
+            wns::node::tests::Stub* node = new wns::node::tests::Stub();
+            ltea::Layer2* layer2 = new ltea::Layer2(node, wns::pyconfig::View(queueConfig, "layer2"));
+            wns::ldk::fun::FUN* fun = new wns::ldk::fun::Main(layer2);
+
+            wns::pyconfig::Parser emptyConfig;
+            fun->addFunctionalUnit("pdcp", new wns::ldk::tools::Stub(fun, emptyConfig));
+            fun->addFunctionalUnit("rlcUnacknowledgedMode", new wns::ldk::tools::Stub(fun, emptyConfig));
+
+            ltea::rlc::SegmentingQueue* queue = new ltea::rlc::SegmentingQueue(wns::pyconfig::View(queueConfig, "queue"));
+            queue->setFUN(fun);
+
+            // nobody evaluates the queue size or the segmentation overhead
+            CPPUNIT_ASSERT(!queue->hasProbeObservers());
+            CPPUNIT_ASSERT(ltea::mac::scheduler::downlink::SchedulerBase::queueSupportsParallelNewTTI(queue));
+
+            {
+                wns::probe::bus::tests::ProbeBusStub sizeProbe;
+                sizeProbe.startObserving(wns::simulator::getProbeBusRegistry()->getMeasurementSource("SegmentingQueueSize"));
+                CPPUNIT_ASSERT(queue->hasProbeObservers());
+                CPPUNIT_ASSERT(!ltea::mac::scheduler::downlink::SchedulerBase::queueSupportsParallelNewTTI(queue));
+            }
+
+            {
+                wns::probe::bus::tests::ProbeBusStub overheadProbe;
+                overheadProbe.startObserving(wns::simulator::getProbeBusRegistry()->getMeasurementSource("SegmentingQueueOverhead"));
+                CPPUNIT_ASSERT(!ltea::mac::scheduler::downlink::SchedulerBase::queueSupportsParallelNewTTI(queue));
+            }
+
+            // the probe buses stopped observing when they were destroyed
+            CPPUNIT_ASSERT(ltea::mac::scheduler::downlink::SchedulerBase::queueSupportsParallelNewTTI(queue));
+
+            delete queue;
+            delete fun;
+            delete node;
+        }
+}}
@@ -0,0 +1,239 @@
+/*******************************************************************************
+ * This file is part of IMTAphy
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2010
+ * Institute of Communication Networks (LKN)
+ * Department of Electrical Engineering and Information Technology (EE & IT)
+ * Technische Universitaet Muenchen
+ * Arcisstr. 21
+ * 80333 Muenchen - Germany
+ * http://www.lkn.ei.tum.de/~jan/imtaphy/index.html
+ * 
+ * _____________________________________________________________________________
+ *
+ *   IMTAphy is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   IMTAphy is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with IMTAphy.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WNS/CppUnit.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+#include <WNS/pyconfig/Parser.hpp>
+#include <WNS/node/Registry.hpp>
+#include <WNS/simulator/ISimulator.hpp>
+
+#include <IMTAPHY/tests/ChannelStub.hpp>
+#include <IMTAPHY/tests/StationPhyStub.hpp>
+#include <IMTAPHY/spatialChannel/m2135/M2135.hpp>
+#include <IMTAPHY/pathloss/M2135Pathloss.hpp>
+#include <IMTAPHY/lsParams/LSCorrelation.hpp>
+#include <IMTAPHY/linkManagement/LinkManager.hpp>
+#include <IMTAPHY/receivers/ReceiverInterface.hpp>
+#include <IMTAPHY/interface/DataReception.hpp>
+#include <IMTAPHY/Link.hpp>
+#include <IMTAPHY/Spectrum.hpp>
+
+#include <itpp/itbase.h>
+#include <vector>
+#include <sstream>
+#include <cmath>
+
+namespace imtaphy { namespace tests {
+
+        // takes the place of the layer 2 and keeps the SINRs of everything delivered to it
+        class SINRRecorder :
+            public imtaphy::interface::PhyNotify
+        {
+        public:
+            void onData(std::vector<wns::ldk::CompoundPtr>, wns::node::Interface*, imtaphy::interface::TransmissionStatusPtr status)
+            {
+                for (unsigned int i = 0; i < status->getNumberOfPRBs(); i++)
+                    sinrs.push_back(status->getSINR(status->getPRBid(i), 1).get_dB());
+            }
+
+            void channelInitialized() {}
+
+            std::vector<double> sinrs;
+        };
+
+        class PipelinedEvolutionTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( PipelinedEvolutionTest );
+            CPPUNIT_TEST( sameSINRsAsSequential );
+            CPPUNIT_TEST_SUITE_END();
+
+        public:
+            void setUp();
+            void tearDown();
+
+            void sameSINRsAsSequential();
+
+        private:
+            // runs numTTIs through Channel::periodically and returns the SINRs the base stations'
+            // receivers delivered, one entry per TTI
+            std::vector<std::vector<double> > run(bool pipelined);
+
+            static const unsigned int numCells = 2;
+            static const unsigned int numUsersPerCell = 2;
+            static const unsigned int numPRBs = 6;
+            static const unsigned int numTTIs = 6;
+
+            wns::pyconfig::Parser config;
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( PipelinedEvolutionTest );
+
+        void
+        PipelinedEvolutionTest::setUp()
+        {
+            config.loadString("import imtaphy.Pathloss\n"
+                              "import imtaphy.SCM\n"
+                              "import imtaphy.Logger\n"
+                              "pathloss = imtaphy.Pathloss.M2135Pathloss()\n"
+                              "sequential = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"))\n"
+                              "pipelined = imtaphy.SCM.M2135(logger = imtaphy.Logger.Logger(\"SCM.M2135\"), pipelinedEvolution = True)\n");
+        }
+
+        void
+        PipelinedEvolutionTest::tearDown()
+        {
+        }
+
+        std::vector<std::vector<double> >
+        PipelinedEvolutionTest::run(bool pipelined)
+        {
+            // both runs have to draw the same large scale parameters and fast fading realization
+            itpp::RNG_reset(8041979);
+            wns::simulator::getRNG()->seed(8041979);
+
+            imtaphy::Spectrum* spectrum = new imtaphy::Spectrum(2E09, 180000.0, numPRBs, numPRBs);
+            ChannelStub* channel = new ChannelStub();
+            channel->setSpectrum(spectrum);
+            channel->initTransmissionLists();
+
+            imtaphy::LinkManagerStub* linkManager = new imtaphy::LinkManagerStub();
+            channel->setLinkManager(linkManager);
+            channel->setPathlossModel(new imtaphy::pathloss::M2135Pathloss(channel, wns::pyconfig::View(config, "pathloss")));
+
+            wns::node::Registry* registry = new wns::node::Registry();
+            double lambda = spectrum->getSystemCenterFrequencyWavelenghtMeters(imtaphy::Downlink);
+
+            std::vector<StationPhyStub*> baseStations;
+            std::vector<StationPhyStub*> mobiles;
+            for (unsigned int c = 0; c < numCells; c++)
+            {
+                std::stringstream name;
+                name << "BS" << c;
+                baseStations.push_back(createStationStub(name.str(), wns::Position(200.0 * c, 0, 25), "BS", 4, 0.5 * lambda, 0, registry, channel));
+            }
+            for (unsigned int m = 0; m < numCells * numUsersPerCell; m++)
+            {
+                std::stringstream name;
+                name << "MS" << m;
+                mobiles.push_back(createStationStub(name.str(), wns::Position(50.0 + 40.0 * m, 60, 1.5), "MS", 2, 0.5 * lambda, 30.0, registry, channel));
+            }
+
+            // every mobile has a SCM link to every base station, the serving one is m / numUsersPerCell
+            std::vector<imtaphy::Link*> servingLinks(mobiles.size());
+            for (unsigned int m = 0; m < mobiles.size(); m++)
+                for (unsigned int c = 0; c < numCells; c++)
+                {
+                    imtaphy::Link* link = new imtaphy::LinkStub(baseStations[c], mobiles[m], imtaphy::Link::UMa, imtaphy::Link::NLoS, imtaphy::Link::NLoS,
+                                                                imtaphy::Link::NotApplicable, mobiles[m]->getPosition(), wns::Ratio::from_dB(0.0), 0);
+                    linkManager->addLink(link, true);
+                    if (c == m / numUsersPerCell)
+                        servingLinks[m] = link;
+                }
+
+            imtaphy::lsparams::LSCorrelation lsCorrelation(linkManager->getAllLinks(), linkManager, new imtaphy::lsparams::RandomMatrix());
+            imtaphy::lsparams::LSmap* largeScaleParams = lsCorrelation.generateLSCorrelation();
+
+            imtaphy::scm::m2135::M2135<float>* scm = new imtaphy::scm::m2135::M2135<float>(channel, wns::pyconfig::View(config, pipelined ? "pipelined" : "sequential"));
+            scm->onWorldCreated(linkManager, largeScaleParams, false);
+            CPPUNIT_ASSERT_EQUAL(pipelined, scm->supportsPipelinedEvolution());
+
+            channel->setSpatialChannelModel(scm);
+            imtaphy::LinkVector links = linkManager->getAllLinks();
+            for (unsigned int i = 0; i < links.size(); i++)
+                links[i]->initComplexFloatChannelMatrices<float>(spectrum, scm);
+
+            // the base stations receive the uplink, which does not need a feedback manager
+            SINRRecorder recorder;
+            for (unsigned int c = 0; c < numCells; c++)
+            {
+                baseStations[c]->getReceiver()->channelInitialized(channel);
+                baseStations[c]->setRxService(&recorder);
+            }
+
+            scm->evolve(0.0);
+            if (pipelined)
+                channel->enablePipelinedEvolution(1);
+
+            imtaphy::detail::ComplexFloatMatrixPtr precoding(new imtaphy::detail::ComplexFloatMatrix(2, 1));
+            (*precoding)[0][0] = std::complex<float>(1.0 / sqrt(2.0), 0.0);
+            (*precoding)[1][0] = std::complex<float>(0.0, 1.0 / sqrt(2.0));
+
+            std::vector<std::vector<double> > result;
+            for (unsigned int tti = 0; tti < numTTIs; tti++)
+            {
+                // all users of a cell share its PRBs, so there is one interferer per PRB
+                for (unsigned int m = 0; m < mobiles.size(); m++)
+                {
+                    imtaphy::interface::PrbPowerPrecodingMap prbMap;
+                    for (unsigned int prb = m % numUsersPerCell; prb < numPRBs; prb += numUsersPerCell)
+                    {
+                        imtaphy::interface::PowerAndPrecoding entry;
+                        entry.power = wns::Power::from_dBm(10.0 + m);
+                        entry.precoding = precoding;
+                        prbMap[prb] = entry;
+                    }
+                    channel->registerTransmission(TransmissionPtr(new Transmission(imtaphy::Uplink, std::vector<wns::ldk::CompoundPtr>(),
+                                                                                   servingLinks[m], mobiles[m], servingLinks[m]->getBS(),
+                                                                                   prbMap, 2, 1)));
+                }
+
+                recorder.sinrs.clear();
+                channel->periodically();
+                CPPUNIT_ASSERT_EQUAL(channel->getTTI(), tti + 1);
+                CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(mobiles.size() * numPRBs / numUsersPerCell), recorder.sinrs.size());
+                result.push_back(recorder.sinrs);
+            }
+
+            for (unsigned int c = 0; c < numCells; c++)
+                baseStations[c]->setRxService(NULL);
+
+            return result;
+        }
+
+        void
+        PipelinedEvolutionTest::sameSINRsAsSequential()
+        {
+            // Channel::periodically evolving the next TTI into the back buffers while the receivers
+            // evaluate the current one has to deliver exactly the SINRs of receive-then-evolve
+            std::vector<std::vector<double> > sequential = run(false);
+            std::vector<std::vector<double> > pipelined = run(true);
+
+            CPPUNIT_ASSERT_EQUAL(sequential.size(), pipelined.size());
+            for (unsigned int tti = 0; tti < sequential.size(); tti++)
+            {
+                CPPUNIT_ASSERT_EQUAL(sequential[tti].size(), pipelined[tti].size());
+                for (unsigned int i = 0; i < sequential[tti].size(); i++)
+                    CPPUNIT_ASSERT_EQUAL(sequential[tti][i], pipelined[tti][i]);
+            }
+
+            // the channel has to change from TTI to TTI, otherwise a missing swap would go unnoticed
+            CPPUNIT_ASSERT(sequential.front() != sequential.back());
+        }
+}}
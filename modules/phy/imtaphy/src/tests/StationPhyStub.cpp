@@ -42,7 +42,7 @@ StationPhyStub::StationPhyStub(wns::node::Interface* node, const wns::pyconfig::
     StationPhy(node, pyco),
     position(p)
 {
-  
+    rxService = NULL;
 }
 
 const wns::Position& StationPhyStub::getPosition() const
@@ -48,6 +48,10 @@ namespace imtaphy { namespace tests {
             StationPhyStub(wns::node::Interface* node, const wns::pyconfig::View& pyco, wns::Position p);
             virtual const wns::Position& getPosition() const;
             void onNodeCreated() {}
+
+            // onNodeCreated would look the service up in the node, this is where onData delivers to
+            void setRxService(imtaphy::interface::PhyNotify* service) {rxService = service;}
+
             wns::Position position;
         };
 
@@ -166,6 +166,8 @@ for msPos in msPositions:
 
 # add channel dumping mobile:
 dumpingNode = imtaphy.Scanner.ScannerStation("dumpingStation")
+# writes the binary trace CIRCTFdump.trc (read it with pywns.ChannelTrace); pass format = "matlab"
+# for the old CIRCTFdump.m text dump and codec = "deflate" to compress the trace
 dumper = imtaphy.Scanner.ChannelDumper(dumpingNode, "channelDumper", "phyTx", "phyRx")                  
 dumperPhy = imtaphy.Station.StationPhy(dumpingNode, "dumperPhy", openwns.geometry.position.Position(0, 0, msHeight), imtaphy.Logger.Logger("dumperPhy") ,"phyTx", "phyRx", antenna = imtaphy.Antenna.Omnidirectional(antennaGain = "0 dB", azimuth = 0, numElements = numRxAntennas , elementSpacingMeters = 0.5*0.15, logger = imtaphy.Logger.Logger("dumperAntenna")))
 WNS.simulationModel.nodes.append(dumpingNode)
@@ -37,6 +37,7 @@ import imtaphy.Pathloss
 import imtaphy.Scanner
 import imtaphy.LinkManagement
 import imtaphy.SCM
+import imtaphy.Probes
 import rise.Mobility
 
 import openwns.probebus
@@ -154,3 +155,5 @@ Y = range(0,2500); random.shuffle(Y)
 
 for j in range(1,(i-1)*numMSperBS+1):
     WNS.simulationModel.nodes.append(createMS(X[j], Y[j], j))
+
+imtaphy.Probes.installChannelPerformanceProbes(WNS)